@@ -0,0 +1,114 @@
+#include "../include/sortkey.h"
+#include "../include/threadpool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Parallel sort benchmark. Sorts N rows of (id INT, ts TIMESTAMP) on
+ * "ORDER BY ts DESC, id" with 1, 2, 4, ... threads and reports the speedup
+ * over one thread. Thread counts run in increasing order because the pool
+ * only ever grows.
+ *
+ * usage: bench_sort [-t max_threads] [rows ...]   (default: 1000000 10000000)
+ */
+
+static Table table;
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void setup_table() {
+    memset(&table, 0, sizeof(table));
+    table.active_schema.num_columns = 2;
+    strcpy(table.active_schema.columns[0].name, "id");
+    table.active_schema.columns[0].type = COL_TYPE_INT;
+    table.active_schema.columns[0].size = 4;
+    strcpy(table.active_schema.columns[1].name, "ts");
+    table.active_schema.columns[1].type = COL_TYPE_TIMESTAMP;
+    table.active_schema.columns[1].size = 8;
+    table.row_size = compute_row_size(&table.active_schema);
+}
+
+static void bench_rows(uint32_t n, uint32_t max_threads) {
+    SortSpec spec = { .cols = { { 1, true }, { 0, false } }, .n_cols = 2 };
+    SortKeyFormat fmt;
+    sortkey_format_init(&fmt, &table, &spec);
+
+    uint8_t* rows = malloc((size_t)n * table.row_size);
+    uint8_t* keys = malloc((size_t)n * fmt.key_len);
+    SortItem* input = malloc((size_t)n * sizeof(SortItem));
+    SortItem* work = malloc((size_t)n * sizeof(SortItem));
+    if (!rows || !keys || !input || !work) {
+        printf("%u rows: out of memory\n", n);
+        free(rows);
+        free(keys);
+        free(input);
+        free(work);
+        return;
+    }
+
+    srand(38);
+    for (uint32_t i = 0; i < n; i++) {
+        uint8_t* row = rows + (size_t)i * table.row_size;
+        int32_t id = (int32_t)i;
+        int64_t ts = ((int64_t)rand() << 16) ^ rand();
+        memcpy(row, &id, 4);
+        memcpy(row + 4, &ts, 8);
+        input[i].key = keys + (size_t)i * fmt.key_len;
+        input[i].row = row;
+        sortkey_encode(&fmt, row, i, (uint8_t*)input[i].key);
+    }
+
+    printf("%10u rows  threads  time(ms)  speedup\n", n);
+    double base = 0;
+    for (uint32_t t = 1; t <= max_threads; t *= 2) {
+        memcpy(work, input, (size_t)n * sizeof(SortItem));
+        double start = now_ms();
+        sortkey_sort_parallel(work, n, fmt.key_len, t);
+        double ms = now_ms() - start;
+        for (uint32_t i = 1; i < n; i++) {
+            if (memcmp(work[i - 1].key, work[i].key, fmt.key_len) >= 0) {
+                printf("  sort is out of order at %u\n", i);
+                exit(EXIT_FAILURE);
+            }
+        }
+        if (t == 1) {
+            base = ms;
+        }
+        printf("%10s       %3u  %8.1f  %6.2fx\n", "", t, ms, base / ms);
+    }
+
+    free(rows);
+    free(keys);
+    free(input);
+    free(work);
+}
+
+int main(int argc, char** argv) {
+    uint32_t max_threads = threadpool_default_threads();
+    int first = 1;
+    if (argc > 2 && strcmp(argv[1], "-t") == 0) {
+        max_threads = (uint32_t)atoi(argv[2]);
+        first = 3;
+    }
+    if (max_threads < 1) {
+        max_threads = 1;
+    }
+
+    setup_table();
+    printf("Parallel sort benchmark (%u CPUs online, threads up to %u)\n",
+           threadpool_default_threads(), max_threads);
+    if (first >= argc) {
+        bench_rows(1000000, max_threads);
+        bench_rows(10000000, max_threads);
+    }
+    for (int i = first; i < argc; i++) {
+        bench_rows((uint32_t)strtoul(argv[i], NULL, 10), max_threads);
+    }
+    return 0;
+}
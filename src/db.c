@@ -1718,15 +1718,15 @@ PrepareResult prepare_statement(InputBuffer* input_buffer,
     statement->has_offset = ps.has_offset;
     statement->offset = ps.offset;
 
-    if(ps.order_by[0]){
-      int ob_idx = schema_col_index(&table->active_schema,ps.order_by);
+    if(ps.order_count > 0){
+      int ob_idx = schema_col_index(&table->active_schema,ps.order_by[0]);
       if(ob_idx < 0){
-        printf("Unknown column in ORDER BY: %s\n", ps.order_by);
+        printf("Unknown column in ORDER BY: %s\n", ps.order_by[0]);
         parsed_stmt_free(&ps);
         return PREPARE_SYNTAX_ERROR;
       }
       statement->order_by_index = ob_idx;
-      statement->order_desc = ps.order_desc ? true : false;
+      statement->order_desc = ps.order_desc[0] ? true : false;
     } else {
       statement->order_by_index = -1;
       statement->order_desc = false;
@@ -0,0 +1,208 @@
+#include "../include/aggregate.h"
+#include "../include/schema.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char* agg_func_name(AggFunc f) {
+  switch (f) {
+    case AGG_COUNT: return "count";
+    case AGG_SUM: return "sum";
+    case AGG_MIN: return "min";
+    case AGG_MAX: return "max";
+    default: return "avg";
+  }
+}
+
+void agg_plan_init(AggPlan* p, Table* t, const AggSpec* specs, uint32_t n) {
+  memset(p, 0, sizeof(*p));
+  p->n = n > AGG_MAX_FUNCS ? AGG_MAX_FUNCS : n;
+  for (uint32_t i = 0; i < p->n; i++) {
+    const AggSpec* s = &specs[i];
+    p->specs[i] = *s;
+    p->widths[i] = 8;
+    if (s->col_idx < 0) {
+      strcpy(p->labels[i], "count(*)");
+    } else {
+      const ColumnDef* c = &t->active_schema.columns[s->col_idx];
+      p->types[i] = c->type;
+      p->col_offsets[i] = schema_col_offset(&t->active_schema, s->col_idx);
+      if (c->type == COL_TYPE_STRING && (s->func == AGG_MIN || s->func == AGG_MAX)) {
+        p->widths[i] = c->size;
+      }
+      snprintf(p->labels[i], AGG_LABEL_LEN, "%s(%s)", agg_func_name(s->func), c->name);
+    }
+    p->state_offsets[i] = p->state_size;
+    /* Row count, then the value, kept 8-byte aligned */
+    p->state_size += 8 + ((p->widths[i] + 7) & ~7u);
+  }
+}
+
+void agg_init(const AggPlan* p, uint8_t* state) {
+  memset(state, 0, p->state_size);
+}
+
+static int64_t agg_number(const AggPlan* p, uint32_t i, const uint8_t* row) {
+  const uint8_t* v = row + p->col_offsets[i];
+  if (p->types[i] == COL_TYPE_TIMESTAMP) {
+    int64_t x;
+    memcpy(&x, v, 8);
+    return x;
+  }
+  int32_t x;
+  memcpy(&x, v, 4);
+  return x;
+}
+
+void agg_add_rows(const AggPlan* p, uint8_t* state, uint32_t i, const void* row, uint64_t times) {
+  uint8_t* slot = state + p->state_offsets[i];
+  uint8_t* value = slot + 8;
+  uint64_t count;
+  memcpy(&count, slot, 8);
+
+  AggFunc f = p->specs[i].func;
+  if (f == AGG_SUM || f == AGG_AVG) {
+    int64_t sum;
+    memcpy(&sum, value, 8);
+    sum += agg_number(p, i, row) * (int64_t)times;
+    memcpy(value, &sum, 8);
+  } else if ((f == AGG_MIN || f == AGG_MAX) && p->types[i] == COL_TYPE_STRING) {
+    /* The slot holds the bytes up to the first NUL, zero-padded */
+    const char* s = (const char*)row + p->col_offsets[i];
+    uint32_t w = p->widths[i];
+    int cmp = count ? strncmp(s, (const char*)value, w) : 0;
+    if (!count || (f == AGG_MIN ? cmp < 0 : cmp > 0)) {
+      const char* nul = memchr(s, 0, w);
+      size_t len = nul ? (size_t)(nul - s) : w;
+      memcpy(value, s, len);
+      memset(value + len, 0, w - len);
+    }
+  } else if (f == AGG_MIN || f == AGG_MAX) {
+    int64_t x = agg_number(p, i, row);
+    int64_t cur;
+    memcpy(&cur, value, 8);
+    if (!count || (f == AGG_MIN ? x < cur : x > cur)) {
+      memcpy(value, &x, 8);
+    }
+  }
+
+  count += times;
+  memcpy(slot, &count, 8);
+}
+
+void agg_update(const AggPlan* p, uint8_t* state, const void* row) {
+  for (uint32_t i = 0; i < p->n; i++) {
+    agg_add_rows(p, state, i, row, 1);
+  }
+}
+
+void agg_value(const AggPlan* p, const uint8_t* state, uint32_t i, AggValue* out) {
+  const uint8_t* slot = state + p->state_offsets[i];
+  const uint8_t* value = slot + 8;
+  uint64_t count;
+  memcpy(&count, slot, 8);
+  memset(out, 0, sizeof(*out));
+
+  AggFunc f = p->specs[i].func;
+  if (f == AGG_COUNT) {
+    out->kind = AGG_VALUE_INT;
+    out->i = (int64_t)count;
+    return;
+  }
+  if (count == 0) {
+    out->kind = AGG_VALUE_NULL;
+    return;
+  }
+  if ((f == AGG_MIN || f == AGG_MAX) && p->types[i] == COL_TYPE_STRING) {
+    const char* nul = memchr(value, 0, p->widths[i]);
+    out->kind = AGG_VALUE_STRING;
+    out->str = (const char*)value;
+    out->len = nul ? (uint32_t)(nul - (const char*)value) : p->widths[i];
+    return;
+  }
+  int64_t x;
+  memcpy(&x, value, 8);
+  if (f == AGG_AVG) {
+    out->kind = AGG_VALUE_DOUBLE;
+    out->d = (double)x / (double)count;
+    return;
+  }
+  out->kind = AGG_VALUE_INT;
+  out->i = x;
+}
+
+void agg_plan_group_by(AggPlan* p, Table* t, const int* cols, uint32_t n) {
+  p->n_group = n > AGG_MAX_GROUP_COLS ? AGG_MAX_GROUP_COLS : n;
+  p->key_len = 0;
+  for (uint32_t g = 0; g < p->n_group; g++) {
+    const ColumnDef* c = &t->active_schema.columns[cols[g]];
+    p->group_cols[g] = cols[g];
+    p->group_types[g] = c->type;
+    p->group_col_offsets[g] = schema_col_offset(&t->active_schema, cols[g]);
+    switch (c->type) {
+      case COL_TYPE_INT:
+        p->group_widths[g] = 4;
+        break;
+      case COL_TYPE_TIMESTAMP:
+        p->group_widths[g] = 8;
+        break;
+      default:
+        p->group_widths[g] = c->size;
+        break;
+    }
+    p->group_key_offsets[g] = p->key_len;
+    p->key_len += p->group_widths[g];
+    snprintf(p->group_labels[g], MAX_COLUMN_NAME_LEN, "%s", c->name);
+  }
+}
+
+void agg_group_key(const AggPlan* p, const void* row, uint8_t* key) {
+  const uint8_t* src = (const uint8_t*)row;
+  for (uint32_t g = 0; g < p->n_group; g++) {
+    const uint8_t* v = src + p->group_col_offsets[g];
+    uint32_t w = p->group_widths[g];
+    uint32_t len = w;
+    if (p->group_types[g] == COL_TYPE_STRING) {
+      /* Bytes past the NUL are not part of the value */
+      const uint8_t* nul = memchr(v, 0, w);
+      len = nul ? (uint32_t)(nul - v) : w;
+    }
+    memcpy(key, v, len);
+    memset(key + len, 0, w - len);
+    key += w;
+  }
+}
+
+void agg_group_value(const AggPlan* p, const uint8_t* key, uint32_t g, AggValue* out) {
+  const uint8_t* v = key + p->group_key_offsets[g];
+  memset(out, 0, sizeof(*out));
+  switch (p->group_types[g]) {
+    case COL_TYPE_INT: {
+      int32_t x;
+      memcpy(&x, v, 4);
+      out->kind = AGG_VALUE_INT;
+      out->i = x;
+      break;
+    }
+    case COL_TYPE_TIMESTAMP:
+      out->kind = AGG_VALUE_INT;
+      memcpy(&out->i, v, 8);
+      break;
+    default: {
+      const uint8_t* nul = memchr(v, 0, p->group_widths[g]);
+      out->kind = AGG_VALUE_STRING;
+      out->str = (const char*)v;
+      out->len = nul ? (uint32_t)(nul - v) : p->group_widths[g];
+      break;
+    }
+  }
+}
+
+const char* agg_output_value(const AggPlan* p, AggOutput o, const uint8_t* key,
+                             const uint8_t* state, AggValue* out) {
+  if (o.group) {
+    agg_group_value(p, key, o.index, out);
+    return p->group_labels[o.index];
+  }
+  agg_value(p, state, o.index, out);
+  return p->labels[o.index];
+}
@@ -0,0 +1,493 @@
+#include "../include/analyze.h"
+#include "../include/catalog.h"
+#include "../include/util.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Selectivities assumed where the statistics say nothing */
+#define ESTIMATE_EQ_SEL 0.005
+#define ESTIMATE_INEQ_SEL (1.0 / 3)
+#define ESTIMATE_RANGE_SEL 0.05
+#define ESTIMATE_MATCH_SEL 0.5
+
+/* Leaves hold this share of their cells on average when never analyzed:
+ * splits leave both halves about half full */
+#define ESTIMATE_LEAF_FILL 0.6
+
+_Static_assert(sizeof(TableStats) <= MYDB_PAGE_SIZE, "table statistics must fit one page");
+
+/* splitmix64: finalizer for value hashes, and the sampling generator */
+static uint64_t mix64(uint64_t z) {
+  z += 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+/* Catalog extension of the active table, or NULL */
+static CatalogTableExt* analyze_table_ext(Table* t) {
+  if (t->root_page_num == INVALID_PAGE_NUM) {
+    return NULL;
+  }
+  int idx = catalog_find_by_root(t->pager, t->root_page_num);
+  return idx < 0 ? NULL : catalog_table_ext(t->pager, idx);
+}
+
+/* Leaf at the left or right edge of the tree; sets the levels walked */
+static uint32_t tree_edge_leaf(Table* t, bool rightmost, uint32_t* height) {
+  uint32_t page_num = t->root_page_num;
+  void* node = get_page(t->pager, page_num);
+  uint32_t levels = 1;
+  while (get_node_type(node) == NODE_INTERNAL && levels < BTREE_MAX_HEIGHT) {
+    uint32_t num_keys = *internal_node_num_keys(node);
+    page_num = (rightmost || num_keys == 0) ? *internal_node_right_child(node)
+                                            : *internal_node_cell(node, 0);
+    if (page_num == INVALID_PAGE_NUM) {
+      break;
+    }
+    node = get_page(t->pager, page_num);
+    levels++;
+  }
+  *height = levels;
+  return page_num;
+}
+
+/* K minimum values: the smallest distinct hashes seen, sorted. Fewer
+ * than K means every distinct value was kept. */
+typedef struct {
+  uint64_t* h;
+  uint32_t n;
+} MinHashes;
+
+static void min_hashes_add(MinHashes* m, uint64_t h) {
+  if (m->n == ANALYZE_DISTINCT_HASHES && h >= m->h[m->n - 1]) {
+    return;
+  }
+  uint32_t lo = 0;
+  uint32_t hi = m->n;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (m->h[mid] < h) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo < m->n && m->h[lo] == h) {
+    return;
+  }
+  uint32_t keep = m->n == ANALYZE_DISTINCT_HASHES ? m->n - 1 : m->n;
+  memmove(&m->h[lo + 1], &m->h[lo], (keep - lo) * sizeof(uint64_t));
+  m->h[lo] = h;
+  m->n = keep + 1;
+}
+
+static uint32_t min_hashes_estimate(const MinHashes* m, uint32_t rows) {
+  if (m->n < ANALYZE_DISTINCT_HASHES) {
+    return m->n;
+  }
+  /* The K-th smallest of d uniform hashes sits near K / d of the range */
+  double kth = (double)m->h[m->n - 1] / 18446744073709551616.0;
+  double d = kth > 0 ? (ANALYZE_DISTINCT_HASHES - 1) / kth : rows;
+  return d > rows ? rows : (uint32_t)d;
+}
+
+static int cmp_i64(const void* a, const void* b) {
+  int64_t x = *(const int64_t*)a;
+  int64_t y = *(const int64_t*)b;
+  return (x > y) - (x < y);
+}
+
+/* Per-column state while scanning */
+typedef struct {
+  MinHashes distinct;
+  int hist;               /* Histogram slot, -1 = none */
+  int64_t min;
+  int64_t max;
+} ColumnScan;
+
+static int64_t column_number(const ColumnDef* c, const uint8_t* field) {
+  if (c->type == COL_TYPE_TIMESTAMP) {
+    int64_t v;
+    memcpy(&v, field, 8);
+    return v;
+  }
+  int32_t v;
+  memcpy(&v, field, 4);
+  return v;
+}
+
+/* One pass over the leaf chain: row and leaf counts, a distinct estimate
+ * per column and a reservoir sample of each histogram column */
+static bool analyze_collect(Table* t, TableStats* out) {
+  const TableSchema* s = &t->active_schema;
+  uint32_t ncols = s->num_columns;
+  ColumnScan* cols = calloc(ncols, sizeof(ColumnScan));
+  uint64_t* hashes = malloc((size_t)ncols * ANALYZE_DISTINCT_HASHES * sizeof(uint64_t));
+  int64_t* samples = NULL;
+  uint32_t offsets[MAX_COLUMNS];
+  uint32_t nhist = 0;
+  bool ok = cols && hashes;
+
+  for (uint32_t c = 0; ok && c < ncols; c++) {
+    cols[c].distinct.h = hashes + (size_t)c * ANALYZE_DISTINCT_HASHES;
+    cols[c].hist = -1;
+    offsets[c] = schema_col_offset(s, (int)c);
+    ColumType type = s->columns[c].type;
+    if ((type == COL_TYPE_INT || type == COL_TYPE_TIMESTAMP) && nhist < ANALYZE_MAX_HISTOGRAMS) {
+      out->histograms[nhist].col = c;
+      cols[c].hist = (int)nhist++;
+    }
+  }
+  if (ok && nhist > 0) {
+    samples = malloc((size_t)nhist * ANALYZE_SAMPLE_ROWS * sizeof(int64_t));
+    ok = samples != NULL;
+  }
+  if (!ok) {
+    free(cols);
+    free(hashes);
+    return false;
+  }
+
+  uint64_t rng = 0x5EED;
+  uint32_t rows = 0;
+  uint32_t leaves = 0;
+  /* From the leftmost leaf, so empty leaves are counted too */
+  uint32_t height = 0;
+  uint32_t leaf = tree_edge_leaf(t, false, &height);
+  while (leaf != 0 && leaf != INVALID_PAGE_NUM) {
+    void* node = get_page(t->pager, leaf);
+    uint32_t num_cells = *leaf_node_num_cells(node);
+    leaves++;
+    for (uint32_t i = 0; i < num_cells; i++) {
+      const uint8_t* row = leaf_value_t(t, node, i);
+      /* Reservoir sampling: the first rows fill it, row r replaces a
+       * random slot with probability size / (r + 1) */
+      uint32_t slot = rows;
+      if (rows >= ANALYZE_SAMPLE_ROWS) {
+        rng = mix64(rng);
+        slot = (uint32_t)(rng % ((uint64_t)rows + 1));
+      }
+      for (uint32_t c = 0; c < ncols; c++) {
+        const ColumnDef* def = &s->columns[c];
+        const uint8_t* field = row + offsets[c];
+        if (def->type == COL_TYPE_STRING) {
+          size_t len = strnlen((const char*)field, def->size);
+          min_hashes_add(&cols[c].distinct, mix64(hash_bytes(field, len)));
+          continue;
+        }
+        int64_t v = column_number(def, field);
+        min_hashes_add(&cols[c].distinct, mix64((uint64_t)v));
+        if (rows == 0 || v < cols[c].min) cols[c].min = v;
+        if (rows == 0 || v > cols[c].max) cols[c].max = v;
+        if (cols[c].hist >= 0 && slot < ANALYZE_SAMPLE_ROWS) {
+          samples[(size_t)cols[c].hist * ANALYZE_SAMPLE_ROWS + slot] = v;
+        }
+      }
+      rows++;
+    }
+    leaf = *leaf_node_next_leaf(node);
+  }
+
+  out->row_count = rows;
+  out->leaf_count = leaves;
+  out->height = height;
+  out->num_columns = ncols;
+  out->num_histograms = nhist;
+  uint32_t sampled = rows < ANALYZE_SAMPLE_ROWS ? rows : ANALYZE_SAMPLE_ROWS;
+  for (uint32_t c = 0; c < ncols; c++) {
+    out->distinct[c] = min_hashes_estimate(&cols[c].distinct, rows);
+    if (cols[c].hist < 0) {
+      continue;
+    }
+    ColumnHistogram* h = &out->histograms[cols[c].hist];
+    int64_t* sample = samples + (size_t)cols[c].hist * ANALYZE_SAMPLE_ROWS;
+    if (sampled == 0) {
+      h->buckets = 0;
+      continue;
+    }
+    qsort(sample, sampled, sizeof(int64_t), cmp_i64);
+    h->buckets = ANALYZE_HISTOGRAM_BUCKETS;
+    for (uint32_t b = 0; b <= ANALYZE_HISTOGRAM_BUCKETS; b++) {
+      h->bounds[b] = sample[(uint64_t)b * (sampled - 1) / ANALYZE_HISTOGRAM_BUCKETS];
+    }
+    /* The ends are exact even when sampled */
+    h->bounds[0] = cols[c].min;
+    h->bounds[ANALYZE_HISTOGRAM_BUCKETS] = cols[c].max;
+  }
+
+  free(samples);
+  free(hashes);
+  free(cols);
+  return true;
+}
+
+int analyze_table(Table* t) {
+  CatalogTableExt* ext = analyze_table_ext(t);
+  if (!ext) {
+    return -1;
+  }
+  TableStats* stats = calloc(1, sizeof(TableStats));
+  if (!stats || !analyze_collect(t, stats)) {
+    free(stats);
+    return -1;
+  }
+
+  uint32_t page_num = ext->stats_page;
+  if (page_num == 0) {
+    page_num = get_unused_page_num(t->pager);
+    if (page_num >= TABLE_MAX_PAGES) {
+      free(stats);
+      return -1;
+    }
+  }
+  void* page = get_page(t->pager, page_num);
+  memset(page, 0, MYDB_PAGE_SIZE);
+  memcpy(page, stats, sizeof(TableStats));
+  free(stats);
+  ext->stats_page = page_num;
+
+  /* Written through, as bloom_enable does */
+  pager_flush(t->pager, page_num);
+  pager_flush(t->pager, 0);
+  return 0;
+}
+
+const TableStats* analyze_stats(Table* t) {
+  CatalogTableExt* ext = analyze_table_ext(t);
+  if (!ext || ext->stats_page == 0) {
+    return NULL;
+  }
+  const TableStats* s = get_page(t->pager, ext->stats_page);
+  return s->num_columns == t->active_schema.num_columns ? s : NULL;
+}
+
+const ColumnHistogram* analyze_histogram(const TableStats* s, int col) {
+  if (!s) {
+    return NULL;
+  }
+  for (uint32_t i = 0; i < s->num_histograms && i < ANALYZE_MAX_HISTOGRAMS; i++) {
+    if ((int)s->histograms[i].col == col) {
+      return s->histograms[i].buckets > 0 ? &s->histograms[i] : NULL;
+    }
+  }
+  return NULL;
+}
+
+void table_estimate(Table* t, TableEstimate* out) {
+  memset(out, 0, sizeof(*out));
+  out->rows = table_row_count(t);
+  out->stats = analyze_stats(t);
+  if (out->stats && out->stats->row_count > 0) {
+    const TableStats* s = out->stats;
+    out->leaves = (double)s->leaf_count * out->rows / s->row_count;
+    out->height = s->height;
+  } else {
+    tree_edge_leaf(t, false, &out->height);
+    out->leaves = out->rows / (leaf_max_cells(t) * ESTIMATE_LEAF_FILL);
+  }
+  if (out->leaves < 1) {
+    out->leaves = 1;
+  }
+
+  /* Without a histogram the int primary key is taken as spread evenly
+   * between its smallest and largest key */
+  if (out->rows > 0 && t->active_schema.columns[0].type == COL_TYPE_INT &&
+      !analyze_histogram(out->stats, 0)) {
+    Cursor* first = table_start(t);
+    uint32_t height = 0;
+    void* last = get_page(t->pager, tree_edge_leaf(t, true, &height));
+    uint32_t num_cells = *leaf_node_num_cells(last);
+    if (!first->end_of_table && num_cells > 0) {
+      int32_t lo = (int32_t)*leaf_key_t(t, get_page(t->pager, first->page_num), first->cell_num);
+      int32_t hi = (int32_t)*leaf_key_t(t, last, num_cells - 1);
+      /* Keys order as unsigned: negative keys would sit past the others */
+      if (lo >= 0 && hi >= lo) {
+        out->pk_bounds = true;
+        out->pk_min = lo;
+        out->pk_max = hi;
+      }
+    }
+    free(first);
+  }
+}
+
+/* Fraction of the rows below `v` */
+static double histogram_below(const ColumnHistogram* h, int64_t v) {
+  const int64_t* b = h->bounds;
+  if (v <= b[0]) {
+    return 0;
+  }
+  if (v > b[h->buckets]) {
+    return 1;
+  }
+  uint32_t i = 0;
+  while (v > b[i + 1]) {
+    i++;
+  }
+  /* b[i] < v <= b[i + 1]: interpolate within the bucket */
+  return (i + ((double)v - (double)b[i]) / ((double)b[i + 1] - (double)b[i])) / h->buckets;
+}
+
+double estimate_range_fraction(const TableEstimate* est, int col, int64_t lo, int64_t hi) {
+  if (lo > hi) {
+    return 0;
+  }
+  const ColumnHistogram* h = analyze_histogram(est->stats, col);
+  if (h) {
+    double above = hi == INT64_MAX ? 1 : histogram_below(h, hi + 1);
+    return above - histogram_below(h, lo);
+  }
+  if (col == 0 && est->pk_bounds) {
+    double from = lo > est->pk_min ? (double)lo : (double)est->pk_min;
+    double to = hi < est->pk_max ? (double)hi : (double)est->pk_max;
+    return to < from ? 0 : (to - from + 1) / ((double)est->pk_max - (double)est->pk_min + 1);
+  }
+  if (lo == INT64_MIN || hi == INT64_MAX) {
+    return ESTIMATE_INEQ_SEL;
+  }
+  return ESTIMATE_RANGE_SEL;
+}
+
+/* Fraction of the rows equal to one value of column `col` */
+static double estimate_eq(Table* t, const TableEstimate* est, int col, bool numeric, int64_t v) {
+  double eq = ESTIMATE_EQ_SEL;
+  if (col == 0 && t->active_schema.columns[0].type == COL_TYPE_INT && est->rows > 0) {
+    /* The primary key is unique */
+    eq = 1 / est->rows;
+  } else if (est->stats && est->stats->distinct[col] > 0) {
+    eq = 1.0 / est->stats->distinct[col];
+  }
+  const ColumnHistogram* h = numeric ? analyze_histogram(est->stats, col) : NULL;
+  if (h) {
+    double slice = estimate_range_fraction(est, col, v, v);
+    if (v < h->bounds[0] || v > h->bounds[h->buckets]) {
+      return 0;
+    }
+    return slice > eq ? slice : eq;
+  }
+  return eq;
+}
+
+static bool is_numeric_column(Table* t, int col) {
+  ColumType type = t->active_schema.columns[col].type;
+  return type == COL_TYPE_INT || type == COL_TYPE_TIMESTAMP;
+}
+
+/* A literal compared with a numeric column; non-numbers compare as 0 */
+static int64_t literal_number(const Expr* e) {
+  int64_t v = 0;
+  if (parse_int64(e->text, &v) != 0) {
+    v = 0;
+  }
+  return v;
+}
+
+/* Column index of `e` when it names one, else -1 */
+static int expr_column(Table* t, const Expr* e) {
+  return e && e->kind == EXPR_COLUMN ? schema_col_index(&t->active_schema, e->text) : -1;
+}
+
+static double estimate_comparison(Table* t, const TableEstimate* est, const Expr* e) {
+  const char* op = e->op;
+  const Expr* lit = e->right;
+  int col = expr_column(t, e->left);
+  bool flipped = false;
+  if (col < 0) {
+    col = expr_column(t, e->right);
+    lit = e->left;
+    flipped = true;
+  }
+  if (col < 0 || !lit || lit->kind != EXPR_LITERAL) {
+    return ESTIMATE_MATCH_SEL;
+  }
+  bool numeric = is_numeric_column(t, col);
+  int64_t v = numeric ? literal_number(lit) : 0;
+
+  if (strcmp(op, "=") == 0) {
+    return estimate_eq(t, est, col, numeric, v);
+  }
+  if (strcmp(op, "!=") == 0) {
+    return 1 - estimate_eq(t, est, col, numeric, v);
+  }
+  if (!numeric) {
+    return ESTIMATE_INEQ_SEL;
+  }
+  /* `lit < col` reads as `col > lit` */
+  if (flipped) {
+    if (strcmp(op, "<") == 0) op = ">";
+    else if (strcmp(op, "<=") == 0) op = ">=";
+    else if (strcmp(op, ">") == 0) op = "<";
+    else if (strcmp(op, ">=") == 0) op = "<=";
+  }
+  if (strcmp(op, "<") == 0) {
+    return v == INT64_MIN ? 0 : estimate_range_fraction(est, col, INT64_MIN, v - 1);
+  }
+  if (strcmp(op, "<=") == 0) {
+    return estimate_range_fraction(est, col, INT64_MIN, v);
+  }
+  if (strcmp(op, ">") == 0) {
+    return v == INT64_MAX ? 0 : estimate_range_fraction(est, col, v + 1, INT64_MAX);
+  }
+  if (strcmp(op, ">=") == 0) {
+    return estimate_range_fraction(est, col, v, INT64_MAX);
+  }
+  return ESTIMATE_MATCH_SEL;
+}
+
+double estimate_selectivity(Table* t, const TableEstimate* est, const Expr* e) {
+  if (!e) {
+    return 1;
+  }
+  double sel = ESTIMATE_MATCH_SEL;
+  switch (e->kind) {
+    case EXPR_BINARY:
+      if (strcmp(e->op, "AND") == 0) {
+        /* Conditions taken as independent */
+        sel = estimate_selectivity(t, est, e->left) * estimate_selectivity(t, est, e->right);
+      } else if (strcmp(e->op, "OR") == 0) {
+        double l = estimate_selectivity(t, est, e->left);
+        double r = estimate_selectivity(t, est, e->right);
+        sel = l + r - l * r;
+      } else {
+        sel = estimate_comparison(t, est, e);
+      }
+      break;
+    case EXPR_UNARY:
+      if (strcmp(e->op, "NOT") == 0) {
+        sel = 1 - estimate_selectivity(t, est, e->left);
+      }
+      break;
+    case EXPR_IN: {
+      int col = expr_column(t, e->left);
+      if (col >= 0) {
+        sel = 0;
+        bool numeric = is_numeric_column(t, col);
+        for (uint32_t i = 0; i < e->n_items; i++) {
+          sel += estimate_eq(t, est, col, numeric, numeric ? literal_number(e->items[i]) : 0);
+        }
+      }
+      break;
+    }
+    case EXPR_BETWEEN: {
+      int col = expr_column(t, e->left);
+      if (col >= 0 && e->right && e->right->left && e->right->right) {
+        sel = is_numeric_column(t, col)
+                  ? estimate_range_fraction(est, col, literal_number(e->right->left),
+                                            literal_number(e->right->right))
+                  : ESTIMATE_RANGE_SEL;
+      }
+      break;
+    }
+    case EXPR_ISNULL:
+      /* Values are never NULL */
+      sel = 0;
+      break;
+    default:
+      break;
+  }
+  if (sel < 0) {
+    return 0;
+  }
+  return sel > 1 ? 1 : sel;
+}
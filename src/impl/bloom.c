@@ -0,0 +1,137 @@
+#include "../include/bloom.h"
+#include "../include/catalog.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* splitmix64 finalizer: spreads sequential keys over the whole word */
+static uint64_t bloom_mix(uint32_t key) {
+  uint64_t z = (uint64_t)key + 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+/* Double hashing: bit i = h1 + i * h2 (h2 odd, table size a power of two) */
+void bloom_add(void* filter, uint32_t num_hashes, uint32_t key) {
+  uint8_t* bits = (uint8_t*)filter;
+  uint64_t h = bloom_mix(key);
+  uint32_t h1 = (uint32_t)h;
+  uint32_t h2 = (uint32_t)(h >> 32) | 1;
+  for (uint32_t i = 0; i < num_hashes; i++) {
+    uint32_t bit = (h1 + i * h2) & (BLOOM_NUM_BITS - 1);
+    bits[bit >> 3] |= (uint8_t)(1u << (bit & 7));
+  }
+}
+
+bool bloom_may_contain(const void* filter, uint32_t num_hashes, uint32_t key) {
+  const uint8_t* bits = (const uint8_t*)filter;
+  uint64_t h = bloom_mix(key);
+  uint32_t h1 = (uint32_t)h;
+  uint32_t h2 = (uint32_t)(h >> 32) | 1;
+  for (uint32_t i = 0; i < num_hashes; i++) {
+    uint32_t bit = (h1 + i * h2) & (BLOOM_NUM_BITS - 1);
+    if (!(bits[bit >> 3] & (1u << (bit & 7)))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Catalog extension of the active table, or NULL */
+static CatalogTableExt* bloom_table_ext(Table* t, int* out_idx) {
+  if (t->root_page_num == INVALID_PAGE_NUM) {
+    return NULL;
+  }
+  int idx = catalog_find_by_root(t->pager, t->root_page_num);
+  if (idx < 0) {
+    return NULL;
+  }
+  if (out_idx) {
+    *out_idx = idx;
+  }
+  return catalog_table_ext(t->pager, idx);
+}
+
+/* (Re)build the filter from every key in the tree. Rebuilding also drops
+ * keys that were deleted since the last build. */
+int bloom_enable(Table* t) {
+  int idx = -1;
+  CatalogTableExt* ext = bloom_table_ext(t, &idx);
+  if (!ext) {
+    return -1;
+  }
+
+  uint32_t page_num = ext->bloom_page;
+  if (page_num == 0) {
+    page_num = get_unused_page_num(t->pager);
+    if (page_num >= TABLE_MAX_PAGES) {
+      return -1;
+    }
+  }
+  void* filter = get_page(t->pager, page_num);
+  memset(filter, 0, MYDB_PAGE_SIZE);
+
+  uint32_t keys = 0;
+  Cursor* cursor = table_start(t);
+  uint32_t leaf = cursor->end_of_table ? 0 : cursor->page_num;
+  free(cursor);
+  while (leaf != 0) {
+    void* node = get_page(t->pager, leaf);
+    uint32_t num_cells = *leaf_node_num_cells(node);
+    for (uint32_t i = 0; i < num_cells; i++) {
+      bloom_add(filter, BLOOM_NUM_HASHES, *leaf_key_t(t, node, i));
+      keys++;
+    }
+    leaf = *leaf_node_next_leaf(node);
+  }
+
+  ext->bloom_page = page_num;
+  ext->bloom_hashes = BLOOM_NUM_HASHES;
+  ext->bloom_keys = keys;
+  memset(&t->stats.bloom[idx], 0, sizeof(BloomStats));
+
+  /* Write through so the page is part of the file before any other pager
+   * instance (schema persistence) allocates pages at the end of it. */
+  pager_flush(t->pager, page_num);
+  pager_flush(t->pager, 0);
+  return 0;
+}
+
+bool bloom_table_enabled(Table* t) {
+  CatalogTableExt* ext = bloom_table_ext(t, NULL);
+  return ext && ext->bloom_page != 0;
+}
+
+bool bloom_table_may_contain(Table* t, uint32_t key) {
+  int idx = -1;
+  CatalogTableExt* ext = bloom_table_ext(t, &idx);
+  if (!ext || ext->bloom_page == 0) {
+    return true;
+  }
+  BloomStats* bs = &t->stats.bloom[idx];
+  bs->probes++;
+  if (!bloom_may_contain(get_page(t->pager, ext->bloom_page), ext->bloom_hashes, key)) {
+    bs->negatives++;
+    return false;
+  }
+  return true;
+}
+
+void bloom_table_note_insert(Table* t, uint32_t key) {
+  CatalogTableExt* ext = bloom_table_ext(t, NULL);
+  if (!ext || ext->bloom_page == 0) {
+    return;
+  }
+  bloom_add(get_page(t->pager, ext->bloom_page), ext->bloom_hashes, key);
+  ext->bloom_keys++;
+}
+
+/* A lookup that passed the filter found nothing */
+void bloom_table_note_miss(Table* t) {
+  int idx = -1;
+  CatalogTableExt* ext = bloom_table_ext(t, &idx);
+  if (!ext || ext->bloom_page == 0) {
+    return;
+  }
+  t->stats.bloom[idx].false_positives++;
+}
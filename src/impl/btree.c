@@ -1,6 +1,9 @@
 #include "../include/btree.h"
 #include "../include/catalog.h"
 #include "../include/util.h"
+#include "../include/zonemap.h"
+#include "../include/extsort.h"
+#include "../include/threadpool.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -34,6 +37,14 @@ const uint32_t INTERNAL_NODE_CELL_SIZE =
     INTERNAL_NODE_CHILD_SIZE + INTERNAL_NODE_KEY_SIZE;
 const uint32_t INTERNAL_NODE_MAX_KEYS = 3;
 
+/* Internal node subtree row counts: a magic word followed by one count per
+ * cell and one for the right child, stored after the cell array. Pages
+ * without the magic word (older files, restructured nodes) are recounted
+ * from their children on first use. */
+const uint32_t INTERNAL_NODE_COUNTS_MAGIC = 0x53434E54; /* "TNCS" */
+const uint32_t INTERNAL_NODE_COUNTS_OFFSET =
+    INTERNAL_NODE_HEADER_SIZE + INTERNAL_NODE_MAX_KEYS * INTERNAL_NODE_CELL_SIZE;
+
 /* Leaf node layout */
 const uint32_t LEAF_NODE_NUM_CELLS_SIZE = sizeof(uint32_t);
 const uint32_t LEAF_NODE_NUM_CELLS_OFFSET = COMMON_NODE_HEADER_SIZE;
@@ -113,6 +124,90 @@ void initialize_internal_node(void* node) {
   set_node_root(node, false);
   *internal_node_num_keys(node) = 0;
   *internal_node_right_child(node) = INVALID_PAGE_NUM;
+  internal_node_invalidate_counts(node);
+}
+
+/* Subtree counts */
+static uint32_t* internal_node_counts_magic(void* node) {
+  return node + INTERNAL_NODE_COUNTS_OFFSET;
+}
+
+uint32_t* internal_node_child_count(void* node, uint32_t child_num) {
+  /* The right child keeps the last slot so shifting cells never moves it */
+  if (child_num >= *internal_node_num_keys(node)) {
+    child_num = INTERNAL_NODE_MAX_KEYS;
+  }
+  return node + INTERNAL_NODE_COUNTS_OFFSET + sizeof(uint32_t) + child_num * sizeof(uint32_t);
+}
+
+bool internal_node_counts_valid(void* node) {
+  return *internal_node_counts_magic(node) == INTERNAL_NODE_COUNTS_MAGIC;
+}
+
+void internal_node_invalidate_counts(void* node) {
+  *internal_node_counts_magic(node) = 0;
+}
+
+/* Recount every child of an internal node (recursing into stale children) */
+void internal_node_refresh_counts(Table* table, uint32_t page_num) {
+  void* node = get_page(table->pager, page_num);
+  uint32_t num_keys = *internal_node_num_keys(node);
+  for (uint32_t i = 0; i <= num_keys; i++) {
+    uint32_t child = (i == num_keys) ? *internal_node_right_child(node)
+                                     : *internal_node_cell(node, i);
+    uint32_t count = 0;
+    if (child != INVALID_PAGE_NUM) {
+      count = subtree_row_count(table, child);
+    }
+    *internal_node_child_count(node, i) = count;
+  }
+  *internal_node_counts_magic(node) = INTERNAL_NODE_COUNTS_MAGIC;
+}
+
+uint32_t subtree_row_count(Table* table, uint32_t page_num) {
+  void* node = get_page(table->pager, page_num);
+  if (get_node_type(node) == NODE_LEAF) {
+    return *leaf_node_num_cells(node);
+  }
+  if (!internal_node_counts_valid(node)) {
+    internal_node_refresh_counts(table, page_num);
+  }
+  uint32_t num_keys = *internal_node_num_keys(node);
+  uint32_t total = 0;
+  for (uint32_t i = 0; i <= num_keys; i++) {
+    total += *internal_node_child_count(node, i);
+  }
+  return total;
+}
+
+/* Recount the internal nodes on the root-to-leaf path of `key`, bottom up.
+ * Called after a row under that path was inserted or removed; nodes off the
+ * path that were restructured are already invalid and get recounted when
+ * their parent on the path asks for them. */
+void btree_refresh_counts(Table* table, uint32_t key) {
+  uint32_t path[BTREE_MAX_HEIGHT];
+  uint32_t depth = 0;
+  uint32_t page_num = table->root_page_num;
+  void* node = get_page(table->pager, page_num);
+  while (get_node_type(node) == NODE_INTERNAL && depth < BTREE_MAX_HEIGHT) {
+    path[depth++] = page_num;
+    uint32_t num_keys = *internal_node_num_keys(node);
+    uint32_t index = internal_node_find_child(node, key);
+    page_num = (index == num_keys) ? *internal_node_right_child(node)
+                                   : *internal_node_cell(node, index);
+    if (page_num == INVALID_PAGE_NUM) {
+      break;
+    }
+    node = get_page(table->pager, page_num);
+  }
+  while (depth > 0) {
+    internal_node_refresh_counts(table, path[--depth]);
+  }
+}
+
+/* Number of rows in the active table */
+uint32_t table_row_count(Table* table) {
+  return subtree_row_count(table, table->root_page_num);
 }
 
 uint32_t internal_node_find_child(void* node, uint32_t key) {
@@ -344,6 +439,209 @@ void cursor_advance(Cursor* cursor) {
   }
 }
 
+/* Resolve the keys under one node; `keys` is sorted and distinct */
+static uint32_t batch_find_node(Table* table, uint32_t page_num, const uint32_t* keys,
+                                uint32_t n, BatchRowHandler found, void* ctx) {
+  void* node = get_page(table->pager, page_num);
+  uint32_t hits = 0;
+
+  if (get_node_type(node) == NODE_LEAF) {
+    /* Keys ascend, so each search starts where the previous one ended */
+    uint32_t num_cells = *leaf_node_num_cells(node);
+    uint32_t pos = 0;
+    for (uint32_t j = 0; j < n && pos < num_cells; j++) {
+      uint32_t lo = pos;
+      uint32_t hi = num_cells;
+      while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (*leaf_key_t(table, node, mid) < keys[j]) {
+          lo = mid + 1;
+        } else {
+          hi = mid;
+        }
+      }
+      pos = lo;
+      if (pos < num_cells && *leaf_key_t(table, node, pos) == keys[j]) {
+        if (found) {
+          found(table, keys[j], leaf_value_t(table, node, pos), ctx);
+        }
+        hits++;
+        pos++;
+      }
+    }
+    return hits;
+  }
+
+  /* Hand each child the run of keys its separator routes to it */
+  uint32_t num_keys = *internal_node_num_keys(node);
+  uint32_t j = 0;
+  for (uint32_t i = 0; i <= num_keys && j < n; i++) {
+    uint32_t end = n;
+    uint32_t child = *internal_node_right_child(node);
+    if (i < num_keys) {
+      uint32_t separator = *internal_node_key(node, i);
+      end = j;
+      while (end < n && keys[end] <= separator) {
+        end++;
+      }
+      child = *internal_node_cell(node, i);
+    }
+    if (end > j && child != INVALID_PAGE_NUM) {
+      hits += batch_find_node(table, child, keys + j, end - j, found, ctx);
+    }
+    j = end;
+  }
+  return hits;
+}
+
+/* Look up many keys in one ordered pass: every node on the way is visited
+ * once for all keys below it instead of once per key. `keys` must be sorted
+ * and distinct. Calls `found` in key order; returns the number of hits. */
+uint32_t table_find_batch(Table* table, const uint32_t* keys, uint32_t n,
+                          BatchRowHandler found, void* ctx) {
+  if (n == 0 || table->root_page_num == INVALID_PAGE_NUM) {
+    return 0;
+  }
+  return batch_find_node(table, table->root_page_num, keys, n, found, ctx);
+}
+
+/* Position a cursor on the n-th row (0-based) in key order, descending by
+ * subtree counts instead of walking the leaves before it. */
+void leaf_walk_init(LeafWalk* w, Table* t, uint32_t page_num) {
+  w->table = t;
+  w->pending = page_num;
+  w->depth = 0;
+  w->seeking = false;
+  w->lo = 0;
+  w->hi = UINT32_MAX;
+}
+
+void leaf_walk_range(LeafWalk* w, Table* t, uint32_t lo, uint32_t hi) {
+  leaf_walk_init(w, t, lo > hi ? INVALID_PAGE_NUM : t->root_page_num);
+  w->seeking = true;
+  w->lo = lo;
+  w->hi = hi;
+}
+
+uint32_t leaf_walk_next(LeafWalk* w, LeafMayMatchFn may_match, const void* ctx, void** node) {
+  for (;;) {
+    uint32_t page_num = w->pending;
+    w->pending = INVALID_PAGE_NUM;
+    if (page_num == INVALID_PAGE_NUM) {
+      if (w->depth == 0) {
+        return INVALID_PAGE_NUM;
+      }
+      void* parent = w->path[w->depth - 1];
+      uint32_t i = w->next_child[w->depth - 1]++;
+      uint32_t num_keys = *internal_node_num_keys(parent);
+      if (i > num_keys) {
+        w->depth--;
+        zonemap_note_subtree(w->table, w->path_page[w->depth], parent);
+        continue;
+      }
+      /* Child i holds keys above the parent's key i - 1 */
+      if (i > 0 && *internal_node_key(parent, i - 1) >= w->hi) {
+        w->depth = 0;
+        return INVALID_PAGE_NUM;
+      }
+      page_num = *internal_node_child(parent, i);
+    }
+
+    if (may_match && !may_match(w->table, page_num, ctx)) {
+      w->seeking = false;
+      continue;
+    }
+    void* page = get_page(w->table->pager, page_num);
+    if (get_node_type(page) == NODE_LEAF) {
+      w->seeking = false;
+      *node = page;
+      return page_num;
+    }
+    if (w->depth == BTREE_MAX_HEIGHT) {
+      return INVALID_PAGE_NUM;
+    }
+    w->path[w->depth] = page;
+    w->path_page[w->depth] = page_num;
+    w->next_child[w->depth] = w->seeking ? internal_node_find_child(page, w->lo) : 0;
+    w->depth++;
+  }
+}
+
+Cursor* table_seek_nth(Table* table, uint32_t n) {
+  Cursor* cursor = malloc(sizeof(Cursor));
+  cursor->table = table;
+  cursor->page_num = table->root_page_num;
+  cursor->cell_num = 0;
+  cursor->end_of_table = true;
+
+  uint32_t page_num = table->root_page_num;
+  for (;;) {
+    void* node = get_page(table->pager, page_num);
+    if (get_node_type(node) == NODE_LEAF) {
+      if (n < *leaf_node_num_cells(node)) {
+        cursor->page_num = page_num;
+        cursor->cell_num = n;
+        cursor->end_of_table = false;
+      }
+      return cursor;
+    }
+    if (!internal_node_counts_valid(node)) {
+      internal_node_refresh_counts(table, page_num);
+    }
+    uint32_t num_keys = *internal_node_num_keys(node);
+    uint32_t next = INVALID_PAGE_NUM;
+    for (uint32_t i = 0; i <= num_keys; i++) {
+      uint32_t count = *internal_node_child_count(node, i);
+      if (n < count) {
+        next = (i == num_keys) ? *internal_node_right_child(node)
+                               : *internal_node_cell(node, i);
+        break;
+      }
+      n -= count;
+    }
+    if (next == INVALID_PAGE_NUM) {
+      return cursor; /* n is past the last row */
+    }
+    page_num = next;
+  }
+}
+
+/* Rows whose key is below `key`, by subtree counts: the position of the
+ * row table_find(key) lands on */
+uint32_t table_rank(Table* table, uint32_t key) {
+  uint32_t rank = 0;
+  uint32_t page_num = table->root_page_num;
+  for (;;) {
+    void* node = get_page(table->pager, page_num);
+    if (get_node_type(node) == NODE_LEAF) {
+      uint32_t lo = 0;
+      uint32_t hi = *leaf_node_num_cells(node);
+      while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (*leaf_key_t(table, node, mid) < key) {
+          lo = mid + 1;
+        } else {
+          hi = mid;
+        }
+      }
+      return rank + lo;
+    }
+    if (!internal_node_counts_valid(node)) {
+      internal_node_refresh_counts(table, page_num);
+    }
+    uint32_t num_keys = *internal_node_num_keys(node);
+    uint32_t child = internal_node_find_child(node, key);
+    for (uint32_t i = 0; i < child; i++) {
+      rank += *internal_node_child_count(node, i);
+    }
+    page_num = (child == num_keys) ? *internal_node_right_child(node)
+                                   : *internal_node_cell(node, child);
+    if (page_num == INVALID_PAGE_NUM) {
+      return rank;
+    }
+  }
+}
+
 /* Print functions */
 void print_constants(Table* t) {
   printf("ROW_SIZE(table): %u\n", t->row_size);
@@ -375,14 +673,15 @@ void print_tree(Table* table, uint32_t page_num, uint32_t indentation_level) {
       num_keys = *internal_node_num_keys(node);
       indent(indentation_level);
       printf("- internal (size %d)\n", num_keys);
-      if (num_keys > 0) {
-        for (uint32_t i = 0; i < num_keys; i++) {
-          child = *internal_node_child(node, i);
-          print_tree(table, child, indentation_level + 1);
-          indent(indentation_level + 1);
-          printf("- key %d\n", *internal_node_key(node, i));
-        }
-        child = *internal_node_right_child(node);
+      for (uint32_t i = 0; i < num_keys; i++) {
+        child = *internal_node_child(node, i);
+        print_tree(table, child, indentation_level + 1);
+        indent(indentation_level + 1);
+        printf("- key %d\n", *internal_node_key(node, i));
+      }
+      /* A node can be down to its right child after deletes */
+      child = *internal_node_right_child(node);
+      if (child != INVALID_PAGE_NUM) {
         print_tree(table, child, indentation_level + 1);
       }
       break;
@@ -407,6 +706,11 @@ Table* db_open(const char* filename) {
   Table* table = malloc(sizeof(Table));
   table->pager = pager;
   table->root_page_num = INVALID_PAGE_NUM;
+  memset(&table->stats, 0, sizeof(table->stats));
+  table->sort_budget = SORT_DEFAULT_BUDGET;
+  table->threads = threadpool_default_threads();
+  table->catalog_version = 0;
+  table->plans = NULL;
 
   if (pager && pager->filename) {
     load_schemas_for_db(pager->filename);
@@ -443,7 +747,8 @@ void db_close(Table* table) {
     save_schemas_for_db(pager->filename);
     free(pager->filename);
   }
-  free(pager);
+  zonemap_free_all(pager);
+  pager_free(pager);
   free(table);
 }
 
@@ -501,6 +806,8 @@ void create_new_root(Table* table, uint32_t right_child_page_num) {
 
   memcpy(left_child, root, MYDB_PAGE_SIZE);
   set_node_root(left_child, false);
+  zonemap_invalidate(table->pager, table->root_page_num);
+  zonemap_invalidate(table->pager, left_child_page_num);
 
   if (get_node_type(left_child) == NODE_INTERNAL) {
     void* child;
@@ -530,6 +837,7 @@ void internal_node_split_and_insert(Table* table, uint32_t parent_page_num, uint
 void internal_node_insert(Table* table, uint32_t parent_page_num, uint32_t child_page_num) {
   void* parent = get_page(table->pager, parent_page_num);
   void* child = get_page(table->pager, child_page_num);
+  internal_node_invalidate_counts(parent);
   uint32_t child_max_key = get_node_max_key(table, child);
   uint32_t index = internal_node_find_child(parent, child_max_key);
 
@@ -590,6 +898,7 @@ void internal_node_split_and_insert(Table* table, uint32_t parent_page_num, uint
     initialize_internal_node(new_node);
   }
 
+  internal_node_invalidate_counts(old_node);
   uint32_t* old_num_keys = internal_node_num_keys(old_node);
   uint32_t cur_page_num = *internal_node_right_child(old_node);
   void* cur = get_page(table->pager, cur_page_num);
@@ -621,8 +930,10 @@ void internal_node_split_and_insert(Table* table, uint32_t parent_page_num, uint
   update_internal_node_key(parent, old_max, get_node_max_key(table, old_node));
 
   if (!splitting_root) {
-    internal_node_insert(table, *node_parent(old_node), new_page_num);
+    /* Set the parent first: if the grandparent splits in turn, it moves
+     * new_node and records its final parent itself. */
     *node_parent(new_node) = *node_parent(old_node);
+    internal_node_insert(table, *node_parent(old_node), new_page_num);
   }
 }
 
@@ -644,6 +955,7 @@ void leaf_node_insert(Cursor* cursor, uint32_t key, char* const* values, uint32_
     fprintf(stderr, "[DEBUG-LEAF-INSERT] leaf_node_insert: node is full, splitting\n");
     fflush(stderr);
     leaf_node_split_and_insert(cursor, key, values, nvals);
+    btree_refresh_counts(cursor->table, key);
     return;
   }
 
@@ -670,6 +982,10 @@ void leaf_node_insert(Cursor* cursor, uint32_t key, char* const* values, uint32_
   *(leaf_key_t(cursor->table, node, cursor->cell_num)) = key;
   serialize_row_dynamic(cursor->table, values, nvals,
                         leaf_value_t(cursor->table, node, cursor->cell_num));
+  zonemap_note_insert(cursor->table, cursor->page_num,
+                      leaf_value_t(cursor->table, node, cursor->cell_num));
+
+  btree_refresh_counts(cursor->table, key);
 
   uint32_t final_cells = *leaf_node_num_cells(node);
   fprintf(stderr, "[DEBUG-LEAF-INSERT] leaf_node_insert: completed, final cell count=%u\n",
@@ -711,6 +1027,8 @@ void leaf_node_split_and_insert(Cursor* cursor, uint32_t key, char* const* value
 
   *(leaf_node_num_cells(old_node)) = leaf_left_split_count(cursor->table);
   *(leaf_node_num_cells(new_node)) = leaf_right_split_count(cursor->table);
+  zonemap_invalidate(cursor->table->pager, cursor->page_num);
+  zonemap_invalidate(cursor->table->pager, new_page_num);
 
   if (is_node_root(old_node)) {
     return create_new_root(cursor->table, new_page_num);
@@ -725,6 +1043,62 @@ void leaf_node_split_and_insert(Cursor* cursor, uint32_t key, char* const* value
   }
 }
 
+/* Insert the run of rows at the front of `keys` that belongs to the
+ * cursor's leaf, as many as fit, with one backward merge over its cells;
+ * returns how many went in */
+static uint32_t leaf_node_insert_run(Cursor* cursor, const uint32_t* keys, char* const* const* rows,
+                                     uint32_t nvals, uint32_t n) {
+  Table* t = cursor->table;
+  void* node = get_page(t->pager, cursor->page_num);
+  uint32_t num_cells = *leaf_node_num_cells(node);
+  uint32_t room = leaf_max_cells(t) - num_cells;
+
+  /* Keys up to the leaf's max route here, and so does everything past it
+   * in the last leaf */
+  bool last_leaf = *leaf_node_next_leaf(node) == 0;
+  uint32_t leaf_max = num_cells > 0 ? *leaf_key_t(t, node, num_cells - 1) : 0;
+  uint32_t m = 1;
+  while (m < n && m < room && (last_leaf || (num_cells > 0 && keys[m] <= leaf_max))) {
+    m++;
+  }
+
+  uint32_t cell_size = leaf_cell_size(t);
+  int64_t i = (int64_t)num_cells - 1;
+  int64_t j = (int64_t)m - 1;
+  for (int64_t w = (int64_t)(num_cells + m) - 1; j >= 0; w--) {
+    if (i >= 0 && *leaf_key_t(t, node, (uint32_t)i) > keys[j]) {
+      memcpy(leaf_cell_t(t, node, (uint32_t)w), leaf_cell_t(t, node, (uint32_t)i), cell_size);
+      i--;
+    } else {
+      *leaf_key_t(t, node, (uint32_t)w) = keys[j];
+      serialize_row_dynamic(t, rows[j], nvals, leaf_value_t(t, node, (uint32_t)w));
+      zonemap_note_insert(t, cursor->page_num, leaf_value_t(t, node, (uint32_t)w));
+      j--;
+    }
+  }
+  *leaf_node_num_cells(node) = num_cells + m;
+  btree_refresh_counts(t, keys[0]);
+  return m;
+}
+
+/* Rows headed for the same leaf go in with one descent and one shift of
+ * its cells; a full leaf takes its next row through the usual split. */
+void table_insert_sorted(Table* table, const uint32_t* keys, char* const* const* rows,
+                         uint32_t nvals, uint32_t n) {
+  uint32_t i = 0;
+  while (i < n) {
+    Cursor* cursor = table_find(table, keys[i]);
+    void* node = get_page(table->pager, cursor->page_num);
+    if (*leaf_node_num_cells(node) >= leaf_max_cells(table)) {
+      leaf_node_insert(cursor, keys[i], rows[i], nvals);
+      i++;
+    } else {
+      i += leaf_node_insert_run(cursor, keys + i, rows + i, nvals, n - i);
+    }
+    free(cursor);
+  }
+}
+
 /* Delete and merge operations */
 int find_child_index_in_parent(void* parent, uint32_t child_page_num) {
   uint32_t num_keys = *internal_node_num_keys(parent);
@@ -781,6 +1155,7 @@ void internal_node_remove_child(Table* table, void* parent, uint32_t child_page_
   }
 
   fprintf(stderr, "[MERGE] Removing child at index %d from parent\n", child_index);
+  internal_node_invalidate_counts(parent);
 
   if (child_index == (int)num_keys) {
     if (num_keys > 0) {
@@ -831,6 +1206,8 @@ void leaf_node_merge_with_right(Table* table, uint32_t left_page_num, uint32_t r
   *leaf_node_next_leaf(left_node) = right_next;
 
   *leaf_node_num_cells(right_node) = 0;
+  zonemap_invalidate(table->pager, left_page_num);
+  zonemap_invalidate(table->pager, right_page_num);
 
   fprintf(stderr, "[MERGE] Merge complete, left node now has %u cells\n",
           *leaf_node_num_cells(left_node));
@@ -895,9 +1272,215 @@ void handle_underflow(Table* table, uint32_t page_num) {
 
       memcpy(parent, child_node, MYDB_PAGE_SIZE);
       set_node_root(parent, true);
+      zonemap_invalidate(table->pager, parent_page_num);
 
       fprintf(stderr, "[MERGE] Tree height reduced\n");
     }
   }
 }
 
+
+/* Bulk delete */
+static void invalidate_counts_to_root(Table* table, void* node) {
+  uint32_t depth = 0;
+  while (!is_node_root(node) && depth++ < BTREE_MAX_HEIGHT) {
+    node = get_page(table->pager, *node_parent(node));
+    internal_node_invalidate_counts(node);
+  }
+}
+
+static int cmp_page_num(const void* a, const void* b) {
+  uint32_t x = *(const uint32_t*)a;
+  uint32_t y = *(const uint32_t*)b;
+  return (x > y) - (x < y);
+}
+
+/* Drop every child of `parent` listed in the sorted `gone`, rebuilding its
+ * cells in one pass; true when no child is left */
+static bool internal_node_drop_children(Table* table, uint32_t parent_page_num,
+                                        const uint32_t* gone, uint32_t n_gone) {
+  void* parent = get_page(table->pager, parent_page_num);
+  uint32_t num_keys = *internal_node_num_keys(parent);
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i <= num_keys; i++) {
+    uint32_t child = (i == num_keys) ? *internal_node_right_child(parent)
+                                     : *internal_node_child(parent, i);
+    if (child == INVALID_PAGE_NUM ||
+        bsearch(&child, gone, n_gone, sizeof(uint32_t), cmp_page_num)) {
+      continue;
+    }
+    /* Cell `kept` takes the child and its key; the last one kept is
+     * rewritten as the right child below */
+    *internal_node_child(parent, kept) = child;
+    if (i < num_keys) {
+      *internal_node_key(parent, kept) = *internal_node_key(parent, i);
+    }
+    kept++;
+  }
+  internal_node_invalidate_counts(parent);
+  if (kept == 0) {
+    *internal_node_num_keys(parent) = 0;
+    *internal_node_right_child(parent) = INVALID_PAGE_NUM;
+    return true;
+  }
+  uint32_t right = *internal_node_child(parent, kept - 1);
+  *internal_node_num_keys(parent) = kept - 1;
+  *internal_node_right_child(parent) = right;
+  return false;
+}
+
+/* Remove emptied nodes from their parents, one rebuild per parent and one
+ * level at a time; the nodes' pages are not reused */
+static void drop_empty_nodes(Table* table, uint32_t* pages, uint32_t n) {
+  uint32_t* parents = malloc((n ? n : 1) * sizeof(uint32_t));
+  uint32_t* next_level = malloc((n ? n : 1) * sizeof(uint32_t));
+  if (!parents || !next_level) {
+    free(parents);
+    free(next_level);
+    return;
+  }
+  while (n > 0) {
+    qsort(pages, n, sizeof(uint32_t), cmp_page_num);
+    uint32_t n_parents = 0;
+    for (uint32_t i = 0; i < n; i++) {
+      void* node = get_page(table->pager, pages[i]);
+      if (is_node_root(node)) {
+        continue;
+      }
+      uint32_t parent = *node_parent(node);
+      bool seen = false;
+      for (uint32_t j = n_parents; j > 0 && !seen; j--) {
+        seen = parents[j - 1] == parent;
+      }
+      if (!seen) {
+        parents[n_parents++] = parent;
+      }
+    }
+    uint32_t n_next = 0;
+    for (uint32_t i = 0; i < n_parents; i++) {
+      if (internal_node_drop_children(table, parents[i], pages, n)) {
+        void* parent = get_page(table->pager, parents[i]);
+        if (is_node_root(parent)) {
+          initialize_leaf_node(parent);
+          set_node_root(parent, true);
+        } else {
+          next_level[n_next++] = parents[i];
+        }
+      } else {
+        invalidate_counts_to_root(table, get_page(table->pager, parents[i]));
+      }
+    }
+    memcpy(pages, next_level, n_next * sizeof(uint32_t));
+    n = n_next;
+  }
+  free(parents);
+  free(next_level);
+}
+
+/* A root left with a single child takes that child's place */
+static void collapse_root(Table* table) {
+  void* root = get_page(table->pager, table->root_page_num);
+  while (get_node_type(root) == NODE_INTERNAL && *internal_node_num_keys(root) == 0) {
+    uint32_t only_child = *internal_node_right_child(root);
+    if (only_child == INVALID_PAGE_NUM) {
+      break;
+    }
+    memcpy(root, get_page(table->pager, only_child), MYDB_PAGE_SIZE);
+    set_node_root(root, true);
+    zonemap_invalidate(table->pager, table->root_page_num);
+    if (get_node_type(root) == NODE_LEAF) {
+      *leaf_node_next_leaf(root) = 0;
+      break;
+    }
+    uint32_t num_keys = *internal_node_num_keys(root);
+    for (uint32_t i = 0; i <= num_keys; i++) {
+      uint32_t child = (i == num_keys) ? *internal_node_right_child(root)
+                                       : *internal_node_child(root, i);
+      *node_parent(get_page(table->pager, child)) = table->root_page_num;
+    }
+    internal_node_invalidate_counts(root);
+  }
+}
+
+uint32_t table_delete_where(Table* table, const DeleteFilter* f) {
+  Cursor* cursor = table_find(table, 0);
+  uint32_t page_num = cursor->page_num;
+  free(cursor);
+
+  uint32_t* emptied = NULL;
+  uint32_t n_emptied = 0;
+  uint32_t cap = 0;
+  uint32_t deleted = 0;
+  void* prev_live = NULL;     /* Last leaf of the chain that keeps rows */
+  uint32_t cell_size = leaf_cell_size(table);
+  for (;;) {
+    void* node = get_page(table->pager, page_num);
+    uint32_t next = *leaf_node_next_leaf(node);
+    uint32_t num_cells = *leaf_node_num_cells(node);
+    uint32_t kept = num_cells;
+    if (num_cells > 0 && (!f->leaf_may_match || f->leaf_may_match(table, page_num, f->ctx))) {
+      uint32_t old_max = *leaf_key_t(table, node, num_cells - 1);
+      kept = 0;
+      for (uint32_t i = 0; i < num_cells; i++) {
+        if (f->row_matches(table, leaf_value_t(table, node, i), f->ctx)) {
+          continue;
+        }
+        if (kept != i) {
+          memcpy(leaf_cell_t(table, node, kept), leaf_cell_t(table, node, i), cell_size);
+        }
+        kept++;
+      }
+      if (kept < num_cells) {
+        memset(leaf_cell_t(table, node, kept), 0, (num_cells - kept) * cell_size);
+        *leaf_node_num_cells(node) = kept;
+        deleted += num_cells - kept;
+        zonemap_invalidate(table->pager, page_num);
+        invalidate_counts_to_root(table, node);
+      }
+      /* The parent's key for this leaf tightens to its new max, unless the
+       * leaf is the right child, which has no key */
+      if (kept > 0 && kept < num_cells && !is_node_root(node)) {
+        void* parent = get_page(table->pager, *node_parent(node));
+        int idx = find_child_index_in_parent(parent, page_num);
+        uint32_t new_max = *leaf_key_t(table, node, kept - 1);
+        if (idx >= 0 && (uint32_t)idx < *internal_node_num_keys(parent) &&
+            *internal_node_key(parent, idx) == old_max) {
+          *internal_node_key(parent, idx) = new_max;
+        }
+      }
+    }
+
+    if (kept == 0 && !is_node_root(node) && n_emptied == cap) {
+      uint32_t grown_cap = cap ? cap * 2 : 64;
+      uint32_t* grown = realloc(emptied, grown_cap * sizeof(uint32_t));
+      if (grown) {
+        emptied = grown;
+        cap = grown_cap;
+      }
+    }
+    if (kept == 0 && !is_node_root(node) && n_emptied < cap) {
+      /* Unlink the leaf now; it leaves its parent with the others below */
+      if (prev_live) {
+        *leaf_node_next_leaf(prev_live) = next;
+      }
+      emptied[n_emptied++] = page_num;
+    } else {
+      /* Also an emptied leaf there was no room to list: it stays in the
+       * chain, and scans step over empty leaves */
+      prev_live = node;
+    }
+    if (next == 0) {
+      break;
+    }
+    page_num = next;
+  }
+
+  drop_empty_nodes(table, emptied, n_emptied);
+  free(emptied);
+  collapse_root(table);
+  void* root = get_page(table->pager, table->root_page_num);
+  if (get_node_type(root) == NODE_INTERNAL) {
+    internal_node_refresh_counts(table, table->root_page_num);
+  }
+  return deleted;
+}
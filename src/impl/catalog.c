@@ -46,6 +46,46 @@ int catalog_find(Pager* pager, const char* name) {
   return -1;
 }
 
+/* Find table by root page (root pages never move) */
+int catalog_find_by_root(Pager* pager, uint32_t root_page_num) {
+  CatalogHeader* hdr = catalog_header(pager);
+  CatalogEntry* ents = catalog_entries(pager);
+  for (uint32_t i = 0; i < hdr->num_tables; i++) {
+    if (ents[i].root_page_num == root_page_num) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/* Get the extension record of catalog entry `idx` */
+CatalogTableExt* catalog_table_ext(Pager* pager, int idx) {
+  if (idx < 0 || idx >= CATALOG_MAX_TABLES) {
+    return NULL;
+  }
+  uint8_t* base = (uint8_t*)catalog_entries(pager) + CATALOG_MAX_TABLES * sizeof(CatalogEntry);
+  return (CatalogTableExt*)base + idx;
+}
+
+/* Make `name` the active table of the handle; returns its catalog index or -1 */
+int table_activate(Table* table, const char* name) {
+  int idx = catalog_find(table->pager, name);
+  if (idx < 0) {
+    return -1;
+  }
+  CatalogEntry* ents = catalog_entries(table->pager);
+  table->root_page_num = ents[idx].root_page_num;
+
+  uint32_t sidx = ents[idx].schema_index;
+  if (sidx < g_num_tables) {
+    table->active_schema = g_table_schemas[sidx];
+  } else {
+    memset(&table->active_schema, 0, sizeof(TableSchema));
+  }
+  table->row_size = compute_row_size(&table->active_schema);
+  return idx;
+}
+
 /* Lookup table schema by name */
 int lookup_table_schema(Pager* pager, const char* name, TableSchema* out_schema) {
   int idx = catalog_find(pager, name);
@@ -74,6 +114,7 @@ int catalog_add_table(Pager* pager, const TableSchema* schema, uint32_t root_pag
   strncpy(e->name, schema->name, MAX_TABLE_NAME_LEN - 1);
   e->root_page_num = root_page_num;
   e->schema_index = 0; /* Will be set by caller */
+  memset(catalog_table_ext(pager, hdr->num_tables), 0, sizeof(CatalogTableExt));
   hdr->num_tables++;
   return 0;
 }
@@ -104,9 +145,12 @@ void load_schemas_for_db(const char* dbfile) {
         }
       }
       /* Close pager */
+      for (uint32_t i = 0; i < TABLE_MAX_PAGES; i++) {
+        free(tmp_pager->pages[i]);
+      }
       close(tmp_pager->file_descriptor);
       if (tmp_pager->filename) free(tmp_pager->filename);
-      free(tmp_pager);
+      pager_free(tmp_pager);
     }
   }
   if (!loaded) return;
@@ -188,7 +232,7 @@ int save_schemas_for_db(const char* dbfile) {
     int res = close(pager->file_descriptor);
     (void)res;
     if (pager->filename) free(pager->filename);
-    free(pager);
+    pager_free(pager);
     rc = 0;
   }
   free(s);
@@ -271,6 +315,7 @@ int handle_create_table_ex(Table* runtime_table, const char* sql) {
   if (catalog_add_table(runtime_table->pager, &schema, root) != 0) {
     return -5;
   }
+  runtime_table->catalog_version++;
   /* Update schema index */
   CatalogHeader* hdr = catalog_header(runtime_table->pager);
   CatalogEntry* ents = catalog_entries(runtime_table->pager);
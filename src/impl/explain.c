@@ -0,0 +1,158 @@
+#include "../include/explain.h"
+#include "../include/catalog.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+void explain_init(Explain* ex, bool analyze) {
+  memset(ex, 0, sizeof(*ex));
+  ex->analyze = analyze;
+  ex->parent = -1;
+}
+
+ExplainNode* explain_add(Explain* ex, const char* name, const char* fmt, ...) {
+  if (ex->n == EXPLAIN_MAX_NODES) {
+    return NULL;
+  }
+  ExplainNode* node = &ex->nodes[ex->n++];
+  memset(node, 0, sizeof(*node));
+  strncpy(node->name, name, sizeof(node->name) - 1);
+  va_list ap;
+  va_start(ap, fmt);
+  vsnprintf(node->detail, sizeof(node->detail), fmt, ap);
+  va_end(ap);
+  node->parent = ex->parent;
+  node->est_pages = -1;
+  node->est_rows = -1;
+  return node;
+}
+
+int explain_index(const Explain* ex, const ExplainNode* node) {
+  return node ? (int)(node - ex->nodes) : ex->parent;
+}
+
+const char* explain_table_name(Table* t) {
+  int idx = t->root_page_num == INVALID_PAGE_NUM ? -1 : catalog_find_by_root(t->pager, t->root_page_num);
+  return idx < 0 ? "?" : catalog_entries(t->pager)[idx].name;
+}
+
+void explain_mark(const Pager* pager, ExplainMark* m) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  m->ns = (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+  m->page_hits = __atomic_load_n(&pager->page_hits, __ATOMIC_RELAXED);
+  m->page_reads = __atomic_load_n(&pager->page_reads, __ATOMIC_RELAXED);
+}
+
+void explain_account(ExplainNode* node, const Pager* pager, const ExplainMark* m, uint64_t rows) {
+  ExplainMark now;
+  explain_mark(pager, &now);
+  node->time_ns += now.ns - m->ns;
+  node->page_hits += now.page_hits - m->page_hits;
+  node->page_reads += now.page_reads - m->page_reads;
+  node->rows += rows;
+}
+
+static bool has_inputs(const Explain* ex, int i) {
+  for (uint32_t c = 0; c < ex->n; c++) {
+    if (ex->nodes[c].parent == i) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Rows a step took in: what its inputs produced */
+static uint64_t rows_in(const Explain* ex, int i) {
+  uint64_t n = 0;
+  for (uint32_t c = 0; c < ex->n; c++) {
+    if (ex->nodes[c].parent == i) {
+      n += ex->nodes[c].rows;
+    }
+  }
+  return n;
+}
+
+static void print_node(const Explain* ex, int i, int depth) {
+  const ExplainNode* node = &ex->nodes[i];
+  printf("%*s%s%s", depth * 4, "", depth > 0 ? "-> " : "", node->name);
+  if (node->detail[0]) {
+    printf(" (%s)", node->detail);
+  }
+  if (node->est_pages >= 0 || node->est_rows >= 0) {
+    printf("  {est.");
+    if (node->est_pages >= 0) {
+      printf(" pages=%.0f", node->est_pages);
+    }
+    if (node->est_rows >= 0) {
+      printf(" rows=%.0f", node->est_rows);
+    }
+    printf("}");
+  }
+  if (ex->analyze) {
+    printf("  [rows ");
+    if (has_inputs(ex, i)) {
+      printf("in=%llu out=", (unsigned long long)rows_in(ex, i));
+    }
+    printf("%llu, time=%.3f ms, pages hit=%llu read=%llu, memory=%zu B]",
+           (unsigned long long)node->rows, node->time_ns / 1e6,
+           (unsigned long long)node->page_hits, (unsigned long long)node->page_reads,
+           node->mem_bytes);
+  }
+  printf("\n");
+  for (uint32_t c = 0; c < ex->n; c++) {
+    if (ex->nodes[c].parent == i) {
+      print_node(ex, (int)c, depth + 1);
+    }
+  }
+}
+
+void explain_print(const Explain* ex) {
+  for (uint32_t i = 0; i < ex->n; i++) {
+    if (ex->nodes[i].parent < 0) {
+      print_node(ex, (int)i, 0);
+    }
+  }
+}
+
+static void append_node_json(const Explain* ex, int parent, StrBuf* sb) {
+  sb_append(sb, "[");
+  bool first = true;
+  for (uint32_t i = 0; i < ex->n; i++) {
+    const ExplainNode* node = &ex->nodes[i];
+    if (node->parent != parent) {
+      continue;
+    }
+    sb_append(sb, first ? "{\"op\":" : ",{\"op\":");
+    first = false;
+    json_escape_append(sb, node->name);
+    sb_append(sb, ",\"detail\":");
+    json_escape_append(sb, node->detail);
+    if (node->est_pages >= 0) {
+      sb_appendf(sb, ",\"est_pages\":%.0f", node->est_pages);
+    }
+    if (node->est_rows >= 0) {
+      sb_appendf(sb, ",\"est_rows\":%.0f", node->est_rows);
+    }
+    if (ex->analyze) {
+      if (has_inputs(ex, (int)i)) {
+        sb_appendf(sb, ",\"rows_in\":%llu", (unsigned long long)rows_in(ex, (int)i));
+      }
+      sb_appendf(sb,
+                 ",\"rows_out\":%llu,\"time_ms\":%.3f,\"page_hits\":%llu,\"page_reads\":%llu,"
+                 "\"memory_bytes\":%zu",
+                 (unsigned long long)node->rows, node->time_ns / 1e6,
+                 (unsigned long long)node->page_hits, (unsigned long long)node->page_reads,
+                 node->mem_bytes);
+    }
+    sb_append(sb, ",\"inputs\":");
+    append_node_json(ex, (int)i, sb);
+    sb_append(sb, "}");
+  }
+  sb_append(sb, "]");
+}
+
+void explain_append_json(const Explain* ex, StrBuf* sb) {
+  append_node_json(ex, -1, sb);
+}
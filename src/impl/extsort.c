@@ -0,0 +1,310 @@
+#include "../include/extsort.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+/* One sorted run in the spill file. Records are a sort key followed by the
+ * row, so merging compares keys without decoding rows. */
+typedef struct {
+  off_t start;          /* Byte offset of the run's first record */
+  uint32_t rows;        /* Rows in the run */
+  uint32_t loaded;      /* Rows read into buf so far */
+  uint8_t* buf;
+  uint32_t buf_cap;     /* Rows buf can hold */
+  uint32_t buf_rows;    /* Rows currently in buf */
+  uint32_t buf_pos;     /* Next row of buf to merge */
+} SortRun;
+
+struct ExtSort {
+  Table* table;
+  SortKeyFormat fmt;
+  size_t budget;
+  uint32_t row_size;
+  uint32_t rec_size;    /* Key + row */
+  uint32_t seq;         /* Rows added so far */
+
+  /* Run being built */
+  uint8_t* arena;
+  SortItem* items;
+  uint32_t cap;
+  uint32_t n;
+  uint32_t pos;         /* Output position when nothing spilled */
+
+  /* Spilled runs and their merge */
+  FILE* spill;
+  off_t spill_len;
+  SortRun* runs;
+  uint32_t n_runs;
+  uint32_t runs_cap;
+  uint32_t* tree;       /* tree[0] = winner, tree[1..k-1] = losers */
+  uint32_t pending;     /* Run whose head was last returned */
+  bool io_error;
+  size_t mem_peak;      /* Most bytes of the arena in use, or of read buffers */
+};
+
+ExtSort* extsort_new(Table* t, const SortSpec* spec, size_t budget) {
+  ExtSort* s = calloc(1, sizeof(ExtSort));
+  if (!s) {
+    return NULL;
+  }
+  s->table = t;
+  sortkey_format_init(&s->fmt, t, spec);
+  s->budget = budget;
+  s->row_size = t->row_size;
+  s->rec_size = s->fmt.key_len + s->row_size;
+  s->pending = UINT32_MAX;
+
+  size_t per_row = s->rec_size + sizeof(SortItem);
+  size_t cap = budget / per_row;
+  s->cap = cap < 2 ? 2 : (cap > UINT32_MAX ? UINT32_MAX : (uint32_t)cap);
+  return s;
+}
+
+static bool ensure_arena(ExtSort* s) {
+  if (s->arena) {
+    return true;
+  }
+  s->arena = malloc((size_t)s->cap * s->rec_size);
+  s->items = malloc((size_t)s->cap * sizeof(SortItem));
+  return s->arena && s->items;
+}
+
+static void note_arena_use(ExtSort* s) {
+  size_t used = (size_t)s->n * (s->rec_size + sizeof(SortItem));
+  if (used > s->mem_peak) {
+    s->mem_peak = used;
+  }
+}
+
+static void sort_arena(ExtSort* s) {
+  for (uint32_t i = 0; i < s->n; i++) {
+    uint8_t* rec = s->arena + (size_t)i * s->rec_size;
+    s->items[i].key = rec;
+    s->items[i].row = rec + s->fmt.key_len;
+  }
+  sortkey_sort_parallel(s->items, s->n, s->fmt.key_len, s->table->threads);
+}
+
+/* Sort the buffered rows and append them to the spill file as a run */
+static bool spill_run(ExtSort* s) {
+  if (!s->spill) {
+    s->spill = tmpfile();
+    if (!s->spill) {
+      return false;
+    }
+  }
+  if (s->n_runs == s->runs_cap) {
+    uint32_t cap = s->runs_cap ? s->runs_cap * 2 : 8;
+    SortRun* grown = realloc(s->runs, cap * sizeof(SortRun));
+    if (!grown) {
+      return false;
+    }
+    s->runs = grown;
+    s->runs_cap = cap;
+  }
+
+  note_arena_use(s);
+  sort_arena(s);
+  for (uint32_t i = 0; i < s->n; i++) {
+    if (fwrite(s->items[i].key, s->rec_size, 1, s->spill) != 1) {
+      return false;
+    }
+  }
+
+  SortRun* run = &s->runs[s->n_runs++];
+  memset(run, 0, sizeof(*run));
+  run->start = s->spill_len;
+  run->rows = s->n;
+  s->spill_len += (off_t)s->n * s->rec_size;
+
+  s->table->stats.sort.runs++;
+  s->table->stats.sort.bytes_spilled += (uint64_t)s->n * s->rec_size;
+  s->n = 0;
+  return true;
+}
+
+bool extsort_add(ExtSort* s, const void* row) {
+  if (!ensure_arena(s)) {
+    return false;
+  }
+  if (s->n == s->cap && !spill_run(s)) {
+    return false;
+  }
+  uint8_t* rec = s->arena + (size_t)s->n * s->rec_size;
+  sortkey_encode(&s->fmt, row, s->seq++, rec);
+  memcpy(rec + s->fmt.key_len, row, s->row_size);
+  s->n++;
+  return true;
+}
+
+/* Merge */
+static bool run_refill(ExtSort* s, SortRun* run) {
+  uint32_t want = run->rows - run->loaded;
+  if (want > run->buf_cap) {
+    want = run->buf_cap;
+  }
+  run->buf_pos = 0;
+  run->buf_rows = 0;
+  if (want == 0) {
+    return true;
+  }
+  size_t bytes = (size_t)want * s->rec_size;
+  off_t at = run->start + (off_t)run->loaded * s->rec_size;
+  ssize_t got = pread(fileno(s->spill), run->buf, bytes, at);
+  if (got < 0 || (size_t)got != bytes) {
+    return false;
+  }
+  run->loaded += want;
+  run->buf_rows = want;
+  return true;
+}
+
+static const uint8_t* run_head(const ExtSort* s, const SortRun* run) {
+  if (run->buf_pos >= run->buf_rows) {
+    return NULL;
+  }
+  return run->buf + (size_t)run->buf_pos * s->rec_size;
+}
+
+/* Whether run a's head sorts before run b's; exhausted runs sort last.
+ * Keys are unique, so there are no ties. */
+static bool run_before(const ExtSort* s, uint32_t a, uint32_t b) {
+  const uint8_t* ka = run_head(s, &s->runs[a]);
+  const uint8_t* kb = run_head(s, &s->runs[b]);
+  if (!ka || !kb) {
+    return ka != NULL;
+  }
+  return memcmp(ka, kb, s->fmt.key_len) < 0;
+}
+
+/* Leaves are k..2k-1 (run i at k+i), internal nodes 1..k-1 hold the loser
+ * of the match played there. */
+static bool loser_tree_build(ExtSort* s) {
+  uint32_t k = s->n_runs;
+  uint32_t* winners = malloc(2 * (size_t)k * sizeof(uint32_t));
+  s->tree = malloc((size_t)k * sizeof(uint32_t));
+  if (!winners || !s->tree) {
+    free(winners);
+    return false;
+  }
+  for (uint32_t i = 0; i < k; i++) {
+    winners[k + i] = i;
+  }
+  for (uint32_t node = k - 1; node >= 1; node--) {
+    uint32_t a = winners[2 * node];
+    uint32_t b = winners[2 * node + 1];
+    if (run_before(s, a, b)) {
+      winners[node] = a;
+      s->tree[node] = b;
+    } else {
+      winners[node] = b;
+      s->tree[node] = a;
+    }
+  }
+  s->tree[0] = winners[1];
+  free(winners);
+  return true;
+}
+
+/* Replay the matches on run r's path after its head changed */
+static void loser_tree_replay(ExtSort* s, uint32_t r) {
+  uint32_t k = s->n_runs;
+  uint32_t winner = r;
+  for (uint32_t node = (k + r) / 2; node >= 1; node /= 2) {
+    if (run_before(s, s->tree[node], winner)) {
+      uint32_t tmp = s->tree[node];
+      s->tree[node] = winner;
+      winner = tmp;
+    }
+  }
+  s->tree[0] = winner;
+}
+
+static bool start_merge(ExtSort* s) {
+  free(s->arena);
+  free(s->items);
+  s->arena = NULL;
+  s->items = NULL;
+  if (fflush(s->spill) != 0) {
+    return false;
+  }
+
+  /* The read buffers share the budget */
+  size_t per_run = s->budget / s->n_runs / s->rec_size;
+  uint32_t buf_cap = per_run < 1 ? 1 : (per_run > UINT32_MAX ? UINT32_MAX : (uint32_t)per_run);
+  size_t bufs = 0;
+  for (uint32_t i = 0; i < s->n_runs; i++) {
+    SortRun* run = &s->runs[i];
+    run->buf_cap = buf_cap < run->rows ? buf_cap : (run->rows ? run->rows : 1);
+    run->buf = malloc((size_t)run->buf_cap * s->rec_size);
+    if (!run->buf || !run_refill(s, run)) {
+      return false;
+    }
+    bufs += (size_t)run->buf_cap * s->rec_size;
+  }
+  if (bufs > s->mem_peak) {
+    s->mem_peak = bufs;
+  }
+  return loser_tree_build(s);
+}
+
+bool extsort_finish(ExtSort* s) {
+  s->table->stats.sort.sorts++;
+  if (s->n_runs == 0) {
+    note_arena_use(s);
+    sort_arena(s);
+    return true;
+  }
+  s->table->stats.sort.spilled_sorts++;
+  if (s->n > 0 && !spill_run(s)) {
+    return false;
+  }
+  return start_merge(s);
+}
+
+const void* extsort_next(ExtSort* s) {
+  if (s->n_runs == 0) {
+    return s->pos < s->n ? s->items[s->pos++].row : NULL;
+  }
+
+  if (s->pending != UINT32_MAX) {
+    SortRun* run = &s->runs[s->pending];
+    run->buf_pos++;
+    if (run->buf_pos >= run->buf_rows && !run_refill(s, run)) {
+      s->io_error = true;
+      return NULL;
+    }
+    loser_tree_replay(s, s->pending);
+  }
+  uint32_t r = s->tree[0];
+  const uint8_t* rec = run_head(s, &s->runs[r]);
+  s->pending = rec ? r : UINT32_MAX;
+  return rec ? rec + s->fmt.key_len : NULL;
+}
+
+bool extsort_failed(const ExtSort* s) {
+  return s->io_error;
+}
+
+size_t extsort_mem_peak(const ExtSort* s) {
+  return s->mem_peak;
+}
+
+void extsort_free(ExtSort* s) {
+  if (!s) {
+    return;
+  }
+  free(s->arena);
+  free(s->items);
+  for (uint32_t i = 0; i < s->n_runs; i++) {
+    free(s->runs[i].buf);
+  }
+  free(s->runs);
+  free(s->tree);
+  if (s->spill) {
+    fclose(s->spill);
+  }
+  free(s);
+}
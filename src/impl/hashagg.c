@@ -0,0 +1,266 @@
+#include "../include/hashagg.h"
+#include "../include/util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Entries a table starts with; always allowed, whatever the budget */
+#define HASHAGG_MIN_ENTRIES 64
+
+/* A table slot; entry is the arena index + 1, 0 when the slot is empty */
+typedef struct {
+  uint32_t hash;
+  uint32_t entry;
+} GroupSlot;
+
+/* A partition spilled by the pass at `level`, waiting for its own pass */
+typedef struct {
+  FILE* f;
+  uint32_t level;
+} GroupPart;
+
+struct HashAgg {
+  Table* table;
+  const AggPlan* plan;
+  size_t budget;
+  uint32_t row_size;
+  uint32_t state_offset;  /* Key, padded to 8 bytes */
+  uint32_t entry_size;    /* Key + aggregate states */
+
+  /* Table of the current pass */
+  uint8_t* entries;
+  uint32_t n_entries;
+  uint32_t cap_entries;
+  GroupSlot* slots;
+  uint32_t n_slots;       /* Power of two, at least twice n_entries */
+  uint8_t* probe;         /* Key of the row being added */
+  uint32_t next;          /* Output position */
+
+  /* Spilling */
+  uint32_t level;         /* Pass depth: selects the partitioning hash bits */
+  bool full;
+  FILE* parts[HASHAGG_FANOUT];
+  GroupPart* pending;
+  uint32_t n_pending;
+  uint32_t pending_cap;
+  uint8_t* row_buf;
+  bool io_error;
+};
+
+HashAgg* hashagg_new(Table* t, const AggPlan* plan, size_t budget) {
+  HashAgg* h = calloc(1, sizeof(HashAgg));
+  if (!h) {
+    return NULL;
+  }
+  h->table = t;
+  h->plan = plan;
+  h->budget = budget;
+  h->row_size = t->row_size;
+  h->state_offset = (plan->key_len + 7) & ~7u;
+  h->entry_size = h->state_offset + plan->state_size;
+  h->cap_entries = HASHAGG_MIN_ENTRIES;
+  h->n_slots = HASHAGG_MIN_ENTRIES * 2;
+  h->entries = malloc((size_t)h->cap_entries * h->entry_size);
+  h->slots = calloc(h->n_slots, sizeof(GroupSlot));
+  h->probe = malloc(plan->key_len ? plan->key_len : 1);
+  h->row_buf = malloc(h->row_size);
+  if (!h->entries || !h->slots || !h->probe || !h->row_buf) {
+    hashagg_free(h);
+    return NULL;
+  }
+  t->stats.group.groupings++;
+  return h;
+}
+
+static size_t table_bytes(const HashAgg* h) {
+  return (size_t)h->cap_entries * h->entry_size + (size_t)h->n_slots * sizeof(GroupSlot);
+}
+
+static uint8_t* group_find(HashAgg* h, uint64_t hash) {
+  uint32_t mask = h->n_slots - 1;
+  for (uint32_t i = (uint32_t)hash & mask;; i = (i + 1) & mask) {
+    GroupSlot* slot = &h->slots[i];
+    if (slot->entry == 0) {
+      return NULL;
+    }
+    if (slot->hash == (uint32_t)hash) {
+      uint8_t* e = h->entries + (size_t)(slot->entry - 1) * h->entry_size;
+      if (memcmp(e, h->probe, h->plan->key_len) == 0) {
+        return e + h->state_offset;
+      }
+    }
+  }
+}
+
+static void slot_insert(GroupSlot* slots, uint32_t n_slots, uint32_t hash, uint32_t entry) {
+  uint32_t mask = n_slots - 1;
+  uint32_t i = hash & mask;
+  while (slots[i].entry != 0) {
+    i = (i + 1) & mask;
+  }
+  slots[i].hash = hash;
+  slots[i].entry = entry;
+}
+
+/* Make room for one more group, doubling the arena and the slots while
+ * the table stays within budget. False when the table is full. */
+static bool make_room(HashAgg* h) {
+  if (h->n_entries < h->cap_entries) {
+    return true;
+  }
+  if (h->level < HASHAGG_MAX_LEVEL && table_bytes(h) * 2 > h->budget) {
+    return false;
+  }
+  uint8_t* entries = realloc(h->entries, (size_t)h->cap_entries * 2 * h->entry_size);
+  if (!entries) {
+    return false;
+  }
+  h->entries = entries;
+  GroupSlot* slots = calloc((size_t)h->n_slots * 2, sizeof(GroupSlot));
+  if (!slots) {
+    return false;
+  }
+  /* The stored hash is enough to place each entry again */
+  for (uint32_t i = 0; i < h->n_slots; i++) {
+    if (h->slots[i].entry != 0) {
+      slot_insert(slots, h->n_slots * 2, h->slots[i].hash, h->slots[i].entry);
+    }
+  }
+  free(h->slots);
+  h->slots = slots;
+  h->n_slots *= 2;
+  h->cap_entries *= 2;
+  return true;
+}
+
+/* Write a row of a group that is not in the full table to its partition */
+static bool spill_row(HashAgg* h, uint64_t hash, const void* row) {
+  uint32_t p = (uint32_t)(hash >> (60 - 4 * h->level)) & (HASHAGG_FANOUT - 1);
+  if (!h->parts[p]) {
+    h->parts[p] = tmpfile();
+    if (!h->parts[p]) {
+      return false;
+    }
+    h->table->stats.group.partitions++;
+  }
+  if (fwrite(row, h->row_size, 1, h->parts[p]) != 1) {
+    return false;
+  }
+  h->table->stats.group.bytes_spilled += h->row_size;
+  return true;
+}
+
+bool hashagg_add(HashAgg* h, const void* row) {
+  const AggPlan* plan = h->plan;
+  agg_group_key(plan, row, h->probe);
+  uint64_t hash = hash_bytes(h->probe, plan->key_len);
+  uint8_t* state = group_find(h, hash);
+  if (!state) {
+    if (!h->full && !make_room(h)) {
+      if (h->level >= HASHAGG_MAX_LEVEL) {
+        return false;
+      }
+      if (h->level == 0) {
+        h->table->stats.group.spilled++;
+      }
+      h->full = true;
+    }
+    if (h->full) {
+      return spill_row(h, hash, row);
+    }
+    uint8_t* e = h->entries + (size_t)h->n_entries * h->entry_size;
+    memcpy(e, h->probe, plan->key_len);
+    state = e + h->state_offset;
+    agg_init(plan, state);
+    h->n_entries++;
+    slot_insert(h->slots, h->n_slots, (uint32_t)hash, h->n_entries);
+  }
+  agg_update(plan, state, row);
+  return true;
+}
+
+/* The groups of the current pass have all been read: queue the partitions
+ * it spilled and aggregate the next pending one into the emptied table */
+static bool next_pass(HashAgg* h) {
+  for (uint32_t p = 0; p < HASHAGG_FANOUT; p++) {
+    if (!h->parts[p]) {
+      continue;
+    }
+    if (h->n_pending == h->pending_cap) {
+      uint32_t cap = h->pending_cap ? h->pending_cap * 2 : HASHAGG_FANOUT;
+      GroupPart* grown = realloc(h->pending, cap * sizeof(GroupPart));
+      if (!grown) {
+        h->io_error = true;
+        return false;
+      }
+      h->pending = grown;
+      h->pending_cap = cap;
+    }
+    h->pending[h->n_pending].f = h->parts[p];
+    h->pending[h->n_pending].level = h->level;
+    h->n_pending++;
+    h->parts[p] = NULL;
+  }
+  if (h->n_pending == 0) {
+    return false;
+  }
+
+  GroupPart part = h->pending[--h->n_pending];
+  h->n_entries = 0;
+  h->next = 0;
+  memset(h->slots, 0, (size_t)h->n_slots * sizeof(GroupSlot));
+  h->full = false;
+  h->level = part.level + 1;
+  rewind(part.f);
+  bool ok = true;
+  while (ok && fread(h->row_buf, h->row_size, 1, part.f) == 1) {
+    ok = hashagg_add(h, h->row_buf);
+  }
+  if (ferror(part.f)) {
+    ok = false;
+  }
+  fclose(part.f);
+  if (!ok) {
+    h->io_error = true;
+  }
+  return ok;
+}
+
+const uint8_t* hashagg_next(HashAgg* h, const uint8_t** state) {
+  while (h->next >= h->n_entries) {
+    if (h->io_error || !next_pass(h)) {
+      return NULL;
+    }
+  }
+  uint8_t* e = h->entries + (size_t)h->next++ * h->entry_size;
+  *state = e + h->state_offset;
+  return e;
+}
+
+bool hashagg_failed(const HashAgg* h) {
+  return h->io_error;
+}
+
+size_t hashagg_mem_bytes(const HashAgg* h) {
+  return table_bytes(h);
+}
+
+void hashagg_free(HashAgg* h) {
+  if (!h) {
+    return;
+  }
+  for (uint32_t p = 0; p < HASHAGG_FANOUT; p++) {
+    if (h->parts[p]) {
+      fclose(h->parts[p]);
+    }
+  }
+  for (uint32_t i = 0; i < h->n_pending; i++) {
+    fclose(h->pending[i].f);
+  }
+  free(h->pending);
+  free(h->entries);
+  free(h->slots);
+  free(h->probe);
+  free(h->row_buf);
+  free(h);
+}
@@ -0,0 +1,397 @@
+#include "../include/hashjoin.h"
+#include "../include/schema.h"
+#include "../include/util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Entries a table starts with; always allowed, whatever the budget */
+#define HASHJOIN_MIN_ENTRIES 64
+
+void join_key_col(JoinKeyCol* k, const TableSchema* s, int col) {
+  k->offset = schema_col_offset(s, col);
+  k->type = s->columns[col].type;
+  switch (k->type) {
+    case COL_TYPE_INT:
+      k->width = 4;
+      break;
+    case COL_TYPE_TIMESTAMP:
+      k->width = 8;
+      break;
+    default:
+      k->width = s->columns[col].size;
+      break;
+  }
+}
+
+uint32_t join_key_len(const JoinKeyCol* a, const JoinKeyCol* b) {
+  if (a->type != COL_TYPE_STRING) {
+    return 8;
+  }
+  return a->width > b->width ? a->width : b->width;
+}
+
+void join_key_encode(const JoinKeyCol* k, uint32_t key_len, const void* row, uint8_t* out) {
+  const uint8_t* v = (const uint8_t*)row + k->offset;
+  if (k->type == COL_TYPE_INT) {
+    int32_t x;
+    memcpy(&x, v, 4);
+    int64_t wide = x;
+    memcpy(out, &wide, 8);
+  } else if (k->type == COL_TYPE_TIMESTAMP) {
+    memcpy(out, v, 8);
+  } else {
+    const uint8_t* nul = memchr(v, 0, k->width);
+    uint32_t len = nul ? (uint32_t)(nul - v) : k->width;
+    memcpy(out, v, len);
+    memset(out + len, 0, key_len - len);
+  }
+}
+
+/* A table slot; entry is the arena index + 1, 0 when the slot is empty */
+typedef struct {
+  uint32_t hash;
+  uint32_t entry;
+} JoinSlot;
+
+/* Partitions of both sides spilled by the pass at `level` */
+typedef struct {
+  FILE* build;
+  FILE* probe;
+  uint32_t level;
+} JoinPart;
+
+struct HashJoin {
+  Table* table;
+  JoinKeyCol build_key;
+  JoinKeyCol probe_key;
+  uint32_t build_row_size;
+  uint32_t probe_row_size;
+  uint32_t key_len;
+  size_t budget;
+  uint32_t row_offset;    /* Key, padded to 8 bytes */
+  uint32_t entry_size;    /* Key + build row */
+
+  /* Table of the current pass */
+  uint8_t* entries;
+  uint32_t n_entries;
+  uint32_t cap_entries;
+  JoinSlot* slots;
+  uint32_t n_slots;       /* Power of two, at least twice n_entries */
+
+  uint8_t* key;           /* Key of the row being added or matched */
+
+  /* Probe row being matched */
+  uint32_t probe_hash;
+  uint32_t match_slot;
+  bool matching;
+
+  /* Spilling */
+  uint32_t level;         /* Pass depth: selects the partitioning hash bits */
+  bool spilled;           /* This pass's build side went to partitions */
+  FILE* build_parts[HASHJOIN_FANOUT];
+  FILE* probe_parts[HASHJOIN_FANOUT];
+  JoinPart* pending;
+  uint32_t n_pending;
+  uint32_t pending_cap;
+  FILE* probe_in;         /* Probe partition read by the current pass */
+  uint8_t* build_buf;
+  uint8_t* probe_buf;
+  bool failed;
+};
+
+HashJoin* hashjoin_new(Table* t, const JoinKeyCol* build_key, uint32_t build_row_size,
+                       const JoinKeyCol* probe_key, uint32_t probe_row_size, size_t budget) {
+  HashJoin* h = calloc(1, sizeof(HashJoin));
+  if (!h) {
+    return NULL;
+  }
+  h->table = t;
+  h->build_key = *build_key;
+  h->probe_key = *probe_key;
+  h->build_row_size = build_row_size;
+  h->probe_row_size = probe_row_size;
+  h->key_len = join_key_len(build_key, probe_key);
+  h->budget = budget;
+  h->row_offset = (h->key_len + 7) & ~7u;
+  h->entry_size = h->row_offset + ((build_row_size + 7) & ~7u);
+  h->cap_entries = HASHJOIN_MIN_ENTRIES;
+  h->n_slots = HASHJOIN_MIN_ENTRIES * 2;
+  h->entries = malloc((size_t)h->cap_entries * h->entry_size);
+  h->slots = calloc(h->n_slots, sizeof(JoinSlot));
+  h->key = malloc(h->key_len);
+  h->build_buf = malloc(build_row_size);
+  h->probe_buf = malloc(probe_row_size);
+  if (!h->entries || !h->slots || !h->key || !h->build_buf || !h->probe_buf) {
+    hashjoin_free(h);
+    return NULL;
+  }
+  t->stats.join.hash_joins++;
+  return h;
+}
+
+static size_t table_bytes(const HashJoin* h) {
+  return (size_t)h->cap_entries * h->entry_size + (size_t)h->n_slots * sizeof(JoinSlot);
+}
+
+static void slot_insert(JoinSlot* slots, uint32_t n_slots, uint32_t hash, uint32_t entry) {
+  uint32_t mask = n_slots - 1;
+  uint32_t i = hash & mask;
+  while (slots[i].entry != 0) {
+    i = (i + 1) & mask;
+  }
+  slots[i].hash = hash;
+  slots[i].entry = entry;
+}
+
+/* Make room for one more entry, doubling the arena and the slots while
+ * the table stays within budget. False when the table is full. */
+static bool make_room(HashJoin* h) {
+  if (h->n_entries < h->cap_entries) {
+    return true;
+  }
+  if (h->level < HASHJOIN_MAX_LEVEL && table_bytes(h) * 2 > h->budget) {
+    return false;
+  }
+  uint8_t* entries = realloc(h->entries, (size_t)h->cap_entries * 2 * h->entry_size);
+  if (!entries) {
+    h->failed = true;
+    return false;
+  }
+  h->entries = entries;
+  JoinSlot* slots = calloc((size_t)h->n_slots * 2, sizeof(JoinSlot));
+  if (!slots) {
+    h->failed = true;
+    return false;
+  }
+  for (uint32_t i = 0; i < h->n_slots; i++) {
+    if (h->slots[i].entry != 0) {
+      slot_insert(slots, h->n_slots * 2, h->slots[i].hash, h->slots[i].entry);
+    }
+  }
+  free(h->slots);
+  h->slots = slots;
+  h->n_slots *= 2;
+  h->cap_entries *= 2;
+  return true;
+}
+
+/* Append a row to its partition of one side, creating the file on first use */
+static bool spill_row(HashJoin* h, FILE** parts, uint64_t hash, const void* row, uint32_t size) {
+  uint32_t p = (uint32_t)(hash >> (60 - 4 * h->level)) & (HASHJOIN_FANOUT - 1);
+  if (!parts[p]) {
+    parts[p] = tmpfile();
+    if (!parts[p]) {
+      return false;
+    }
+    h->table->stats.join.partitions++;
+  }
+  if (fwrite(row, size, 1, parts[p]) != 1) {
+    return false;
+  }
+  h->table->stats.join.bytes_spilled += size;
+  return true;
+}
+
+/* The build side does not fit: move the table's rows to the partitions,
+ * where the rest of the build side follows them */
+static bool spill_table(HashJoin* h) {
+  if (h->level == 0) {
+    h->table->stats.join.spilled++;
+  }
+  for (uint32_t i = 0; i < h->n_entries; i++) {
+    uint8_t* e = h->entries + (size_t)i * h->entry_size;
+    if (!spill_row(h, h->build_parts, hash_bytes(e, h->key_len), e + h->row_offset,
+                   h->build_row_size)) {
+      return false;
+    }
+  }
+  h->n_entries = 0;
+  memset(h->slots, 0, (size_t)h->n_slots * sizeof(JoinSlot));
+  h->spilled = true;
+  return true;
+}
+
+bool hashjoin_build(HashJoin* h, const void* row) {
+  uint8_t* key = h->key;
+  join_key_encode(&h->build_key, h->key_len, row, key);
+  uint64_t hash = hash_bytes(key, h->key_len);
+  if (!h->spilled && !make_room(h)) {
+    if (h->failed || !spill_table(h)) {
+      h->failed = true;
+      return false;
+    }
+  }
+  if (h->spilled) {
+    if (!spill_row(h, h->build_parts, hash, row, h->build_row_size)) {
+      h->failed = true;
+      return false;
+    }
+    return true;
+  }
+  uint8_t* e = h->entries + (size_t)h->n_entries * h->entry_size;
+  memcpy(e, key, h->key_len);
+  memset(e + h->key_len, 0, h->row_offset - h->key_len);
+  memcpy(e + h->row_offset, row, h->build_row_size);
+  h->n_entries++;
+  slot_insert(h->slots, h->n_slots, (uint32_t)hash, h->n_entries);
+  return true;
+}
+
+bool hashjoin_probe(HashJoin* h, const void* row) {
+  join_key_encode(&h->probe_key, h->key_len, row, h->key);
+  uint64_t hash = hash_bytes(h->key, h->key_len);
+  h->matching = false;
+  if (h->spilled) {
+    uint32_t p = (uint32_t)(hash >> (60 - 4 * h->level)) & (HASHJOIN_FANOUT - 1);
+    /* Without build rows in its partition the row cannot match */
+    if (h->build_parts[p] &&
+        !spill_row(h, h->probe_parts, hash, row, h->probe_row_size)) {
+      h->failed = true;
+      return false;
+    }
+    return true;
+  }
+  h->probe_hash = (uint32_t)hash;
+  h->match_slot = (uint32_t)hash & (h->n_slots - 1);
+  h->matching = true;
+  return true;
+}
+
+const void* hashjoin_match(HashJoin* h) {
+  if (!h->matching) {
+    return NULL;
+  }
+  uint32_t mask = h->n_slots - 1;
+  for (;;) {
+    JoinSlot* slot = &h->slots[h->match_slot];
+    if (slot->entry == 0) {
+      h->matching = false;
+      return NULL;
+    }
+    h->match_slot = (h->match_slot + 1) & mask;
+    if (slot->hash == h->probe_hash) {
+      uint8_t* e = h->entries + (size_t)(slot->entry - 1) * h->entry_size;
+      if (memcmp(e, h->key, h->key_len) == 0) {
+        return e + h->row_offset;
+      }
+    }
+  }
+}
+
+bool hashjoin_next_pass(HashJoin* h) {
+  if (h->failed) {
+    return false;
+  }
+  /* Queue the pairs this pass spilled; a partition without a partner on
+   * the other side holds no matches */
+  for (uint32_t p = 0; p < HASHJOIN_FANOUT; p++) {
+    FILE* build = h->build_parts[p];
+    FILE* probe = h->probe_parts[p];
+    h->build_parts[p] = NULL;
+    h->probe_parts[p] = NULL;
+    if (!build || !probe) {
+      if (build) {
+        fclose(build);
+      }
+      if (probe) {
+        fclose(probe);
+      }
+      continue;
+    }
+    if (h->n_pending == h->pending_cap) {
+      uint32_t cap = h->pending_cap ? h->pending_cap * 2 : HASHJOIN_FANOUT;
+      JoinPart* grown = realloc(h->pending, cap * sizeof(JoinPart));
+      if (!grown) {
+        fclose(build);
+        fclose(probe);
+        h->failed = true;
+        return false;
+      }
+      h->pending = grown;
+      h->pending_cap = cap;
+    }
+    h->pending[h->n_pending].build = build;
+    h->pending[h->n_pending].probe = probe;
+    h->pending[h->n_pending].level = h->level;
+    h->n_pending++;
+  }
+  if (h->probe_in) {
+    fclose(h->probe_in);
+    h->probe_in = NULL;
+  }
+  if (h->n_pending == 0) {
+    return false;
+  }
+
+  JoinPart part = h->pending[--h->n_pending];
+  h->n_entries = 0;
+  memset(h->slots, 0, (size_t)h->n_slots * sizeof(JoinSlot));
+  h->matching = false;
+  h->spilled = false;
+  h->level = part.level + 1;
+  h->probe_in = part.probe;
+  rewind(part.build);
+  bool ok = true;
+  while (ok && fread(h->build_buf, h->build_row_size, 1, part.build) == 1) {
+    ok = hashjoin_build(h, h->build_buf);
+  }
+  if (ferror(part.build)) {
+    ok = false;
+  }
+  fclose(part.build);
+  rewind(h->probe_in);
+  if (!ok) {
+    h->failed = true;
+  }
+  return ok;
+}
+
+const void* hashjoin_next_probe(HashJoin* h) {
+  if (!h->probe_in || h->failed) {
+    return NULL;
+  }
+  if (fread(h->probe_buf, h->probe_row_size, 1, h->probe_in) != 1) {
+    if (ferror(h->probe_in)) {
+      h->failed = true;
+    }
+    return NULL;
+  }
+  return h->probe_buf;
+}
+
+bool hashjoin_failed(const HashJoin* h) {
+  return h->failed;
+}
+
+size_t hashjoin_mem_bytes(const HashJoin* h) {
+  return table_bytes(h);
+}
+
+void hashjoin_free(HashJoin* h) {
+  if (!h) {
+    return;
+  }
+  for (uint32_t p = 0; p < HASHJOIN_FANOUT; p++) {
+    if (h->build_parts[p]) {
+      fclose(h->build_parts[p]);
+    }
+    if (h->probe_parts[p]) {
+      fclose(h->probe_parts[p]);
+    }
+  }
+  for (uint32_t i = 0; i < h->n_pending; i++) {
+    fclose(h->pending[i].build);
+    fclose(h->pending[i].probe);
+  }
+  if (h->probe_in) {
+    fclose(h->probe_in);
+  }
+  free(h->pending);
+  free(h->entries);
+  free(h->slots);
+  free(h->key);
+  free(h->build_buf);
+  free(h->probe_buf);
+  free(h);
+}
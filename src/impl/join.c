@@ -0,0 +1,382 @@
+#include "../include/join.h"
+#include "../include/hashjoin.h"
+#include "../include/bloom.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void join_view(const JoinSpec* j, const Table* t, Table* view) {
+  *view = *t;
+  view->root_page_num = INVALID_PAGE_NUM;
+  view->active_schema = j->schema;
+  view->row_size = compute_row_size(&j->schema);
+}
+
+/* Hash join: drains the build input (the side) into the hash table on
+ * open, then streams the probe input (the child) through it */
+typedef struct {
+  Operator base;
+  int build;
+  JoinKeyCol keys[JOIN_SIDES];
+  uint32_t row_sizes[JOIN_SIDES];
+  HashJoin* hash;
+  const void* probe_row;      /* Row whose matches are being returned */
+  bool in_pass;               /* Probe rows come from spilled partitions */
+  uint8_t* out;
+} HashJoinOp;
+
+static bool hash_join_open(Operator* self) {
+  HashJoinOp* s = (HashJoinOp*)self;
+  int b = s->build;
+  s->hash = hashjoin_new(self->table, &s->keys[b], s->row_sizes[b], &s->keys[1 - b],
+                         s->row_sizes[1 - b], self->table->sort_budget);
+  if (!s->hash || !operator_open(self->side)) {
+    return false;
+  }
+  const void* row;
+  while ((row = operator_next(self->side)) != NULL) {
+    if (!hashjoin_build(s->hash, row)) {
+      return false;
+    }
+  }
+  bool failed = operator_failed(self->side);
+  /* The build input is no longer needed */
+  operator_close(self->side);
+  self->side = NULL;
+  return !failed;
+}
+
+static const void* hash_join_next(Operator* self) {
+  HashJoinOp* s = (HashJoinOp*)self;
+  for (;;) {
+    if (s->probe_row) {
+      const void* match = hashjoin_match(s->hash);
+      if (match) {
+        const void* left = s->build == 0 ? match : s->probe_row;
+        const void* right = s->build == 0 ? s->probe_row : match;
+        memcpy(s->out, left, s->row_sizes[0]);
+        memcpy(s->out + s->row_sizes[0], right, s->row_sizes[1]);
+        return s->out;
+      }
+      s->probe_row = NULL;
+    }
+
+    const void* row = s->in_pass ? hashjoin_next_probe(s->hash) : operator_next(self->child);
+    if (!row) {
+      if (!s->in_pass && operator_failed(self->child)) {
+        return NULL;
+      }
+      if (!hashjoin_next_pass(s->hash)) {
+        self->failed = hashjoin_failed(s->hash);
+        return NULL;
+      }
+      s->in_pass = true;
+      continue;
+    }
+    if (!hashjoin_probe(s->hash, row)) {
+      self->failed = true;
+      return NULL;
+    }
+    s->probe_row = row;
+  }
+}
+
+static void hash_join_close(Operator* self) {
+  HashJoinOp* s = (HashJoinOp*)self;
+  if (s->hash) {
+    operator_note_mem(self, hashjoin_mem_bytes(s->hash));
+  }
+  hashjoin_free(s->hash);
+  free(s->out);
+}
+
+static void hash_join_describe(Operator* self, char* buf, size_t cap) {
+  snprintf(buf, cap, "build on %s, probe with %s, budget %zu bytes",
+           explain_table_name(self->side->table), explain_table_name(self->child->table),
+           self->table->sort_budget);
+}
+
+Operator* op_hash_join(Table* view, const JoinSpec* j, Operator* left, Operator* right, int build) {
+  if (!left || !right) {
+    operator_close(left);
+    operator_close(right);
+    return NULL;
+  }
+  Operator* sides[JOIN_SIDES] = { left, right };
+  HashJoinOp* s = (HashJoinOp*)operator_alloc(sizeof(HashJoinOp), sides[1 - build], view);
+  if (!s) {
+    operator_close(sides[build]);
+    return NULL;
+  }
+  s->base.open = hash_join_open;
+  s->base.next = hash_join_next;
+  s->base.close = hash_join_close;
+  s->base.name = "Hash Join";
+  s->base.describe = hash_join_describe;
+  s->base.side = sides[build];
+  s->build = build;
+  for (int i = 0; i < JOIN_SIDES; i++) {
+    join_key_col(&s->keys[i], &sides[i]->table->active_schema, j->key_cols[i]);
+    s->row_sizes[i] = sides[i]->table->row_size;
+  }
+  s->out = malloc(s->row_sizes[0] + s->row_sizes[1]);
+  if (!s->out) {
+    operator_close(&s->base);
+    return NULL;
+  }
+  return &s->base;
+}
+
+/* Index nested-loop join: the child is the outer input */
+typedef struct {
+  Operator base;
+  Table* inner;
+  int inner_side;
+  JoinKeyCol outer_key;
+  uint32_t row_sizes[JOIN_SIDES];
+  const void* outer[INDEX_JOIN_BATCH];    /* Outer rows of the batch */
+  int64_t outer_keys[INDEX_JOIN_BATCH];
+  uint32_t keys[INDEX_JOIN_BATCH];        /* The batch's keys, sorted and distinct */
+  const void* found[INDEX_JOIN_BATCH];    /* Inner row per key, NULL when absent */
+  uint32_t probe[INDEX_JOIN_BATCH];       /* Keys the Bloom filter lets through */
+  uint32_t n_outer;
+  uint32_t n_keys;
+  uint32_t pos;                           /* Next outer row to match */
+  bool outer_done;
+  uint8_t* out;
+} IndexJoinOp;
+
+static int cmp_key(const void* a, const void* b) {
+  uint32_t x = *(const uint32_t*)a;
+  uint32_t y = *(const uint32_t*)b;
+  return (x > y) - (x < y);
+}
+
+/* Whether an outer key can equal an int primary key, which the tree
+ * orders as its unsigned bits */
+static bool index_key(int64_t v, uint32_t* key) {
+  if (v < INT32_MIN || v > INT32_MAX) {
+    return false;
+  }
+  *key = (uint32_t)(int32_t)v;
+  return true;
+}
+
+static void index_join_found(Table* t, uint32_t key, void* row, void* ctx) {
+  (void)t;
+  IndexJoinOp* s = (IndexJoinOp*)ctx;
+  uint32_t* k = bsearch(&key, s->keys, s->n_keys, sizeof(uint32_t), cmp_key);
+  if (k) {
+    s->found[k - s->keys] = row;
+  }
+}
+
+/* Pull the next batch of outer rows and look up all of their keys */
+static bool index_join_fill(IndexJoinOp* s) {
+  Operator* outer = s->base.child;
+  s->n_outer = 0;
+  s->n_keys = 0;
+  s->pos = 0;
+  while (s->n_outer < INDEX_JOIN_BATCH) {
+    const void* row = operator_next(outer);
+    if (!row) {
+      s->outer_done = true;
+      break;
+    }
+    uint8_t enc[8];
+    join_key_encode(&s->outer_key, sizeof(enc), row, enc);
+    memcpy(&s->outer_keys[s->n_outer], enc, sizeof(int64_t));
+    s->outer[s->n_outer++] = row;
+    uint32_t key;
+    if (index_key(s->outer_keys[s->n_outer - 1], &key)) {
+      s->keys[s->n_keys++] = key;
+    }
+  }
+  if (s->n_outer == 0) {
+    return false;
+  }
+
+  qsort(s->keys, s->n_keys, sizeof(uint32_t), cmp_key);
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < s->n_keys; i++) {
+    if (n == 0 || s->keys[i] != s->keys[n - 1]) {
+      s->keys[n++] = s->keys[i];
+    }
+  }
+  s->n_keys = n;
+  memset(s->found, 0, n * sizeof(s->found[0]));
+
+  Table* t = s->inner;
+  uint32_t n_probe = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    if (bloom_table_may_contain(t, s->keys[i])) {
+      s->probe[n_probe++] = s->keys[i];
+    }
+  }
+  uint32_t hits = table_find_batch(t, s->probe, n_probe, index_join_found, s);
+  for (uint32_t i = hits; i < n_probe; i++) {
+    bloom_table_note_miss(t);
+  }
+  s->base.table->stats.join.index_lookups += n_probe;
+  return true;
+}
+
+static bool index_join_open(Operator* self) {
+  IndexJoinOp* s = (IndexJoinOp*)self;
+  self->table->stats.join.index_joins++;
+  /* The batch lives in the operator itself */
+  operator_note_mem(self, sizeof(*s) - sizeof(s->base) + s->row_sizes[0] + s->row_sizes[1]);
+  return true;
+}
+
+static const void* index_join_next(Operator* self) {
+  IndexJoinOp* s = (IndexJoinOp*)self;
+  for (;;) {
+    while (s->pos < s->n_outer) {
+      const void* row = s->outer[s->pos];
+      uint32_t key;
+      const uint32_t* k = NULL;
+      if (index_key(s->outer_keys[s->pos++], &key)) {
+        k = bsearch(&key, s->keys, s->n_keys, sizeof(uint32_t), cmp_key);
+      }
+      const void* match = k ? s->found[k - s->keys] : NULL;
+      if (match) {
+        const void* left = s->inner_side == 0 ? match : row;
+        const void* right = s->inner_side == 0 ? row : match;
+        memcpy(s->out, left, s->row_sizes[0]);
+        memcpy(s->out + s->row_sizes[0], right, s->row_sizes[1]);
+        return s->out;
+      }
+    }
+    if (s->outer_done || !index_join_fill(s)) {
+      return NULL;
+    }
+  }
+}
+
+static void index_join_close(Operator* self) {
+  free(((IndexJoinOp*)self)->out);
+}
+
+static void index_join_describe(Operator* self, char* buf, size_t cap) {
+  snprintf(buf, cap, "look up %s by primary key, batches of %u",
+           explain_table_name(((IndexJoinOp*)self)->inner), INDEX_JOIN_BATCH);
+}
+
+Operator* op_index_join(Table* view, const JoinSpec* j, Operator* outer, Table* inner, int inner_side) {
+  if (!outer) {
+    return NULL;
+  }
+  IndexJoinOp* s = (IndexJoinOp*)operator_alloc(sizeof(IndexJoinOp), outer, view);
+  if (!s) {
+    return NULL;
+  }
+  s->base.open = index_join_open;
+  s->base.next = index_join_next;
+  s->base.close = index_join_close;
+  s->base.name = "Index Join";
+  s->base.describe = index_join_describe;
+  s->inner = inner;
+  s->inner_side = inner_side;
+  join_key_col(&s->outer_key, &outer->table->active_schema, j->key_cols[1 - inner_side]);
+  s->row_sizes[inner_side] = inner->row_size;
+  s->row_sizes[1 - inner_side] = outer->table->row_size;
+  s->out = malloc(s->row_sizes[0] + s->row_sizes[1]);
+  if (!s->out) {
+    operator_close(&s->base);
+    return NULL;
+  }
+  return &s->base;
+}
+
+/* Merge join: a cursor per side, each on its table's leaf chain */
+typedef struct {
+  Operator base;
+  Table* tables[JOIN_SIDES];
+  Cursor* cursors[JOIN_SIDES];
+  uint8_t* out;
+} MergeJoinOp;
+
+/* Row under the cursor and its key, stepping over empty leaves; NULL at
+ * the end of the table */
+static const void* merge_row(Cursor* c, uint32_t* key) {
+  while (!c->end_of_table) {
+    void* node = get_page(c->table->pager, c->page_num);
+    if (c->cell_num < *leaf_node_num_cells(node)) {
+      *key = *leaf_key_t(c->table, node, c->cell_num);
+      return leaf_value_t(c->table, node, c->cell_num);
+    }
+    cursor_advance(c);
+  }
+  return NULL;
+}
+
+static bool merge_join_open(Operator* self) {
+  MergeJoinOp* s = (MergeJoinOp*)self;
+  for (int i = 0; i < JOIN_SIDES; i++) {
+    s->cursors[i] = table_start(s->tables[i]);
+    if (!s->cursors[i]) {
+      return false;
+    }
+  }
+  self->table->stats.join.merge_joins++;
+  return true;
+}
+
+static const void* merge_join_next(Operator* self) {
+  MergeJoinOp* s = (MergeJoinOp*)self;
+  for (;;) {
+    uint32_t keys[JOIN_SIDES];
+    const void* left = merge_row(s->cursors[0], &keys[0]);
+    const void* right = merge_row(s->cursors[1], &keys[1]);
+    if (!left || !right) {
+      return NULL;
+    }
+    /* Both trees order keys as unsigned; keys are unique on each side */
+    if (keys[0] < keys[1]) {
+      cursor_advance(s->cursors[0]);
+    } else if (keys[0] > keys[1]) {
+      cursor_advance(s->cursors[1]);
+    } else {
+      memcpy(s->out, left, s->tables[0]->row_size);
+      memcpy(s->out + s->tables[0]->row_size, right, s->tables[1]->row_size);
+      cursor_advance(s->cursors[0]);
+      cursor_advance(s->cursors[1]);
+      return s->out;
+    }
+  }
+}
+
+static void merge_join_describe(Operator* self, char* buf, size_t cap) {
+  MergeJoinOp* s = (MergeJoinOp*)self;
+  snprintf(buf, cap, "%s and %s on primary keys", explain_table_name(s->tables[0]),
+           explain_table_name(s->tables[1]));
+}
+
+static void merge_join_close(Operator* self) {
+  MergeJoinOp* s = (MergeJoinOp*)self;
+  for (int i = 0; i < JOIN_SIDES; i++) {
+    free(s->cursors[i]);
+  }
+  free(s->out);
+}
+
+Operator* op_merge_join(Table* view, Table* left, Table* right) {
+  MergeJoinOp* s = (MergeJoinOp*)operator_alloc(sizeof(MergeJoinOp), NULL, view);
+  if (!s) {
+    return NULL;
+  }
+  s->base.open = merge_join_open;
+  s->base.next = merge_join_next;
+  s->base.close = merge_join_close;
+  s->base.name = "Merge Join";
+  s->base.describe = merge_join_describe;
+  s->tables[0] = left;
+  s->tables[1] = right;
+  s->out = malloc(left->row_size + right->row_size);
+  if (!s->out) {
+    operator_close(&s->base);
+    return NULL;
+  }
+  return &s->base;
+}
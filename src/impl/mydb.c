@@ -3,6 +3,9 @@
 #include "../include/sql_executor.h"
 #include "../include/util.h"
 #include "../include/catalog.h"
+#include "../include/bloom.h"
+#include "../include/threadpool.h"
+#include "../include/plancache.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -131,12 +134,116 @@ static void json_row_handler(Table* t, const void* row, const Statement* st, voi
   jc->first = 0;
 }
 
+/* Aggregate handler for JSON output: one object keyed by aggregate name */
+static void json_agg_handler(const AggPlan* plan, const uint8_t* key, const uint8_t* state,
+                             const Statement* st, void* ctx) {
+  JsonCtx* jc = (JsonCtx*)ctx;
+  if (!jc->first) {
+    sb_append(jc->sb, ",");
+  }
+  sb_append(jc->sb, "{");
+  for (uint32_t i = 0; i < st->agg_output_count; ++i) {
+    if (i) sb_append(jc->sb, ",");
+    AggValue v;
+    const char* label = agg_output_value(plan, st->agg_outputs[i], key, state, &v);
+    sb_appendf(jc->sb, "\"%s\":", label);
+    if (v.kind == AGG_VALUE_INT) {
+      sb_appendf(jc->sb, "%lld", (long long)v.i);
+    } else if (v.kind == AGG_VALUE_DOUBLE) {
+      sb_appendf(jc->sb, "%.15g", v.d);
+    } else if (v.kind == AGG_VALUE_STRING) {
+      char buf[1024];
+      snprintf(buf, sizeof(buf), "%.*s", (int)v.len, v.str);
+      json_escape_append(jc->sb, buf);
+    } else {
+      sb_append(jc->sb, "null");
+    }
+  }
+  sb_append(jc->sb, "}");
+  jc->first = 0;
+}
+
+/* Error code reported for a statement that failed, NULL if it did not */
+static const char* execute_error(ExecuteResult er) {
+  switch (er) {
+    case EXECUTE_DUPLICATE_KEY:
+      return "duplicate_key";
+    case EXECUTE_TABLE_NOT_FOUND:
+      return "table_not_found";
+    case EXECUTE_INVALID_VALUE:
+      return "invalid_value";
+    case EXECUTE_FAILED:
+      return "failed";
+    default:
+      return NULL;
+  }
+}
+
+/* Statements that run for their effect and return no rows */
+static bool statement_writes(const Statement* st) {
+  return st->type == STATEMENT_INSERT || st->type == STATEMENT_DELETE || st->type == STATEMENT_UPDATE ||
+         st->type == STATEMENT_ANALYZE;
+}
+
+/* Run a prepared statement and render its result as JSON; the statement
+ * stays intact */
+static int statement_json(Table* table, Statement* st, char** out_json) {
+  if (!statement_apply_params(st, table)) {
+    return -6;
+  }
+
+  if (statement_writes(st)) {
+    const char* err = execute_error(statement_run(st, table));
+    StrBuf sb;
+    sb_init(&sb);
+    if (err) {
+      sb_appendf(&sb, "{\"ok\":false,\"error\":\"%s\"}", err);
+    } else {
+      sb_append(&sb, "{\"ok\":true}");
+    }
+    *out_json = sb.buf;
+    return 0;
+  }
+
+  if (st->type == STATEMENT_SELECT && st->explain != EXPLAIN_NONE) {
+    Explain ex;
+    execute_explain(st, table, &ex);
+    StrBuf sb;
+    sb_init(&sb);
+    sb_appendf(&sb, "{\"ok\":true,\"analyze\":%s,\"plan\":", ex.analyze ? "true" : "false");
+    explain_append_json(&ex, &sb);
+    sb_append(&sb, "}");
+    *out_json = sb.buf;
+    return 0;
+  }
+
+  if (st->type == STATEMENT_SELECT) {
+    StrBuf sb;
+    sb_init(&sb);
+    sb_append(&sb, "{\"ok\":true,\"rows\":[");
+    JsonCtx jctx = {.sb = &sb, .first = 1};
+    if (st->aggregate) {
+      execute_aggregate(st, table, json_agg_handler, &jctx);
+    } else {
+      execute_select_core(st, table, json_row_handler, &jctx);
+    }
+
+    sb_append(&sb, "]}");
+    *out_json = sb.buf;
+    return 0;
+  }
+  return -5;
+}
+
 /* Public API */
 MYDB_Handle mydb_open(const char* filename) {
   if (!filename) {
     return NULL;
   }
-  return (MYDB_Handle)db_open(filename);
+  Table* t = db_open(filename);
+  /* Without a cache (out of memory) statements are prepared every time */
+  t->plans = plancache_new(PLAN_CACHE_DEFAULT_ENTRIES);
+  return (MYDB_Handle)t;
 }
 
 MYDB_Handle mydb_open_with_ems(const char* filename) {
@@ -155,6 +262,7 @@ void mydb_close(MYDB_Handle h) {
   if (!h) {
     return;
   }
+  plancache_free(((Table*)h)->plans);
   db_close((Table*)h);
 }
 
@@ -177,6 +285,18 @@ int mydb_execute_json(MYDB_Handle h, const char* sql, char** out_json) {
   }
   Table* table = (Table*)h;
 
+  /* Statements that differ only in constants share one prepared plan */
+  if (table->plans) {
+    PrepareResult cached_pr;
+    Statement* cached = plancache_statement(table->plans, table, sql, &cached_pr);
+    if (cached) {
+      return statement_json(table, cached, out_json);
+    }
+    if (cached_pr != PREPARE_SUCCESS) {
+      return cached_pr == PREPARE_SYNTAX_ERROR ? -3 : -4;
+    }
+  }
+
   InputBuffer ib;
   ib.buffer = strdup(sql);
   ib.buffer_length = strlen(ib.buffer) + 1;
@@ -204,34 +324,10 @@ int mydb_execute_json(MYDB_Handle h, const char* sql, char** out_json) {
     return -4;
   }
 
-  if (st.type == STATEMENT_INSERT || st.type == STATEMENT_DELETE) {
-    ExecuteResult er = execute_statement(&st, table);
-    StrBuf sb;
-    sb_init(&sb);
-    if (er == EXECUTE_DUPLICATE_KEY) {
-      sb_append(&sb, "{\"ok\":false,\"error\":\"duplicate_key\"}");
-    } else {
-      sb_append(&sb, "{\"ok\":true}");
-    }
-    *out_json = sb.buf;
-    free(ib.buffer);
-    return 0;
-  }
-
-  if (st.type == STATEMENT_SELECT) {
-    StrBuf sb;
-    sb_init(&sb);
-    sb_append(&sb, "{\"ok\":true,\"rows\":[");
-    JsonCtx jctx = {.sb = &sb, .first = 1};
-    execute_select_core(&st, table, json_row_handler, &jctx);
-
-    sb_append(&sb, "]}");
-    *out_json = sb.buf;
-    free(ib.buffer);
-    return 0;
-  }
+  int rc = statement_json(table, &st, out_json);
+  statement_cleanup(&st);
   free(ib.buffer);
-  return -5;
+  return rc;
 }
 
 int mydb_execute_json_with_ems(MYDB_Handle h, const char* sql, char** out_json) {
@@ -303,9 +399,12 @@ int mydb_execute_json_with_ems(MYDB_Handle h, const char* sql, char** out_json)
     return -4;
   }
 
-  if (st.type == STATEMENT_INSERT || st.type == STATEMENT_DELETE) {
+  if (statement_writes(&st)) {
     fprintf(stderr, "[DEBUG-WASM] About to execute %s statement\n",
-            st.type == STATEMENT_INSERT ? "INSERT" : "DELETE");
+            st.type == STATEMENT_INSERT   ? "INSERT"
+            : st.type == STATEMENT_UPDATE ? "UPDATE"
+            : st.type == STATEMENT_DELETE ? "DELETE"
+                                          : "ANALYZE");
     fflush(stderr);
     fprintf(stderr, "[DEBUG-WASM] Table state before execute: root_page_num=%u\n", table->root_page_num);
     fflush(stderr);
@@ -314,19 +413,20 @@ int mydb_execute_json_with_ems(MYDB_Handle h, const char* sql, char** out_json)
     fprintf(stderr, "[DEBUG-WASM] execute_statement returned: %d\n", er);
     fflush(stderr);
 
+    const char* err = execute_error(er);
     StrBuf sb;
     sb_init(&sb);
-    if (er == EXECUTE_DUPLICATE_KEY) {
-      fprintf(stderr, "[DEBUG-WASM] Duplicate key error\n");
+    if (err) {
+      fprintf(stderr, "[DEBUG-WASM] Execution failed: %s\n", err);
       fflush(stderr);
-      sb_append(&sb, "{\"ok\":false,\"error\":\"duplicate_key\"}");
+      sb_appendf(&sb, "{\"ok\":false,\"error\":\"%s\"}", err);
     } else {
       fprintf(stderr, "[DEBUG-WASM] Execution successful\n");
       fflush(stderr);
       sb_append(&sb, "{\"ok\":true}");
     }
     *out_json = sb.buf;
-    if (er != EXECUTE_DUPLICATE_KEY) {
+    if (!err) {
       fprintf(stderr, "[DEBUG-WASM] Starting persistence...\n");
       fflush(stderr);
       if (table && table->pager && table->pager->filename) {
@@ -344,7 +444,7 @@ int mydb_execute_json_with_ems(MYDB_Handle h, const char* sql, char** out_json)
       fprintf(stderr, "[DEBUG-WASM] Persistence completed\n");
       fflush(stderr);
     } else {
-      fprintf(stderr, "[DEBUG-WASM] Skipping persistence due to duplicate key\n");
+      fprintf(stderr, "[DEBUG-WASM] Skipping persistence after the error\n");
       fflush(stderr);
     }
     free(ib.buffer);
@@ -356,7 +456,12 @@ int mydb_execute_json_with_ems(MYDB_Handle h, const char* sql, char** out_json)
     sb_init(&sb);
     sb_append(&sb, "{\"ok\":true,\"rows\":[");
     JsonCtx jctx = {.sb = &sb, .first = 1};
-    execute_select_core(&st, table, json_row_handler, &jctx);
+    if (st.aggregate) {
+      execute_aggregate(&st, table, json_agg_handler, &jctx);
+    } else {
+      execute_select_core(&st, table, json_row_handler, &jctx);
+    }
+    statement_cleanup(&st);
 
     sb_append(&sb, "]}");
     *out_json = sb.buf;
@@ -367,3 +472,155 @@ int mydb_execute_json_with_ems(MYDB_Handle h, const char* sql, char** out_json)
   return -5;
 }
 
+/* Build a Bloom filter for `table` without changing the active table */
+int mydb_enable_bloom(MYDB_Handle h, const char* table) {
+  if (!h || !table) {
+    return -2;
+  }
+  Table* t = (Table*)h;
+  uint32_t saved_root = t->root_page_num;
+  TableSchema saved_schema = t->active_schema;
+  uint32_t saved_row_size = t->row_size;
+
+  int rc = -3;
+  if (table_activate(t, table) >= 0) {
+    rc = bloom_enable(t) == 0 ? 0 : -4;
+  }
+
+  t->root_page_num = saved_root;
+  t->active_schema = saved_schema;
+  t->row_size = saved_row_size;
+  return rc;
+}
+
+int mydb_stats_json(MYDB_Handle h, char** out_json) {
+  if (!out_json) {
+    return -1;
+  }
+  *out_json = NULL;
+  if (!h) {
+    return -2;
+  }
+  StrBuf sb;
+  sb_init(&sb);
+  sb_append(&sb, "{\"ok\":true,\"stats\":");
+  stats_append_json((Table*)h, &sb);
+  sb_append(&sb, "}");
+  *out_json = sb.buf;
+  return 0;
+}
+
+/* Memory budget for ORDER BY sorts on this handle */
+int mydb_set_sort_budget(MYDB_Handle h, unsigned long bytes) {
+  if (!h || bytes == 0) {
+    return -2;
+  }
+  ((Table*)h)->sort_budget = (size_t)bytes;
+  return 0;
+}
+
+/* Worker threads a scan on this handle may use (1 = serial) */
+int mydb_set_threads(MYDB_Handle h, unsigned int threads) {
+  if (!h || threads == 0) {
+    return -2;
+  }
+  ((Table*)h)->threads = threads > THREADPOOL_MAX_WORKERS ? THREADPOOL_MAX_WORKERS : threads;
+  return 0;
+}
+
+/* Plan cache size in statements on this handle (0 = off) */
+int mydb_set_plan_cache(MYDB_Handle h, unsigned int entries) {
+  Table* t = (Table*)h;
+  if (!t || !t->plans) {
+    return -2;
+  }
+  return plancache_resize(t->plans, entries) ? 0 : -1;
+}
+
+/* A statement parsed and resolved once, then executed many times */
+typedef struct {
+  Table* table;
+  char* sql;        /* The legacy INSERT form points into it */
+  Statement st;
+} PreparedStmt;
+
+int mydb_prepare(MYDB_Handle h, const char* sql, MYDB_Stmt* out_stmt) {
+  if (!out_stmt) {
+    return -1;
+  }
+  *out_stmt = NULL;
+  if (!h || !sql) {
+    return -2;
+  }
+  /* CREATE TABLE and USE take effect while being prepared, so only
+   * statements that do their work when executed can be prepared */
+  const char* s = sql;
+  while (*s == ' ' || *s == '\t') {
+    s++;
+  }
+  if (strncmp(s, "select", 6) != 0 && strncmp(s, "insert", 6) != 0 &&
+      strncmp(s, "update", 6) != 0 && strncmp(s, "delete", 6) != 0) {
+    return -4;
+  }
+
+  PreparedStmt* ps = calloc(1, sizeof(PreparedStmt));
+  if (!ps || !(ps->sql = strdup(sql))) {
+    free(ps);
+    return -1;
+  }
+  ps->table = (Table*)h;
+  InputBuffer ib;
+  ib.buffer = ps->sql;
+  ib.buffer_length = strlen(ps->sql) + 1;
+  ib.input_length = (ssize_t)strlen(ps->sql);
+  PrepareResult pr = prepare_statement(&ib, &ps->st, ps->table);
+  if (pr != PREPARE_SUCCESS) {
+    statement_cleanup(&ps->st);
+    free(ps->sql);
+    free(ps);
+    return pr == PREPARE_SYNTAX_ERROR ? -3 : -4;
+  }
+  *out_stmt = (MYDB_Stmt)ps;
+  return 0;
+}
+
+int mydb_bind_text(MYDB_Stmt stmt, int idx, const char* value) {
+  if (!stmt || !value || idx < 1) {
+    return -2;
+  }
+  return statement_bind(&((PreparedStmt*)stmt)->st, (uint32_t)idx, value) ? 0 : -3;
+}
+
+int mydb_bind_int(MYDB_Stmt stmt, int idx, int value) {
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%d", value);
+  return mydb_bind_text(stmt, idx, buf);
+}
+
+int mydb_bind_int64(MYDB_Stmt stmt, int idx, long long value) {
+  char buf[24];
+  snprintf(buf, sizeof(buf), "%lld", value);
+  return mydb_bind_text(stmt, idx, buf);
+}
+
+int mydb_execute_prepared(MYDB_Stmt stmt, char** out_json) {
+  if (!out_json) {
+    return -1;
+  }
+  *out_json = NULL;
+  if (!stmt) {
+    return -2;
+  }
+  PreparedStmt* ps = (PreparedStmt*)stmt;
+  return statement_json(ps->table, &ps->st, out_json);
+}
+
+void mydb_finalize(MYDB_Stmt stmt) {
+  if (!stmt) {
+    return;
+  }
+  PreparedStmt* ps = (PreparedStmt*)stmt;
+  statement_cleanup(&ps->st);
+  free(ps->sql);
+  free(ps);
+}
@@ -0,0 +1,885 @@
+#include "../include/operator.h"
+#include "../include/bloom.h"
+#include "../include/zonemap.h"
+#include "../include/pager.h"
+#include "../include/extsort.h"
+#include "../include/threadpool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+Operator* operator_alloc(size_t size, Operator* child, Table* t) {
+  Operator* op = calloc(1, size);
+  if (!op) {
+    operator_close(child);
+    return NULL;
+  }
+  op->child = child;
+  op->table = t;
+  op->est_pages = -1;
+  op->est_rows = -1;
+  return op;
+}
+
+void operator_note_mem(Operator* op, size_t bytes) {
+  if (bytes > op->mem_peak) {
+    op->mem_peak = bytes;
+  }
+}
+
+void operator_explain(Operator* root, Explain* ex) {
+  if (!root) {
+    return;
+  }
+  char detail[160] = "";
+  if (root->describe) {
+    root->describe(root, detail, sizeof(detail));
+  }
+  ExplainNode* node = explain_add(ex, root->name, "%s", detail);
+  if (node) {
+    node->est_pages = root->est_pages;
+    node->est_rows = root->est_rows;
+  }
+  if (ex->analyze) {
+    root->prof = node;
+  }
+  int saved = ex->parent;
+  ex->parent = explain_index(ex, node);
+  operator_explain(root->child, ex);
+  operator_explain(root->side, ex);
+  ex->parent = saved;
+}
+
+static bool open_tree(Operator* op) {
+  if (op->child && !operator_open(op->child)) {
+    return false;
+  }
+  if (op->open && !op->open(op)) {
+    op->failed = true;
+    return false;
+  }
+  return true;
+}
+
+bool operator_open(Operator* op) {
+  if (!op->prof) {
+    return open_tree(op);
+  }
+  ExplainMark mark;
+  explain_mark(op->table->pager, &mark);
+  bool ok = open_tree(op);
+  explain_account(op->prof, op->table->pager, &mark, 0);
+  return ok;
+}
+
+const void* operator_next(Operator* op) {
+  if (op->failed) {
+    return NULL;
+  }
+  if (!op->prof) {
+    return op->next(op);
+  }
+  ExplainMark mark;
+  explain_mark(op->table->pager, &mark);
+  const void* row = op->next(op);
+  explain_account(op->prof, op->table->pager, &mark, row ? 1 : 0);
+  return row;
+}
+
+bool operator_failed(const Operator* op) {
+  for (; op; op = op->child) {
+    if (op->failed) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void operator_close(Operator* op) {
+  if (!op) {
+    return;
+  }
+  if (op->close) {
+    op->close(op);
+  }
+  if (op->prof) {
+    op->prof->mem_bytes = op->mem_peak;
+  }
+  operator_close(op->child);
+  operator_close(op->side);
+  free(op);
+}
+
+/* Growable array of row pointers */
+typedef struct {
+  RowRef* rows;
+  size_t nrows;
+  size_t capacity;
+} RowBuf;
+
+static bool rowbuf_push(RowBuf* buf, const void* row) {
+  if (buf->nrows == buf->capacity) {
+    size_t newcap = buf->capacity ? buf->capacity * 2 : 256;
+    RowRef* tmp = realloc(buf->rows, newcap * sizeof(RowRef));
+    if (!tmp) {
+      return false;
+    }
+    buf->rows = tmp;
+    buf->capacity = newcap;
+  }
+  buf->rows[buf->nrows++].row = row;
+  return true;
+}
+
+/* Leaf scan */
+typedef struct {
+  Operator base;
+  const Predicate* prog;
+  const Expr* zone_where;
+  uint32_t stride;
+  LeafWalk walk;          /* Leaves still to load */
+  bool done;              /* A range scan passed its last key */
+  uint8_t* rows;          /* First row of the current leaf */
+  uint32_t num_cells;
+  uint32_t batch_end;     /* Cells of the current leaf already filtered */
+  uint8_t* batch;         /* First row of the current batch */
+  uint32_t sel[PREDICATE_BATCH_MAX];
+  uint32_t n_sel;
+  uint32_t pos;
+  bool ranged;            /* Range scan: keys lo..hi only */
+  uint32_t lo;
+  uint32_t hi;
+  bool started;           /* A leaf has been loaded */
+} LeafScanOp;
+
+static bool leaf_scan_open(Operator* self) {
+  LeafScanOp* s = (LeafScanOp*)self;
+  s->stride = leaf_cell_size(self->table);
+  if (s->ranged) {
+    leaf_walk_range(&s->walk, self->table, s->lo, s->hi);
+  } else {
+    leaf_walk_init(&s->walk, self->table, self->table->root_page_num);
+  }
+  return true;
+}
+
+/* First cell of a range scan's first leaf with a key of at least `lo` */
+static uint32_t range_scan_first(LeafScanOp* s, void* node, uint32_t num_cells) {
+  Table* t = s->base.table;
+  uint32_t lo = 0;
+  uint32_t hi = num_cells;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (*leaf_key_t(t, node, mid) < s->lo) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+/* Cells of a range scan's leaf up to key `hi`; a key past it ends the scan */
+static uint32_t range_scan_cells(LeafScanOp* s, void* node, uint32_t num_cells) {
+  Table* t = s->base.table;
+  if (num_cells == 0 || *leaf_key_t(t, node, num_cells - 1) <= s->hi) {
+    return num_cells;
+  }
+  uint32_t lo = 0;
+  uint32_t hi = num_cells - 1;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (*leaf_key_t(t, node, mid) <= s->hi) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  s->done = true;
+  return lo;
+}
+
+static const void* leaf_scan_next(Operator* self) {
+  LeafScanOp* s = (LeafScanOp*)self;
+  Table* t = self->table;
+  for (;;) {
+    if (s->pos < s->n_sel) {
+      return s->batch + (size_t)s->sel[s->pos++] * s->stride;
+    }
+
+    /* Load the next leaf, skipping those the zone map rules out: from the
+     * parent when the leaf's zone is known, so such a leaf is not read */
+    while (s->batch_end >= s->num_cells) {
+      if (s->done) {
+        return NULL;
+      }
+      void* node;
+      LeafMayMatchFn zones = s->zone_where ? zonemap_subtree_may_match : NULL;
+      uint32_t page_num = leaf_walk_next(&s->walk, zones, s->zone_where, &node);
+      if (page_num == INVALID_PAGE_NUM) {
+        return NULL;
+      }
+      uint32_t num_cells = *leaf_node_num_cells(node);
+      uint32_t first = 0;
+      if (s->ranged) {
+        first = s->started ? 0 : range_scan_first(s, node, num_cells);
+        num_cells = range_scan_cells(s, node, num_cells);
+      }
+      s->started = true;
+      if (s->zone_where && !zonemap_leaf_may_match(t, page_num, s->zone_where)) {
+        continue;
+      }
+      s->rows = leaf_value_t(t, node, 0);
+      s->num_cells = num_cells;
+      s->batch_end = first;
+    }
+
+    uint32_t n = s->num_cells - s->batch_end;
+    if (n > PREDICATE_BATCH_MAX) {
+      n = PREDICATE_BATCH_MAX;
+    }
+    s->batch = s->rows + (size_t)s->batch_end * s->stride;
+    s->batch_end += n;
+    s->pos = 0;
+    if (s->prog) {
+      s->n_sel = predicate_filter_batch(s->prog, s->batch, s->stride, n, s->sel);
+    } else {
+      for (uint32_t i = 0; i < n; i++) {
+        s->sel[i] = i;
+      }
+      s->n_sel = n;
+    }
+  }
+}
+
+static void leaf_scan_describe(Operator* self, char* buf, size_t cap) {
+  LeafScanOp* s = (LeafScanOp*)self;
+  char range[48] = "";
+  if (s->ranged) {
+    snprintf(range, sizeof(range), ", keys %d to %d", (int32_t)s->lo, (int32_t)s->hi);
+  }
+  snprintf(buf, cap, "on %s%s%s%s", explain_table_name(self->table), range,
+           s->prog ? ", compiled filter" : "", s->zone_where ? ", zone maps" : "");
+}
+
+Operator* op_leaf_scan(Table* t, const Predicate* prog, const Expr* zone_where) {
+  LeafScanOp* s = (LeafScanOp*)operator_alloc(sizeof(LeafScanOp), NULL, t);
+  if (!s) {
+    return NULL;
+  }
+  s->base.open = leaf_scan_open;
+  s->base.next = leaf_scan_next;
+  s->base.name = "Leaf Scan";
+  s->base.describe = leaf_scan_describe;
+  s->prog = prog;
+  s->zone_where = zone_where;
+  return &s->base;
+}
+
+Operator* op_range_scan(Table* t, uint32_t lo, uint32_t hi, const Predicate* prog,
+                        const Expr* zone_where) {
+  Operator* op = op_leaf_scan(t, prog, zone_where);
+  if (!op) {
+    return NULL;
+  }
+  LeafScanOp* s = (LeafScanOp*)op;
+  op->name = "Range Scan";
+  s->ranged = true;
+  s->lo = lo;
+  s->hi = hi;
+  return op;
+}
+
+/* Parallel scan: the tree is cut into key ranges at the first internal
+ * level with enough subtrees to keep every worker busy, and each range is
+ * scanned and filtered on a worker into its own buffer of row pointers.
+ * Ranges are handed out in key order, each as soon as it is finished, or in
+ * completion order when the caller does not need key order. */
+#define PARALLEL_RANGES_PER_THREAD 4
+
+typedef struct ParallelScanOp ParallelScanOp;
+
+typedef struct {
+  ParallelScanOp* scan;
+  uint32_t root;          /* Subtree whose leaves make up the range */
+  RowBuf rows;
+  bool oom;
+} ScanRange;
+
+struct ParallelScanOp {
+  Operator base;
+  const Predicate* prog;
+  const Expr* zone_where;
+  RowFilterFn fn;
+  const void* ctx;
+  bool ordered;
+  uint32_t threads;
+  ScanRange* ranges;
+  uint32_t n_ranges;
+  size_t buffered;        /* Bytes of the range buffers handed out so far */
+  TaskGroup* tasks;
+  bool cancel;            /* Set on close; workers stop at the next leaf */
+  uint32_t returned;      /* Ranges handed out so far */
+  uint32_t cur;           /* Range being returned (UINT32_MAX = none) */
+  size_t pos;
+};
+
+/* Roots of the subtrees under the root, level by level until there are at
+ * least `want` of them or the level is all leaves; in key order. Subtrees
+ * the zone maps rule out are left out. */
+static uint32_t scan_range_starts(Table* t, uint32_t want, const Expr* zone_where, uint32_t* starts) {
+  uint32_t level[TABLE_MAX_PAGES];
+  uint32_t n = 0;
+  if (!zone_where || zonemap_subtree_may_match(t, t->root_page_num, zone_where)) {
+    starts[n++] = t->root_page_num;
+  }
+  while (n > 0 && n < want && get_node_type(get_page(t->pager, starts[0])) == NODE_INTERNAL) {
+    uint32_t m = 0;
+    for (uint32_t i = 0; i < n; i++) {
+      void* node = get_page(t->pager, starts[i]);
+      uint32_t num_keys = *internal_node_num_keys(node);
+      for (uint32_t c = 0; c <= num_keys && m < TABLE_MAX_PAGES; c++) {
+        uint32_t child = *internal_node_child(node, c);
+        if (!zone_where || zonemap_subtree_may_match(t, child, zone_where)) {
+          level[m++] = child;
+        }
+      }
+    }
+    memcpy(starts, level, m * sizeof(uint32_t));
+    n = m;
+  }
+  return n;
+}
+
+static void scan_range_task(void* arg) {
+  ScanRange* r = (ScanRange*)arg;
+  ParallelScanOp* s = r->scan;
+  Table* t = s->base.table;
+  uint32_t stride = leaf_cell_size(t);
+  uint32_t sel[PREDICATE_BATCH_MAX];
+
+  LeafWalk walk;
+  leaf_walk_init(&walk, t, r->root);
+  LeafMayMatchFn zones = s->zone_where ? zonemap_subtree_may_match : NULL;
+  for (;;) {
+    if (__atomic_load_n(&s->cancel, __ATOMIC_RELAXED)) {
+      return;
+    }
+    void* node;
+    uint32_t page_num = leaf_walk_next(&walk, zones, s->zone_where, &node);
+    if (page_num == INVALID_PAGE_NUM) {
+      return;
+    }
+    if (s->zone_where && !zonemap_leaf_may_match(t, page_num, s->zone_where)) {
+      continue;
+    }
+    uint8_t* rows = leaf_value_t(t, node, 0);
+    uint32_t num_cells = *leaf_node_num_cells(node);
+    for (uint32_t start = 0; start < num_cells; start += PREDICATE_BATCH_MAX) {
+      uint32_t n = num_cells - start;
+      if (n > PREDICATE_BATCH_MAX) {
+        n = PREDICATE_BATCH_MAX;
+      }
+      uint8_t* batch = rows + (size_t)start * stride;
+      uint32_t n_sel = n;
+      if (s->prog) {
+        n_sel = predicate_filter_batch(s->prog, batch, stride, n, sel);
+      } else {
+        for (uint32_t i = 0; i < n; i++) {
+          sel[i] = i;
+        }
+      }
+      for (uint32_t i = 0; i < n_sel; i++) {
+        const void* row = batch + (size_t)sel[i] * stride;
+        if (s->fn && !s->fn(t, row, s->ctx)) {
+          continue;
+        }
+        if (!rowbuf_push(&r->rows, row)) {
+          r->oom = true;
+          return;
+        }
+      }
+    }
+  }
+}
+
+static bool parallel_scan_open(Operator* self) {
+  ParallelScanOp* s = (ParallelScanOp*)self;
+  Table* t = self->table;
+  uint32_t starts[TABLE_MAX_PAGES];
+  s->n_ranges = scan_range_starts(t, s->threads * PARALLEL_RANGES_PER_THREAD, s->zone_where, starts);
+  s->ranges = calloc(s->n_ranges ? s->n_ranges : 1, sizeof(ScanRange));
+  s->tasks = task_group_new(s->n_ranges);
+  if (!s->ranges || !s->tasks) {
+    return false;
+  }
+
+  threadpool_start(s->threads);
+  for (uint32_t i = 0; i < s->n_ranges; i++) {
+    ScanRange* r = &s->ranges[i];
+    r->scan = s;
+    r->root = starts[i];
+    task_group_submit(s->tasks, i, scan_range_task, r);
+  }
+  return true;
+}
+
+static const void* parallel_scan_next(Operator* self) {
+  ParallelScanOp* s = (ParallelScanOp*)self;
+  for (;;) {
+    if (s->cur != UINT32_MAX) {
+      RowBuf* buf = &s->ranges[s->cur].rows;
+      if (s->pos < buf->nrows) {
+        return buf->rows[s->pos++].row;
+      }
+      free(buf->rows);
+      buf->rows = NULL;
+      s->cur = UINT32_MAX;
+    }
+    if (s->returned == s->n_ranges) {
+      return NULL;
+    }
+
+    uint32_t i;
+    if (s->ordered) {
+      i = s->returned;
+      task_group_wait_one(s->tasks, i);
+    } else {
+      i = task_group_wait_any(s->tasks);
+    }
+    s->returned++;
+    if (s->ranges[i].oom) {
+      self->failed = true;
+      return NULL;
+    }
+    /* Finished ranges wait with their buffers, so all of them may be
+     * held at once */
+    s->buffered += s->ranges[i].rows.capacity * sizeof(RowRef);
+    operator_note_mem(self, s->buffered);
+    s->cur = i;
+    s->pos = 0;
+  }
+}
+
+static void parallel_scan_close(Operator* self) {
+  ParallelScanOp* s = (ParallelScanOp*)self;
+  __atomic_store_n(&s->cancel, true, __ATOMIC_RELAXED);
+  task_group_free(s->tasks);
+  if (s->ranges) {
+    for (uint32_t i = 0; i < s->n_ranges; i++) {
+      free(s->ranges[i].rows.rows);
+    }
+    free(s->ranges);
+  }
+}
+
+static void parallel_scan_describe(Operator* self, char* buf, size_t cap) {
+  ParallelScanOp* s = (ParallelScanOp*)self;
+  snprintf(buf, cap, "on %s, %u threads, %s%s%s%s", explain_table_name(self->table), s->threads,
+           s->ordered ? "key order" : "completion order", s->prog ? ", compiled filter" : "",
+           s->fn ? ", row filter" : "", s->zone_where ? ", zone maps" : "");
+}
+
+Operator* op_parallel_scan(Table* t, const Predicate* prog, const Expr* zone_where,
+                           RowFilterFn fn, const void* ctx, uint32_t threads, bool ordered) {
+  ParallelScanOp* s = (ParallelScanOp*)operator_alloc(sizeof(ParallelScanOp), NULL, t);
+  if (!s) {
+    return NULL;
+  }
+  s->base.open = parallel_scan_open;
+  s->base.next = parallel_scan_next;
+  s->base.close = parallel_scan_close;
+  s->base.name = "Parallel Scan";
+  s->base.describe = parallel_scan_describe;
+  s->prog = prog;
+  s->zone_where = zone_where;
+  s->fn = fn;
+  s->ctx = ctx;
+  s->threads = threads ? threads : 1;
+  s->ordered = ordered;
+  s->cur = UINT32_MAX;
+  return &s->base;
+}
+
+/* Primary-key set scan */
+typedef struct {
+  Operator base;
+  uint32_t* keys;
+  uint32_t n_keys;
+  RowBuf found;
+  size_t pos;
+  bool oom;
+} KeyScanOp;
+
+static void key_scan_collect(Table* t, uint32_t key, void* row, void* ctx) {
+  (void)t;
+  (void)key;
+  KeyScanOp* s = (KeyScanOp*)ctx;
+  if (!s->oom && !rowbuf_push(&s->found, row)) {
+    s->oom = true;
+  }
+}
+
+static bool key_scan_open(Operator* self) {
+  KeyScanOp* s = (KeyScanOp*)self;
+  Table* t = self->table;
+  uint32_t n_probe = 0;
+  for (uint32_t i = 0; i < s->n_keys; i++) {
+    if (bloom_table_may_contain(t, s->keys[i])) {
+      s->keys[n_probe++] = s->keys[i];
+    }
+  }
+  /* All matches are resolved in a single ordered descent */
+  uint32_t found = table_find_batch(t, s->keys, n_probe, key_scan_collect, s);
+  for (uint32_t i = found; i < n_probe; i++) {
+    bloom_table_note_miss(t);
+  }
+  operator_note_mem(self, s->n_keys * sizeof(uint32_t) + s->found.capacity * sizeof(RowRef));
+  return !s->oom;
+}
+
+static const void* key_scan_next(Operator* self) {
+  KeyScanOp* s = (KeyScanOp*)self;
+  return s->pos < s->found.nrows ? s->found.rows[s->pos++].row : NULL;
+}
+
+static void key_scan_close(Operator* self) {
+  KeyScanOp* s = (KeyScanOp*)self;
+  free(s->keys);
+  free(s->found.rows);
+}
+
+static void key_scan_describe(Operator* self, char* buf, size_t cap) {
+  snprintf(buf, cap, "on %s, %u primary keys", explain_table_name(self->table),
+           ((KeyScanOp*)self)->n_keys);
+}
+
+Operator* op_key_scan(Table* t, uint32_t* keys, uint32_t n) {
+  KeyScanOp* s = (KeyScanOp*)operator_alloc(sizeof(KeyScanOp), NULL, t);
+  if (!s) {
+    free(keys);
+    return NULL;
+  }
+  s->base.open = key_scan_open;
+  s->base.next = key_scan_next;
+  s->base.close = key_scan_close;
+  s->base.name = "Key Scan";
+  s->base.describe = key_scan_describe;
+  s->keys = keys;
+  s->n_keys = n;
+  return &s->base;
+}
+
+/* Row-at-a-time filter */
+typedef struct {
+  Operator base;
+  RowFilterFn fn;
+  const void* ctx;
+} FilterOp;
+
+static const void* filter_next(Operator* self) {
+  FilterOp* f = (FilterOp*)self;
+  const void* row;
+  while ((row = operator_next(self->child)) != NULL) {
+    if (f->fn(self->table, row, f->ctx)) {
+      return row;
+    }
+  }
+  return NULL;
+}
+
+static void filter_describe(Operator* self, char* buf, size_t cap) {
+  (void)self;
+  snprintf(buf, cap, "WHERE, row at a time");
+}
+
+Operator* op_filter(Operator* child, RowFilterFn fn, const void* ctx) {
+  if (!child) {
+    return NULL;
+  }
+  FilterOp* f = (FilterOp*)operator_alloc(sizeof(FilterOp), child, child->table);
+  if (!f) {
+    return NULL;
+  }
+  f->base.next = filter_next;
+  f->base.name = "Filter";
+  f->base.describe = filter_describe;
+  f->fn = fn;
+  f->ctx = ctx;
+  return &f->base;
+}
+
+/* Full sort: drains its input on open into an external sort bounded by
+ * the table's sort budget */
+typedef struct {
+  Operator base;
+  SortSpec spec;
+  ExtSort* sort;
+} SortOp;
+
+static bool sort_open(Operator* self) {
+  SortOp* s = (SortOp*)self;
+  s->sort = extsort_new(self->table, &s->spec, self->table->sort_budget);
+  if (!s->sort) {
+    return false;
+  }
+  const void* row;
+  while ((row = operator_next(self->child)) != NULL) {
+    if (!extsort_add(s->sort, row)) {
+      return false;
+    }
+  }
+  return extsort_finish(s->sort);
+}
+
+static const void* sort_next(Operator* self) {
+  SortOp* s = (SortOp*)self;
+  const void* row = extsort_next(s->sort);
+  if (!row && extsort_failed(s->sort)) {
+    self->failed = true;
+  }
+  return row;
+}
+
+static void sort_close(Operator* self) {
+  SortOp* s = (SortOp*)self;
+  if (s->sort) {
+    operator_note_mem(self, extsort_mem_peak(s->sort));
+  }
+  extsort_free(s->sort);
+}
+
+static void sort_describe(Operator* self, char* buf, size_t cap) {
+  snprintf(buf, cap, "%u columns, budget %zu bytes", ((SortOp*)self)->spec.n_cols,
+           self->table->sort_budget);
+}
+
+Operator* op_sort(Operator* child, const SortSpec* spec) {
+  if (!child) {
+    return NULL;
+  }
+  SortOp* s = (SortOp*)operator_alloc(sizeof(SortOp), child, child->table);
+  if (!s) {
+    return NULL;
+  }
+  s->base.open = sort_open;
+  s->base.next = sort_next;
+  s->base.close = sort_close;
+  s->base.name = "Sort";
+  s->base.describe = sort_describe;
+  s->spec = *spec;
+  return &s->base;
+}
+
+/* Top-K: a bounded heap keeps the best `k` rows seen so far. The root is
+ * the row that sorts last, so a new row only enters by replacing it. Memory
+ * is O(k) and the cost N log k instead of sorting all N rows. Heap entries
+ * are slot numbers; a slot holds one row and its sort key. */
+typedef struct {
+  Operator base;
+  SortKeyFormat fmt;
+  uint32_t k;
+  uint8_t* keys;        /* Slot i's key at keys + i * key_len */
+  const void** rows;
+  uint32_t* heap;
+  uint8_t* probe;       /* Key of the incoming row */
+  uint32_t n;
+  uint32_t cap;
+  uint32_t pos;
+  uint32_t seq;
+} TopKOp;
+
+static uint8_t* top_k_key(const TopKOp* s, uint32_t slot) {
+  return s->keys + (size_t)slot * s->fmt.key_len;
+}
+
+static int top_k_cmp(const TopKOp* s, uint32_t a, uint32_t b) {
+  return memcmp(top_k_key(s, a), top_k_key(s, b), s->fmt.key_len);
+}
+
+static void top_k_sift_down(TopKOp* s, uint32_t i, uint32_t n) {
+  for (;;) {
+    uint32_t worst = i;
+    uint32_t l = 2 * i + 1;
+    uint32_t r = l + 1;
+    if (l < n && top_k_cmp(s, s->heap[l], s->heap[worst]) > 0) {
+      worst = l;
+    }
+    if (r < n && top_k_cmp(s, s->heap[r], s->heap[worst]) > 0) {
+      worst = r;
+    }
+    if (worst == i) {
+      return;
+    }
+    uint32_t tmp = s->heap[i];
+    s->heap[i] = s->heap[worst];
+    s->heap[worst] = tmp;
+    i = worst;
+  }
+}
+
+static void top_k_sift_up(TopKOp* s, uint32_t i) {
+  while (i > 0) {
+    uint32_t parent = (i - 1) / 2;
+    if (top_k_cmp(s, s->heap[i], s->heap[parent]) <= 0) {
+      return;
+    }
+    uint32_t tmp = s->heap[i];
+    s->heap[i] = s->heap[parent];
+    s->heap[parent] = tmp;
+    i = parent;
+  }
+}
+
+static bool top_k_grow(TopKOp* s) {
+  uint32_t cap = s->cap ? s->cap * 2 : 64;
+  if (cap > s->k) {
+    cap = s->k;
+  }
+  uint8_t* keys = realloc(s->keys, (size_t)cap * s->fmt.key_len);
+  if (!keys) {
+    return false;
+  }
+  s->keys = keys;
+  const void** rows = realloc(s->rows, cap * sizeof(*rows));
+  if (!rows) {
+    return false;
+  }
+  s->rows = rows;
+  uint32_t* heap = realloc(s->heap, cap * sizeof(uint32_t));
+  if (!heap) {
+    return false;
+  }
+  s->heap = heap;
+  s->cap = cap;
+  return true;
+}
+
+static bool top_k_open(Operator* self) {
+  TopKOp* s = (TopKOp*)self;
+  const void* row;
+  if (s->k == 0) {
+    return true;
+  }
+  s->probe = malloc(s->fmt.key_len);
+  if (!s->probe) {
+    return false;
+  }
+  while ((row = operator_next(self->child)) != NULL) {
+    if (s->n < s->k) {
+      if (s->n == s->cap && !top_k_grow(s)) {
+        return false;
+      }
+      sortkey_encode(&s->fmt, row, s->seq++, top_k_key(s, s->n));
+      s->rows[s->n] = row;
+      s->heap[s->n] = s->n;
+      top_k_sift_up(s, s->n++);
+      continue;
+    }
+    sortkey_encode(&s->fmt, row, s->seq++, s->probe);
+    uint32_t root = s->heap[0];
+    if (memcmp(s->probe, top_k_key(s, root), s->fmt.key_len) < 0) {
+      memcpy(top_k_key(s, root), s->probe, s->fmt.key_len);
+      s->rows[root] = row;
+      top_k_sift_down(s, 0, s->n);
+    }
+  }
+
+  /* Heapsort in place: repeatedly move the last-sorting row to the end */
+  for (uint32_t end = s->n; end > 1; end--) {
+    uint32_t tmp = s->heap[0];
+    s->heap[0] = s->heap[end - 1];
+    s->heap[end - 1] = tmp;
+    top_k_sift_down(s, 0, end - 1);
+  }
+  return true;
+}
+
+static const void* top_k_next(Operator* self) {
+  TopKOp* s = (TopKOp*)self;
+  return s->pos < s->n ? s->rows[s->heap[s->pos++]] : NULL;
+}
+
+static void top_k_close(Operator* self) {
+  TopKOp* s = (TopKOp*)self;
+  size_t slot = s->fmt.key_len + sizeof(*s->rows) + sizeof(*s->heap);
+  operator_note_mem(self, (size_t)s->cap * slot + (s->probe ? s->fmt.key_len : 0));
+  free(s->keys);
+  free(s->rows);
+  free(s->heap);
+  free(s->probe);
+}
+
+static void top_k_describe(Operator* self, char* buf, size_t cap) {
+  snprintf(buf, cap, "k=%u", ((TopKOp*)self)->k);
+}
+
+Operator* op_top_k(Operator* child, const SortSpec* spec, uint32_t k) {
+  if (!child) {
+    return NULL;
+  }
+  TopKOp* s = (TopKOp*)operator_alloc(sizeof(TopKOp), child, child->table);
+  if (!s) {
+    return NULL;
+  }
+  s->base.open = top_k_open;
+  s->base.next = top_k_next;
+  s->base.close = top_k_close;
+  s->base.name = "Top-K";
+  s->base.describe = top_k_describe;
+  sortkey_format_init(&s->fmt, child->table, spec);
+  s->k = k;
+  return &s->base;
+}
+
+/* OFFSET/LIMIT: stops pulling from its input once the limit is reached */
+typedef struct {
+  Operator base;
+  uint32_t offset;
+  uint32_t limit;
+  uint32_t emitted;
+} LimitOp;
+
+static const void* limit_next(Operator* self) {
+  LimitOp* l = (LimitOp*)self;
+  /* LIMIT 0 reads nothing, not even the rows OFFSET skips */
+  if (l->emitted >= l->limit) {
+    return NULL;
+  }
+  while (l->offset > 0) {
+    if (!operator_next(self->child)) {
+      return NULL;
+    }
+    l->offset--;
+  }
+  const void* row = operator_next(self->child);
+  if (row) {
+    l->emitted++;
+  }
+  return row;
+}
+
+static void limit_describe(Operator* self, char* buf, size_t cap) {
+  LimitOp* l = (LimitOp*)self;
+  if (l->limit == UINT32_MAX) {
+    snprintf(buf, cap, "offset %u", l->offset);
+  } else {
+    snprintf(buf, cap, "offset %u, limit %u", l->offset, l->limit);
+  }
+}
+
+Operator* op_limit(Operator* child, uint32_t offset, uint32_t limit) {
+  if (!child) {
+    return NULL;
+  }
+  LimitOp* l = (LimitOp*)operator_alloc(sizeof(LimitOp), child, child->table);
+  if (!l) {
+    return NULL;
+  }
+  l->base.next = limit_next;
+  l->base.name = "Limit";
+  l->base.describe = limit_describe;
+  l->offset = offset;
+  l->limit = limit;
+  return &l->base;
+}
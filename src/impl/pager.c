@@ -36,22 +36,50 @@ Pager* pager_open(const char* filename) {
 
   for (uint32_t i = 0; i < TABLE_MAX_PAGES; i++) {
     pager->pages[i] = NULL;
+    pager->zones[i] = NULL;
   }
+  pager->zone_version = 0;
+  pthread_mutex_init(&pager->lock, NULL);
+  pager->count_fetches = false;
+  pager->page_hits = 0;
+  pager->page_reads = 0;
 
   return pager;
 }
 
+/* Release the pager struct itself (pages, zones and the file are the
+ * caller's to close first) */
+void pager_free(Pager* pager) {
+  pthread_mutex_destroy(&pager->lock);
+  free(pager);
+}
+
 /* Get a page from the pager (with caching) */
 void* get_page(Pager* pager, uint32_t page_num) {
-  if (page_num > TABLE_MAX_PAGES) {
+  if (page_num >= TABLE_MAX_PAGES) {
     printf("Tried to fetch page number out of bounds. %d > %d\n", page_num,
            TABLE_MAX_PAGES);
     exit(EXIT_FAILURE);
   }
 
+  void* cached = __atomic_load_n(&pager->pages[page_num], __ATOMIC_ACQUIRE);
+  if (cached) {
+    if (pager->count_fetches) {
+      __atomic_fetch_add(&pager->page_hits, 1, __ATOMIC_RELAXED);
+    }
+    return cached;
+  }
+
+  pthread_mutex_lock(&pager->lock);
+  if (pager->count_fetches) {
+    /* Another thread may have loaded it meanwhile; still a miss here */
+    __atomic_fetch_add(&pager->page_reads, 1, __ATOMIC_RELAXED);
+  }
   if (pager->pages[page_num] == NULL) {
     /* Cache miss. Allocate memory and load from file. */
     void* page = malloc(MYDB_PAGE_SIZE);
+    /* Pages past the end of the file, or a short read, start zeroed */
+    memset(page, 0, MYDB_PAGE_SIZE);
     uint32_t num_pages = pager->file_length / MYDB_PAGE_SIZE;
 
     /* We might save a partial page at the end of the file */
@@ -60,22 +88,26 @@ void* get_page(Pager* pager, uint32_t page_num) {
     }
 
     if (page_num <= num_pages) {
-      lseek(pager->file_descriptor, page_num * MYDB_PAGE_SIZE, SEEK_SET);
-      ssize_t bytes_read = read(pager->file_descriptor, page, MYDB_PAGE_SIZE);
+      /* pread leaves the shared file offset alone */
+      ssize_t bytes_read = pread(pager->file_descriptor, page, MYDB_PAGE_SIZE,
+                                 (off_t)page_num * MYDB_PAGE_SIZE);
       if (bytes_read == -1) {
         printf("Error reading file: %d\n", errno);
         exit(EXIT_FAILURE);
       }
     }
 
-    pager->pages[page_num] = page;
+    /* Publish only once the page is filled in */
+    __atomic_store_n(&pager->pages[page_num], page, __ATOMIC_RELEASE);
 
     if (page_num >= pager->num_pages) {
       pager->num_pages = page_num + 1;
     }
   }
+  void* page = pager->pages[page_num];
+  pthread_mutex_unlock(&pager->lock);
 
-  return pager->pages[page_num];
+  return page;
 }
 
 /* Flush a page to disk */
@@ -0,0 +1,239 @@
+#include "../include/plancache.h"
+#include "../include/util.h"
+#include "../sql_lexer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool push_literal(NormalizedSql* n, uint32_t* cap, const char* text) {
+  if (n->n_literals == *cap) {
+    uint32_t new_cap = *cap ? *cap * 2 : 8;
+    char** grown = realloc(n->literals, new_cap * sizeof(char*));
+    if (!grown) {
+      return false;
+    }
+    n->literals = grown;
+    *cap = new_cap;
+  }
+  char* copy = strdup(text);
+  if (!copy) {
+    return false;
+  }
+  n->literals[n->n_literals++] = copy;
+  return true;
+}
+
+bool sql_normalize(const char* sql, NormalizedSql* out) {
+  memset(out, 0, sizeof(*out));
+  Lexer lx;
+  lexer_init(&lx, sql);
+  lexer_next(&lx);
+  TokenType first = lx.cur.type;
+  if (first != TOK_SELECT && first != TOK_UPDATE && first != TOK_DELETE && first != TOK_INSERT) {
+    return false;
+  }
+
+  StrBuf sb;
+  sb_init(&sb);
+  uint32_t cap = 0;
+  uint32_t pos = 0;
+  TokenType prev = TOK_ILLEGAL;
+  bool ok = true;
+  for (; ok && lx.cur.type != TOK_EOF; prev = lx.cur.type, lexer_next(&lx), pos++) {
+    TokenType type = lx.cur.type;
+    /* The legacy INSERT takes bare values, which are not SQL literals */
+    if (type == TOK_PARAM || (first == TOK_INSERT && ((pos == 1 && type != TOK_INTO) ||
+                                                      (pos == 3 && type != TOK_VALUES)))) {
+      ok = false;
+      break;
+    }
+    if (pos > 0) {
+      sb_append(&sb, " ");
+    }
+    bool count = prev == TOK_LIMIT || prev == TOK_OFFSET;
+    if ((type == TOK_NUMBER || type == TOK_STRING) && !count) {
+      ok = push_literal(out, &cap, lx.cur.text);
+      sb_append(&sb, "?");
+    } else if (type == TOK_STRING) {
+      sb_appendf(&sb, "'%s'", lx.cur.text);
+    } else {
+      sb_append(&sb, lx.cur.text);
+    }
+  }
+  if (first == TOK_INSERT && pos < 4) {
+    ok = false;
+  }
+  if (!ok) {
+    sb_free(&sb);
+    normalized_sql_free(out);
+    return false;
+  }
+  out->key = sb.buf;
+  return true;
+}
+
+void normalized_sql_free(NormalizedSql* n) {
+  for (uint32_t i = 0; i < n->n_literals; i++) {
+    free(n->literals[i]);
+  }
+  free(n->literals);
+  free(n->key);
+  memset(n, 0, sizeof(*n));
+}
+
+typedef struct {
+  char* key;
+  uint64_t hash;
+  uint64_t last_used;
+  Statement st;
+} PlanEntry;
+
+struct PlanCache {
+  PlanEntry** entries;
+  uint32_t capacity;
+  uint32_t n;
+  uint64_t clock;            /* Ticks once per lookup; orders entries by use */
+  uint32_t catalog_version;  /* Catalog the entries were prepared against */
+};
+
+static void entry_free(PlanEntry* e) {
+  statement_cleanup(&e->st);
+  free(e->key);
+  free(e);
+}
+
+static void plancache_clear(PlanCache* c) {
+  for (uint32_t i = 0; i < c->n; i++) {
+    entry_free(c->entries[i]);
+  }
+  c->n = 0;
+}
+
+PlanCache* plancache_new(uint32_t capacity) {
+  PlanCache* c = calloc(1, sizeof(PlanCache));
+  if (!c) {
+    return NULL;
+  }
+  if (!plancache_resize(c, capacity)) {
+    free(c);
+    return NULL;
+  }
+  return c;
+}
+
+void plancache_free(PlanCache* c) {
+  if (!c) {
+    return;
+  }
+  plancache_clear(c);
+  free(c->entries);
+  free(c);
+}
+
+bool plancache_resize(PlanCache* c, uint32_t capacity) {
+  plancache_clear(c);
+  PlanEntry** entries = NULL;
+  if (capacity > 0) {
+    entries = malloc(capacity * sizeof(PlanEntry*));
+    if (!entries) {
+      return false;
+    }
+  }
+  free(c->entries);
+  c->entries = entries;
+  c->capacity = capacity;
+  return true;
+}
+
+uint32_t plancache_capacity(const PlanCache* c) {
+  return c->capacity;
+}
+
+uint32_t plancache_entries(const PlanCache* c) {
+  return c->n;
+}
+
+/* Prepare the normalized statement into a new entry; NULL with *pr set
+ * when it is not cacheable or fails */
+static PlanEntry* entry_prepare(Table* t, const NormalizedSql* n, uint64_t hash, PrepareResult* pr) {
+  PlanEntry* e = calloc(1, sizeof(PlanEntry));
+  if (!e || !(e->key = strdup(n->key))) {
+    free(e);
+    *pr = PREPARE_SUCCESS;
+    return NULL;
+  }
+  e->hash = hash;
+  InputBuffer ib;
+  ib.buffer = e->key;
+  ib.buffer_length = strlen(e->key) + 1;
+  ib.input_length = (ssize_t)strlen(e->key);
+  *pr = prepare_statement(&ib, &e->st, t);
+  /* A placeholder count off from the literals means some literal sits
+   * where the parser takes no placeholder; that is left uncached */
+  if (*pr != PREPARE_SUCCESS || e->st.param_count != n->n_literals) {
+    entry_free(e);
+    return NULL;
+  }
+  return e;
+}
+
+Statement* plancache_statement(PlanCache* c, Table* t, const char* sql, PrepareResult* pr) {
+  *pr = PREPARE_SUCCESS;
+  if (c->capacity == 0) {
+    return NULL;
+  }
+  NormalizedSql n;
+  if (!sql_normalize(sql, &n)) {
+    return NULL;
+  }
+  if (c->catalog_version != t->catalog_version) {
+    if (c->n > 0) {
+      t->stats.plans.invalidations++;
+    }
+    plancache_clear(c);
+    c->catalog_version = t->catalog_version;
+  }
+
+  uint64_t hash = hash_bytes(n.key, strlen(n.key));
+  PlanEntry* e = NULL;
+  for (uint32_t i = 0; i < c->n; i++) {
+    if (c->entries[i]->hash == hash && strcmp(c->entries[i]->key, n.key) == 0) {
+      e = c->entries[i];
+      break;
+    }
+  }
+  if (e) {
+    t->stats.plans.hits++;
+  } else {
+    t->stats.plans.misses++;
+    e = entry_prepare(t, &n, hash, pr);
+    if (!e) {
+      normalized_sql_free(&n);
+      return NULL;
+    }
+    if (c->n < c->capacity) {
+      c->entries[c->n++] = e;
+    } else {
+      uint32_t lru = 0;
+      for (uint32_t i = 1; i < c->n; i++) {
+        if (c->entries[i]->last_used < c->entries[lru]->last_used) {
+          lru = i;
+        }
+      }
+      entry_free(c->entries[lru]);
+      c->entries[lru] = e;
+      t->stats.plans.evictions++;
+    }
+  }
+  e->last_used = ++c->clock;
+
+  for (uint32_t i = 0; i < n.n_literals; i++) {
+    if (!statement_bind(&e->st, i + 1, n.literals[i])) {
+      /* Cached but not usable with these constants */
+      normalized_sql_free(&n);
+      return NULL;
+    }
+  }
+  normalized_sql_free(&n);
+  return &e->st;
+}
@@ -0,0 +1,691 @@
+#include "../include/predicate.h"
+#include "../include/simd_filter.h"
+#include "../include/schema.h"
+#include "../include/util.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Program building */
+static uint32_t emit(Predicate* p, PredOpcode code) {
+  if (p->n_code == p->cap) {
+    uint32_t cap = p->cap ? p->cap * 2 : 16;
+    PredInstr* grown = realloc(p->code, cap * sizeof(PredInstr));
+    if (!grown) {
+      return UINT32_MAX;
+    }
+    p->code = grown;
+    p->cap = cap;
+  }
+  PredInstr* in = &p->code[p->n_code];
+  memset(in, 0, sizeof(*in));
+  in->code = code;
+  return p->n_code++;
+}
+
+static void emit_const(Predicate* p, bool value) {
+  uint32_t at = emit(p, PI_CONST);
+  if (at != UINT32_MAX) {
+    p->code[at].imm = value;
+  }
+}
+
+static bool parse_cmp_op(const char* op, CmpOp* out) {
+  if (strcmp(op, "=") == 0) *out = CMP_EQ;
+  else if (strcmp(op, "!=") == 0) *out = CMP_NE;
+  else if (strcmp(op, "<") == 0) *out = CMP_LT;
+  else if (strcmp(op, "<=") == 0) *out = CMP_LE;
+  else if (strcmp(op, ">") == 0) *out = CMP_GT;
+  else if (strcmp(op, ">=") == 0) *out = CMP_GE;
+  else return false;
+  return true;
+}
+
+/* `lit op col` is `col flip(op) lit` */
+static CmpOp flip_cmp_op(CmpOp op) {
+  switch (op) {
+    case CMP_LT: return CMP_GT;
+    case CMP_LE: return CMP_GE;
+    case CMP_GT: return CMP_LT;
+    case CMP_GE: return CMP_LE;
+    default: return op;
+  }
+}
+
+/* Resolve a column or literal operand (mirrors eval_operand) */
+static Operand operand_of(Table* t, const Expr* e) {
+  Operand o;
+  memset(&o, 0, sizeof(o));
+  o.kind = OPND_NONE;
+  if (!e) {
+    return o;
+  }
+  if (e->kind == EXPR_COLUMN) {
+    int idx = schema_col_index(&t->active_schema, e->text);
+    if (idx < 0) {
+      return o;
+    }
+    const ColumnDef* c = &t->active_schema.columns[idx];
+    o.offset = schema_col_offset(&t->active_schema, idx);
+    o.size = c->size;
+    o.kind = c->type == COL_TYPE_INT ? OPND_I32_COL
+           : c->type == COL_TYPE_TIMESTAMP ? OPND_I64_COL
+           : OPND_STR_COL;
+    return o;
+  }
+  if (e->kind == EXPR_LITERAL) {
+    if (parse_int64(e->text, &o.num) == 0) {
+      o.kind = OPND_NUM_LIT;
+    } else {
+      o.kind = OPND_STR_LIT;
+      o.num = 0;
+      o.str = strdup(e->text);
+      o.size = (uint32_t)strlen(e->text);
+    }
+  }
+  return o;
+}
+
+static bool operand_is_numeric(const Operand* o) {
+  return o->kind == OPND_I32_COL || o->kind == OPND_I64_COL || o->kind == OPND_NUM_LIT;
+}
+
+static bool operand_is_const(const Operand* o) {
+  return o->kind == OPND_NUM_LIT || o->kind == OPND_STR_LIT || o->kind == OPND_NONE;
+}
+
+static bool operand_is_num_col(const Operand* o) {
+  return o->kind == OPND_I32_COL || o->kind == OPND_I64_COL;
+}
+
+static void operand_free(Operand* o) {
+  free(o->str);
+  o->str = NULL;
+}
+
+/* Operand access during evaluation */
+static inline int64_t operand_num(const Operand* o, const uint8_t* row) {
+  switch (o->kind) {
+    case OPND_I32_COL: {
+      int32_t v;
+      memcpy(&v, row + o->offset, 4);
+      return v;
+    }
+    case OPND_I64_COL: {
+      int64_t v;
+      memcpy(&v, row + o->offset, 8);
+      return v;
+    }
+    case OPND_NUM_LIT:
+      return o->num;
+    default:
+      return 0;
+  }
+}
+
+static inline const char* operand_str(const Operand* o, const uint8_t* row, uint32_t* len) {
+  switch (o->kind) {
+    case OPND_STR_COL:
+      *len = o->size;
+      return (const char*)row + o->offset;
+    case OPND_STR_LIT:
+      *len = o->size;
+      return o->str;
+    default:
+      *len = 0;
+      return "";
+  }
+}
+
+/* strcmp on strings that end at a NUL or at their length, whichever is first */
+static inline int bounded_strcmp(const char* a, uint32_t alen, const char* b, uint32_t blen) {
+  for (uint32_t i = 0;; i++) {
+    unsigned char ca = i < alen ? (unsigned char)a[i] : 0;
+    unsigned char cb = i < blen ? (unsigned char)b[i] : 0;
+    if (ca != cb) {
+      return ca < cb ? -1 : 1;
+    }
+    if (ca == 0) {
+      return 0;
+    }
+  }
+}
+
+static inline bool cmp_holds(CmpOp op, int c) {
+  switch (op) {
+    case CMP_EQ: return c == 0;
+    case CMP_NE: return c != 0;
+    case CMP_LT: return c < 0;
+    case CMP_LE: return c <= 0;
+    case CMP_GT: return c > 0;
+    case CMP_GE: return c >= 0;
+  }
+  return false;
+}
+
+static inline int cmp_i64(int64_t x, int64_t y) {
+  return (x > y) - (x < y);
+}
+
+/* Leaf compilation */
+static void compile_cmp(Predicate* p, Table* t, const Expr* e) {
+  CmpOp op;
+  if (!parse_cmp_op(e->op, &op)) {
+    emit_const(p, false);
+    return;
+  }
+  Operand a = operand_of(t, e->left);
+  Operand b = operand_of(t, e->right);
+
+  /* Put a lone column on the left */
+  if (operand_is_const(&a) && !operand_is_const(&b)) {
+    Operand tmp = a;
+    a = b;
+    b = tmp;
+    op = flip_cmp_op(op);
+  }
+
+  uint32_t at = emit(p, PI_CMP);
+  if (at == UINT32_MAX) {
+    operand_free(&a);
+    operand_free(&b);
+    return;
+  }
+  PredInstr* in = &p->code[at];
+  in->op = op;
+  in->a = a;
+  in->b = b;
+
+  if (operand_is_num_col(&a) && operand_is_const(&b)) {
+    /* Numeric comparison; a non-numeric literal compares as 0 */
+    in->code = a.kind == OPND_I32_COL ? PI_CMP_I32 : PI_CMP_I64;
+    in->lo = b.kind == OPND_NUM_LIT ? b.num : 0;
+  } else if (a.kind == OPND_STR_COL && b.kind == OPND_STR_LIT) {
+    in->code = PI_CMP_STR;
+  }
+}
+
+static void compile_between(Predicate* p, Table* t, const Expr* e) {
+  if (!e->right) {
+    emit_const(p, false);
+    return;
+  }
+  uint32_t at = emit(p, PI_BETWEEN);
+  if (at == UINT32_MAX) {
+    return;
+  }
+  PredInstr* in = &p->code[at];
+  in->a = operand_of(t, e->left);
+  in->b = operand_of(t, e->right->left);
+  in->c = operand_of(t, e->right->right);
+  if (operand_is_num_col(&in->a) && operand_is_const(&in->b) && operand_is_const(&in->c)) {
+    in->code = in->a.kind == OPND_I32_COL ? PI_BETWEEN_I32 : PI_BETWEEN_I64;
+    in->lo = in->b.kind == OPND_NUM_LIT ? in->b.num : 0;
+    in->hi = in->c.kind == OPND_NUM_LIT ? in->c.num : 0;
+  }
+}
+
+static int cmp_i64_qsort(const void* x, const void* y) {
+  return cmp_i64(*(const int64_t*)x, *(const int64_t*)y);
+}
+
+static int cmp_str_qsort(const void* x, const void* y) {
+  return strcmp(*(char* const*)x, *(char* const*)y);
+}
+
+static void compile_in(Predicate* p, Table* t, const Expr* e) {
+  bool all_literals = true;
+  for (uint32_t i = 0; i < e->n_items; i++) {
+    if (!e->items[i] || e->items[i]->kind != EXPR_LITERAL) {
+      all_literals = false;
+      break;
+    }
+  }
+
+  if (!all_literals) {
+    /* Row-dependent items: x IN (a, b) is x = a OR x = b */
+    uint32_t* jumps = malloc((e->n_items ? e->n_items : 1) * sizeof(uint32_t));
+    if (!jumps) {
+      emit_const(p, false);
+      return;
+    }
+    emit_const(p, false);
+    for (uint32_t i = 0; i < e->n_items; i++) {
+      Expr eq;
+      memset(&eq, 0, sizeof(eq));
+      eq.kind = EXPR_BINARY;
+      strcpy(eq.op, "=");
+      eq.left = e->left;
+      eq.right = e->items[i];
+      compile_cmp(p, t, &eq);
+      jumps[i] = emit(p, PI_JUMP_IF_TRUE);
+    }
+    for (uint32_t i = 0; i < e->n_items; i++) {
+      if (jumps[i] != UINT32_MAX) {
+        p->code[jumps[i]].target = p->n_code;
+      }
+    }
+    free(jumps);
+    return;
+  }
+
+  Operand a = operand_of(t, e->left);
+  if (operand_is_numeric(&a)) {
+    int64_t* nums = malloc((e->n_items ? e->n_items : 1) * sizeof(int64_t));
+    if (!nums) {
+      operand_free(&a);
+      emit_const(p, false);
+      return;
+    }
+    for (uint32_t i = 0; i < e->n_items; i++) {
+      int64_t v = 0;
+      if (parse_int64(e->items[i]->text, &v) != 0) {
+        v = 0;
+      }
+      nums[i] = v;
+    }
+    qsort(nums, e->n_items, sizeof(int64_t), cmp_i64_qsort);
+    uint32_t at = emit(p, PI_IN_NUM);
+    if (at == UINT32_MAX) {
+      free(nums);
+      operand_free(&a);
+      return;
+    }
+    p->code[at].a = a;
+    p->code[at].nums = nums;
+    p->code[at].n_set = e->n_items;
+    return;
+  }
+
+  /* String operand: a numeric item compares against 0, which a string
+   * operand always equals; other items compare as strings. */
+  char** strs = malloc((e->n_items ? e->n_items : 1) * sizeof(char*));
+  if (!strs) {
+    operand_free(&a);
+    emit_const(p, false);
+    return;
+  }
+  uint32_t n = 0;
+  bool zero_item = false;
+  for (uint32_t i = 0; i < e->n_items; i++) {
+    int64_t v = 0;
+    if (parse_int64(e->items[i]->text, &v) == 0) {
+      zero_item |= (v == 0);
+    } else {
+      strs[n++] = strdup(e->items[i]->text);
+    }
+  }
+  if (zero_item) {
+    for (uint32_t i = 0; i < n; i++) {
+      free(strs[i]);
+    }
+    free(strs);
+    operand_free(&a);
+    emit_const(p, true);
+    return;
+  }
+  qsort(strs, n, sizeof(char*), cmp_str_qsort);
+  uint32_t at = emit(p, PI_IN_STR);
+  if (at == UINT32_MAX) {
+    for (uint32_t i = 0; i < n; i++) {
+      free(strs[i]);
+    }
+    free(strs);
+    operand_free(&a);
+    return;
+  }
+  p->code[at].a = a;
+  p->code[at].strs = strs;
+  p->code[at].n_set = n;
+}
+
+static void compile_node(Predicate* p, Table* t, const Expr* e) {
+  if (!e) {
+    emit_const(p, true);
+    return;
+  }
+
+  switch (e->kind) {
+    case EXPR_LITERAL:
+      emit_const(p, e->text[0] != '\0' && strcmp(e->text, "0") != 0);
+      return;
+
+    case EXPR_COLUMN: {
+      uint32_t at = emit(p, PI_TRUTHY);
+      if (at != UINT32_MAX) {
+        p->code[at].a = operand_of(t, e);
+      }
+      return;
+    }
+
+    case EXPR_UNARY:
+      if (strcmp(e->op, "NOT") == 0) {
+        compile_node(p, t, e->left);
+        emit(p, PI_NOT);
+      } else {
+        emit_const(p, false);
+      }
+      return;
+
+    case EXPR_BINARY: {
+      bool is_and = strcmp(e->op, "AND") == 0;
+      if (is_and || strcmp(e->op, "OR") == 0) {
+        compile_node(p, t, e->left);
+        uint32_t jump = emit(p, is_and ? PI_JUMP_IF_FALSE : PI_JUMP_IF_TRUE);
+        compile_node(p, t, e->right);
+        if (jump != UINT32_MAX) {
+          p->code[jump].target = p->n_code;
+        }
+        return;
+      }
+      compile_cmp(p, t, e);
+      return;
+    }
+
+    case EXPR_BETWEEN:
+      compile_between(p, t, e);
+      return;
+
+    case EXPR_IN:
+      compile_in(p, t, e);
+      return;
+
+    case EXPR_ISNULL:
+    case EXPR_AGG:
+      emit_const(p, false);
+      return;
+  }
+  emit_const(p, false);
+}
+
+Predicate* predicate_compile(Table* t, const Expr* where) {
+  Predicate* p = calloc(1, sizeof(Predicate));
+  if (!p) {
+    return NULL;
+  }
+  p->root_page_num = t->root_page_num;
+  if (where) {
+    compile_node(p, t, where);
+  }
+  return p;
+}
+
+void predicate_free(Predicate* p) {
+  if (!p) {
+    return;
+  }
+  for (uint32_t i = 0; i < p->n_code; i++) {
+    PredInstr* in = &p->code[i];
+    operand_free(&in->a);
+    operand_free(&in->b);
+    operand_free(&in->c);
+    free(in->nums);
+    if (in->strs) {
+      for (uint32_t j = 0; j < in->n_set; j++) {
+        free(in->strs[j]);
+      }
+      free(in->strs);
+    }
+  }
+  free(p->code);
+  free(p);
+}
+
+/* Evaluation */
+static bool eval_cmp(const PredInstr* in, const uint8_t* row) {
+  if (operand_is_numeric(&in->a) || operand_is_numeric(&in->b)) {
+    return cmp_holds(in->op, cmp_i64(operand_num(&in->a, row), operand_num(&in->b, row)));
+  }
+  uint32_t alen, blen;
+  const char* as = operand_str(&in->a, row, &alen);
+  const char* bs = operand_str(&in->b, row, &blen);
+  return cmp_holds(in->op, bounded_strcmp(as, alen, bs, blen));
+}
+
+static bool eval_between(const PredInstr* in, const uint8_t* row) {
+  if (operand_is_numeric(&in->a) || operand_is_numeric(&in->b) || operand_is_numeric(&in->c)) {
+    int64_t v = operand_num(&in->a, row);
+    return v >= operand_num(&in->b, row) && v <= operand_num(&in->c, row);
+  }
+  uint32_t vlen, lolen, hilen;
+  const char* vs = operand_str(&in->a, row, &vlen);
+  const char* los = operand_str(&in->b, row, &lolen);
+  const char* his = operand_str(&in->c, row, &hilen);
+  return bounded_strcmp(vs, vlen, los, lolen) >= 0 && bounded_strcmp(vs, vlen, his, hilen) <= 0;
+}
+
+static bool eval_in_num(const PredInstr* in, const uint8_t* row) {
+  int64_t v = operand_num(&in->a, row);
+  uint32_t lo = 0, hi = in->n_set;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (in->nums[mid] < v) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo < in->n_set && in->nums[lo] == v;
+}
+
+static bool eval_in_str(const PredInstr* in, const uint8_t* row) {
+  uint32_t len;
+  const char* s = operand_str(&in->a, row, &len);
+  uint32_t lo = 0, hi = in->n_set;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    int c = bounded_strcmp(in->strs[mid], UINT32_MAX, s, len);
+    if (c == 0) {
+      return true;
+    }
+    if (c < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return false;
+}
+
+/* Evaluate one non-control instruction against one row */
+static inline bool eval_instr(const PredInstr* in, const uint8_t* r) {
+  switch (in->code) {
+    case PI_CONST:
+      return in->imm;
+    case PI_CMP_I32: {
+      int32_t v;
+      memcpy(&v, r + in->a.offset, 4);
+      return cmp_holds(in->op, cmp_i64(v, in->lo));
+    }
+    case PI_CMP_I64: {
+      int64_t v;
+      memcpy(&v, r + in->a.offset, 8);
+      return cmp_holds(in->op, cmp_i64(v, in->lo));
+    }
+    case PI_CMP_STR:
+      return cmp_holds(in->op, bounded_strcmp((const char*)r + in->a.offset, in->a.size,
+                                              in->b.str, in->b.size));
+    case PI_CMP:
+      return eval_cmp(in, r);
+    case PI_BETWEEN_I32: {
+      int32_t v;
+      memcpy(&v, r + in->a.offset, 4);
+      return v >= in->lo && v <= in->hi;
+    }
+    case PI_BETWEEN_I64: {
+      int64_t v;
+      memcpy(&v, r + in->a.offset, 8);
+      return v >= in->lo && v <= in->hi;
+    }
+    case PI_BETWEEN:
+      return eval_between(in, r);
+    case PI_IN_NUM:
+      return eval_in_num(in, r);
+    case PI_IN_STR:
+      return eval_in_str(in, r);
+    case PI_TRUTHY:
+      if (operand_is_numeric(&in->a)) {
+        return operand_num(&in->a, r) != 0;
+      }
+      return in->a.kind == OPND_STR_COL && r[in->a.offset] != '\0';
+    default:
+      return false;
+  }
+}
+
+bool predicate_eval(const Predicate* p, const void* row) {
+  const uint8_t* r = (const uint8_t*)row;
+  bool acc = true;
+  uint32_t pc = 0;
+  while (pc < p->n_code) {
+    const PredInstr* in = &p->code[pc++];
+    switch (in->code) {
+      case PI_NOT:
+        acc = !acc;
+        break;
+      case PI_JUMP_IF_FALSE:
+        if (!acc) {
+          pc = in->target;
+        }
+        break;
+      case PI_JUMP_IF_TRUE:
+        if (acc) {
+          pc = in->target;
+        }
+        break;
+      default:
+        acc = eval_instr(in, r);
+        break;
+    }
+  }
+  return acc;
+}
+
+/* Batch evaluation.
+ *
+ * Each instruction runs over the whole active selection vector before the
+ * next one starts, so a comparison is one tight loop over one column. A
+ * short-circuit jump moves the rows it decides out of the active vector and
+ * parks them until the program reaches the jump target. Targets of nested
+ * jumps never exceed those of enclosing ones, so parked rows form a stack
+ * whose top always holds the nearest target. */
+
+/* Int and timestamp columns are gathered into a dense array and compared by
+ * the SIMD filter kernels, which return a bitmask over the gathered values. */
+static void scatter_mask(const uint64_t* mask, const uint32_t* act, uint32_t n, uint8_t* acc) {
+  for (uint32_t k = 0; k < n; k++) {
+    acc[act[k]] = (uint8_t)((mask[k >> 6] >> (k & 63)) & 1);
+  }
+}
+
+static void filter_num_batch(const PredInstr* in, const uint8_t* base, uint32_t stride,
+                             const uint32_t* act, uint32_t n, uint8_t* acc) {
+  uint64_t mask[PREDICATE_BATCH_MAX / 64];
+  const uint8_t* col = base + in->a.offset;
+  bool between = in->code == PI_BETWEEN_I32 || in->code == PI_BETWEEN_I64;
+
+  if (in->a.kind == OPND_I32_COL) {
+    int32_t vals[PREDICATE_BATCH_MAX];
+    for (uint32_t k = 0; k < n; k++) {
+      memcpy(&vals[k], col + (size_t)act[k] * stride, 4);
+    }
+    if (between) {
+      simd_filter_between_i32(vals, n, in->lo, in->hi, mask);
+    } else {
+      simd_filter_cmp_i32(vals, n, in->op, in->lo, mask);
+    }
+  } else {
+    int64_t vals[PREDICATE_BATCH_MAX];
+    for (uint32_t k = 0; k < n; k++) {
+      memcpy(&vals[k], col + (size_t)act[k] * stride, 8);
+    }
+    if (between) {
+      simd_filter_between_i64(vals, n, in->lo, in->hi, mask);
+    } else {
+      simd_filter_cmp_i64(vals, n, in->op, in->lo, mask);
+    }
+  }
+  scatter_mask(mask, act, n, acc);
+}
+
+static void eval_instr_batch(const PredInstr* in, const uint8_t* base, uint32_t stride,
+                             const uint32_t* act, uint32_t n, uint8_t* acc) {
+  switch (in->code) {
+    case PI_CONST:
+      for (uint32_t k = 0; k < n; k++) {
+        acc[act[k]] = in->imm;
+      }
+      return;
+    case PI_CMP_I32:
+    case PI_CMP_I64:
+    case PI_BETWEEN_I32:
+    case PI_BETWEEN_I64:
+      filter_num_batch(in, base, stride, act, n, acc);
+      return;
+    default:
+      for (uint32_t k = 0; k < n; k++) {
+        acc[act[k]] = eval_instr(in, base + (size_t)act[k] * stride);
+      }
+      return;
+  }
+}
+
+uint32_t predicate_filter_batch(const Predicate* p, const void* rows, uint32_t stride,
+                                uint32_t n, uint32_t* sel) {
+  const uint8_t* base = (const uint8_t*)rows;
+  uint8_t acc[PREDICATE_BATCH_MAX];
+  uint32_t act[PREDICATE_BATCH_MAX];
+  uint32_t parked[PREDICATE_BATCH_MAX];
+  uint32_t parked_at[PREDICATE_BATCH_MAX];
+  uint32_t n_act = n, n_parked = 0;
+
+  if (n > PREDICATE_BATCH_MAX) {
+    n = n_act = PREDICATE_BATCH_MAX;
+  }
+  for (uint32_t i = 0; i < n; i++) {
+    acc[i] = 1;
+    act[i] = i;
+  }
+
+  for (uint32_t pc = 0; pc <= p->n_code; pc++) {
+    while (n_parked > 0 && parked_at[n_parked - 1] == pc) {
+      act[n_act++] = parked[--n_parked];
+    }
+    if (pc == p->n_code) {
+      break;
+    }
+    const PredInstr* in = &p->code[pc];
+    switch (in->code) {
+      case PI_NOT:
+        for (uint32_t k = 0; k < n_act; k++) {
+          acc[act[k]] = !acc[act[k]];
+        }
+        break;
+      case PI_JUMP_IF_FALSE:
+      case PI_JUMP_IF_TRUE: {
+        uint8_t decided = in->code == PI_JUMP_IF_TRUE;
+        uint32_t kept = 0;
+        for (uint32_t k = 0; k < n_act; k++) {
+          uint32_t i = act[k];
+          if (acc[i] == decided) {
+            parked[n_parked] = i;
+            parked_at[n_parked++] = in->target;
+          } else {
+            act[kept++] = i;
+          }
+        }
+        n_act = kept;
+        break;
+      }
+      default:
+        eval_instr_batch(in, base, stride, act, n_act, acc);
+        break;
+    }
+  }
+
+  uint32_t m = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    sel[m] = i;
+    m += acc[i];
+  }
+  return m;
+}
@@ -1,4 +1,7 @@
 #include "../include/repl.h"
+#include "../include/catalog.h"
+#include "../include/bloom.h"
+#include "../include/threadpool.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -38,7 +41,7 @@ void close_input_buffer(InputBuffer* input_buffer) {
   free(input_buffer);
 }
 
-/* Handle meta commands (.exit, .btree, .constants) */
+/* Handle meta commands (.exit, .btree, .constants, .bloom, .stats, .sortmem, .threads) */
 MetaCommandResult do_meta_command(InputBuffer* input_buffer, Table* table) {
   if (strcmp(input_buffer->buffer, ".exit") == 0) {
     close_input_buffer(input_buffer);
@@ -56,6 +59,40 @@ MetaCommandResult do_meta_command(InputBuffer* input_buffer, Table* table) {
     printf("Constants:\n");
     print_constants(table);
     return META_COMMAND_SUCCESS;
+  } else if (strncmp(input_buffer->buffer, ".bloom ", 7) == 0) {
+    const char* name = input_buffer->buffer + 7;
+    while (*name == ' ') {
+      name++;
+    }
+    if (table_activate(table, name) < 0) {
+      printf("Table not found: %s\n", name);
+    } else if (bloom_enable(table) != 0) {
+      printf("Could not build Bloom filter for '%s'.\n", name);
+    } else {
+      printf("Bloom filter enabled on '%s'.\n", name);
+    }
+    return META_COMMAND_SUCCESS;
+  } else if (strcmp(input_buffer->buffer, ".stats") == 0) {
+    stats_print(table);
+    return META_COMMAND_SUCCESS;
+  } else if (strncmp(input_buffer->buffer, ".sortmem ", 9) == 0) {
+    int64_t bytes = 0;
+    if (parse_int64(input_buffer->buffer + 9, &bytes) != 0 || bytes <= 0) {
+      printf("Usage: .sortmem <bytes>\n");
+    } else {
+      table->sort_budget = (size_t)bytes;
+      printf("Sort budget set to %lld bytes.\n", (long long)bytes);
+    }
+    return META_COMMAND_SUCCESS;
+  } else if (strncmp(input_buffer->buffer, ".threads ", 9) == 0) {
+    int n = 0;
+    if (parse_int(input_buffer->buffer + 9, &n) != 0 || n <= 0) {
+      printf("Usage: .threads <n>\n");
+    } else {
+      table->threads = n > THREADPOOL_MAX_WORKERS ? THREADPOOL_MAX_WORKERS : (uint32_t)n;
+      printf("Scan threads set to %u.\n", table->threads);
+    }
+    return META_COMMAND_SUCCESS;
   } else {
     return META_COMMAND_UNRECOGNIZED_COMMAND;
   }
@@ -0,0 +1,360 @@
+#include "../include/simd_filter.h"
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(__EMSCRIPTEN__) && defined(__GNUC__)
+#define MYDB_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+typedef struct {
+  void (*cmp_i32)(const int32_t* vals, uint32_t n, CmpOp op, int32_t c, uint64_t* mask);
+  void (*cmp_i64)(const int64_t* vals, uint32_t n, CmpOp op, int64_t c, uint64_t* mask);
+  void (*between_i32)(const int32_t* vals, uint32_t n, int32_t lo, int32_t hi, uint64_t* mask);
+  void (*between_i64)(const int64_t* vals, uint32_t n, int64_t lo, int64_t hi, uint64_t* mask);
+} FilterKernels;
+
+/* Vector kernels compare with == and > only; the other operators are one of
+ * those, possibly with the operands swapped, followed by a negation. */
+typedef enum { BASE_EQ, BASE_GT, BASE_LT } BaseCmp;
+
+static BaseCmp base_cmp(CmpOp op) {
+  switch (op) {
+    case CMP_EQ:
+    case CMP_NE:
+      return BASE_EQ;
+    case CMP_GT:
+    case CMP_LE:
+      return BASE_GT;
+    default:
+      return BASE_LT;
+  }
+}
+
+static int negates(CmpOp op) {
+  return op == CMP_NE || op == CMP_LE || op == CMP_GE;
+}
+
+/* Scalar kernels. `from` lets the vector kernels finish their tail here. */
+#define SCALAR_LOOP(cond)                                 \
+  for (uint32_t i = from; i < n; i++) {                   \
+    int64_t v = vals[i];                                  \
+    mask[i >> 6] |= (uint64_t)(cond) << (i & 63);         \
+  }
+
+#define SCALAR_CMP(vals, from, n, op, c, mask)            \
+  switch (op) {                                           \
+    case CMP_EQ: SCALAR_LOOP(v == c); break;              \
+    case CMP_NE: SCALAR_LOOP(v != c); break;              \
+    case CMP_LT: SCALAR_LOOP(v < c); break;               \
+    case CMP_LE: SCALAR_LOOP(v <= c); break;              \
+    case CMP_GT: SCALAR_LOOP(v > c); break;               \
+    case CMP_GE: SCALAR_LOOP(v >= c); break;              \
+  }
+
+static void cmp_i32_tail(const int32_t* vals, uint32_t from, uint32_t n, CmpOp op, int32_t c,
+                         uint64_t* mask) {
+  SCALAR_CMP(vals, from, n, op, c, mask);
+}
+
+static void cmp_i64_tail(const int64_t* vals, uint32_t from, uint32_t n, CmpOp op, int64_t c,
+                         uint64_t* mask) {
+  SCALAR_CMP(vals, from, n, op, c, mask);
+}
+
+static void between_i32_tail(const int32_t* vals, uint32_t from, uint32_t n, int32_t lo,
+                             int32_t hi, uint64_t* mask) {
+  SCALAR_LOOP(v >= lo && v <= hi);
+}
+
+static void between_i64_tail(const int64_t* vals, uint32_t from, uint32_t n, int64_t lo,
+                             int64_t hi, uint64_t* mask) {
+  SCALAR_LOOP(v >= lo && v <= hi);
+}
+
+#undef SCALAR_CMP
+#undef SCALAR_LOOP
+
+static void cmp_i32_scalar(const int32_t* vals, uint32_t n, CmpOp op, int32_t c, uint64_t* mask) {
+  cmp_i32_tail(vals, 0, n, op, c, mask);
+}
+
+static void cmp_i64_scalar(const int64_t* vals, uint32_t n, CmpOp op, int64_t c, uint64_t* mask) {
+  cmp_i64_tail(vals, 0, n, op, c, mask);
+}
+
+static void between_i32_scalar(const int32_t* vals, uint32_t n, int32_t lo, int32_t hi,
+                               uint64_t* mask) {
+  between_i32_tail(vals, 0, n, lo, hi, mask);
+}
+
+static void between_i64_scalar(const int64_t* vals, uint32_t n, int64_t lo, int64_t hi,
+                               uint64_t* mask) {
+  between_i64_tail(vals, 0, n, lo, hi, mask);
+}
+
+static const FilterKernels scalar_kernels = {
+  cmp_i32_scalar, cmp_i64_scalar, between_i32_scalar, between_i64_scalar
+};
+
+#ifdef MYDB_SIMD_X86
+
+/* SSE: 4 x int32 (SSE2) or 2 x int64 (SSE4.2) per step */
+__attribute__((target("sse4.2")))
+static void cmp_i32_sse(const int32_t* vals, uint32_t n, CmpOp op, int32_t c, uint64_t* mask) {
+  __m128i vc = _mm_set1_epi32(c);
+  BaseCmp base = base_cmp(op);
+  uint32_t flip = negates(op) ? 0xF : 0;
+  uint32_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(vals + i));
+    __m128i r = base == BASE_EQ ? _mm_cmpeq_epi32(v, vc)
+              : base == BASE_GT ? _mm_cmpgt_epi32(v, vc)
+              : _mm_cmpgt_epi32(vc, v);
+    uint32_t bits = (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(r)) ^ flip;
+    mask[i >> 6] |= (uint64_t)bits << (i & 63);
+  }
+  cmp_i32_tail(vals, i, n, op, c, mask);
+}
+
+__attribute__((target("sse4.2")))
+static void cmp_i64_sse(const int64_t* vals, uint32_t n, CmpOp op, int64_t c, uint64_t* mask) {
+  __m128i vc = _mm_set1_epi64x(c);
+  BaseCmp base = base_cmp(op);
+  uint32_t flip = negates(op) ? 0x3 : 0;
+  uint32_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(vals + i));
+    __m128i r = base == BASE_EQ ? _mm_cmpeq_epi64(v, vc)
+              : base == BASE_GT ? _mm_cmpgt_epi64(v, vc)
+              : _mm_cmpgt_epi64(vc, v);
+    uint32_t bits = (uint32_t)_mm_movemask_pd(_mm_castsi128_pd(r)) ^ flip;
+    mask[i >> 6] |= (uint64_t)bits << (i & 63);
+  }
+  cmp_i64_tail(vals, i, n, op, c, mask);
+}
+
+__attribute__((target("sse4.2")))
+static void between_i32_sse(const int32_t* vals, uint32_t n, int32_t lo, int32_t hi,
+                            uint64_t* mask) {
+  __m128i vlo = _mm_set1_epi32(lo);
+  __m128i vhi = _mm_set1_epi32(hi);
+  uint32_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(vals + i));
+    __m128i out = _mm_or_si128(_mm_cmpgt_epi32(vlo, v), _mm_cmpgt_epi32(v, vhi));
+    uint32_t bits = (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(out)) ^ 0xF;
+    mask[i >> 6] |= (uint64_t)bits << (i & 63);
+  }
+  between_i32_tail(vals, i, n, lo, hi, mask);
+}
+
+__attribute__((target("sse4.2")))
+static void between_i64_sse(const int64_t* vals, uint32_t n, int64_t lo, int64_t hi,
+                            uint64_t* mask) {
+  __m128i vlo = _mm_set1_epi64x(lo);
+  __m128i vhi = _mm_set1_epi64x(hi);
+  uint32_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(vals + i));
+    __m128i out = _mm_or_si128(_mm_cmpgt_epi64(vlo, v), _mm_cmpgt_epi64(v, vhi));
+    uint32_t bits = (uint32_t)_mm_movemask_pd(_mm_castsi128_pd(out)) ^ 0x3;
+    mask[i >> 6] |= (uint64_t)bits << (i & 63);
+  }
+  between_i64_tail(vals, i, n, lo, hi, mask);
+}
+
+/* AVX2: 8 x int32 or 4 x int64 per step */
+__attribute__((target("avx2")))
+static void cmp_i32_avx2(const int32_t* vals, uint32_t n, CmpOp op, int32_t c, uint64_t* mask) {
+  __m256i vc = _mm256_set1_epi32(c);
+  BaseCmp base = base_cmp(op);
+  uint32_t flip = negates(op) ? 0xFF : 0;
+  uint32_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(vals + i));
+    __m256i r = base == BASE_EQ ? _mm256_cmpeq_epi32(v, vc)
+              : base == BASE_GT ? _mm256_cmpgt_epi32(v, vc)
+              : _mm256_cmpgt_epi32(vc, v);
+    uint32_t bits = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(r)) ^ flip;
+    mask[i >> 6] |= (uint64_t)bits << (i & 63);
+  }
+  cmp_i32_tail(vals, i, n, op, c, mask);
+}
+
+__attribute__((target("avx2")))
+static void cmp_i64_avx2(const int64_t* vals, uint32_t n, CmpOp op, int64_t c, uint64_t* mask) {
+  __m256i vc = _mm256_set1_epi64x(c);
+  BaseCmp base = base_cmp(op);
+  uint32_t flip = negates(op) ? 0xF : 0;
+  uint32_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(vals + i));
+    __m256i r = base == BASE_EQ ? _mm256_cmpeq_epi64(v, vc)
+              : base == BASE_GT ? _mm256_cmpgt_epi64(v, vc)
+              : _mm256_cmpgt_epi64(vc, v);
+    uint32_t bits = (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(r)) ^ flip;
+    mask[i >> 6] |= (uint64_t)bits << (i & 63);
+  }
+  cmp_i64_tail(vals, i, n, op, c, mask);
+}
+
+__attribute__((target("avx2")))
+static void between_i32_avx2(const int32_t* vals, uint32_t n, int32_t lo, int32_t hi,
+                             uint64_t* mask) {
+  __m256i vlo = _mm256_set1_epi32(lo);
+  __m256i vhi = _mm256_set1_epi32(hi);
+  uint32_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(vals + i));
+    __m256i out = _mm256_or_si256(_mm256_cmpgt_epi32(vlo, v), _mm256_cmpgt_epi32(v, vhi));
+    uint32_t bits = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(out)) ^ 0xFF;
+    mask[i >> 6] |= (uint64_t)bits << (i & 63);
+  }
+  between_i32_tail(vals, i, n, lo, hi, mask);
+}
+
+__attribute__((target("avx2")))
+static void between_i64_avx2(const int64_t* vals, uint32_t n, int64_t lo, int64_t hi,
+                             uint64_t* mask) {
+  __m256i vlo = _mm256_set1_epi64x(lo);
+  __m256i vhi = _mm256_set1_epi64x(hi);
+  uint32_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(vals + i));
+    __m256i out = _mm256_or_si256(_mm256_cmpgt_epi64(vlo, v), _mm256_cmpgt_epi64(v, vhi));
+    uint32_t bits = (uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(out)) ^ 0xF;
+    mask[i >> 6] |= (uint64_t)bits << (i & 63);
+  }
+  between_i64_tail(vals, i, n, lo, hi, mask);
+}
+
+static const FilterKernels sse_kernels = {
+  cmp_i32_sse, cmp_i64_sse, between_i32_sse, between_i64_sse
+};
+
+static const FilterKernels avx2_kernels = {
+  cmp_i32_avx2, cmp_i64_avx2, between_i32_avx2, between_i64_avx2
+};
+
+static int cpu_has(SimdLevel level) {
+  __builtin_cpu_init();
+  switch (level) {
+    case SIMD_AVX2:
+      return __builtin_cpu_supports("avx2");
+    case SIMD_SSE:
+      return __builtin_cpu_supports("sse4.2");
+    default:
+      return 1;
+  }
+}
+
+#else
+
+static int cpu_has(SimdLevel level) {
+  return level == SIMD_SCALAR;
+}
+
+#endif /* MYDB_SIMD_X86 */
+
+/* Runtime dispatch */
+static const FilterKernels* active_kernels = NULL;
+static SimdLevel active_level = SIMD_SCALAR;
+
+static void use_level(SimdLevel level) {
+  active_level = level;
+#ifdef MYDB_SIMD_X86
+  if (level == SIMD_AVX2) {
+    active_kernels = &avx2_kernels;
+    return;
+  }
+  if (level == SIMD_SSE) {
+    active_kernels = &sse_kernels;
+    return;
+  }
+#endif
+  active_kernels = &scalar_kernels;
+}
+
+static const FilterKernels* kernels(void) {
+  if (!active_kernels) {
+    use_level(cpu_has(SIMD_AVX2) ? SIMD_AVX2 : cpu_has(SIMD_SSE) ? SIMD_SSE : SIMD_SCALAR);
+  }
+  return active_kernels;
+}
+
+SimdLevel simd_filter_level(void) {
+  kernels();
+  return active_level;
+}
+
+const char* simd_filter_level_name(SimdLevel level) {
+  switch (level) {
+    case SIMD_AVX2: return "avx2";
+    case SIMD_SSE: return "sse";
+    default: return "scalar";
+  }
+}
+
+int simd_filter_force(SimdLevel level) {
+  if (!cpu_has(level)) {
+    return -1;
+  }
+  use_level(level);
+  return 0;
+}
+
+/* Entry points */
+static void mask_clear(uint64_t* mask, uint32_t n) {
+  memset(mask, 0, ((n + 63) / 64) * sizeof(uint64_t));
+}
+
+static void mask_fill(uint64_t* mask, uint32_t n) {
+  for (uint32_t w = 0; w < n / 64; w++) {
+    mask[w] = ~(uint64_t)0;
+  }
+  if (n % 64) {
+    mask[n / 64] = ((uint64_t)1 << (n % 64)) - 1;
+  }
+}
+
+void simd_filter_cmp_i32(const int32_t* vals, uint32_t n, CmpOp op, int64_t c, uint64_t* mask) {
+  mask_clear(mask, n);
+  if (c > INT32_MAX || c < INT32_MIN) {
+    /* Every value lies on the same side of the constant */
+    int above = c > INT32_MAX;
+    int all = op == CMP_NE || (above ? (op == CMP_LT || op == CMP_LE)
+                                     : (op == CMP_GT || op == CMP_GE));
+    if (all) {
+      mask_fill(mask, n);
+    }
+    return;
+  }
+  kernels()->cmp_i32(vals, n, op, (int32_t)c, mask);
+}
+
+void simd_filter_cmp_i64(const int64_t* vals, uint32_t n, CmpOp op, int64_t c, uint64_t* mask) {
+  mask_clear(mask, n);
+  kernels()->cmp_i64(vals, n, op, c, mask);
+}
+
+void simd_filter_between_i32(const int32_t* vals, uint32_t n, int64_t lo, int64_t hi, uint64_t* mask) {
+  mask_clear(mask, n);
+  if (lo < INT32_MIN) {
+    lo = INT32_MIN;
+  }
+  if (hi > INT32_MAX) {
+    hi = INT32_MAX;
+  }
+  if (lo > hi) {
+    return;
+  }
+  kernels()->between_i32(vals, n, (int32_t)lo, (int32_t)hi, mask);
+}
+
+void simd_filter_between_i64(const int64_t* vals, uint32_t n, int64_t lo, int64_t hi, uint64_t* mask) {
+  mask_clear(mask, n);
+  if (lo > hi) {
+    return;
+  }
+  kernels()->between_i64(vals, n, lo, hi, mask);
+}
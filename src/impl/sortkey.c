@@ -0,0 +1,311 @@
+#include "../include/sortkey.h"
+#include "../include/schema.h"
+#include "../include/threadpool.h"
+#include <stdlib.h>
+#include <string.h>
+
+void sortkey_format_init(SortKeyFormat* f, Table* t, const SortSpec* spec) {
+  memset(f, 0, sizeof(*f));
+  f->spec = *spec;
+  for (uint32_t i = 0; i < spec->n_cols; i++) {
+    int col = spec->cols[i].col_idx;
+    const ColumnDef* c = &t->active_schema.columns[col];
+    f->types[i] = c->type;
+    f->offsets[i] = schema_col_offset(&t->active_schema, col);
+    switch (c->type) {
+      case COL_TYPE_INT:
+        f->widths[i] = 4;
+        break;
+      case COL_TYPE_TIMESTAMP:
+        f->widths[i] = 8;
+        break;
+      default:
+        f->widths[i] = c->size;
+        break;
+    }
+    f->key_len += f->widths[i];
+  }
+  f->key_len += 4; /* Sequence number */
+}
+
+static void put_be(uint8_t* out, uint64_t v, uint32_t bytes) {
+  for (uint32_t i = 0; i < bytes; i++) {
+    out[i] = (uint8_t)(v >> (8 * (bytes - 1 - i)));
+  }
+}
+
+void sortkey_encode(const SortKeyFormat* f, const void* row, uint32_t seq, uint8_t* out) {
+  const uint8_t* src = (const uint8_t*)row;
+  for (uint32_t i = 0; i < f->spec.n_cols; i++) {
+    const uint8_t* v = src + f->offsets[i];
+    uint32_t w = f->widths[i];
+    switch (f->types[i]) {
+      case COL_TYPE_INT: {
+        int32_t x;
+        memcpy(&x, v, 4);
+        put_be(out, (uint32_t)x ^ 0x80000000u, 4);
+        break;
+      }
+      case COL_TYPE_TIMESTAMP: {
+        int64_t x;
+        memcpy(&x, v, 8);
+        put_be(out, (uint64_t)x ^ 0x8000000000000000ull, 8);
+        break;
+      }
+      default: {
+        /* Bytes up to the first NUL, then padding: memcmp order is strcmp order */
+        const uint8_t* nul = memchr(v, 0, w);
+        size_t len = nul ? (size_t)(nul - v) : w;
+        memcpy(out, v, len);
+        memset(out + len, 0, w - len);
+        break;
+      }
+    }
+    if (f->spec.cols[i].desc) {
+      for (uint32_t j = 0; j < w; j++) {
+        out[j] = (uint8_t)~out[j];
+      }
+    }
+    out += w;
+  }
+  put_be(out, seq, 4);
+}
+
+static void insertion_sort(SortItem* a, uint32_t n, uint32_t depth, uint32_t key_len) {
+  for (uint32_t i = 1; i < n; i++) {
+    SortItem x = a[i];
+    uint32_t j = i;
+    while (j > 0 && memcmp(a[j - 1].key + depth, x.key + depth, key_len - depth) > 0) {
+      a[j] = a[j - 1];
+      j--;
+    }
+    a[j] = x;
+  }
+}
+
+/* MSD radix sort, permuting each byte's buckets in place (American flag
+ * sort). Smaller buckets recurse and the largest is handled by the loop, so
+ * the recursion is at most log2(n) deep however long the keys are. */
+static void radix_sort(SortItem* a, uint32_t n, uint32_t depth, uint32_t key_len) {
+  while (n >= SORT_RADIX_MIN && depth < key_len) {
+    uint32_t count[256] = {0};
+    for (uint32_t i = 0; i < n; i++) {
+      count[a[i].key[depth]]++;
+    }
+    uint32_t largest = 0;
+    for (uint32_t b = 1; b < 256; b++) {
+      if (count[b] > count[largest]) {
+        largest = b;
+      }
+    }
+    if (count[largest] == n) {
+      depth++;
+      continue;
+    }
+
+    uint32_t start[257];
+    uint32_t next[256];
+    start[0] = 0;
+    for (uint32_t b = 0; b < 256; b++) {
+      start[b + 1] = start[b] + count[b];
+      next[b] = start[b];
+    }
+    for (uint32_t b = 0; b < 256; b++) {
+      while (next[b] < start[b + 1]) {
+        SortItem x = a[next[b]];
+        uint8_t xb = x.key[depth];
+        while (xb != b) {
+          SortItem y = a[next[xb]];
+          a[next[xb]++] = x;
+          x = y;
+          xb = x.key[depth];
+        }
+        a[next[b]++] = x;
+      }
+    }
+
+    for (uint32_t b = 0; b < 256; b++) {
+      if (b != largest && count[b] > 1) {
+        radix_sort(a + start[b], count[b], depth + 1, key_len);
+      }
+    }
+    a += start[largest];
+    n = count[largest];
+    depth++;
+  }
+  if (n > 1 && depth < key_len) {
+    insertion_sort(a, n, depth, key_len);
+  }
+}
+
+void sortkey_sort(SortItem* items, uint32_t n, uint32_t key_len) {
+  radix_sort(items, n, 0, key_len);
+}
+
+/* Parallel sample sort */
+#define SAMPLE_BUCKETS_PER_THREAD 4
+#define SAMPLE_OVERSAMPLING 32
+
+typedef struct {
+  SortItem* items;
+  SortItem* tmp;
+  uint32_t n;
+  uint32_t key_len;
+  uint32_t n_chunks;
+  uint32_t n_buckets;
+  const uint8_t** splitters;  /* n_buckets - 1, ascending */
+  uint8_t* bucket_of;         /* Bucket of each item */
+  uint32_t* counts;           /* [chunk * n_buckets + bucket], then offsets */
+  uint32_t* bucket_start;     /* n_buckets + 1 */
+} SampleSort;
+
+typedef struct {
+  SampleSort* ss;
+  uint32_t index;
+} SampleTask;
+
+static uint32_t chunk_begin(const SampleSort* ss, uint32_t c) {
+  return (uint32_t)((uint64_t)ss->n * c / ss->n_chunks);
+}
+
+/* Bucket of a key: the first splitter it does not exceed */
+static uint32_t sample_bucket(const SampleSort* ss, const uint8_t* key) {
+  uint32_t lo = 0;
+  uint32_t hi = ss->n_buckets - 1;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (memcmp(key, ss->splitters[mid], ss->key_len) <= 0) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  return lo;
+}
+
+static void classify_task(void* arg) {
+  SampleTask* task = (SampleTask*)arg;
+  SampleSort* ss = task->ss;
+  uint32_t* counts = ss->counts + (size_t)task->index * ss->n_buckets;
+  uint32_t end = chunk_begin(ss, task->index + 1);
+  for (uint32_t i = chunk_begin(ss, task->index); i < end; i++) {
+    uint32_t b = sample_bucket(ss, ss->items[i].key);
+    ss->bucket_of[i] = (uint8_t)b;
+    counts[b]++;
+  }
+}
+
+static void scatter_task(void* arg) {
+  SampleTask* task = (SampleTask*)arg;
+  SampleSort* ss = task->ss;
+  uint32_t* next = ss->counts + (size_t)task->index * ss->n_buckets;
+  uint32_t end = chunk_begin(ss, task->index + 1);
+  for (uint32_t i = chunk_begin(ss, task->index); i < end; i++) {
+    ss->tmp[next[ss->bucket_of[i]]++] = ss->items[i];
+  }
+}
+
+static void bucket_task(void* arg) {
+  SampleTask* task = (SampleTask*)arg;
+  SampleSort* ss = task->ss;
+  uint32_t start = ss->bucket_start[task->index];
+  uint32_t n = ss->bucket_start[task->index + 1] - start;
+  sortkey_sort(ss->tmp + start, n, ss->key_len);
+  memcpy(ss->items + start, ss->tmp + start, (size_t)n * sizeof(SortItem));
+}
+
+/* Run `fn` for indexes 0..n-1 on the pool and wait for all of them */
+static bool run_phase(SampleSort* ss, TaskFn fn, uint32_t n, SampleTask* tasks) {
+  TaskGroup* g = task_group_new(n);
+  if (!g) {
+    return false;
+  }
+  for (uint32_t i = 0; i < n; i++) {
+    tasks[i].ss = ss;
+    tasks[i].index = i;
+    task_group_submit(g, i, fn, &tasks[i]);
+  }
+  task_group_free(g);
+  return true;
+}
+
+static bool sample_sort(SampleSort* ss, SampleTask* tasks) {
+  /* Splitters: every SAMPLE_OVERSAMPLING-th key of a sorted, evenly spaced
+   * sample. Keys are unique, so the splitters are strictly increasing. */
+  uint32_t n_sample = ss->n_buckets * SAMPLE_OVERSAMPLING;
+  SortItem* sample = malloc((size_t)n_sample * sizeof(SortItem));
+  if (!sample) {
+    return false;
+  }
+  for (uint32_t i = 0; i < n_sample; i++) {
+    sample[i] = ss->items[(uint64_t)ss->n * i / n_sample];
+  }
+  sortkey_sort(sample, n_sample, ss->key_len);
+  for (uint32_t b = 0; b + 1 < ss->n_buckets; b++) {
+    ss->splitters[b] = sample[(b + 1) * SAMPLE_OVERSAMPLING - 1].key;
+  }
+  free(sample);
+
+  if (!run_phase(ss, classify_task, ss->n_chunks, tasks)) {
+    return false;
+  }
+
+  /* Turn per-chunk counts into scatter offsets: bucket by bucket, and
+   * chunk by chunk within a bucket */
+  uint32_t pos = 0;
+  for (uint32_t b = 0; b < ss->n_buckets; b++) {
+    ss->bucket_start[b] = pos;
+    for (uint32_t c = 0; c < ss->n_chunks; c++) {
+      uint32_t* count = &ss->counts[(size_t)c * ss->n_buckets + b];
+      uint32_t n = *count;
+      *count = pos;
+      pos += n;
+    }
+  }
+  ss->bucket_start[ss->n_buckets] = pos;
+
+  return run_phase(ss, scatter_task, ss->n_chunks, tasks) &&
+         run_phase(ss, bucket_task, ss->n_buckets, tasks);
+}
+
+void sortkey_sort_parallel(SortItem* items, uint32_t n, uint32_t key_len, uint32_t threads) {
+  if (threads > THREADPOOL_MAX_WORKERS) {
+    threads = THREADPOOL_MAX_WORKERS;
+  }
+  if (n < SORT_PARALLEL_MIN || threads <= 1) {
+    sortkey_sort(items, n, key_len);
+    return;
+  }
+
+  SampleSort ss = {0};
+  ss.items = items;
+  ss.n = n;
+  ss.key_len = key_len;
+  ss.n_chunks = threads;
+  ss.n_buckets = threads * SAMPLE_BUCKETS_PER_THREAD;
+  if (ss.n_buckets > 256) {
+    ss.n_buckets = 256;
+  }
+  uint32_t max_tasks = ss.n_buckets > ss.n_chunks ? ss.n_buckets : ss.n_chunks;
+  ss.tmp = malloc((size_t)n * sizeof(SortItem));
+  ss.bucket_of = malloc(n);
+  ss.splitters = malloc(ss.n_buckets * sizeof(*ss.splitters));
+  ss.counts = calloc((size_t)ss.n_chunks * ss.n_buckets, sizeof(uint32_t));
+  ss.bucket_start = malloc((ss.n_buckets + 1) * sizeof(uint32_t));
+  SampleTask* tasks = malloc(max_tasks * sizeof(SampleTask));
+
+  bool ok = ss.tmp && ss.bucket_of && ss.splitters && ss.counts && ss.bucket_start && tasks;
+  if (ok) {
+    threadpool_start(threads);
+    ok = sample_sort(&ss, tasks);
+  }
+  free(ss.tmp);
+  free(ss.bucket_of);
+  free(ss.splitters);
+  free(ss.counts);
+  free(ss.bucket_start);
+  free(tasks);
+  if (!ok) {
+    sortkey_sort(items, n, key_len);
+  }
+}
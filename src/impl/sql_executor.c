@@ -2,10 +2,17 @@
 #include "../include/btree.h"
 #include "../include/catalog.h"
 #include "../include/util.h"
+#include "../include/zonemap.h"
+#include "../include/bloom.h"
+#include "../include/predicate.h"
+#include "../include/operator.h"
+#include "../include/hashagg.h"
+#include "../include/analyze.h"
 #include "../sql_parser.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <ctype.h>
 
 /* Helper to collect values from statement */
@@ -18,6 +25,75 @@ static void collect_values(char* start, Statement* st) {
   }
 }
 
+/* Record where each ? placeholder of a parsed statement goes, once its
+ * WHERE, HAVING, VALUES and SET parts have moved into `st` */
+static void collect_expr_params(Statement* st, Expr* e) {
+  if (!e) {
+    return;
+  }
+  if (e->kind == EXPR_LITERAL && e->param > 0 && e->param <= st->param_count) {
+    st->params[e->param - 1].target = PARAM_EXPR;
+    st->params[e->param - 1].expr = e;
+  }
+  collect_expr_params(st, e->left);
+  collect_expr_params(st, e->right);
+  for (uint32_t i = 0; i < e->n_items; i++) {
+    collect_expr_params(st, e->items[i]);
+  }
+}
+
+static bool collect_params(Statement* st, const ParsedStmt* ps) {
+  if (ps->param_count == 0) {
+    return true;
+  }
+  st->params = calloc(ps->param_count, sizeof(StmtParam));
+  if (!st->params) {
+    printf("Out of memory\n");
+    return false;
+  }
+  st->param_count = ps->param_count;
+  collect_expr_params(st, st->where_ast);
+  collect_expr_params(st, st->having_ast);
+  uint32_t k = 0;
+  for (uint32_t i = 0; st->insert_values && i < st->insert_rows * st->num_values; i++) {
+    if (!st->insert_values[i] && k < st->param_count) {
+      st->params[k].target = PARAM_INSERT_VALUE;
+      st->params[k++].slot = i;
+    }
+  }
+  for (uint32_t i = 0; i < st->set_count; i++) {
+    uint32_t n = ps->set_param[i];
+    if (n > 0 && n <= st->param_count) {
+      st->params[n - 1].target = PARAM_SET_VALUE;
+      st->params[n - 1].slot = i;
+    }
+  }
+  return true;
+}
+
+/* INSERT INTO t VALUES (...), (...): rows of quoted or bare literals
+ * through the SQL parser */
+static PrepareResult prepare_insert_values(InputBuffer* input_buffer, Statement* st) {
+  ParsedStmt ps;
+  if (parse_sql_to_parsed_stmt(input_buffer->buffer, &ps) != 0) {
+    return PREPARE_SYNTAX_ERROR;
+  }
+  if (ps.kind != PARSED_INSERT || ps.insert_row_len > MAX_VALUES) {
+    parsed_stmt_free(&ps);
+    return PREPARE_SYNTAX_ERROR;
+  }
+  strncpy(st->target_table, ps.insert_table, MAX_TABLE_NAME_LEN - 1);
+  st->target_table[MAX_TABLE_NAME_LEN - 1] = '\0';
+  st->num_values = ps.insert_row_len;
+  st->insert_rows = ps.insert_n / ps.insert_row_len;
+  st->insert_values = ps.insert_value;
+  ps.insert_value = NULL;
+  ps.insert_n = 0;
+  bool ok = collect_params(st, &ps);
+  parsed_stmt_free(&ps);
+  return ok ? PREPARE_SUCCESS : PREPARE_SYNTAX_ERROR;
+}
+
 /* Prepare INSERT statement */
 PrepareResult prepare_insert(InputBuffer* input_buffer, Statement* st) {
   st->type = STATEMENT_INSERT;
@@ -33,6 +109,17 @@ PrepareResult prepare_insert(InputBuffer* input_buffer, Statement* st) {
     while (*s == ' ' || *s == '\t') {
       s++;
     }
+    const char* after = s;
+    while (*after && *after != ' ' && *after != '\t' && *after != '(') {
+      after++;
+    }
+    while (*after == ' ' || *after == '\t') {
+      after++;
+    }
+    if (strncasecmp(after, "values", 6) == 0 &&
+        (after[6] == ' ' || after[6] == '\t' || after[6] == '(')) {
+      return prepare_insert_values(input_buffer, st);
+    }
     char* tbl = strtok(s, " ");
     if (!tbl) {
       return PREPARE_SYNTAX_ERROR;
@@ -55,7 +142,10 @@ PrepareResult prepare_select(InputBuffer* in, Statement* st, Table* table) {
   st->type = STATEMENT_SELECT;
   st->target_table[0] = '\0';
   st->proj_count = 0;
+  st->aggregate = false;
+  st->agg_count = 0;
   st->has_where = false;
+  st->join.active = false;
 
   char* s = in->buffer;
   while (*s == ' ' || *s == '\t') {
@@ -201,39 +291,519 @@ PrepareResult prepare_select(InputBuffer* in, Statement* st, Table* table) {
   return PREPARE_SUCCESS;
 }
 
+static AggFunc agg_func_from_parsed(int agg) {
+  switch (agg) {
+    case PARSED_AGG_SUM: return AGG_SUM;
+    case PARSED_AGG_MIN: return AGG_MIN;
+    case PARSED_AGG_MAX: return AGG_MAX;
+    case PARSED_AGG_AVG: return AGG_AVG;
+    default: return AGG_COUNT;
+  }
+}
+
+/* Resolve the aggregate call `agg(arg)`; prints why when it is invalid */
+static bool resolve_agg(Table* t, int agg, const char* arg, AggSpec* out) {
+  out->func = agg_func_from_parsed(agg);
+  out->col_idx = -1;
+  if (out->func == AGG_COUNT && strcmp(arg, "*") == 0) {
+    return true;
+  }
+  out->col_idx = schema_col_index(&t->active_schema, arg);
+  if (out->col_idx < 0) {
+    printf("Unknown column: %s\n", arg);
+    return false;
+  }
+  if ((out->func == AGG_SUM || out->func == AGG_AVG) &&
+      t->active_schema.columns[out->col_idx].type != COL_TYPE_INT) {
+    printf("SUM/AVG need an int column: %s\n", arg);
+    return false;
+  }
+  return true;
+}
+
+/* Index of `spec` among the statement's aggregates, adding it if new; -1
+ * when there is no room */
+static int statement_agg_index(Statement* st, const AggSpec* spec) {
+  for (uint32_t i = 0; i < st->agg_count; i++) {
+    if (st->aggs[i].func == spec->func && st->aggs[i].col_idx == spec->col_idx) {
+      return (int)i;
+    }
+  }
+  if (st->agg_count == AGG_MAX_FUNCS) {
+    printf("Too many aggregates\n");
+    return -1;
+  }
+  st->aggs[st->agg_count] = *spec;
+  return (int)st->agg_count++;
+}
+
+static int statement_group_index(const Statement* st, int col) {
+  for (uint32_t g = 0; g < st->group_count; g++) {
+    if (st->group_by[g] == col) {
+      return (int)g;
+    }
+  }
+  return -1;
+}
+
+static bool expr_has_agg(const Expr* e) {
+  if (!e) {
+    return false;
+  }
+  if (e->kind == EXPR_AGG || expr_has_agg(e->left) || expr_has_agg(e->right)) {
+    return true;
+  }
+  for (uint32_t i = 0; i < e->n_items; i++) {
+    if (expr_has_agg(e->items[i])) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* HAVING may name grouped columns and any aggregate; the aggregates it
+ * names are computed along with the projected ones */
+static bool prepare_having(Statement* st, Table* t, const Expr* e) {
+  if (!e) {
+    return true;
+  }
+  if (e->kind == EXPR_AGG) {
+    AggSpec spec;
+    return resolve_agg(t, parsed_agg_from_name(e->op), e->text, &spec) &&
+           statement_agg_index(st, &spec) >= 0;
+  }
+  if (e->kind == EXPR_COLUMN &&
+      statement_group_index(st, schema_col_index(&t->active_schema, e->text)) < 0) {
+    printf("Column %s must appear in GROUP BY or an aggregate\n", e->text);
+    return false;
+  }
+  if (e->kind == EXPR_BETWEEN) {
+    /* The bounds hang off a node that is not an operand itself */
+    return prepare_having(st, t, e->left) &&
+           (!e->right || (prepare_having(st, t, e->right->left) &&
+                          prepare_having(st, t, e->right->right)));
+  }
+  if (!prepare_having(st, t, e->left) || !prepare_having(st, t, e->right)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < e->n_items; i++) {
+    if (!prepare_having(st, t, e->items[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Resolve the projection, GROUP BY and HAVING; prints why on failure */
+static bool prepare_projection(Statement* st, Table* t, const ParsedStmt* ps) {
+  st->proj_count = 0;
+  st->agg_count = 0;
+  st->agg_output_count = 0;
+  st->group_count = 0;
+  for (uint32_t g = 0; g < ps->group_count; g++) {
+    int idx = schema_col_index(&t->active_schema, ps->group_by[g]);
+    if (idx < 0) {
+      printf("Unknown column in GROUP BY: %s\n", ps->group_by[g]);
+      return false;
+    }
+    st->group_by[st->group_count++] = idx;
+  }
+
+  for (uint32_t i = 0; i < ps->proj_count && !ps->select_all; i++) {
+    AggOutput* out = &st->agg_outputs[st->agg_output_count++];
+    if (ps->proj_agg[i] != PARSED_AGG_NONE) {
+      AggSpec spec;
+      if (!resolve_agg(t, ps->proj_agg[i], ps->proj_list[i], &spec)) {
+        return false;
+      }
+      int a = statement_agg_index(st, &spec);
+      if (a < 0) {
+        return false;
+      }
+      out->group = false;
+      out->index = (uint32_t)a;
+      continue;
+    }
+    int idx = schema_col_index(&t->active_schema, ps->proj_list[i]);
+    if (idx < 0) {
+      printf("Unknown column: %s\n", ps->proj_list[i]);
+      return false;
+    }
+    st->proj_indices[st->proj_count++] = idx;
+    out->group = true;
+    out->index = (uint32_t)statement_group_index(st, idx);
+  }
+
+  st->aggregate = st->agg_count > 0 || st->group_count > 0 || ps->having;
+  if (!st->aggregate) {
+    return true;
+  }
+  if (ps->select_all) {
+    printf("SELECT * cannot be grouped; name the columns\n");
+    return false;
+  }
+  for (uint32_t i = 0; i < st->agg_output_count; i++) {
+    if (st->agg_outputs[i].group && st->agg_outputs[i].index == UINT32_MAX) {
+      printf("Column %s must appear in GROUP BY or an aggregate\n", ps->proj_list[i]);
+      return false;
+    }
+  }
+  if (st->group_count > 0 && ps->order_count > 0) {
+    printf("ORDER BY is not supported with GROUP BY\n");
+    return false;
+  }
+  return prepare_having(st, t, ps->having);
+}
+
+/* Qualify a column name against a join's schema: a bare name only one
+ * side has becomes "qualifier.name". Prints why and returns false when
+ * both sides have it; names matching nothing are left to the usual
+ * unknown-column errors. */
+static bool qualify_column(const TableSchema* s, char* name, size_t cap) {
+  if (strchr(name, '.') || strcmp(name, "*") == 0) {
+    return true;
+  }
+  int found = -1;
+  for (uint32_t i = 0; i < s->num_columns; i++) {
+    const char* dot = strchr(s->columns[i].name, '.');
+    if (dot && strcmp(dot + 1, name) == 0) {
+      if (found >= 0) {
+        printf("Ambiguous column: %s\n", name);
+        return false;
+      }
+      found = (int)i;
+    }
+  }
+  if (found >= 0) {
+    snprintf(name, cap, "%s", s->columns[found].name);
+  }
+  return true;
+}
+
+static bool qualify_expr(const TableSchema* s, Expr* e) {
+  if (!e) {
+    return true;
+  }
+  if ((e->kind == EXPR_COLUMN || e->kind == EXPR_AGG) &&
+      !qualify_column(s, e->text, sizeof(e->text))) {
+    return false;
+  }
+  if (!qualify_expr(s, e->left) || !qualify_expr(s, e->right)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < e->n_items; i++) {
+    if (!qualify_expr(s, e->items[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Resolve FROM ... JOIN ... ON: the joined rows' schema, the ON column of
+ * each side, and every column the statement names, qualified against the
+ * joined schema. Prints why on failure. */
+static bool prepare_join(Statement* st, Table* t, ParsedStmt* ps) {
+  JoinSpec* j = &st->join;
+  const char* names[JOIN_SIDES] = { ps->table_name, ps->join_table };
+  const char* quals[JOIN_SIDES] = {
+    ps->table_alias[0] ? ps->table_alias : ps->table_name,
+    ps->join_alias[0] ? ps->join_alias : ps->join_table
+  };
+  if (strcmp(quals[0], quals[1]) == 0) {
+    printf("Joined tables need distinct aliases: %s\n", quals[0]);
+    return false;
+  }
+
+  memset(j, 0, sizeof(*j));
+  TableSchema* out = &j->schema;
+  for (int side = 0; side < JOIN_SIDES; side++) {
+    TableSchema s;
+    if (lookup_table_schema(t->pager, names[side], &s) < 0) {
+      printf("Table not found: %s\n", names[side]);
+      return false;
+    }
+    strncpy(j->tables[side], names[side], MAX_TABLE_NAME_LEN - 1);
+    if (out->num_columns + s.num_columns > MAX_COLUMNS) {
+      printf("Too many columns to join\n");
+      return false;
+    }
+    for (uint32_t c = 0; c < s.num_columns; c++) {
+      ColumnDef* col = &out->columns[out->num_columns++];
+      *col = s.columns[c];
+      int len = snprintf(col->name, sizeof(col->name), "%s.%s", quals[side], s.columns[c].name);
+      if (len < 0 || (size_t)len >= sizeof(col->name)) {
+        printf("Column name too long for a join: %s.%s\n", quals[side], s.columns[c].name);
+        return false;
+      }
+    }
+    if (side == 0) {
+      j->left_columns = out->num_columns;
+    }
+  }
+
+  int on[2];
+  for (int i = 0; i < 2; i++) {
+    if (!qualify_column(out, ps->join_on[i], sizeof(ps->join_on[i]))) {
+      return false;
+    }
+    on[i] = schema_col_index(out, ps->join_on[i]);
+    if (on[i] < 0) {
+      printf("Unknown column in ON: %s\n", ps->join_on[i]);
+      return false;
+    }
+  }
+  if (on[0] > on[1]) {
+    int tmp = on[0];
+    on[0] = on[1];
+    on[1] = tmp;
+  }
+  if ((uint32_t)on[0] >= j->left_columns || (uint32_t)on[1] < j->left_columns) {
+    printf("ON must compare a column of each table\n");
+    return false;
+  }
+  if ((out->columns[on[0]].type == COL_TYPE_STRING) != (out->columns[on[1]].type == COL_TYPE_STRING)) {
+    printf("ON cannot compare a string with a number\n");
+    return false;
+  }
+  j->key_cols[0] = on[0];
+  j->key_cols[1] = on[1] - (int)j->left_columns;
+
+  for (uint32_t i = 0; i < ps->proj_count; i++) {
+    if (!qualify_column(out, ps->proj_list[i], sizeof(ps->proj_list[i]))) {
+      return false;
+    }
+  }
+  for (uint32_t i = 0; i < ps->group_count; i++) {
+    if (!qualify_column(out, ps->group_by[i], sizeof(ps->group_by[i]))) {
+      return false;
+    }
+  }
+  for (uint32_t i = 0; i < ps->order_count; i++) {
+    if (!qualify_column(out, ps->order_by[i], sizeof(ps->order_by[i]))) {
+      return false;
+    }
+  }
+  if (!qualify_expr(out, ps->where) || !qualify_expr(out, ps->having)) {
+    return false;
+  }
+  j->active = true;
+  return true;
+}
+
+/* Serialize the value text of SET column `col` into `row`; prints why
+ * on failure */
+static PrepareResult serialize_set_value(const TableSchema* s, int col, const char* val, uint8_t* row) {
+  const ColumnDef* c = &s->columns[col];
+  uint8_t* dest = row + schema_col_offset(s, col);
+  if (c->type == COL_TYPE_INT) {
+    int v = 0;
+    if (parse_int(val, &v) != 0) {
+      printf("Not an int for %s: %s\n", c->name, val);
+      return PREPARE_SYNTAX_ERROR;
+    }
+    memcpy(dest, &v, 4);
+  } else if (c->type == COL_TYPE_TIMESTAMP) {
+    int64_t v = 0;
+    if (parse_int64(val, &v) != 0) {
+      printf("Not a timestamp for %s: %s\n", c->name, val);
+      return PREPARE_SYNTAX_ERROR;
+    }
+    memcpy(dest, &v, 8);
+  } else if (strlen(val) > c->size) {
+    return PREPARE_STRING_TOO_LONG;
+  } else {
+    memset(dest, 0, c->size);
+    memcpy(dest, val, strlen(val));
+  }
+  return PREPARE_SUCCESS;
+}
+
+/* UPDATE: resolve the SET columns against the target table and serialize
+ * their values into set_row; prints why on failure */
+static PrepareResult prepare_update(InputBuffer* in, Statement* st, Table* table) {
+  ParsedStmt ps;
+  if (parse_sql_to_parsed_stmt(in->buffer, &ps) != 0) {
+    return PREPARE_SYNTAX_ERROR;
+  }
+  if (ps.kind != PARSED_UPDATE) {
+    parsed_stmt_free(&ps);
+    return PREPARE_SYNTAX_ERROR;
+  }
+  st->type = STATEMENT_UPDATE;
+  strncpy(st->target_table, ps.table_name, MAX_TABLE_NAME_LEN - 1);
+  st->target_table[MAX_TABLE_NAME_LEN - 1] = '\0';
+  if (table_activate(table, ps.table_name) < 0) {
+    printf("Table not found: %s\n", ps.table_name);
+    parsed_stmt_free(&ps);
+    return PREPARE_SYNTAX_ERROR;
+  }
+
+  PrepareResult result = PREPARE_SUCCESS;
+  const TableSchema* s = &table->active_schema;
+  st->set_count = 0;
+  st->set_row = calloc(1, table->row_size ? table->row_size : 1);
+  if (!st->set_row) {
+    printf("Out of memory\n");
+    result = PREPARE_SYNTAX_ERROR;
+  }
+  for (uint32_t i = 0; i < ps.set_count && result == PREPARE_SUCCESS; i++) {
+    int col = schema_col_index(s, ps.set_cols[i]);
+    if (col < 0) {
+      printf("Unknown column: %s\n", ps.set_cols[i]);
+      result = PREPARE_SYNTAX_ERROR;
+      break;
+    }
+    for (uint32_t j = 0; j < st->set_count; j++) {
+      if (st->set_cols[j] == col) {
+        printf("Column %s is set twice\n", ps.set_cols[i]);
+        result = PREPARE_SYNTAX_ERROR;
+      }
+    }
+    /* A placeholder's value is serialized when it is bound */
+    if (result == PREPARE_SUCCESS && ps.set_param[i] == 0) {
+      result = serialize_set_value(s, col, ps.set_values[i], st->set_row);
+    }
+    st->set_cols[st->set_count++] = col;
+  }
+  if (result != PREPARE_SUCCESS) {
+    free(st->set_row);
+    st->set_row = NULL;
+    parsed_stmt_free(&ps);
+    return result;
+  }
+
+  st->where_ast = ps.where;
+  st->has_where = false;
+  ps.where = NULL;
+  if (st->where_ast) {
+    st->where_prog = predicate_compile(table, st->where_ast);
+  }
+  if (!collect_params(st, &ps)) {
+    parsed_stmt_free(&ps);
+    return PREPARE_SYNTAX_ERROR;
+  }
+  parsed_stmt_free(&ps);
+  return PREPARE_SUCCESS;
+}
+
 /* Prepare statement */
+/* EXPLAIN [ANALYZE] SELECT ...: the SELECT is prepared as usual */
+static PrepareResult prepare_explain(const char* s, Statement* st, Table* table) {
+  ExplainMode mode = EXPLAIN_PLAN;
+  while (*s == ' ' || *s == '\t') {
+    s++;
+  }
+  if (strncmp(s, "analyze ", 8) == 0) {
+    mode = EXPLAIN_ANALYZE;
+    s += 8;
+    while (*s == ' ' || *s == '\t') {
+      s++;
+    }
+  }
+  if (strncmp(s, "select", 6) != 0) {
+    printf("EXPLAIN supports SELECT only\n");
+    return PREPARE_SYNTAX_ERROR;
+  }
+  InputBuffer select;
+  select.buffer = (char*)s;
+  select.buffer_length = strlen(s) + 1;
+  select.input_length = (ssize_t)strlen(s);
+  PrepareResult result = prepare_statement(&select, st, table);
+  st->explain = mode;
+  return result;
+}
+
+/* ANALYZE one table through a copy of the handle, like a join side */
+static ExecuteResult analyze_one(Table* table, const char* name) {
+  Table side = *table;
+  if (table_activate(&side, name) < 0) {
+    printf("Table not found: %s\n", name);
+    return EXECUTE_TABLE_NOT_FOUND;
+  }
+  DbStats before = table->stats;
+  int ret = analyze_table(&side);
+  stats_add_delta(&table->stats, &before, &side.stats);
+  if (ret != 0) {
+    printf("Analyze failed: %s\n", name);
+    return EXECUTE_FAILED;
+  }
+  const TableStats* ts = analyze_stats(&side);
+  printf("Analyzed table '%s': %u rows, %u leaves, height %u.\n", name, ts->row_count,
+         ts->leaf_count, ts->height);
+  return EXECUTE_SUCCESS;
+}
+
+/* ANALYZE [table]: the name is only read here; the table is looked up
+ * when the statement runs */
+static PrepareResult prepare_analyze(const char* s, Statement* st) {
+  while (*s == ' ' || *s == '\t') {
+    s++;
+  }
+  size_t len = 0;
+  while (s[len] && s[len] != ' ' && s[len] != '\t' && s[len] != ';' && len < sizeof(st->target_table) - 1) {
+    st->target_table[len] = s[len];
+    len++;
+  }
+  st->target_table[len] = '\0';
+  st->type = STATEMENT_ANALYZE;
+  return PREPARE_SUCCESS;
+}
+
+/* Statistics for the planner, of every table when none is named. Cached
+ * plans are dropped, as after any catalog change. */
+static ExecuteResult execute_analyze(Statement* st, Table* table) {
+  ExecuteResult result = EXECUTE_SUCCESS;
+  if (st->target_table[0]) {
+    result = analyze_one(table, st->target_table);
+  } else {
+    CatalogHeader* hdr = catalog_header(table->pager);
+    for (uint32_t i = 0; i < hdr->num_tables && result == EXECUTE_SUCCESS; i++) {
+      result = analyze_one(table, catalog_entries(table->pager)[i].name);
+    }
+  }
+  table->catalog_version++;
+  return result;
+}
+
 PrepareResult prepare_statement(InputBuffer* input_buffer, Statement* statement, Table* table) {
   const char* s = input_buffer->buffer;
   statement->where_ast = NULL;
+  statement->where_prog = NULL;
+  statement->having_ast = NULL;
+  statement->join.active = false;
+  statement->set_row = NULL;
+  statement->insert_values = NULL;
+  statement->insert_rows = 0;
+  statement->param_count = 0;
+  statement->params = NULL;
+  statement->explain = EXPLAIN_NONE;
+  statement->profile = NULL;
   while (*s == ' ' || *s == '\t') {
     s++;
   }
 
+  if (strncmp(s, "explain ", 8) == 0) {
+    return prepare_explain(s + 8, statement, table);
+  }
+
   if (strncmp(s, "use ", 4) == 0) {
     const char* name = s + 4;
     while (*name == ' ' || *name == '\t') {
       name++;
     }
-    int idx = catalog_find(table->pager, name);
+    int idx = table_activate(table, name);
     if (idx < 0) {
       printf("Table not found: %s\n", name);
       return PREPARE_UNRECOGNIZED_STATEMENT;
     }
-    CatalogEntry* ents = catalog_entries(table->pager);
-    table->root_page_num = ents[idx].root_page_num;
-
-    uint32_t sidx = ents[idx].schema_index;
-    if (sidx < g_num_tables) {
-      table->active_schema = g_table_schemas[sidx];
-    } else {
-      memset(&table->active_schema, 0, sizeof(TableSchema));
-    }
-    table->row_size = compute_row_size(&table->active_schema);
-
-    printf("Using table '%s'.\n", ents[idx].name);
+    printf("Using table '%s'.\n", catalog_entries(table->pager)[idx].name);
     return PREPARE_CREATE_TABLE_DONE;
   }
 
+  if (strncmp(s, "analyze", 7) == 0 && (s[7] == '\0' || s[7] == ' ' || s[7] == '\t' || s[7] == ';')) {
+    return prepare_analyze(s + 7, statement);
+  }
+
   if (strncmp(s, "insert", 6) == 0) {
     return prepare_insert(input_buffer, statement);
   }
@@ -263,20 +833,30 @@ PrepareResult prepare_statement(InputBuffer* input_buffer, Statement* statement,
     } else {
       statement->target_table[0] = '\0';
     }
-
-    statement->proj_count = 0;
-    if (ps.select_all) {
-      statement->proj_count = 0;
-    } else {
-      for (uint32_t i = 0; i < ps.proj_count; i++) {
-        int idx = schema_col_index(&table->active_schema, ps.proj_list[i]);
-        if (idx < 0) {
-          printf("Unknown column: %s\n", ps.proj_list[i]);
-          parsed_stmt_free(&ps);
-          return PREPARE_SYNTAX_ERROR;
-        }
-        statement->proj_indices[statement->proj_count++] = idx;
+    /* Resolve columns against the table the query names */
+    if (ps.table_name[0]) {
+      table_activate(table, ps.table_name);
+    }
+    /* A join's columns resolve against the joined rows */
+    Table view;
+    Table* cols = table;
+    if (ps.has_join) {
+      if (!prepare_join(statement, table, &ps)) {
+        parsed_stmt_free(&ps);
+        return PREPARE_SYNTAX_ERROR;
       }
+      join_view(&statement->join, table, &view);
+      cols = &view;
+    }
+
+    if (!prepare_projection(statement, cols, &ps)) {
+      parsed_stmt_free(&ps);
+      return PREPARE_SYNTAX_ERROR;
+    }
+    if (expr_has_agg(ps.where)) {
+      printf("Aggregates are not allowed in WHERE; use HAVING\n");
+      parsed_stmt_free(&ps);
+      return PREPARE_SYNTAX_ERROR;
     }
 
     statement->has_limit = ps.has_limit;
@@ -284,27 +864,38 @@ PrepareResult prepare_statement(InputBuffer* input_buffer, Statement* statement,
     statement->has_offset = ps.has_offset;
     statement->offset = ps.offset;
 
-    if (ps.order_by[0]) {
-      int ob_idx = schema_col_index(&table->active_schema, ps.order_by);
+    statement->order_by.n_cols = 0;
+    for (uint32_t i = 0; i < ps.order_count; i++) {
+      int ob_idx = schema_col_index(&cols->active_schema, ps.order_by[i]);
       if (ob_idx < 0) {
-        printf("Unknown column in ORDER BY: %s\n", ps.order_by);
+        printf("Unknown column in ORDER BY: %s\n", ps.order_by[i]);
         parsed_stmt_free(&ps);
         return PREPARE_SYNTAX_ERROR;
       }
-      statement->order_by_index = ob_idx;
-      statement->order_desc = ps.order_desc ? true : false;
-    } else {
-      statement->order_by_index = -1;
-      statement->order_desc = false;
+      SortKeyCol* col = &statement->order_by.cols[statement->order_by.n_cols++];
+      col->col_idx = ob_idx;
+      col->desc = ps.order_desc[i] ? true : false;
     }
 
     statement->where_ast = ps.where;
     statement->has_where = (ps.where != NULL);
     ps.where = NULL;
+    statement->having_ast = ps.having;
+    ps.having = NULL;
+    if (statement->where_ast && (ps.has_join || table->root_page_num != INVALID_PAGE_NUM)) {
+      statement->where_prog = predicate_compile(cols, statement->where_ast);
+    }
+    if (!collect_params(statement, &ps)) {
+      parsed_stmt_free(&ps);
+      return PREPARE_SYNTAX_ERROR;
+    }
 
     parsed_stmt_free(&ps);
     return PREPARE_SUCCESS;
   }
+  if (strncmp(s, "update", 6) == 0) {
+    return prepare_update(input_buffer, statement, table);
+  }
   if (strncmp(s, "delete", 6) == 0) {
     ParsedStmt ps;
     if (parse_sql_to_parsed_stmt(input_buffer->buffer, &ps) != 0) {
@@ -323,6 +914,10 @@ PrepareResult prepare_statement(InputBuffer* input_buffer, Statement* statement,
     }
     statement->where_ast = ps.where;
     ps.where = NULL;
+    if (!collect_params(statement, &ps)) {
+      parsed_stmt_free(&ps);
+      return PREPARE_SYNTAX_ERROR;
+    }
 
     parsed_stmt_free(&ps);
     return PREPARE_SUCCESS;
@@ -331,109 +926,148 @@ PrepareResult prepare_statement(InputBuffer* input_buffer, Statement* statement,
   return PREPARE_UNRECOGNIZED_STATEMENT;
 }
 
-/* Execute INSERT */
-ExecuteResult execute_insert(Statement* st, Table* table) {
-  fprintf(stderr, "[DEBUG-INSERT] Starting INSERT operation\n");
+/* Insert a row given as column value texts under primary key `key` */
+static ExecuteResult insert_row(Table* table, uint32_t key, char* const* values, uint32_t num_values) {
+  Cursor* cursor = table_find(table, key);
+  fprintf(stderr, "[DEBUG-INSERT] table_find returned: page_num=%u, cell_num=%u\n",
+          cursor->page_num, cursor->cell_num);
   fflush(stderr);
 
-  if (table->root_page_num == INVALID_PAGE_NUM) {
-    fprintf(stderr, "[DEBUG-INSERT] No active table (root_page_num=INVALID)\n");
-    fflush(stderr);
-    printf("No active table. Use 'use <table>' or 'insert into <table> ...' first.\n");
-    return EXECUTE_SUCCESS;
-  }
-
-  fprintf(stderr, "[DEBUG-INSERT] Current table root_page_num=%u\n", table->root_page_num);
+  void* node = get_page(table->pager, cursor->page_num);
+  uint32_t num_cells = *leaf_node_num_cells(node);
+  fprintf(stderr, "[DEBUG-INSERT] Node has %u cells\n", num_cells);
   fflush(stderr);
 
-  if (st->target_table[0]) {
-    fprintf(stderr, "[DEBUG-INSERT] Switching to target table: %s\n", st->target_table);
+  if (cursor->cell_num < num_cells) {
+    uint32_t key_at_index = *leaf_key_t(table, node, cursor->cell_num);
+    fprintf(stderr, "[DEBUG-INSERT] Key at cursor position: %u (searching for %u)\n", key_at_index, key);
     fflush(stderr);
-    int idx = catalog_find(table->pager, st->target_table);
-    if (idx < 0) {
-      fprintf(stderr, "[DEBUG-INSERT] Table not found: %s\n", st->target_table);
+    if (key_at_index == key) {
+      fprintf(stderr, "[DEBUG-INSERT] Duplicate key detected: %u\n", key);
       fflush(stderr);
-      printf("Table not found: %s\n", st->target_table);
-      return EXECUTE_SUCCESS;
+      free(cursor);
+      return EXECUTE_DUPLICATE_KEY;
     }
-    CatalogEntry* ents = catalog_entries(table->pager);
-    table->root_page_num = ents[idx].root_page_num;
-    uint32_t sidx = ents[idx].schema_index;
-    fprintf(stderr, "[DEBUG-INSERT] Switched to table, new root_page_num=%u, schema_index=%u\n", table->root_page_num, sidx);
+  } else {
+    fprintf(stderr, "[DEBUG-INSERT] Cursor at end position (cell_num=%u >= num_cells=%u)\n", cursor->cell_num, num_cells);
     fflush(stderr);
-    if (sidx < g_num_tables) {
-      table->active_schema = g_table_schemas[sidx];
-    } else {
-      memset(&table->active_schema, 0, sizeof(TableSchema));
-    }
-    table->row_size = compute_row_size(&table->active_schema);
   }
 
-  if (table->active_schema.num_columns == 0 || table->active_schema.columns[0].type != COL_TYPE_INT) {
-    fprintf(stderr, "[DEBUG-INSERT] Schema validation failed: num_columns=%u, first_col_type=%d\n",
-            table->active_schema.num_columns,
-            table->active_schema.num_columns > 0 ? table->active_schema.columns[0].type : -1);
-    fflush(stderr);
-    printf("First column must be int primary key.\n");
-    return EXECUTE_SUCCESS;
-  }
-  int key_int = 0;
-  if (st->num_values == 0 || parse_int(st->values[0], &key_int) != 0) {
-    fprintf(stderr, "[DEBUG-INSERT] Key parsing failed: num_values=%u, first_value=%s\n",
-            st->num_values, st->num_values > 0 ? st->values[0] : "NULL");
-    fflush(stderr);
-    printf("Invalid key.\n");
-    return EXECUTE_SUCCESS;
-  }
-  uint32_t key = (uint32_t)key_int;
-  fprintf(stderr, "[DEBUG-INSERT] Attempting to insert key=%u\n", key);
+  fprintf(stderr, "[DEBUG-INSERT] Proceeding with leaf_node_insert for key=%u\n", key);
   fflush(stderr);
-
-  Cursor* cursor = table_find(table, key);
-  fprintf(stderr, "[DEBUG-INSERT] table_find returned: page_num=%u, cell_num=%u\n",
-          cursor->page_num, cursor->cell_num);
+  leaf_node_insert(cursor, key, values, num_values);
+  fprintf(stderr, "[DEBUG-INSERT] leaf_node_insert completed successfully\n");
   fflush(stderr);
+  bloom_table_note_insert(table, key);
+  free(cursor);
+  return EXECUTE_SUCCESS;
+}
 
-  void* node = get_page(table->pager, cursor->page_num);
-  uint32_t num_cells = *leaf_node_num_cells(node);
-  fprintf(stderr, "[DEBUG-INSERT] Node has %u cells\n", num_cells);
-  fflush(stderr);
+typedef struct {
+  uint32_t key;
+  char** values;
+} InsertRow;
 
-  if (cursor->cell_num < num_cells) {
-    uint32_t key_at_index = *leaf_key_t(table, node, cursor->cell_num);
-    fprintf(stderr, "[DEBUG-INSERT] Key at cursor position: %u (searching for %u)\n", key_at_index, key);
-    fflush(stderr);
-    if (key_at_index == key) {
-      fprintf(stderr, "[DEBUG-INSERT] Duplicate key detected: %u\n", key);
-      fflush(stderr);
-      free(cursor);
-      return EXECUTE_DUPLICATE_KEY;
+static int cmp_insert_row(const void* a, const void* b) {
+  uint32_t x = ((const InsertRow*)a)->key;
+  uint32_t y = ((const InsertRow*)b)->key;
+  return (x > y) - (x < y);
+}
+
+/* Whether every value of a row fits its column, by the rules UPDATE ...
+ * SET applies; prints why not */
+static bool insert_row_valid(const Table* table, char* const* values, uint8_t* scratch) {
+  const TableSchema* s = &table->active_schema;
+  for (uint32_t c = 0; c < s->num_columns; c++) {
+    PrepareResult r = serialize_set_value(s, (int)c, values[c], scratch);
+    if (r == PREPARE_STRING_TOO_LONG) {
+      printf("String is too long.\n");
     }
-  } else {
-    fprintf(stderr, "[DEBUG-INSERT] Cursor at end position (cell_num=%u >= num_cells=%u)\n", cursor->cell_num, num_cells);
+    if (r != PREPARE_SUCCESS) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* INSERT ... VALUES: all rows are checked first, so a row of the wrong
+ * width, a value that does not fit its column or a duplicate key inserts
+ * nothing; then they go in sorted by key, a leaf at a time (see
+ * table_insert_sorted) */
+static ExecuteResult insert_values(Statement* st, Table* table) {
+  uint32_t n = st->insert_rows;
+  if (st->num_values != table->active_schema.num_columns) {
+    printf("Expected %u values per row, got %u\n", table->active_schema.num_columns, st->num_values);
+    return EXECUTE_INVALID_VALUE;
+  }
+  InsertRow* rows = malloc((n ? n : 1) * sizeof(InsertRow));
+  uint32_t* keys = malloc((n ? n : 1) * sizeof(uint32_t));
+  char*** values = malloc((n ? n : 1) * sizeof(char**));
+  uint8_t* scratch = malloc(table->row_size ? table->row_size : 1);
+  ExecuteResult result = EXECUTE_SUCCESS;
+  if (!rows || !keys || !values || !scratch) {
+    printf("Out of memory\n");
+    n = 0;
+    result = EXECUTE_FAILED;
+  }
+  for (uint32_t i = 0; i < n; i++) {
+    int key_int = 0;
+    rows[i].values = st->insert_values + (size_t)i * st->num_values;
+    if (!insert_row_valid(table, rows[i].values, scratch)) {
+      n = 0;
+      result = EXECUTE_INVALID_VALUE;
+      break;
+    }
+    parse_int(rows[i].values[0], &key_int);
+    rows[i].key = (uint32_t)key_int;
+  }
+  free(scratch);
+  qsort(rows, n, sizeof(InsertRow), cmp_insert_row);
+  for (uint32_t i = 0; i < n; i++) {
+    if (i > 0 && rows[i].key == rows[i - 1].key) {
+      result = EXECUTE_DUPLICATE_KEY;
+    }
+    keys[i] = rows[i].key;
+    values[i] = rows[i].values;
+  }
+  if (result == EXECUTE_SUCCESS && table_find_batch(table, keys, n, NULL, NULL) > 0) {
+    result = EXECUTE_DUPLICATE_KEY;
+  }
+  if (result == EXECUTE_SUCCESS) {
+    fprintf(stderr, "[DEBUG-INSERT] Inserting %u rows in key order\n", n);
     fflush(stderr);
+    table_insert_sorted(table, keys, (char* const* const*)values, st->num_values, n);
+    for (uint32_t i = 0; i < n; i++) {
+      bloom_table_note_insert(table, keys[i]);
+    }
   }
+  free(rows);
+  free(keys);
+  free(values);
+  return result;
+}
 
-  fprintf(stderr, "[DEBUG-INSERT] Proceeding with leaf_node_insert for key=%u\n", key);
-  fflush(stderr);
-  leaf_node_insert(cursor, key, st->values, st->num_values);
-  fprintf(stderr, "[DEBUG-INSERT] leaf_node_insert completed successfully\n");
+/* Execute INSERT */
+ExecuteResult execute_insert(Statement* st, Table* table) {
+  fprintf(stderr, "[DEBUG-INSERT] Starting INSERT operation\n");
   fflush(stderr);
-  free(cursor);
-  return EXECUTE_SUCCESS;
-}
 
-/* Execute DELETE */
-ExecuteResult execute_delete(Statement* st, Table* table) {
-  fprintf(stderr, "[DEBUG-DELETE] Starting DELETE operation\n");
+  if (table->root_page_num == INVALID_PAGE_NUM) {
+    fprintf(stderr, "[DEBUG-INSERT] No active table (root_page_num=INVALID)\n");
+    fflush(stderr);
+    printf("No active table. Use 'use <table>' or 'insert into <table> ...' first.\n");
+    return EXECUTE_SUCCESS;
+  }
+
+  fprintf(stderr, "[DEBUG-INSERT] Current table root_page_num=%u\n", table->root_page_num);
   fflush(stderr);
 
   if (st->target_table[0]) {
-    fprintf(stderr, "[DEBUG-DELETE] Switching to target table: %s\n", st->target_table);
+    fprintf(stderr, "[DEBUG-INSERT] Switching to target table: %s\n", st->target_table);
     fflush(stderr);
     int idx = catalog_find(table->pager, st->target_table);
     if (idx < 0) {
-      fprintf(stderr, "[DEBUG-DELETE] Table not found: %s\n", st->target_table);
+      fprintf(stderr, "[DEBUG-INSERT] Table not found: %s\n", st->target_table);
       fflush(stderr);
       printf("Table not found: %s\n", st->target_table);
       return EXECUTE_SUCCESS;
@@ -441,7 +1075,7 @@ ExecuteResult execute_delete(Statement* st, Table* table) {
     CatalogEntry* ents = catalog_entries(table->pager);
     table->root_page_num = ents[idx].root_page_num;
     uint32_t sidx = ents[idx].schema_index;
-    fprintf(stderr, "[DEBUG-DELETE] Switched to table, root_page_num=%u, schema_index=%u\n", table->root_page_num, sidx);
+    fprintf(stderr, "[DEBUG-INSERT] Switched to table, new root_page_num=%u, schema_index=%u\n", table->root_page_num, sidx);
     fflush(stderr);
     if (sidx < g_num_tables) {
       table->active_schema = g_table_schemas[sidx];
@@ -451,71 +1085,38 @@ ExecuteResult execute_delete(Statement* st, Table* table) {
     table->row_size = compute_row_size(&table->active_schema);
   }
 
-  if (table->root_page_num == INVALID_PAGE_NUM) {
-    fprintf(stderr, "[DEBUG-DELETE] No active table (root_page_num=INVALID)\n");
+  if (table->active_schema.num_columns == 0 || table->active_schema.columns[0].type != COL_TYPE_INT) {
+    fprintf(stderr, "[DEBUG-INSERT] Schema validation failed: num_columns=%u, first_col_type=%d\n",
+            table->active_schema.num_columns,
+            table->active_schema.num_columns > 0 ? table->active_schema.columns[0].type : -1);
     fflush(stderr);
-    printf("No active table. Use 'use <table>' or 'create table..' first.\n");
+    printf("First column must be int primary key.\n");
     return EXECUTE_SUCCESS;
   }
-
-  fprintf(stderr, "[DEBUG-DELETE] Current table root_page_num=%u\n", table->root_page_num);
-  fflush(stderr);
-
-  uint32_t key = 0;
-  int have_key = 0;
-
-  if (st->where_ast) {
-    fprintf(stderr, "[DEBUG-DELETE] Processing WHERE AST\n");
-    fflush(stderr);
-    Expr* ast = st->where_ast;
-    if (ast && ast->kind == EXPR_BINARY && strcmp(ast->op, "=") == 0) {
-      Expr* left = ast->left;
-      Expr* right = ast->right;
-      Expr* colExpr = NULL;
-      Expr* litExpr = NULL;
-
-      if (left && left->kind == EXPR_COLUMN && right && right->kind == EXPR_LITERAL) {
-        colExpr = left;
-        litExpr = right;
-      } else if (right && right->kind == EXPR_COLUMN && left && left->kind == EXPR_LITERAL) {
-        colExpr = right;
-        litExpr = left;
-      }
-
-      if (colExpr && litExpr) {
-        int col_idx = schema_col_index(&table->active_schema, colExpr->text);
-        fprintf(stderr, "[DEBUG-DELETE] WHERE clause: column=%s (idx=%d), value=%s\n", colExpr->text, col_idx, litExpr->text);
-        fflush(stderr);
-        if (col_idx == 0 && table->active_schema.columns[0].type == COL_TYPE_INT) {
-          int v = 0;
-          if (parse_int(litExpr->text, &v) == 0) {
-            key = (uint32_t)v;
-            have_key = 1;
-            fprintf(stderr, "[DEBUG-DELETE] Extracted key from WHERE: %u\n", key);
-            fflush(stderr);
-          }
-        }
-      }
-    }
+  if (st->insert_values) {
+    return insert_values(st, table);
   }
-
-  if (!have_key) {
-    fprintf(stderr, "[DEBUG-DELETE] Trying legacy WHERE format\n");
+  int key_int = 0;
+  if (st->num_values == 0 || parse_int(st->values[0], &key_int) != 0) {
+    fprintf(stderr, "[DEBUG-INSERT] Key parsing failed: num_values=%u, first_value=%s\n",
+            st->num_values, st->num_values > 0 ? st->values[0] : "NULL");
     fflush(stderr);
-    if (st->has_where && st->where_col_index == 0 && !st->where_is_string &&
-        table->active_schema.columns[0].type == COL_TYPE_INT) {
-      key = (uint32_t)st->where_int;
-      have_key = 1;
-      fprintf(stderr, "[DEBUG-DELETE] Using legacy WHERE key: %u\n", key);
-      fflush(stderr);
-    }
+    printf("Invalid key.\n");
+    return EXECUTE_SUCCESS;
   }
+  uint32_t key = (uint32_t)key_int;
+  fprintf(stderr, "[DEBUG-INSERT] Attempting to insert key=%u\n", key);
+  fflush(stderr);
 
-  if (!have_key) {
-    fprintf(stderr, "[DEBUG-DELETE] No valid key found in WHERE clause\n");
+  return insert_row(table, key, st->values, st->num_values);
+}
+
+/* Delete the row with primary key `key`; false when there is none */
+static bool delete_key(Table* table, uint32_t key) {
+  if (!bloom_table_may_contain(table, key)) {
+    fprintf(stderr, "[DEBUG-DELETE] Bloom filter rules out key %u\n", key);
     fflush(stderr);
-    printf("Only DELETE by integer primary key is supported.\n");
-    return EXECUTE_SUCCESS;
+    return false;
   }
 
   fprintf(stderr, "[DEBUG-DELETE] Searching for key to delete: %u\n", key);
@@ -532,8 +1133,9 @@ ExecuteResult execute_delete(Statement* st, Table* table) {
   if (cursor->cell_num >= num_cells) {
     fprintf(stderr, "[DEBUG-DELETE] Key not found: cursor position (%u) >= num_cells (%u)\n", cursor->cell_num, num_cells);
     fflush(stderr);
+    bloom_table_note_miss(table);
     free(cursor);
-    return EXECUTE_SUCCESS;
+    return false;
   }
   uint32_t key_at_index = *leaf_key_t(table, node, cursor->cell_num);
   fprintf(stderr, "[DEBUG-DELETE] Key at cursor position: %u (looking for %u)\n", key_at_index, key);
@@ -541,8 +1143,9 @@ ExecuteResult execute_delete(Statement* st, Table* table) {
   if (key_at_index != key) {
     fprintf(stderr, "[DEBUG-DELETE] Key mismatch: found %u but looking for %u\n", key_at_index, key);
     fflush(stderr);
+    bloom_table_note_miss(table);
     free(cursor);
-    return EXECUTE_SUCCESS;
+    return false;
   }
 
   fprintf(stderr, "[DEBUG-DELETE] Found key %u, proceeding with deletion\n", key);
@@ -553,6 +1156,7 @@ ExecuteResult execute_delete(Statement* st, Table* table) {
 
   fprintf(stderr, "[DEBUG-DELETE] Shifting cells: from position %u to %u\n", cursor->cell_num, num_cells - 1);
   fflush(stderr);
+  zonemap_note_delete(table, cursor->page_num, leaf_value_t(table, node, cursor->cell_num));
   for (uint32_t i = cursor->cell_num; i < num_cells - 1; i++) {
     void* dest = leaf_cell_t(table, node, i);
     void* src = leaf_cell_t(table, node, i + 1);
@@ -604,9 +1208,56 @@ ExecuteResult execute_delete(Statement* st, Table* table) {
     fflush(stderr);
     handle_underflow(table, cursor->page_num);
   }
+  btree_refresh_counts(table, key);
 
   free(cursor);
-  return EXECUTE_SUCCESS;
+  return true;
+}
+
+/* Load one comparison operand. Int and timestamp columns and numeric
+ * literals are numeric (returns 1); everything else lands in `s`. */
+static int eval_operand(Table* t, const void* row, Expr* e, int64_t* num, char* s, size_t cap) {
+  *num = 0;
+  s[0] = '\0';
+  if (!e) {
+    return 0;
+  }
+  if (e->kind == EXPR_COLUMN) {
+    int idx = schema_col_index(&t->active_schema, e->text);
+    if (idx < 0) {
+      return 0;
+    }
+    switch (t->active_schema.columns[idx].type) {
+      case COL_TYPE_INT:
+        *num = row_get_int(t, row, idx);
+        return 1;
+      case COL_TYPE_TIMESTAMP:
+        *num = row_get_timestamp(t, row, idx);
+        return 1;
+      default:
+        row_get_string(t, row, idx, s, cap);
+        return 0;
+    }
+  }
+  if (e->kind == EXPR_LITERAL) {
+    if (parse_int64(e->text, num) == 0) {
+      return 1;
+    }
+    strncpy(s, e->text, cap - 1);
+    s[cap - 1] = '\0';
+  }
+  return 0;
+}
+
+/* Apply a comparison operator to a three-way compare result */
+static int cmp_matches_op(const char* op, int cmp) {
+  if (strcmp(op, "=") == 0) return cmp == 0;
+  if (strcmp(op, "!=") == 0) return cmp != 0;
+  if (strcmp(op, "<") == 0) return cmp < 0;
+  if (strcmp(op, "<=") == 0) return cmp <= 0;
+  if (strcmp(op, ">") == 0) return cmp > 0;
+  if (strcmp(op, ">=") == 0) return cmp >= 0;
+  return 0;
 }
 
 /* Expression evaluation */
@@ -623,18 +1274,12 @@ int eval_expr_to_bool(Table* t, const void* row, Expr* e) {
     }
 
     case EXPR_COLUMN: {
-      int idx = schema_col_index(&t->active_schema, e->text);
-      if (idx < 0) {
-        return 0;
-      }
-      if (t->active_schema.columns[idx].type == COL_TYPE_INT) {
-        int v = row_get_int(t, row, idx);
+      int64_t v = 0;
+      char buf[512];
+      if (eval_operand(t, row, e, &v, buf, sizeof(buf))) {
         return v != 0;
-      } else {
-        char buf[512];
-        row_get_string(t, row, idx, buf, sizeof(buf));
-        return buf[0] != '\0';
       }
+      return buf[0] != '\0';
     }
 
     case EXPR_UNARY: {
@@ -652,254 +1297,1674 @@ int eval_expr_to_bool(Table* t, const void* row, Expr* e) {
         return eval_expr_to_bool(t, row, e->left) || eval_expr_to_bool(t, row, e->right);
       }
 
-      int lhs_int = 0;
-      int rhs_int = 0;
+      int64_t lhs_num = 0;
+      int64_t rhs_num = 0;
       char lhs_s[512] = {0};
       char rhs_s[512] = {0};
-      int is_num = 0;
-
-      if (e->left->kind == EXPR_COLUMN) {
-        int idx = schema_col_index(&t->active_schema, e->left->text);
-        if (idx >= 0 && t->active_schema.columns[idx].type == COL_TYPE_INT) {
-          lhs_int = row_get_int(t, row, idx);
-          is_num = 1;
-        } else if (idx >= 0) {
-          row_get_string(t, row, idx, lhs_s, sizeof(lhs_s));
-        }
-      } else if (e->left->kind == EXPR_LITERAL) {
-        if (parse_int(e->left->text, &lhs_int) == 0) {
-          is_num = 1;
-        } else {
-          strncpy(lhs_s, e->left->text, sizeof(lhs_s) - 1);
-          lhs_s[sizeof(lhs_s) - 1] = '\0';
-        }
-      }
+      int is_num = eval_operand(t, row, e->left, &lhs_num, lhs_s, sizeof(lhs_s));
+      is_num |= eval_operand(t, row, e->right, &rhs_num, rhs_s, sizeof(rhs_s));
 
-      if (e->right->kind == EXPR_COLUMN) {
-        int idx = schema_col_index(&t->active_schema, e->right->text);
-        if (idx >= 0 && t->active_schema.columns[idx].type == COL_TYPE_INT) {
-          rhs_int = row_get_int(t, row, idx);
-          is_num = 1;
-        } else if (idx >= 0) {
-          row_get_string(t, row, idx, rhs_s, sizeof(rhs_s));
-        }
-      } else if (e->right->kind == EXPR_LITERAL) {
-        if (parse_int(e->right->text, &rhs_int) == 0) {
-          is_num = 1;
-        } else {
-          strncpy(rhs_s, e->right->text, sizeof(rhs_s) - 1);
-          rhs_s[sizeof(rhs_s) - 1] = '\0';
-        }
+      int cmp;
+      if (is_num) {
+        cmp = (lhs_num > rhs_num) - (lhs_num < rhs_num);
+      } else {
+        cmp = strcmp(lhs_s, rhs_s);
       }
+      return cmp_matches_op(e->op, cmp);
+    }
 
+    case EXPR_BETWEEN: {
+      if (!e->right) {
+        return 0;
+      }
+      int64_t v = 0, low = 0, high = 0;
+      char vs[512], lows[512], highs[512];
+      int is_num = eval_operand(t, row, e->left, &v, vs, sizeof(vs));
+      is_num |= eval_operand(t, row, e->right->left, &low, lows, sizeof(lows));
+      is_num |= eval_operand(t, row, e->right->right, &high, highs, sizeof(highs));
       if (is_num) {
-        if (strcmp(e->op, "=") == 0) return lhs_int == rhs_int;
-        if (strcmp(e->op, "!=") == 0) return lhs_int != rhs_int;
-        if (strcmp(e->op, "<") == 0) return lhs_int < rhs_int;
-        if (strcmp(e->op, "<=") == 0) return lhs_int <= rhs_int;
-        if (strcmp(e->op, ">") == 0) return lhs_int > rhs_int;
-        if (strcmp(e->op, ">=") == 0) return lhs_int >= rhs_int;
-      } else {
-        int result = strcmp(lhs_s, rhs_s);
-        if (strcmp(e->op, "=") == 0) {
-          return (result == 0);
+        return v >= low && v <= high;
+      }
+      return strcmp(vs, lows) >= 0 && strcmp(vs, highs) <= 0;
+    }
+
+    case EXPR_IN: {
+      int64_t v = 0;
+      char vs[512];
+      int lhs_num = eval_operand(t, row, e->left, &v, vs, sizeof(vs));
+      for (uint32_t i = 0; i < e->n_items; i++) {
+        int64_t item = 0;
+        char items[512];
+        int is_num = eval_operand(t, row, e->items[i], &item, items, sizeof(items)) | lhs_num;
+        if (is_num ? (v == item) : (strcmp(vs, items) == 0)) {
+          return 1;
         }
-        if (strcmp(e->op, "!=") == 0) return strcmp(lhs_s, rhs_s) != 0;
-        if (strcmp(e->op, "<") == 0) return strcmp(lhs_s, rhs_s) < 0;
-        if (strcmp(e->op, ">") == 0) return strcmp(lhs_s, rhs_s) > 0;
-        if (strcmp(e->op, "<=") == 0) return strcmp(lhs_s, rhs_s) <= 0;
-        if (strcmp(e->op, ">=") == 0) return strcmp(lhs_s, rhs_s) >= 0;
       }
       return 0;
     }
 
-    case EXPR_BETWEEN:
     case EXPR_ISNULL:
-    case EXPR_IN:
       /* Additional expression types can be implemented here */
       return 0;
+
+    case EXPR_AGG:
+      /* Only HAVING has aggregates; see having_matches */
+      return 0;
   }
   return 0;
 }
 
-/* Row handler for printing */
-static void print_row_handler(Table* t, const void* row, const Statement* st, void* ctx) {
-  (void)ctx;
-  print_row_projected(t, row, st->proj_indices, st->proj_count);
+static int cmp_u32(const void* a, const void* b) {
+  uint32_t x = *(const uint32_t*)a;
+  uint32_t y = *(const uint32_t*)b;
+  return (x > y) - (x < y);
 }
 
-/* Execute SELECT with custom handler */
-ExecuteResult execute_select_core(Statement* st, Table* table, RowHandler handler, void* ctx) {
-  if (st->target_table[0]) {
-    int idx = catalog_find(table->pager, st->target_table);
-    if (idx < 0) {
-      printf("Table not found: %s\n", st->target_table);
-      return EXECUTE_SUCCESS;
-    }
-    CatalogEntry* ents = catalog_entries(table->pager);
-    table->root_page_num = ents[idx].root_page_num;
-    uint32_t sidx = ents[idx].schema_index;
-    if (sidx < g_num_tables) {
-      table->active_schema = g_table_schemas[sidx];
-    } else {
-      memset(&table->active_schema, 0, sizeof(TableSchema));
+/* Keys of `id = c` or `id IN (c, ...)` on the int primary key; false when
+ * `e` is not such a predicate. A non-numeric literal stands for 0; a number
+ * outside the int range matches nothing and is dropped. */
+static bool pk_predicate_keys(Table* t, Expr* e, uint32_t** out_keys, uint32_t* out_n) {
+  Expr* col = NULL;
+  Expr* const* lits = NULL;
+  uint32_t n_lits = 0;
+  Expr* single = NULL;
+
+  if (e->kind == EXPR_BINARY && strcmp(e->op, "=") == 0 && e->left && e->right) {
+    if (e->left->kind == EXPR_COLUMN && e->right->kind == EXPR_LITERAL) {
+      col = e->left;
+      single = e->right;
+    } else if (e->right->kind == EXPR_COLUMN && e->left->kind == EXPR_LITERAL) {
+      col = e->right;
+      single = e->left;
     }
-    table->row_size = compute_row_size(&table->active_schema);
+    lits = &single;
+    n_lits = 1;
+  } else if (e->kind == EXPR_IN && e->left && e->left->kind == EXPR_COLUMN) {
+    col = e->left;
+    lits = e->items;
+    n_lits = e->n_items;
   }
-
-  if (table->root_page_num == INVALID_PAGE_NUM) {
-    printf("No active table. Use 'use <table>' or 'create table..' first.\n");
-    return EXECUTE_SUCCESS;
+  if (!col || schema_col_index(&t->active_schema, col->text) != 0 ||
+      t->active_schema.columns[0].type != COL_TYPE_INT) {
+    return false;
   }
 
-  bool can_point_lookup = false;
-  uint32_t lookup_key = 0;
-
-  Expr* ast = st->where_ast;
-
-  if (ast && ast->kind == EXPR_BINARY && strcmp(ast->op, "=") == 0) {
-    Expr* left = ast->left;
-    Expr* right = ast->right;
-    Expr* colExpr = NULL;
-    Expr* litExpr = NULL;
-
-    if (left && left->kind == EXPR_COLUMN && right && right->kind == EXPR_LITERAL) {
-      colExpr = left;
-      litExpr = right;
-    } else if (right && right->kind == EXPR_COLUMN && left && left->kind == EXPR_LITERAL) {
-      colExpr = right;
-      litExpr = left;
-    }
-
-    if (colExpr && litExpr) {
-      int col_idx = schema_col_index(&table->active_schema, colExpr->text);
-      if (col_idx == 0 && table->active_schema.columns[0].type == COL_TYPE_INT) {
-        int v = 0;
-        if (parse_int(litExpr->text, &v) == 0) {
-          can_point_lookup = true;
-          lookup_key = (uint32_t)v;
-        }
-      }
-    }
+  uint32_t* keys = malloc((n_lits ? n_lits : 1) * sizeof(uint32_t));
+  if (!keys) {
+    return false;
   }
-
-  if (!can_point_lookup) {
-    if (st->has_where &&
-        (st->where_col_index == 0) &&
-        !st->where_is_string &&
-        (table->active_schema.columns[0].type == COL_TYPE_INT)) {
-      can_point_lookup = true;
-      lookup_key = (uint32_t)st->where_int;
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < n_lits; i++) {
+    if (!lits[i] || lits[i]->kind != EXPR_LITERAL) {
+      free(keys);
+      return false;
+    }
+    /* A non-numeric literal compares to an int column as 0 */
+    int64_t v = 0;
+    if (parse_int64(lits[i]->text, &v) != 0) {
+      v = 0;
+    }
+    if (v >= INT32_MIN && v <= INT32_MAX) {
+      keys[n++] = (uint32_t)(int32_t)v;
     }
   }
 
-  if (can_point_lookup) {
-    Cursor* cursor = table_find(table, lookup_key);
-    void* node = get_page(table->pager, cursor->page_num);
-    uint32_t num_cells = *leaf_node_num_cells(node);
-
-    if (cursor->cell_num < num_cells) {
-      uint32_t key_at_index = *leaf_key_t(table, node, cursor->cell_num);
-      if (key_at_index == lookup_key) {
-        void* row = leaf_value_t(table, node, cursor->cell_num);
-        int pass = 1;
-        if (ast) {
-          pass = eval_expr_to_bool(table, row, ast);
-        } else if (st->has_where) {
-          pass = row_matches_where(table, row, st);
-        }
-        if (pass && handler) {
-          handler(table, row, st, ctx);
-        }
-      }
+  qsort(keys, n, sizeof(uint32_t), cmp_u32);
+  uint32_t distinct = 0;
+  for (uint32_t i = 0; i < n; i++) {
+    if (distinct == 0 || keys[distinct - 1] != keys[i]) {
+      keys[distinct++] = keys[i];
     }
-    free(cursor);
-    return EXECUTE_SUCCESS;
   }
+  *out_keys = keys;
+  *out_n = distinct;
+  return true;
+}
 
-  /* Full table scan */
-  RowRef* rows = NULL;
-  size_t nrows = 0;
-  size_t capacity = 0;
-
-  Cursor* cursor = table_start(table);
-  while (!cursor->end_of_table) {
-    void* row = cursor_value(cursor);
-    int pass = 1;
-    if (ast) {
-      pass = eval_expr_to_bool(table, row, ast);
-    } else if (st->has_where) {
-      pass = row_matches_where(table, row, st);
-    }
-
-    if (pass) {
-      if (nrows == capacity) {
-        size_t newcap = capacity ? capacity * 2 : 256;
-        RowRef* tmp = realloc(rows, newcap * sizeof(RowRef));
-        if (!tmp) {
-          printf("Out of memory\n");
-          free(rows);
-          free(cursor);
-          return EXECUTE_SUCCESS;
-        }
-        rows = tmp;
-        capacity = newcap;
+/* Smallest primary-key set any top-level AND conjunct of `e` pins the
+ * query to, sorted and distinct. */
+static bool where_pk_keys(Table* t, Expr* e, uint32_t** out_keys, uint32_t* out_n) {
+  if (!e) {
+    return false;
+  }
+  if (e->kind == EXPR_BINARY && strcmp(e->op, "AND") == 0) {
+    uint32_t *lk = NULL, *rk = NULL;
+    uint32_t ln = 0, rn = 0;
+    bool l = where_pk_keys(t, e->left, &lk, &ln);
+    bool r = where_pk_keys(t, e->right, &rk, &rn);
+    if (l && r) {
+      if (rn < ln) {
+        free(lk);
+        *out_keys = rk;
+        *out_n = rn;
+      } else {
+        free(rk);
+        *out_keys = lk;
+        *out_n = ln;
       }
-      rows[nrows++].row = row;
+      return true;
     }
-    cursor_advance(cursor);
+    if (l || r) {
+      *out_keys = l ? lk : rk;
+      *out_n = l ? ln : rn;
+      return true;
+    }
+    return false;
   }
-  free(cursor);
+  return pk_predicate_keys(t, e, out_keys, out_n);
+}
 
-  /* Optional sort */
-  if (st->order_by_index >= 0 && nrows > 1) {
-    g_sort_ctx.table = table;
-    g_sort_ctx.col_idx = st->order_by_index;
-    g_sort_ctx.desc = st->order_desc ? 1 : 0;
-    qsort(rows, nrows, sizeof(RowRef), rowref_comparator);
+/* Whether `e` is the int primary key of `t` */
+static bool is_pk_column(Table* t, const Expr* e) {
+  return e && e->kind == EXPR_COLUMN && schema_col_index(&t->active_schema, e->text) == 0 &&
+         t->active_schema.columns[0].type == COL_TYPE_INT;
+}
+
+/* A literal compared with the key; clamped just past the int range so
+ * bounds one off it stay exact */
+static int64_t pk_literal(const Expr* e) {
+  int64_t v = 0;
+  if (parse_int64(e->text, &v) != 0) {
+    v = 0;
   }
+  if (v < (int64_t)INT32_MIN - 1) return (int64_t)INT32_MIN - 1;
+  if (v > (int64_t)INT32_MAX + 1) return (int64_t)INT32_MAX + 1;
+  return v;
+}
 
-  /* Apply offset/limit */
-  size_t start = st->has_offset ? st->offset : 0;
-  size_t end = st->has_limit ? (start + st->limit) : nrows;
-  if (start > nrows) start = nrows;
-  if (end > nrows) end = nrows;
-  for (size_t i = start; i < end; ++i) {
-    if (handler) {
-      handler(table, rows[i].row, st, ctx);
+/* Narrow [lo, hi] by `e` when it compares the int primary key with a
+ * literal or bounds it with BETWEEN; false when it does neither */
+static bool pk_predicate_range(Table* t, const Expr* e, int64_t* lo, int64_t* hi) {
+  if (e->kind == EXPR_BETWEEN && is_pk_column(t, e->left) && e->right && e->right->left &&
+      e->right->right && e->right->left->kind == EXPR_LITERAL &&
+      e->right->right->kind == EXPR_LITERAL) {
+    int64_t low = pk_literal(e->right->left);
+    int64_t high = pk_literal(e->right->right);
+    if (low > *lo) *lo = low;
+    if (high < *hi) *hi = high;
+    return true;
+  }
+  if (e->kind != EXPR_BINARY || !e->left || !e->right) {
+    return false;
+  }
+  const char* op = e->op;
+  const Expr* lit = e->right;
+  if (!is_pk_column(t, e->left)) {
+    if (!is_pk_column(t, e->right)) {
+      return false;
     }
+    /* `c < id` reads as `id > c` */
+    lit = e->left;
+    if (strcmp(op, "<") == 0) op = ">";
+    else if (strcmp(op, "<=") == 0) op = ">=";
+    else if (strcmp(op, ">") == 0) op = "<";
+    else if (strcmp(op, ">=") == 0) op = "<=";
+  }
+  if (lit->kind != EXPR_LITERAL) {
+    return false;
+  }
+  int64_t v = pk_literal(lit);
+  if (strcmp(op, "=") == 0) {
+    if (v > *lo) *lo = v;
+    if (v < *hi) *hi = v;
+  } else if (strcmp(op, "<") == 0) {
+    if (v - 1 < *hi) *hi = v - 1;
+  } else if (strcmp(op, "<=") == 0) {
+    if (v < *hi) *hi = v;
+  } else if (strcmp(op, ">") == 0) {
+    if (v + 1 > *lo) *lo = v + 1;
+  } else if (strcmp(op, ">=") == 0) {
+    if (v > *lo) *lo = v;
+  } else {
+    return false;
   }
+  return true;
+}
 
-  free(rows);
-  return EXECUTE_SUCCESS;
+/* Primary-key range the top-level AND conjuncts of `e` pin the query to,
+ * starting from the whole int range; false when none bounds it */
+static bool where_pk_range(Table* t, const Expr* e, int64_t* lo, int64_t* hi) {
+  if (!e) {
+    return false;
+  }
+  if (e->kind == EXPR_BINARY && strcmp(e->op, "AND") == 0) {
+    bool l = where_pk_range(t, e->left, lo, hi);
+    bool r = where_pk_range(t, e->right, lo, hi);
+    return l || r;
+  }
+  return pk_predicate_range(t, e, lo, hi);
 }
 
-/* Execute SELECT (with default printing) */
-ExecuteResult execute_select(Statement* st, Table* table) {
-  return execute_select_core(st, table, print_row_handler, NULL);
+/* Filter one row: the compiled program when it was built for this table,
+ * otherwise the AST interpreter or the legacy single-column WHERE. */
+static int where_matches(const Statement* st, Table* t, const void* row) {
+  if (st->where_prog && st->where_prog->root_page_num == t->root_page_num) {
+    return predicate_eval(st->where_prog, row);
+  }
+  if (st->where_ast) {
+    return eval_expr_to_bool(t, row, st->where_ast);
+  }
+  if (st->has_where) {
+    return row_matches_where(t, row, st);
+  }
+  return 1;
 }
 
-/* Execute any statement */
-ExecuteResult execute_statement(Statement* statement, Table* table) {
-  ExecuteResult result = EXECUTE_SUCCESS;
-  switch (statement->type) {
-    case (STATEMENT_INSERT):
-      result = execute_insert(statement, table);
-      break;
-    case (STATEMENT_SELECT):
-      result = execute_select(statement, table);
-      break;
-    case (STATEMENT_DELETE):
-      result = execute_delete(statement, table);
-      break;
-    default:
-      result = EXECUTE_SUCCESS;
+static int where_filter(Table* t, const void* row, const void* ctx) {
+  return where_matches((const Statement*)ctx, t, row);
+}
+
+/* A step of an explained statement that the executor runs itself rather
+ * than an operator; steps recorded while it runs become its inputs */
+typedef struct {
+  Explain* ex;          /* NULL when not explaining */
+  ExplainNode* node;
+  int parent;
+  ExplainMark mark;
+} ExecStep;
+
+/* Start `node` (from explain_add, may be NULL when the plan is full).
+ * False when the statement is only explained: the step must not run,
+ * though the steps under it may still be recorded. */
+static bool step_begin(ExecStep* step, Explain* ex, ExplainNode* node, Table* t) {
+  step->ex = ex;
+  step->node = node;
+  if (!ex) {
+    return true;
   }
+  step->parent = ex->parent;
+  ex->parent = explain_index(ex, node);
+  if (node && ex->analyze) {
+    explain_mark(t->pager, &step->mark);
+  }
+  return ex->analyze;
+}
 
-  if (statement->where_ast) {
-    expr_free(statement->where_ast);
-    statement->where_ast = NULL;
+static void step_end(ExecStep* step, Table* t, uint64_t rows) {
+  if (!step->ex) {
+    return;
+  }
+  if (step->node && step->ex->analyze) {
+    explain_account(step->node, t->pager, &step->mark, rows);
+  }
+  step->ex->parent = step->parent;
+}
+
+/* How a single-table SELECT reaches its rows */
+typedef enum { ACCESS_FULL_SCAN, ACCESS_KEYS, ACCESS_PK_RANGE } AccessKind;
+
+typedef struct {
+  AccessKind kind;
+  uint32_t* keys;       /* ACCESS_KEYS: sorted and distinct, owned by the plan */
+  uint32_t n_keys;
+  uint32_t lo;          /* ACCESS_PK_RANGE: inclusive key bounds */
+  uint32_t hi;
+  double pages;         /* Estimated page reads, -1 when not estimated */
+  double rows;          /* Estimated rows passing WHERE, -1 likewise */
+} AccessPlan;
+
+/* Page reads to find `n` keys in one ordered descent: the leaves they land
+ * on plus the internal nodes above them, each read once */
+static double key_set_pages(const TableEstimate* est, double n) {
+  double leaves = n < est->leaves ? n : est->leaves;
+  double internal = est->leaves / INTERNAL_NODE_MAX_KEYS + 1;
+  double paths = n * (est->height - 1);
+  return leaves + (paths < internal ? paths : internal);
+}
+
+/* Page reads of a full scan: the descent to the first leaf, then every leaf */
+static double full_scan_pages(const TableEstimate* est) {
+  return est->height - 1 + est->leaves;
+}
+
+/* Choose the access path with the fewest estimated page reads: the full
+ * leaf chain, the primary-key set `=` and IN pin the query to, or the
+ * range of keys comparisons bound it to. A single key needs no estimate;
+ * nothing beats one descent. Estimates are kept for EXPLAIN. */
+static void plan_access(Statement* st, Table* table, AccessPlan* ap) {
+  memset(ap, 0, sizeof(*ap));
+  ap->kind = ACCESS_FULL_SCAN;
+  ap->pages = -1;
+  ap->rows = -1;
+  Expr* ast = st->where_ast;
+  bool keyed = ast && where_pk_keys(table, ast, &ap->keys, &ap->n_keys);
+  int64_t lo = INT32_MIN;
+  int64_t hi = INT32_MAX;
+  /* Negative keys order after the others, so only a range within one sign
+   * is contiguous in the tree */
+  bool ranged = ast && where_pk_range(table, ast, &lo, &hi) && (lo >= 0 || hi < 0 || lo > hi);
+  if (keyed && ap->n_keys <= 1 && !st->profile) {
+    ap->kind = ACCESS_KEYS;
+    return;
+  }
+  if (!keyed && !ranged && !st->profile) {
+    return;
+  }
+
+  TableEstimate est;
+  table_estimate(table, &est);
+  ap->pages = full_scan_pages(&est);
+  if (ranged) {
+    double frac = estimate_range_fraction(&est, 0, lo, hi);
+    double pages = est.height + (double)(uint64_t)(frac * est.leaves);
+    if (pages < ap->pages) {
+      ap->kind = ACCESS_PK_RANGE;
+      ap->pages = pages;
+      if (lo > hi) {
+        ap->lo = 1;
+        ap->hi = 0;
+      } else {
+        ap->lo = (uint32_t)(int32_t)lo;
+        ap->hi = (uint32_t)(int32_t)hi;
+      }
+    }
+  }
+  if (keyed) {
+    double pages = key_set_pages(&est, ap->n_keys);
+    if (pages <= ap->pages) {
+      ap->kind = ACCESS_KEYS;
+      ap->pages = pages;
+    } else {
+      free(ap->keys);
+      ap->keys = NULL;
+    }
+  }
+  ap->rows = est.rows * estimate_selectivity(table, &est, ast);
+}
+
+/* Whether LIMIT can stop the scan early: nothing between it and the scan
+ * needs every row. A parallel scan hands out all its leaf ranges up front,
+ * so such statements scan serially. */
+static bool limit_stops_scan(const Statement* st) {
+  return st->has_limit && st->order_by.n_cols == 0 && !st->aggregate;
+}
+
+/* Access path plus WHERE filtering. Keys come from the tree directly and
+ * a key range from its leaves; otherwise leaves are scanned, filtered in
+ * batches by the compiled program when there is one, and on the worker
+ * pool when the table is large enough and LIMIT cannot stop early. */
+static Operator* build_scan_pipeline(Statement* st, Table* table, AccessPlan* ap) {
+  Expr* ast = st->where_ast;
+  const Predicate* prog = NULL;
+  if (st->where_prog && st->where_prog->root_page_num == table->root_page_num) {
+    prog = st->where_prog;
+  }
+  bool filter = !prog && (ast || st->has_where);
+
+  Operator* scan;
+  Operator* root;
+  if (ap->kind == ACCESS_KEYS) {
+    scan = op_key_scan(table, ap->keys, ap->n_keys);
+    ap->keys = NULL;
+    root = op_filter(scan, where_filter, st);
+  } else {
+    if (ap->kind == ACCESS_PK_RANGE) {
+      scan = op_range_scan(table, ap->lo, ap->hi, prog, ast);
+    } else if (table->threads > 1 && !limit_stops_scan(st) &&
+               table_row_count(table) >= PARALLEL_SCAN_MIN_ROWS) {
+      /* Aggregates are the only consumers indifferent to row order */
+      scan = op_parallel_scan(table, prog, ast, filter ? where_filter : NULL, st,
+                              table->threads, !st->aggregate);
+      filter = false;
+    } else {
+      scan = op_leaf_scan(table, prog, ast);
+    }
+    root = scan && filter ? op_filter(scan, where_filter, st) : scan;
+  }
+  if (root) {
+    scan->est_pages = ap->pages;
+    root->est_rows = ap->rows;
+  }
+  return root;
+}
+
+/* Row handler for printing */
+static void print_row_handler(Table* t, const void* row, const Statement* st, void* ctx) {
+  (void)ctx;
+  print_row_projected(t, row, st->proj_indices, st->proj_count);
+}
+
+/* Stream up to `limit` rows from tree position `pos` on, following the
+ * leaf chain; returns how many were emitted */
+static uint32_t emit_positions(Statement* st, Table* table, uint32_t pos, uint32_t limit,
+                               RowHandler handler, void* ctx) {
+  uint32_t emitted = 0;
+  Cursor* cursor = table_seek_nth(table, pos);
+  while (!cursor->end_of_table && emitted < limit) {
+    void* node = get_page(table->pager, cursor->page_num);
+    if (cursor->cell_num < *leaf_node_num_cells(node)) {
+      if (handler) {
+        handler(table, cursor_value(cursor), st, ctx);
+      }
+      emitted++;
+    }
+    cursor_advance(cursor);
+  }
+  free(cursor);
+  return emitted;
+}
+
+/* Unfiltered LIMIT/OFFSET in key order: seek to the first wanted row by
+ * subtree counts and stream from there instead of materializing every row.
+ * Returns false when the statement needs the general path. */
+static bool select_by_position(Statement* st, Table* table, RowHandler handler, void* ctx) {
+  if (st->where_ast || st->has_where || (!st->has_offset && !st->has_limit)) {
+    return false;
+  }
+  /* Key order only; the primary key is unique, so later ORDER BY columns
+   * never decide anything after it */
+  const SortKeyCol* first = st->order_by.n_cols > 0 ? &st->order_by.cols[0] : NULL;
+  if (first && (first->col_idx != 0 || table->active_schema.columns[0].type != COL_TYPE_INT)) {
+    return false;
+  }
+
+  uint32_t offset = st->has_offset ? st->offset : 0;
+  uint32_t limit = st->has_limit ? st->limit : UINT32_MAX;
+  bool desc = first && first->desc;
+
+  Explain* ex = st->profile;
+  ExecStep step;
+  ExplainNode* step_node = NULL;
+  if (ex) {
+    step_node = explain_add(ex, "Position Seek", "on %s, %s, offset %u", explain_table_name(table),
+                            desc ? "descending" : "ascending", offset);
+  }
+  if (!step_begin(&step, ex, step_node, table)) {
+    step_end(&step, table, 0);
+    return true;
+  }
+
+  /* The tree orders keys unsigned, so negative ids come after the rest.
+   * ORDER BY is signed: its order starts with the last `neg` positions. */
+  uint32_t total = table_row_count(table);
+  uint32_t neg = first ? total - table_rank(table, (uint32_t)INT32_MIN) : 0;
+  uint32_t emitted = 0;
+  if (desc) {
+    /* No backward leaf links: seek each row from the root */
+    for (uint32_t i = 0; i < limit && offset + i < total; i++) {
+      uint32_t pos = total - 1 - offset - i;
+      Cursor* cursor = table_seek_nth(table, pos < neg ? total - neg + pos : pos - neg);
+      if (!cursor->end_of_table) {
+        if (handler) {
+          handler(table, cursor_value(cursor), st, ctx);
+        }
+        emitted++;
+      }
+      free(cursor);
+    }
+    step_end(&step, table, emitted);
+    return true;
+  }
+
+  /* At most two runs along the leaf chain: the negatives, then the rest */
+  if (offset < neg) {
+    uint32_t n = neg - offset < limit ? neg - offset : limit;
+    emitted = emit_positions(st, table, total - neg + offset, n, handler, ctx);
+    offset = neg;
+  }
+  if (emitted < limit && offset < total) {
+    uint32_t n = total - offset < limit - emitted ? total - offset : limit - emitted;
+    emitted += emit_positions(st, table, offset - neg, n, handler, ctx);
+  }
+  step_end(&step, table, emitted);
+  return true;
+}
+
+/* All rows of one side of a join, in key order when `ordered`; serially
+ * when the side streams and LIMIT may stop it early */
+static Operator* join_input(Table* t, bool ordered, bool serial) {
+  if (t->threads > 1 && !serial && table_row_count(t) >= PARALLEL_SCAN_MIN_ROWS) {
+    return op_parallel_scan(t, NULL, NULL, NULL, NULL, t->threads, ordered);
+  }
+  return op_leaf_scan(t, NULL, NULL);
+}
+
+/* Whether side `i` joins on its int primary key, so its rows can be
+ * found by key and come in ON order */
+static bool join_on_pk(const JoinSpec* j, const Table* sides, int i) {
+  return j->key_cols[i] == 0 && sides[i].active_schema.columns[0].type == COL_TYPE_INT;
+}
+
+typedef enum { JOIN_MERGE, JOIN_INDEX, JOIN_HASH } JoinMethod;
+
+typedef struct {
+  JoinMethod method;
+  int side;             /* Inner side of an index join, build side of a hash join */
+  double pages;         /* Estimated page reads */
+  double rows;          /* Estimated joined rows */
+} JoinCost;
+
+/* Choose how to join by estimated page reads. Two sides joined on their
+ * int primary keys merge, reading each leaf once. A single such side can
+ * be looked up from the other side's rows: one descent per batch of outer
+ * keys, which beats scanning it only when the outer side is small next to
+ * it. Otherwise the hash table is built on the side with fewer estimated
+ * bytes; a build side over the memory budget costs writing and reading
+ * both sides once more. */
+static void plan_join(const Statement* st, Table* sides, JoinCost* out) {
+  TableEstimate est[JOIN_SIDES];
+  double bytes[JOIN_SIDES];
+  for (int i = 0; i < JOIN_SIDES; i++) {
+    table_estimate(&sides[i], &est[i]);
+    bytes[i] = est[i].rows * sides[i].row_size;
+  }
+  /* Each row of the side with fewer distinct keys meets rows / distinct
+   * rows of the other */
+  double distinct = 1;
+  for (int i = 0; i < JOIN_SIDES; i++) {
+    int col = st->join.key_cols[i];
+    double d = est[i].rows;
+    if (!join_on_pk(&st->join, sides, i) && est[i].stats && est[i].stats->row_count > 0) {
+      d = (double)est[i].stats->distinct[col] * est[i].rows / est[i].stats->row_count;
+    }
+    if (d > distinct) {
+      distinct = d;
+    }
+  }
+  out->rows = est[0].rows * est[1].rows / distinct;
+
+  bool pk[JOIN_SIDES] = { join_on_pk(&st->join, sides, 0), join_on_pk(&st->join, sides, 1) };
+  if (pk[0] && pk[1]) {
+    out->method = JOIN_MERGE;
+    out->side = 0;
+    out->pages = full_scan_pages(&est[0]) + full_scan_pages(&est[1]);
+    return;
+  }
+
+  out->method = JOIN_HASH;
+  out->side = bytes[1] <= bytes[0] ? 1 : 0;
+  out->pages = full_scan_pages(&est[0]) + full_scan_pages(&est[1]);
+  if (bytes[out->side] > (double)sides[0].sort_budget) {
+    out->pages += 2 * (bytes[0] + bytes[1]) / MYDB_PAGE_SIZE;
+  }
+  if (pk[0] || pk[1]) {
+    int inner = pk[0] ? 0 : 1;
+    const TableEstimate* outer = &est[1 - inner];
+    double batches = (double)(uint64_t)((outer->rows + INDEX_JOIN_BATCH - 1) / INDEX_JOIN_BATCH);
+    double per_batch = outer->rows < INDEX_JOIN_BATCH ? outer->rows : INDEX_JOIN_BATCH;
+    double pages = full_scan_pages(outer) + batches * key_set_pages(&est[inner], per_batch);
+    if (pages <= out->pages) {
+      out->method = JOIN_INDEX;
+      out->side = inner;
+      out->pages = pages;
+    }
+  }
+}
+
+/* SELECT over FROM ... JOIN, by the method plan_join finds cheapest.
+ * WHERE, ORDER BY and LIMIT apply to the joined rows. The sides are copies
+ * of `table`; what they count is added to its stats afterwards. */
+static ExecuteResult execute_join(Statement* st, Table* table, RowHandler handler, void* ctx) {
+  Table sides[JOIN_SIDES];
+  for (int i = 0; i < JOIN_SIDES; i++) {
+    sides[i] = *table;
+    if (table_activate(&sides[i], st->join.tables[i]) < 0) {
+      printf("Table not found: %s\n", st->join.tables[i]);
+      return EXECUTE_SUCCESS;
+    }
+  }
+  Table view;
+  join_view(&st->join, table, &view);
+  DbStats before = table->stats;
+
+  /* Rows come out in the key order of the side that streams: both sides
+   * for a merge, the outer or probe side otherwise */
+  Operator* root;
+  JoinCost cost;
+  plan_join(st, sides, &cost);
+  if (cost.method == JOIN_MERGE) {
+    root = op_merge_join(&view, &sides[0], &sides[1]);
+  } else if (cost.method == JOIN_INDEX) {
+    int inner = cost.side;
+    Operator* outer = join_input(&sides[1 - inner], true, limit_stops_scan(st));
+    root = op_index_join(&view, &st->join, outer, &sides[inner], inner);
+  } else {
+    /* The build side is read whole before the first row comes out */
+    int build = cost.side;
+    bool serial = limit_stops_scan(st);
+    root = op_hash_join(&view, &st->join, join_input(&sides[0], build == 1, serial && build == 1),
+                        join_input(&sides[1], build == 0, serial && build == 0), build);
+  }
+  if (root && st->profile) {
+    root->est_pages = cost.pages;
+    root->est_rows = cost.rows;
+  }
+  if (root && st->where_ast) {
+    root = op_filter(root, where_filter, st);
+  }
+  if (root && st->order_by.n_cols > 0) {
+    /* Not op_top_k, which keeps pointers to rows: joined rows are
+     * assembled in one buffer */
+    root = op_sort(root, &st->order_by);
+  }
+  if (root && (st->has_offset || st->has_limit)) {
+    root = op_limit(root, st->has_offset ? st->offset : 0,
+                    st->has_limit ? st->limit : UINT32_MAX);
+  }
+  if (!root) {
+    printf("Out of memory\n");
+    return EXECUTE_SUCCESS;
+  }
+  if (st->profile) {
+    operator_explain(root, st->profile);
+  }
+
+  if ((!st->profile || st->profile->analyze) && operator_open(root)) {
+    const void* row;
+    while ((row = operator_next(root)) != NULL) {
+      if (handler) {
+        handler(&view, row, st, ctx);
+      }
+    }
+  }
+  if (operator_failed(root)) {
+    printf("Out of memory\n");
+  }
+  operator_close(root);
+
+  for (int i = 0; i < JOIN_SIDES; i++) {
+    stats_add_delta(&table->stats, &before, &sides[i].stats);
+  }
+  stats_add_delta(&table->stats, &before, &view.stats);
+  return EXECUTE_SUCCESS;
+}
+
+/* The row with primary key `key`, if it passes WHERE; returns the rows
+ * handed to `handler` */
+static uint64_t select_by_key(Statement* st, Table* table, uint32_t key, RowHandler handler,
+                              void* ctx) {
+  /* A negative filter answer proves the key is absent: skip the descent */
+  if (!bloom_table_may_contain(table, key)) {
+    return 0;
+  }
+  Cursor* cursor = table_find(table, key);
+  void* node = get_page(table->pager, cursor->page_num);
+  uint32_t num_cells = *leaf_node_num_cells(node);
+  bool found = false;
+  uint64_t rows = 0;
+
+  if (cursor->cell_num < num_cells) {
+    uint32_t key_at_index = *leaf_key_t(table, node, cursor->cell_num);
+    if (key_at_index == key) {
+      found = true;
+      void* row = leaf_value_t(table, node, cursor->cell_num);
+      if (where_matches(st, table, row)) {
+        if (handler) {
+          handler(table, row, st, ctx);
+        }
+        rows++;
+      }
+    }
+  }
+  if (!found) {
+    bloom_table_note_miss(table);
+  }
+  free(cursor);
+  return rows;
+}
+
+/* Execute SELECT with custom handler */
+ExecuteResult execute_select_core(Statement* st, Table* table, RowHandler handler, void* ctx) {
+  if (st->join.active) {
+    return execute_join(st, table, handler, ctx);
+  }
+  if (st->target_table[0] && table_activate(table, st->target_table) < 0) {
+    printf("Table not found: %s\n", st->target_table);
+    return EXECUTE_SUCCESS;
+  }
+
+  if (table->root_page_num == INVALID_PAGE_NUM) {
+    printf("No active table. Use 'use <table>' or 'create table..' first.\n");
+    return EXECUTE_SUCCESS;
+  }
+
+  AccessPlan ap;
+  plan_access(st, table, &ap);
+  bool can_point_lookup = false;
+  uint32_t lookup_key = 0;
+  /* A single key needs no operators, unless LIMIT or OFFSET might drop it */
+  if (ap.kind == ACCESS_KEYS && ap.n_keys == 1 && !st->has_limit && !st->has_offset) {
+    can_point_lookup = true;
+    lookup_key = ap.keys[0];
+  }
+  if (!st->where_ast && st->has_where && st->where_col_index == 0 && !st->where_is_string &&
+      table->active_schema.columns[0].type == COL_TYPE_INT) {
+    can_point_lookup = true;
+    lookup_key = (uint32_t)st->where_int;
+  }
+
+  if (can_point_lookup) {
+    free(ap.keys);
+    Explain* ex = st->profile;
+    ExecStep step;
+    ExplainNode* step_node = NULL;
+    if (ex) {
+      step_node = explain_add(ex, "Point Lookup", "on %s, %s = %d, Bloom filter first",
+                              explain_table_name(table), table->active_schema.columns[0].name,
+                              (int32_t)lookup_key);
+      if (step_node) {
+        step_node->est_pages = ap.pages;
+        step_node->est_rows = ap.rows;
+      }
+    }
+    if (step_begin(&step, ex, step_node, table)) {
+      step_end(&step, table, select_by_key(st, table, lookup_key, handler, ctx));
+    } else {
+      step_end(&step, table, 0);
+    }
+    return EXECUTE_SUCCESS;
+  }
+
+  if (select_by_position(st, table, handler, ctx)) {
+    free(ap.keys);
+    return EXECUTE_SUCCESS;
+  }
+
+  Operator* root = build_scan_pipeline(st, table, &ap);
+  if (root && st->order_by.n_cols > 0) {
+    uint64_t k = (uint64_t)(st->has_offset ? st->offset : 0) + st->limit;
+    if (st->has_limit && k < UINT32_MAX) {
+      /* Only the first OFFSET + LIMIT rows of the order can be output */
+      root = op_top_k(root, &st->order_by, (uint32_t)k);
+    } else {
+      root = op_sort(root, &st->order_by);
+    }
+  }
+  if (root && (st->has_offset || st->has_limit)) {
+    root = op_limit(root, st->has_offset ? st->offset : 0,
+                    st->has_limit ? st->limit : UINT32_MAX);
+  }
+  if (!root) {
+    printf("Out of memory\n");
+    return EXECUTE_SUCCESS;
+  }
+  if (st->profile) {
+    operator_explain(root, st->profile);
+    if (!st->profile->analyze) {
+      operator_close(root);
+      return EXECUTE_SUCCESS;
+    }
+  }
+
+  /* Rows stream to the handler as the pipeline produces them */
+  if (operator_open(root)) {
+    const void* row;
+    while ((row = operator_next(root)) != NULL) {
+      if (handler) {
+        handler(table, row, st, ctx);
+      }
+    }
+  }
+  if (operator_failed(root)) {
+    printf("Out of memory\n");
+  }
+  operator_close(root);
+  return EXECUTE_SUCCESS;
+}
+
+typedef struct {
+  const AggPlan* plan;
+  uint8_t* state;
+} AggScanCtx;
+
+static void agg_row_handler(Table* t, const void* row, const Statement* st, void* ctx) {
+  (void)t;
+  (void)st;
+  AggScanCtx* ac = (AggScanCtx*)ctx;
+  agg_update(ac->plan, ac->state, row);
+}
+
+static void fold_row_at(Table* table, uint32_t n, const AggPlan* plan, uint8_t* state,
+                        uint32_t i, uint64_t times) {
+  Cursor* cursor = table_seek_nth(table, n);
+  agg_add_rows(plan, state, i, cursor_value(cursor), times);
+  free(cursor);
+}
+
+/* Whether every aggregate can be answered by the tree alone, without a
+ * scan: COUNT from the root's subtree counts, MIN/MAX of the int primary
+ * key from the ends of the key order */
+static bool aggregate_tree_only(const Statement* st, Table* table, const AggPlan* plan) {
+  if (st->where_ast || st->has_where || plan->n_group > 0 || st->join.active) {
+    return false;
+  }
+  bool int_pk = table->active_schema.columns[0].type == COL_TYPE_INT;
+  for (uint32_t i = 0; i < plan->n; i++) {
+    AggFunc f = plan->specs[i].func;
+    bool pk_extreme = (f == AGG_MIN || f == AGG_MAX) && plan->specs[i].col_idx == 0 && int_pk;
+    if (f != AGG_COUNT && !pk_extreme) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Fold the aggregates from the tree (see aggregate_tree_only); false when
+ * some aggregate needs the rows */
+static bool aggregate_from_tree(Statement* st, Table* table, const AggPlan* plan, uint8_t* state) {
+  if (!aggregate_tree_only(st, table, plan)) {
+    return false;
+  }
+
+  uint32_t total = table_row_count(table);
+  if (total == 0) {
+    return true;
+  }
+  /* Keys are ordered as unsigned, so negative ids follow the others: the
+   * signed minimum is the first key with the sign bit set, when there is
+   * one, and the maximum is the key just before it */
+  uint32_t first_negative = table_rank(table, (uint32_t)INT32_MIN);
+  uint32_t min_pos = first_negative < total ? first_negative : 0;
+  uint32_t max_pos = first_negative > 0 ? first_negative - 1 : total - 1;
+
+  for (uint32_t i = 0; i < plan->n; i++) {
+    switch (plan->specs[i].func) {
+      case AGG_MIN:
+        fold_row_at(table, min_pos, plan, state, i, 1);
+        break;
+      case AGG_MAX:
+        fold_row_at(table, max_pos, plan, state, i, 1);
+        break;
+      default:
+        /* COUNT reads no value: any row stands in for all of them */
+        fold_row_at(table, 0, plan, state, i, total);
+        break;
+    }
+  }
+  return true;
+}
+
+/* A group being tested against HAVING */
+typedef struct {
+  Table* table;
+  const AggPlan* plan;
+  const uint8_t* key;
+  const uint8_t* state;
+} HavingCtx;
+
+/* Value of a HAVING operand: an aggregate, a grouped column or a literal */
+static void having_operand(const HavingCtx* h, const Expr* e, AggValue* out) {
+  memset(out, 0, sizeof(*out));
+  if (!e) {
+    return;
+  }
+  if (e->kind == EXPR_AGG) {
+    AggFunc f = agg_func_from_parsed(parsed_agg_from_name(e->op));
+    int col = strcmp(e->text, "*") == 0 ? -1 : schema_col_index(&h->table->active_schema, e->text);
+    for (uint32_t i = 0; i < h->plan->n; i++) {
+      if (h->plan->specs[i].func == f && h->plan->specs[i].col_idx == col) {
+        agg_value(h->plan, h->state, i, out);
+        return;
+      }
+    }
+    return;
+  }
+  if (e->kind == EXPR_COLUMN) {
+    int col = schema_col_index(&h->table->active_schema, e->text);
+    for (uint32_t g = 0; g < h->plan->n_group; g++) {
+      if (h->plan->group_cols[g] == col) {
+        agg_group_value(h->plan, h->key, g, out);
+        return;
+      }
+    }
+    return;
+  }
+  if (e->kind == EXPR_LITERAL) {
+    char* end;
+    if (parse_int64(e->text, &out->i) == 0) {
+      out->kind = AGG_VALUE_INT;
+      return;
+    }
+    out->d = strtod(e->text, &end);
+    if (end != e->text && *end == '\0') {
+      out->kind = AGG_VALUE_DOUBLE;
+      return;
+    }
+    out->kind = AGG_VALUE_STRING;
+    out->str = e->text;
+    out->len = (uint32_t)strlen(e->text);
+  }
+}
+
+/* Three-way compare of two values; false when they are not comparable:
+ * either is NULL, or a string meets a number */
+static bool agg_value_cmp(const AggValue* a, const AggValue* b, int* cmp) {
+  if (a->kind == AGG_VALUE_NULL || b->kind == AGG_VALUE_NULL) {
+    return false;
+  }
+  if ((a->kind == AGG_VALUE_STRING) != (b->kind == AGG_VALUE_STRING)) {
+    return false;
+  }
+  if (a->kind == AGG_VALUE_STRING) {
+    uint32_t n = a->len < b->len ? a->len : b->len;
+    int c = memcmp(a->str, b->str, n);
+    *cmp = c ? (c > 0) - (c < 0) : (a->len > b->len) - (a->len < b->len);
+  } else if (a->kind == AGG_VALUE_INT && b->kind == AGG_VALUE_INT) {
+    *cmp = (a->i > b->i) - (a->i < b->i);
+  } else {
+    double x = a->kind == AGG_VALUE_INT ? (double)a->i : a->d;
+    double y = b->kind == AGG_VALUE_INT ? (double)b->i : b->d;
+    *cmp = (x > y) - (x < y);
+  }
+  return true;
+}
+
+/* HAVING evaluation over a group; comparisons involving NULL are false */
+static bool having_matches(const HavingCtx* h, const Expr* e) {
+  if (!e) {
+    return true;
+  }
+  AggValue a, b, c;
+  int cmp, cmp2;
+  switch (e->kind) {
+    case EXPR_UNARY:
+      return strcmp(e->op, "NOT") == 0 && !having_matches(h, e->left);
+
+    case EXPR_BINARY:
+      if (strcmp(e->op, "AND") == 0) {
+        return having_matches(h, e->left) && having_matches(h, e->right);
+      }
+      if (strcmp(e->op, "OR") == 0) {
+        return having_matches(h, e->left) || having_matches(h, e->right);
+      }
+      having_operand(h, e->left, &a);
+      having_operand(h, e->right, &b);
+      return agg_value_cmp(&a, &b, &cmp) && cmp_matches_op(e->op, cmp);
+
+    case EXPR_BETWEEN:
+      if (!e->right) {
+        return false;
+      }
+      having_operand(h, e->left, &a);
+      having_operand(h, e->right->left, &b);
+      having_operand(h, e->right->right, &c);
+      return agg_value_cmp(&a, &b, &cmp) && agg_value_cmp(&a, &c, &cmp2) && cmp >= 0 && cmp2 <= 0;
+
+    case EXPR_IN:
+      having_operand(h, e->left, &a);
+      for (uint32_t i = 0; i < e->n_items; i++) {
+        having_operand(h, e->items[i], &b);
+        if (agg_value_cmp(&a, &b, &cmp) && cmp == 0) {
+          return true;
+        }
+      }
+      return false;
+
+    case EXPR_ISNULL:
+      having_operand(h, e->left, &a);
+      return (a.kind == AGG_VALUE_NULL) == (strcmp(e->op, "IS") == 0);
+
+    default:
+      /* A bare operand: true when not NULL, zero or empty */
+      having_operand(h, e, &a);
+      switch (a.kind) {
+        case AGG_VALUE_INT: return a.i != 0;
+        case AGG_VALUE_DOUBLE: return a.d != 0;
+        case AGG_VALUE_STRING: return a.len > 0;
+        default: return false;
+      }
+  }
+}
+
+typedef struct {
+  HashAgg* groups;
+  bool failed;
+} GroupScanCtx;
+
+static void group_row_handler(Table* t, const void* row, const Statement* st, void* ctx) {
+  (void)t;
+  (void)st;
+  GroupScanCtx* gc = (GroupScanCtx*)ctx;
+  if (!gc->failed && !hashagg_add(gc->groups, row)) {
+    gc->failed = true;
+  }
+}
+
+/* Stream the scan into the hash table, then hand every group that passes
+ * HAVING to `handler`, applying OFFSET and LIMIT to the groups */
+static void execute_grouped(Statement* st, Statement* scan, Table* table, const AggPlan* plan,
+                            AggRowHandler handler, void* ctx) {
+  Explain* ex = st->profile;
+  ExecStep step;
+  ExplainNode* step_node = NULL;
+  if (ex) {
+    step_node = explain_add(ex, "Hash Aggregate", "%u group columns, %u aggregates, budget %zu bytes",
+                            plan->n_group, plan->n, table->sort_budget);
+  }
+  if (!step_begin(&step, ex, step_node, table)) {
+    execute_select_core(scan, table, NULL, NULL);
+    step_end(&step, table, 0);
+    return;
+  }
+
+  GroupScanCtx gc = { hashagg_new(table, plan, table->sort_budget), false };
+  if (!gc.groups) {
+    printf("Out of memory\n");
+    step_end(&step, table, 0);
+    return;
+  }
+  execute_select_core(scan, table, group_row_handler, &gc);
+
+  uint64_t skip = st->has_offset ? st->offset : 0;
+  uint64_t emitted = 0;
+  const uint8_t* key;
+  const uint8_t* state;
+  while (!gc.failed && (key = hashagg_next(gc.groups, &state)) != NULL) {
+    if (st->has_limit && emitted >= st->limit) {
+      break;
+    }
+    HavingCtx h = { table, plan, key, state };
+    if (!having_matches(&h, st->having_ast)) {
+      continue;
+    }
+    if (skip > 0) {
+      skip--;
+      continue;
+    }
+    if (handler) {
+      handler(plan, key, state, st, ctx);
+    }
+    emitted++;
+  }
+  if (gc.failed || hashagg_failed(gc.groups)) {
+    printf("Out of memory\n");
+  }
+  if (step_node) {
+    step_node->mem_bytes = hashagg_mem_bytes(gc.groups);
+  }
+  step_end(&step, table, emitted);
+  hashagg_free(gc.groups);
+}
+
+/* Without GROUP BY: one state block and at most one result row */
+static void execute_ungrouped(Statement* st, Statement* scan, Table* table, const AggPlan* plan,
+                              AggRowHandler handler, void* ctx) {
+  Explain* ex = st->profile;
+  ExecStep step;
+  ExplainNode* step_node = NULL;
+  if (ex) {
+    bool tree = aggregate_tree_only(st, table, plan);
+    step_node = explain_add(ex, "Aggregate", "%u aggregates%s", plan->n,
+                            tree ? ", from the tree's counts and key order" : "");
+    if (!ex->analyze && tree) {
+      return;
+    }
+  }
+  if (!step_begin(&step, ex, step_node, table)) {
+    execute_select_core(scan, table, NULL, NULL);
+    step_end(&step, table, 0);
+    return;
+  }
+
+  uint8_t* state = malloc(plan->state_size ? plan->state_size : 1);
+  if (!state) {
+    printf("Out of memory\n");
+    step_end(&step, table, 0);
+    return;
+  }
+  agg_init(plan, state);
+  if (!aggregate_from_tree(st, table, plan, state)) {
+    AggScanCtx ac = { plan, state };
+    execute_select_core(scan, table, agg_row_handler, &ac);
+  }
+
+  HavingCtx h = { table, plan, NULL, state };
+  bool skipped = (st->has_offset && st->offset > 0) || (st->has_limit && st->limit == 0) ||
+                 !having_matches(&h, st->having_ast);
+  if (handler && !skipped) {
+    handler(plan, NULL, state, st, ctx);
+  }
+  if (step_node) {
+    step_node->mem_bytes = plan->state_size;
+  }
+  step_end(&step, table, skipped ? 0 : 1);
+  free(state);
+}
+
+/* Execute an aggregate SELECT. The aggregates are folded into one state
+ * block as the scan pipeline streams rows, so nothing is materialized;
+ * with GROUP BY there is a state block per group, kept in a hash table
+ * (hashagg.h). Over a join, the joined rows are aggregated through a view
+ * of them. `handler` receives each result row. */
+ExecuteResult execute_aggregate(Statement* st, Table* table, AggRowHandler handler, void* ctx) {
+  Table view;
+  Table* rows = table;
+  if (st->join.active) {
+    join_view(&st->join, table, &view);
+    rows = &view;
+  } else {
+    if (st->target_table[0] && table_activate(table, st->target_table) < 0) {
+      printf("Table not found: %s\n", st->target_table);
+      return EXECUTE_SUCCESS;
+    }
+    if (table->root_page_num == INVALID_PAGE_NUM) {
+      printf("No active table. Use 'use <table>' or 'create table..' first.\n");
+      return EXECUTE_SUCCESS;
+    }
+  }
+  DbStats before = table->stats;
+
+  AggPlan plan;
+  agg_plan_init(&plan, rows, st->aggs, st->agg_count);
+  agg_plan_group_by(&plan, rows, st->group_by, st->group_count);
+
+  /* LIMIT/OFFSET/ORDER BY apply to the result rows, not the input */
+  Statement scan = *st;
+  scan.has_limit = false;
+  scan.has_offset = false;
+  scan.order_by.n_cols = 0;
+  if (plan.n_group > 0) {
+    execute_grouped(st, &scan, rows, &plan, handler, ctx);
+  } else {
+    execute_ungrouped(st, &scan, rows, &plan, handler, ctx);
+  }
+  if (rows != table) {
+    stats_add_delta(&table->stats, &before, &rows->stats);
+  }
+  return EXECUTE_SUCCESS;
+}
+
+/* Aggregate handler for printing */
+static void print_agg_handler(const AggPlan* plan, const uint8_t* key, const uint8_t* state,
+                              const Statement* st, void* ctx) {
+  (void)ctx;
+  printf("(");
+  for (uint32_t i = 0; i < st->agg_output_count; i++) {
+    if (i) {
+      printf(",");
+    }
+    AggValue v;
+    agg_output_value(plan, st->agg_outputs[i], key, state, &v);
+    switch (v.kind) {
+      case AGG_VALUE_INT:
+        printf("%lld", (long long)v.i);
+        break;
+      case AGG_VALUE_DOUBLE:
+        printf("%.15g", v.d);
+        break;
+      case AGG_VALUE_STRING:
+        printf("%.*s", (int)v.len, v.str);
+        break;
+      default:
+        printf("NULL");
+        break;
+    }
+  }
+  printf(")\n");
+}
+
+static bool delete_leaf_may_match(Table* t, uint32_t page_num, void* ctx) {
+  return zonemap_leaf_may_match(t, page_num, ((Statement*)ctx)->where_ast);
+}
+
+static bool delete_row_matches(Table* t, const void* row, void* ctx) {
+  return where_matches((Statement*)ctx, t, row);
+}
+
+/* Execute DELETE. A WHERE that pins primary keys deletes key by key, one
+ * descent each; any other WHERE, or none, deletes in one pass over the
+ * leaves (see table_delete_where). */
+ExecuteResult execute_delete(Statement* st, Table* table) {
+  fprintf(stderr, "[DEBUG-DELETE] Starting DELETE operation\n");
+  fflush(stderr);
+
+  if (st->target_table[0]) {
+    fprintf(stderr, "[DEBUG-DELETE] Switching to target table: %s\n", st->target_table);
+    fflush(stderr);
+    int idx = catalog_find(table->pager, st->target_table);
+    if (idx < 0) {
+      fprintf(stderr, "[DEBUG-DELETE] Table not found: %s\n", st->target_table);
+      fflush(stderr);
+      printf("Table not found: %s\n", st->target_table);
+      return EXECUTE_SUCCESS;
+    }
+    CatalogEntry* ents = catalog_entries(table->pager);
+    table->root_page_num = ents[idx].root_page_num;
+    uint32_t sidx = ents[idx].schema_index;
+    fprintf(stderr, "[DEBUG-DELETE] Switched to table, root_page_num=%u, schema_index=%u\n", table->root_page_num, sidx);
+    fflush(stderr);
+    if (sidx < g_num_tables) {
+      table->active_schema = g_table_schemas[sidx];
+    } else {
+      memset(&table->active_schema, 0, sizeof(TableSchema));
+    }
+    table->row_size = compute_row_size(&table->active_schema);
+  }
+
+  if (table->root_page_num == INVALID_PAGE_NUM) {
+    fprintf(stderr, "[DEBUG-DELETE] No active table (root_page_num=INVALID)\n");
+    fflush(stderr);
+    printf("No active table. Use 'use <table>' or 'create table..' first.\n");
+    return EXECUTE_SUCCESS;
+  }
+
+  fprintf(stderr, "[DEBUG-DELETE] Current table root_page_num=%u\n", table->root_page_num);
+  fflush(stderr);
+
+  if (st->where_ast && !st->where_prog) {
+    st->where_prog = predicate_compile(table, st->where_ast);
+  }
+
+  uint32_t* keys = NULL;
+  uint32_t n_keys = 0;
+  if (st->where_ast && where_pk_keys(table, st->where_ast, &keys, &n_keys)) {
+    for (uint32_t i = 0; i < n_keys; i++) {
+      if (!bloom_table_may_contain(table, keys[i])) {
+        continue;
+      }
+      Cursor* cursor = table_find(table, keys[i]);
+      void* node = get_page(table->pager, cursor->page_num);
+      bool found = cursor->cell_num < *leaf_node_num_cells(node) &&
+                   *leaf_key_t(table, node, cursor->cell_num) == keys[i];
+      bool match = found && where_matches(st, table, leaf_value_t(table, node, cursor->cell_num));
+      free(cursor);
+      if (!found) {
+        bloom_table_note_miss(table);
+      } else if (match) {
+        delete_key(table, keys[i]);
+      }
+    }
+    free(keys);
+    return EXECUTE_SUCCESS;
+  }
+
+  DeleteFilter filter = { delete_leaf_may_match, delete_row_matches, st };
+  uint32_t deleted = table_delete_where(table, &filter);
+  fprintf(stderr, "[DEBUG-DELETE] Deleted %u rows in one pass\n", deleted);
+  fflush(stderr);
+  return EXECUTE_SUCCESS;
+}
+
+/* Called for each row an UPDATE selects, with the leaf holding it */
+typedef void (*UpdateRowFn)(Statement* st, Table* t, uint32_t page_num, uint8_t* row, void* ctx);
+
+/* Hand `fn` every row the statement's WHERE selects, in key order: one
+ * descent per key when WHERE pins primary keys, otherwise one pass over
+ * the leaves, skipping those the zone map rules out, unread when their
+ * zone is known */
+static void for_each_update_row(Statement* st, Table* table, UpdateRowFn fn, void* ctx) {
+  uint32_t* keys = NULL;
+  uint32_t n_keys = 0;
+  if (st->where_ast && where_pk_keys(table, st->where_ast, &keys, &n_keys)) {
+    for (uint32_t i = 0; i < n_keys; i++) {
+      if (!bloom_table_may_contain(table, keys[i])) {
+        continue;
+      }
+      Cursor* cursor = table_find(table, keys[i]);
+      void* node = get_page(table->pager, cursor->page_num);
+      if (cursor->cell_num < *leaf_node_num_cells(node) &&
+          *leaf_key_t(table, node, cursor->cell_num) == keys[i]) {
+        uint8_t* row = leaf_value_t(table, node, cursor->cell_num);
+        if (where_matches(st, table, row)) {
+          fn(st, table, cursor->page_num, row, ctx);
+        }
+      } else {
+        bloom_table_note_miss(table);
+      }
+      free(cursor);
+    }
+    free(keys);
+    return;
+  }
+
+  LeafWalk walk;
+  leaf_walk_init(&walk, table, table->root_page_num);
+  LeafMayMatchFn zones = st->where_ast ? zonemap_subtree_may_match : NULL;
+  void* node;
+  uint32_t page_num;
+  while ((page_num = leaf_walk_next(&walk, zones, st->where_ast, &node)) != INVALID_PAGE_NUM) {
+    if (!st->where_ast || zonemap_leaf_may_match(table, page_num, st->where_ast)) {
+      uint32_t num_cells = *leaf_node_num_cells(node);
+      for (uint32_t i = 0; i < num_cells; i++) {
+        uint8_t* row = leaf_value_t(table, node, i);
+        if (where_matches(st, table, row)) {
+          fn(st, table, page_num, row, ctx);
+        }
+      }
+    }
+  }
+}
+
+/* Copy the SET columns' bytes over a row */
+static void apply_set(const Statement* st, const Table* t, uint8_t* row) {
+  const TableSchema* s = &t->active_schema;
+  for (uint32_t i = 0; i < st->set_count; i++) {
+    int col = st->set_cols[i];
+    uint32_t off = schema_col_offset(s, col);
+    memcpy(row + off, st->set_row + off, schema_col_offset(s, col + 1) - off);
+  }
+}
+
+/* Overwrite the SET columns of a row in its leaf, keeping the leaf's
+ * zone map in step */
+static void update_in_place(Statement* st, Table* t, uint32_t page_num, uint8_t* row, void* ctx) {
+  (void)ctx;
+  zonemap_note_delete(t, page_num, row);
+  apply_set(st, t, row);
+  zonemap_note_insert(t, page_num, row);
+}
+
+/* Rows of an UPDATE that moves primary keys, copied out of the tree with
+ * the SET columns applied */
+typedef struct {
+  uint8_t* rows;
+  uint32_t* old_keys;
+  uint32_t n;
+  uint32_t cap;
+  bool oom;
+} MovedRows;
+
+static void collect_moved_row(Statement* st, Table* t, uint32_t page_num, uint8_t* row, void* ctx) {
+  (void)page_num;
+  MovedRows* m = (MovedRows*)ctx;
+  if (m->oom) {
+    return;
+  }
+  if (m->n == m->cap) {
+    uint32_t cap = m->cap ? m->cap * 2 : 64;
+    uint8_t* rows = realloc(m->rows, (size_t)cap * t->row_size);
+    if (rows) {
+      m->rows = rows;
+    }
+    uint32_t* keys = realloc(m->old_keys, cap * sizeof(uint32_t));
+    if (keys) {
+      m->old_keys = keys;
+    }
+    if (!rows || !keys) {
+      m->oom = true;
+      return;
+    }
+    m->cap = cap;
+  }
+  uint8_t* copy = m->rows + (size_t)m->n * t->row_size;
+  memcpy(copy, row, t->row_size);
+  memcpy(&m->old_keys[m->n], row, sizeof(uint32_t));
+  apply_set(st, t, copy);
+  m->n++;
+}
+
+/* Column value texts of a serialized row, as an INSERT would give them */
+static char** row_values(Table* t, const uint8_t* row) {
+  const TableSchema* s = &t->active_schema;
+  char** values = calloc(s->num_columns, sizeof(char*));
+  if (!values) {
+    return NULL;
+  }
+  for (uint32_t i = 0; i < s->num_columns; i++) {
+    const ColumnDef* c = &s->columns[i];
+    const uint8_t* v = row + schema_col_offset(s, (int)i);
+    values[i] = malloc(c->size + 24);
+    if (!values[i]) {
+      continue;
+    }
+    if (c->type == COL_TYPE_INT) {
+      int32_t x;
+      memcpy(&x, v, 4);
+      snprintf(values[i], 24, "%d", x);
+    } else if (c->type == COL_TYPE_TIMESTAMP) {
+      int64_t x;
+      memcpy(&x, v, 8);
+      snprintf(values[i], 24, "%lld", (long long)x);
+    } else {
+      memcpy(values[i], v, c->size);
+      values[i][c->size] = '\0';
+    }
+  }
+  return values;
+}
+
+static int cmp_key_u32(const void* a, const void* b) {
+  uint32_t x = *(const uint32_t*)a;
+  uint32_t y = *(const uint32_t*)b;
+  return (x > y) - (x < y);
+}
+
+/* UPDATE that sets the primary key: the selected rows are copied out and
+ * checked for key clashes first, so a failing statement changes nothing;
+ * then every old key is deleted and every row inserted under its new key */
+static ExecuteResult update_moving_keys(Statement* st, Table* table) {
+  MovedRows m = { NULL, NULL, 0, 0, false };
+  for_each_update_row(st, table, collect_moved_row, &m);
+  ExecuteResult result = EXECUTE_SUCCESS;
+  uint32_t* new_keys = m.oom ? NULL : malloc((m.n ? m.n : 1) * sizeof(uint32_t));
+  if (!new_keys) {
+    printf("Out of memory\n");
+    free(m.rows);
+    free(m.old_keys);
+    return EXECUTE_SUCCESS;
+  }
+
+  for (uint32_t i = 0; i < m.n; i++) {
+    memcpy(&new_keys[i], m.rows + (size_t)i * table->row_size, sizeof(uint32_t));
+  }
+  qsort(new_keys, m.n, sizeof(uint32_t), cmp_key_u32);
+  uint32_t* old_sorted = malloc((m.n ? m.n : 1) * sizeof(uint32_t));
+  if (!old_sorted) {
+    printf("Out of memory\n");
+    m.n = 0;
+  } else {
+    memcpy(old_sorted, m.old_keys, m.n * sizeof(uint32_t));
+    qsort(old_sorted, m.n, sizeof(uint32_t), cmp_key_u32);
+  }
+  /* A new key may reuse a key this statement vacates, but not one of a
+   * row it leaves alone or another new key */
+  for (uint32_t i = 0; i < m.n && result == EXECUTE_SUCCESS; i++) {
+    if (i > 0 && new_keys[i] == new_keys[i - 1]) {
+      result = EXECUTE_DUPLICATE_KEY;
+      break;
+    }
+    if (bsearch(&new_keys[i], old_sorted, m.n, sizeof(uint32_t), cmp_key_u32)) {
+      continue;
+    }
+    Cursor* cursor = table_find(table, new_keys[i]);
+    void* node = get_page(table->pager, cursor->page_num);
+    if (cursor->cell_num < *leaf_node_num_cells(node) &&
+        *leaf_key_t(table, node, cursor->cell_num) == new_keys[i]) {
+      result = EXECUTE_DUPLICATE_KEY;
+    }
+    free(cursor);
+  }
+
+  if (result == EXECUTE_SUCCESS) {
+    for (uint32_t i = 0; i < m.n; i++) {
+      delete_key(table, m.old_keys[i]);
+    }
+    for (uint32_t i = 0; i < m.n; i++) {
+      const uint8_t* row = m.rows + (size_t)i * table->row_size;
+      char** values = row_values(table, row);
+      uint32_t key;
+      memcpy(&key, row, sizeof(uint32_t));
+      if (values) {
+        insert_row(table, key, values, table->active_schema.num_columns);
+        for (uint32_t c = 0; c < table->active_schema.num_columns; c++) {
+          free(values[c]);
+        }
+        free(values);
+      }
+    }
+  }
+  free(old_sorted);
+  free(new_keys);
+  free(m.rows);
+  free(m.old_keys);
+  return result;
+}
+
+/* Execute UPDATE. Fixed-width column bytes are rewritten in place in the
+ * leaf; only a statement that sets the primary key deletes and re-inserts
+ * rows. */
+ExecuteResult execute_update(Statement* st, Table* table) {
+  if (table_activate(table, st->target_table) < 0) {
+    printf("Table not found: %s\n", st->target_table);
+    return EXECUTE_SUCCESS;
+  }
+  for (uint32_t i = 0; i < st->set_count; i++) {
+    if (st->set_cols[i] == 0) {
+      return update_moving_keys(st, table);
+    }
+  }
+  for_each_update_row(st, table, update_in_place, NULL);
+  return EXECUTE_SUCCESS;
+}
+
+/* Execute SELECT (with default printing) */
+ExecuteResult execute_select(Statement* st, Table* table) {
+  if (st->aggregate) {
+    return execute_aggregate(st, table, print_agg_handler, NULL);
+  }
+  return execute_select_core(st, table, print_row_handler, NULL);
+}
+
+ExecuteResult execute_explain(Statement* st, Table* table, Explain* ex) {
+  explain_init(ex, st->explain == EXPLAIN_ANALYZE);
+  st->profile = ex;
+  table->pager->count_fetches = ex->analyze;
+  ExecuteResult result = st->aggregate ? execute_aggregate(st, table, NULL, NULL)
+                                       : execute_select_core(st, table, NULL, NULL);
+  table->pager->count_fetches = false;
+  st->profile = NULL;
+  return result;
+}
+
+/* Execute any statement */
+bool statement_bind(Statement* st, uint32_t idx, const char* text) {
+  if (idx == 0 || idx > st->param_count || strlen(text) >= sizeof(st->params[0].value)) {
+    return false;
+  }
+  StmtParam* p = &st->params[idx - 1];
+  strcpy(p->value, text);
+  p->bound = true;
+  p->dirty = true;
+  return true;
+}
+
+bool statement_apply_params(Statement* st, Table* table) {
+  bool where_changed = false;
+  bool activated = false;
+  for (uint32_t i = 0; i < st->param_count; i++) {
+    StmtParam* p = &st->params[i];
+    if (!p->bound) {
+      printf("Parameter %u is not bound\n", i + 1);
+      return false;
+    }
+    if (!p->dirty) {
+      continue;
+    }
+    if (p->target == PARAM_EXPR) {
+      strncpy(p->expr->text, p->value, sizeof(p->expr->text) - 1);
+      where_changed = true;
+    } else if (p->target == PARAM_INSERT_VALUE) {
+      char* v = strdup(p->value);
+      if (!v) {
+        printf("Out of memory\n");
+        return false;
+      }
+      free(st->insert_values[p->slot]);
+      st->insert_values[p->slot] = v;
+    } else {
+      if (!activated && table_activate(table, st->target_table) < 0) {
+        printf("Table not found: %s\n", st->target_table);
+        return false;
+      }
+      activated = true;
+      PrepareResult r = serialize_set_value(&table->active_schema, st->set_cols[p->slot],
+                                            p->value, st->set_row);
+      if (r != PREPARE_SUCCESS) {
+        if (r == PREPARE_STRING_TOO_LONG) {
+          printf("String is too long.\n");
+        }
+        return false;
+      }
+    }
+    p->dirty = false;
+  }
+
+  /* The WHERE program holds its literals, so it is lowered again from the
+   * AST; nothing is parsed or resolved by name again */
+  if (where_changed && st->where_ast) {
+    if (!activated && st->target_table[0] && table_activate(table, st->target_table) < 0) {
+      printf("Table not found: %s\n", st->target_table);
+      return false;
+    }
+    Table view;
+    Table* cols = table;
+    if (st->join.active) {
+      join_view(&st->join, table, &view);
+      cols = &view;
+    }
+    if (st->where_prog) {
+      predicate_free(st->where_prog);
+    }
+    st->where_prog = predicate_compile(cols, st->where_ast);
+  }
+  return true;
+}
+
+ExecuteResult execute_statement(Statement* statement, Table* table) {
+  ExecuteResult result = statement_run(statement, table);
+  statement_cleanup(statement);
+  return result;
+}
+
+ExecuteResult statement_run(Statement* statement, Table* table) {
+  ExecuteResult result = EXECUTE_SUCCESS;
+  if (!statement_apply_params(statement, table)) {
+    return EXECUTE_SUCCESS;
+  }
+  switch (statement->type) {
+    case (STATEMENT_INSERT):
+      result = execute_insert(statement, table);
+      break;
+    case (STATEMENT_SELECT):
+      if (statement->explain != EXPLAIN_NONE) {
+        Explain ex;
+        result = execute_explain(statement, table, &ex);
+        explain_print(&ex);
+      } else {
+        result = execute_select(statement, table);
+      }
+      break;
+    case (STATEMENT_DELETE):
+      result = execute_delete(statement, table);
+      break;
+    case (STATEMENT_UPDATE):
+      result = execute_update(statement, table);
+      break;
+    case (STATEMENT_ANALYZE):
+      result = execute_analyze(statement, table);
+      break;
+    default:
+      result = EXECUTE_SUCCESS;
   }
   return result;
 }
 
+/* Release what prepare_statement attached to the statement */
+void statement_cleanup(Statement* st) {
+  if (st->where_ast) {
+    expr_free(st->where_ast);
+    st->where_ast = NULL;
+  }
+  if (st->where_prog) {
+    predicate_free(st->where_prog);
+    st->where_prog = NULL;
+  }
+  if (st->having_ast) {
+    expr_free(st->having_ast);
+    st->having_ast = NULL;
+  }
+  free(st->set_row);
+  st->set_row = NULL;
+  if (st->insert_values) {
+    for (uint32_t i = 0; i < st->insert_rows * st->num_values; i++) {
+      free(st->insert_values[i]);
+    }
+    free(st->insert_values);
+    st->insert_values = NULL;
+    st->insert_rows = 0;
+  }
+  free(st->params);
+  st->params = NULL;
+  st->param_count = 0;
+}
+
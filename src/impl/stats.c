@@ -0,0 +1,143 @@
+#include "../include/stats.h"
+#include "../include/btree.h"
+#include "../include/catalog.h"
+#include "../include/bloom.h"
+#include "../include/plancache.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Share of absent-key probes the filter failed to reject */
+double bloom_false_positive_rate(const BloomStats* bs) {
+  uint64_t absent = bs->false_positives + bs->negatives;
+  if (absent == 0) {
+    return 0.0;
+  }
+  return (double)bs->false_positives / (double)absent;
+}
+
+#define STATS_ADD_DELTA(field) (into->field += after->field - before->field)
+
+void stats_add_delta(DbStats* into, const DbStats* before, const DbStats* after) {
+  for (uint32_t i = 0; i < MAX_TABLES; i++) {
+    STATS_ADD_DELTA(bloom[i].probes);
+    STATS_ADD_DELTA(bloom[i].negatives);
+    STATS_ADD_DELTA(bloom[i].false_positives);
+  }
+  STATS_ADD_DELTA(sort.sorts);
+  STATS_ADD_DELTA(sort.spilled_sorts);
+  STATS_ADD_DELTA(sort.runs);
+  STATS_ADD_DELTA(sort.bytes_spilled);
+  STATS_ADD_DELTA(group.groupings);
+  STATS_ADD_DELTA(group.spilled);
+  STATS_ADD_DELTA(group.partitions);
+  STATS_ADD_DELTA(group.bytes_spilled);
+  STATS_ADD_DELTA(join.hash_joins);
+  STATS_ADD_DELTA(join.index_joins);
+  STATS_ADD_DELTA(join.index_lookups);
+  STATS_ADD_DELTA(join.merge_joins);
+  STATS_ADD_DELTA(join.spilled);
+  STATS_ADD_DELTA(join.partitions);
+  STATS_ADD_DELTA(join.bytes_spilled);
+}
+
+/* Print per-table counters (.stats) */
+void stats_print(Table* t) {
+  CatalogHeader* hdr = catalog_header(t->pager);
+  CatalogEntry* ents = catalog_entries(t->pager);
+  printf("Stats:\n");
+  for (uint32_t i = 0; i < hdr->num_tables; i++) {
+    CatalogTableExt* ext = catalog_table_ext(t->pager, i);
+    if (!ext || ext->bloom_page == 0) {
+      printf("  %s: bloom off\n", ents[i].name);
+      continue;
+    }
+    const BloomStats* bs = &t->stats.bloom[i];
+    printf("  %s: bloom keys=%u bits=%u hashes=%u probes=%llu negatives=%llu "
+           "false_positives=%llu fpr=%.4f\n",
+           ents[i].name, ext->bloom_keys, (unsigned)BLOOM_NUM_BITS, ext->bloom_hashes,
+           (unsigned long long)bs->probes, (unsigned long long)bs->negatives,
+           (unsigned long long)bs->false_positives, bloom_false_positive_rate(bs));
+  }
+  const SortStats* ss = &t->stats.sort;
+  printf("  sort: budget=%zu sorts=%llu spilled=%llu runs=%llu bytes_spilled=%llu\n",
+         t->sort_budget, (unsigned long long)ss->sorts, (unsigned long long)ss->spilled_sorts,
+         (unsigned long long)ss->runs, (unsigned long long)ss->bytes_spilled);
+  const GroupStats* gs = &t->stats.group;
+  printf("  group: groupings=%llu spilled=%llu partitions=%llu bytes_spilled=%llu\n",
+         (unsigned long long)gs->groupings, (unsigned long long)gs->spilled,
+         (unsigned long long)gs->partitions, (unsigned long long)gs->bytes_spilled);
+  const JoinStats* js = &t->stats.join;
+  printf("  join: hash_joins=%llu index_joins=%llu index_lookups=%llu merge_joins=%llu "
+         "spilled=%llu partitions=%llu bytes_spilled=%llu\n",
+         (unsigned long long)js->hash_joins, (unsigned long long)js->index_joins,
+         (unsigned long long)js->index_lookups, (unsigned long long)js->merge_joins,
+         (unsigned long long)js->spilled,
+         (unsigned long long)js->partitions, (unsigned long long)js->bytes_spilled);
+  if (t->plans) {
+    const PlanCacheStats* ps = &t->stats.plans;
+    printf("  plans: capacity=%u entries=%u hits=%llu misses=%llu evictions=%llu "
+           "invalidations=%llu\n",
+           plancache_capacity(t->plans), plancache_entries(t->plans),
+           (unsigned long long)ps->hits, (unsigned long long)ps->misses,
+           (unsigned long long)ps->evictions, (unsigned long long)ps->invalidations);
+  }
+}
+
+/* Append {"tables":[...],"sort":{...},"group":{...},"join":{...},"plans":{...}} with the same
+ * counters as stats_print; "plans" is null without a plan cache */
+void stats_append_json(Table* t, StrBuf* sb) {
+  CatalogHeader* hdr = catalog_header(t->pager);
+  CatalogEntry* ents = catalog_entries(t->pager);
+  sb_append(sb, "{\"tables\":[");
+  for (uint32_t i = 0; i < hdr->num_tables; i++) {
+    CatalogTableExt* ext = catalog_table_ext(t->pager, i);
+    if (i > 0) {
+      sb_append(sb, ",");
+    }
+    sb_append(sb, "{\"name\":");
+    json_escape_append(sb, ents[i].name);
+    sb_append(sb, ",\"bloom\":");
+    if (!ext || ext->bloom_page == 0) {
+      sb_append(sb, "null}");
+      continue;
+    }
+    const BloomStats* bs = &t->stats.bloom[i];
+    sb_appendf(sb,
+               "{\"keys\":%u,\"bits\":%u,\"hashes\":%u,\"probes\":%llu,\"negatives\":%llu,"
+               "\"false_positives\":%llu,\"false_positive_rate\":%.6f}}",
+               ext->bloom_keys, (unsigned)BLOOM_NUM_BITS, ext->bloom_hashes,
+               (unsigned long long)bs->probes, (unsigned long long)bs->negatives,
+               (unsigned long long)bs->false_positives, bloom_false_positive_rate(bs));
+  }
+  const SortStats* ss = &t->stats.sort;
+  sb_appendf(sb,
+             "],\"sort\":{\"budget\":%zu,\"sorts\":%llu,\"spilled\":%llu,\"runs\":%llu,"
+             "\"bytes_spilled\":%llu}",
+             t->sort_budget, (unsigned long long)ss->sorts, (unsigned long long)ss->spilled_sorts,
+             (unsigned long long)ss->runs, (unsigned long long)ss->bytes_spilled);
+  const GroupStats* gs = &t->stats.group;
+  sb_appendf(sb,
+             ",\"group\":{\"groupings\":%llu,\"spilled\":%llu,\"partitions\":%llu,"
+             "\"bytes_spilled\":%llu}",
+             (unsigned long long)gs->groupings, (unsigned long long)gs->spilled,
+             (unsigned long long)gs->partitions, (unsigned long long)gs->bytes_spilled);
+  const JoinStats* js = &t->stats.join;
+  sb_appendf(sb,
+             ",\"join\":{\"hash_joins\":%llu,\"index_joins\":%llu,\"index_lookups\":%llu,"
+             "\"merge_joins\":%llu,\"spilled\":%llu,\"partitions\":%llu,\"bytes_spilled\":%llu}",
+             (unsigned long long)js->hash_joins, (unsigned long long)js->index_joins,
+             (unsigned long long)js->index_lookups, (unsigned long long)js->merge_joins,
+             (unsigned long long)js->spilled,
+             (unsigned long long)js->partitions, (unsigned long long)js->bytes_spilled);
+  if (!t->plans) {
+    sb_append(sb, ",\"plans\":null}");
+    return;
+  }
+  const PlanCacheStats* ps = &t->stats.plans;
+  sb_appendf(sb,
+             ",\"plans\":{\"capacity\":%u,\"entries\":%u,\"hits\":%llu,\"misses\":%llu,"
+             "\"evictions\":%llu,\"invalidations\":%llu}}",
+             plancache_capacity(t->plans), plancache_entries(t->plans),
+             (unsigned long long)ps->hits, (unsigned long long)ps->misses,
+             (unsigned long long)ps->evictions, (unsigned long long)ps->invalidations);
+}
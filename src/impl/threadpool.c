@@ -0,0 +1,183 @@
+#include "../include/threadpool.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+/* Task states within a group */
+enum { TASK_NONE, TASK_QUEUED, TASK_DONE, TASK_RETURNED };
+
+struct TaskGroup {
+  pthread_mutex_t lock;
+  pthread_cond_t changed;
+  uint32_t n;
+  uint32_t submitted;
+  uint32_t finished;
+  uint32_t returned;    /* Handed out by task_group_wait_any */
+  uint8_t* state;
+};
+
+typedef struct Job {
+  TaskFn fn;
+  void* arg;
+  TaskGroup* group;
+  uint32_t index;
+  struct Job* next;
+} Job;
+
+static struct {
+  pthread_mutex_t lock;
+  pthread_cond_t ready;
+  Job* head;
+  Job* tail;
+  uint32_t workers;
+} pool = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, NULL, 0 };
+
+uint32_t threadpool_default_threads(void) {
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  if (n < 1) {
+    return 1;
+  }
+  return n > THREADPOOL_MAX_WORKERS ? THREADPOOL_MAX_WORKERS : (uint32_t)n;
+}
+
+static void task_finished(TaskGroup* g, uint32_t i) {
+  pthread_mutex_lock(&g->lock);
+  g->state[i] = TASK_DONE;
+  g->finished++;
+  pthread_cond_broadcast(&g->changed);
+  pthread_mutex_unlock(&g->lock);
+}
+
+static void* worker_main(void* unused) {
+  (void)unused;
+  for (;;) {
+    pthread_mutex_lock(&pool.lock);
+    while (!pool.head) {
+      pthread_cond_wait(&pool.ready, &pool.lock);
+    }
+    Job* job = pool.head;
+    pool.head = job->next;
+    if (!pool.head) {
+      pool.tail = NULL;
+    }
+    pthread_mutex_unlock(&pool.lock);
+
+    job->fn(job->arg);
+    task_finished(job->group, job->index);
+    free(job);
+  }
+  return NULL;
+}
+
+uint32_t threadpool_start(uint32_t n) {
+  if (n > THREADPOOL_MAX_WORKERS) {
+    n = THREADPOOL_MAX_WORKERS;
+  }
+  pthread_mutex_lock(&pool.lock);
+  while (pool.workers < n) {
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, worker_main, NULL) != 0) {
+      break;
+    }
+    pthread_detach(tid);
+    pool.workers++;
+  }
+  uint32_t workers = pool.workers;
+  pthread_mutex_unlock(&pool.lock);
+  return workers;
+}
+
+TaskGroup* task_group_new(uint32_t n) {
+  TaskGroup* g = calloc(1, sizeof(TaskGroup));
+  if (!g) {
+    return NULL;
+  }
+  g->state = calloc(n ? n : 1, 1);
+  if (!g->state) {
+    free(g);
+    return NULL;
+  }
+  pthread_mutex_init(&g->lock, NULL);
+  pthread_cond_init(&g->changed, NULL);
+  g->n = n;
+  return g;
+}
+
+void task_group_submit(TaskGroup* g, uint32_t i, TaskFn fn, void* arg) {
+  pthread_mutex_lock(&g->lock);
+  g->state[i] = TASK_QUEUED;
+  g->submitted++;
+  pthread_mutex_unlock(&g->lock);
+
+  Job* job = malloc(sizeof(Job));
+  pthread_mutex_lock(&pool.lock);
+  if (!job || pool.workers == 0) {
+    /* No worker to hand it to: run it here */
+    pthread_mutex_unlock(&pool.lock);
+    free(job);
+    fn(arg);
+    task_finished(g, i);
+    return;
+  }
+  job->fn = fn;
+  job->arg = arg;
+  job->group = g;
+  job->index = i;
+  job->next = NULL;
+  if (pool.tail) {
+    pool.tail->next = job;
+  } else {
+    pool.head = job;
+  }
+  pool.tail = job;
+  pthread_cond_signal(&pool.ready);
+  pthread_mutex_unlock(&pool.lock);
+}
+
+void task_group_wait_one(TaskGroup* g, uint32_t i) {
+  pthread_mutex_lock(&g->lock);
+  while (g->state[i] == TASK_QUEUED) {
+    pthread_cond_wait(&g->changed, &g->lock);
+  }
+  pthread_mutex_unlock(&g->lock);
+}
+
+uint32_t task_group_wait_any(TaskGroup* g) {
+  pthread_mutex_lock(&g->lock);
+  uint32_t found = UINT32_MAX;
+  while (g->returned < g->submitted) {
+    for (uint32_t i = 0; i < g->n; i++) {
+      if (g->state[i] == TASK_DONE) {
+        found = i;
+        break;
+      }
+    }
+    if (found != UINT32_MAX) {
+      g->state[found] = TASK_RETURNED;
+      g->returned++;
+      break;
+    }
+    pthread_cond_wait(&g->changed, &g->lock);
+  }
+  pthread_mutex_unlock(&g->lock);
+  return found;
+}
+
+void task_group_wait(TaskGroup* g) {
+  pthread_mutex_lock(&g->lock);
+  while (g->finished < g->submitted) {
+    pthread_cond_wait(&g->changed, &g->lock);
+  }
+  pthread_mutex_unlock(&g->lock);
+}
+
+void task_group_free(TaskGroup* g) {
+  if (!g) {
+    return;
+  }
+  task_group_wait(g);
+  pthread_mutex_destroy(&g->lock);
+  pthread_cond_destroy(&g->changed);
+  free(g->state);
+  free(g);
+}
@@ -8,9 +8,7 @@
 #include <limits.h>
 #include <ctype.h>
 #include <stdarg.h>
-
-/* Global sort context */
-SortContext g_sort_ctx;
+#include <errno.h>
 
 /* Parse integer from string */
 int parse_int(const char* s, int* out) {
@@ -29,14 +27,37 @@ int parse_int(const char* s, int* out) {
 /* Parse 64-bit integer from string */
 int parse_int64(const char* s, int64_t* out) {
   char* end = NULL;
+  errno = 0;
   long long v = strtoll(s, &end, 10);
-  if (end == s || *end != '\0') {
+  if (end == s || *end != '\0' || errno == ERANGE) {
     return -1;
   }
   *out = (int64_t)v;
   return 0;
 }
 
+/* 8 bytes at a time, then a final avalanche */
+uint64_t hash_bytes(const void* data, size_t len) {
+  const uint8_t* p = (const uint8_t*)data;
+  uint64_t h = 0x9E3779B97F4A7C15ull ^ len;
+  size_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    uint64_t w;
+    memcpy(&w, p + i, 8);
+    h = (h ^ w) * 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 31;
+  }
+  if (i < len) {
+    uint64_t w = 0;
+    memcpy(&w, p + i, len - i);
+    h = (h ^ w) * 0xBF58476D1CE4E5B9ull;
+  }
+  h ^= h >> 33;
+  h *= 0xFF51AFD7ED558CCDull;
+  h ^= h >> 33;
+  return h;
+}
+
 /* Get integer value from row */
 int row_get_int(Table* t, const void* row, int col_idx) {
   uint32_t off = schema_col_offset(&t->active_schema, col_idx);
@@ -145,31 +166,6 @@ void print_row_projected(Table* t, const void* row, const int* idxs, uint32_t n)
   printf(")\n");
 }
 
-/* Comparator for sorting rows */
-int rowref_comparator(const void* a, const void* b) {
-  const RowRef* ra = (const RowRef*)a;
-  const RowRef* rb = (const RowRef*)b;
-  Table* t = g_sort_ctx.table;
-  int idx = g_sort_ctx.col_idx;
-  if (t->active_schema.columns[idx].type == COL_TYPE_INT) {
-    int va = row_get_int(t, ra->row, idx);
-    int vb = row_get_int(t, rb->row, idx);
-    if (va < vb) {
-      return g_sort_ctx.desc ? 1 : -1;
-    }
-    if (va > vb) {
-      return g_sort_ctx.desc ? -1 : 1;
-    }
-    return 0;
-  } else {
-    char sa[512], sb[512];
-    row_get_string(t, ra->row, idx, sa, sizeof(sa));
-    row_get_string(t, rb->row, idx, sb, sizeof(sb));
-    int cmp = strcmp(sa, sb);
-    return g_sort_ctx.desc ? -cmp : cmp;
-  }
-}
-
 /* String buffer operations */
 void sb_init(StrBuf* s) {
   s->cap = 1024;
@@ -0,0 +1,357 @@
+#include "../include/zonemap.h"
+#include "../include/util.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Only fixed-width numeric columns carry bounds */
+static bool zone_col_tracked(const ColumnDef* c) {
+  return c->type == COL_TYPE_INT || c->type == COL_TYPE_TIMESTAMP;
+}
+
+static int64_t zone_col_value(const ColumnDef* c, const uint8_t* row, uint32_t off) {
+  if (c->type == COL_TYPE_TIMESTAMP) {
+    int64_t v;
+    memcpy(&v, row + off, 8);
+    return v;
+  }
+  int32_t v;
+  memcpy(&v, row + off, 4);
+  return v;
+}
+
+/* Widen the bounds of `z` with one row; true when they grew */
+static bool zone_fold_row(Table* t, LeafZone* z, const void* row) {
+  const TableSchema* s = &t->active_schema;
+  bool grew = z->num_rows == 0;
+  uint32_t off = 0;
+  for (uint32_t i = 0; i < z->num_columns; i++) {
+    const ColumnDef* c = &s->columns[i];
+    if (zone_col_tracked(c)) {
+      int64_t v = zone_col_value(c, row, off);
+      if (z->num_rows == 0 || v < z->bounds[2 * i]) {
+        z->bounds[2 * i] = v;
+        grew = true;
+      }
+      if (z->num_rows == 0 || v > z->bounds[2 * i + 1]) {
+        z->bounds[2 * i + 1] = v;
+        grew = true;
+      }
+    }
+    off += (c->type == COL_TYPE_INT) ? 4 : c->size;
+  }
+  z->num_rows++;
+  return grew;
+}
+
+static LeafZone* zone_alloc(uint32_t ncols) {
+  LeafZone* z = malloc(sizeof(LeafZone) + 2 * ncols * sizeof(int64_t));
+  if (!z) {
+    return NULL;
+  }
+  z->num_columns = ncols;
+  z->num_rows = 0;
+  z->internal = false;
+  z->version = 0;
+  memset(z->bounds, 0, 2 * ncols * sizeof(int64_t));
+  return z;
+}
+
+static LeafZone* zone_build(Table* t, uint32_t page_num) {
+  LeafZone* z = zone_alloc(t->active_schema.num_columns);
+  if (!z) {
+    return NULL;
+  }
+
+  void* node = get_page(t->pager, page_num);
+  uint32_t num_cells = *leaf_node_num_cells(node);
+  for (uint32_t i = 0; i < num_cells; i++) {
+    zone_fold_row(t, z, leaf_value_t(t, node, i));
+  }
+  return z;
+}
+
+static void zone_drop(Pager* pager, uint32_t page_num) {
+  if (page_num >= TABLE_MAX_PAGES || !pager->zones[page_num]) {
+    return;
+  }
+  free(pager->zones[page_num]);
+  pager->zones[page_num] = NULL;
+}
+
+/* A leaf's bounds changed: every internal zone is stale */
+static void zone_leaf_changed(Pager* pager) {
+  pager->zone_version++;
+}
+
+void zonemap_invalidate(Pager* pager, uint32_t page_num) {
+  zone_leaf_changed(pager);
+  zone_drop(pager, page_num);
+}
+
+void zonemap_free_all(Pager* pager) {
+  for (uint32_t i = 0; i < TABLE_MAX_PAGES; i++) {
+    zone_drop(pager, i);
+  }
+}
+
+void zonemap_note_insert(Table* t, uint32_t page_num, const void* row) {
+  if (page_num >= TABLE_MAX_PAGES) {
+    return;
+  }
+  LeafZone* z = t->pager->zones[page_num];
+  if (!z) {
+    /* Built from the leaf on first use; dropping it already made the
+     * zones above it stale */
+    return;
+  }
+  if (z->num_columns != t->active_schema.num_columns) {
+    zonemap_invalidate(t->pager, page_num);
+    return;
+  }
+  /* A row within the bounds leaves the zones above it right */
+  if (zone_fold_row(t, z, row)) {
+    zone_leaf_changed(t->pager);
+  }
+}
+
+void zonemap_note_delete(Table* t, uint32_t page_num, const void* row) {
+  if (page_num >= TABLE_MAX_PAGES) {
+    return;
+  }
+  LeafZone* z = t->pager->zones[page_num];
+  if (!z) {
+    return;
+  }
+  if (z->num_rows <= 1 || z->num_columns != t->active_schema.num_columns) {
+    zonemap_invalidate(t->pager, page_num);
+    return;
+  }
+
+  /* Removing an interior value keeps the bounds exact, here and above;
+   * removing a bound would need a rescan, so drop the zone and let the
+   * next scan rebuild it. */
+  const TableSchema* s = &t->active_schema;
+  uint32_t off = 0;
+  for (uint32_t i = 0; i < z->num_columns; i++) {
+    const ColumnDef* c = &s->columns[i];
+    if (zone_col_tracked(c)) {
+      int64_t v = zone_col_value(c, row, off);
+      if (v == z->bounds[2 * i] || v == z->bounds[2 * i + 1]) {
+        zonemap_invalidate(t->pager, page_num);
+        return;
+      }
+    }
+    off += (c->type == COL_TYPE_INT) ? 4 : c->size;
+  }
+  z->num_rows--;
+}
+
+const LeafZone* zonemap_get(Table* t, uint32_t page_num) {
+  if (page_num >= TABLE_MAX_PAGES) {
+    return NULL;
+  }
+  Pager* pager = t->pager;
+  uint32_t ncols = t->active_schema.num_columns;
+  LeafZone* z = __atomic_load_n(&pager->zones[page_num], __ATOMIC_ACQUIRE);
+  if (z && z->num_columns == ncols && !z->internal) {
+    return z;
+  }
+
+  /* Build outside the lock (it loads the leaf), then publish unless a
+   * parallel scan got there first */
+  LeafZone* built = zone_build(t, page_num);
+  pthread_mutex_lock(&pager->lock);
+  z = pager->zones[page_num];
+  if (!z || z->num_columns != ncols || z->internal) {
+    zone_drop(pager, page_num);
+    __atomic_store_n(&pager->zones[page_num], built, __ATOMIC_RELEASE);
+    z = built;
+  } else {
+    free(built);
+  }
+  pthread_mutex_unlock(&pager->lock);
+  return z;
+}
+
+/* Resolve `col` to a tracked column index, or -1 */
+static int zone_column(Table* t, const Expr* col) {
+  if (!col || col->kind != EXPR_COLUMN) {
+    return -1;
+  }
+  int idx = schema_col_index(&t->active_schema, col->text);
+  if (idx < 0 || !zone_col_tracked(&t->active_schema.columns[idx])) {
+    return -1;
+  }
+  return idx;
+}
+
+/* Literal as compared by eval_expr_to_bool against a numeric column */
+static int64_t zone_literal(const Expr* lit) {
+  int64_t v = 0;
+  if (parse_int64(lit->text, &v) != 0) {
+    v = 0;
+  }
+  return v;
+}
+
+static const char* zone_flip_op(const char* op) {
+  if (strcmp(op, "<") == 0) return ">";
+  if (strcmp(op, "<=") == 0) return ">=";
+  if (strcmp(op, ">") == 0) return "<";
+  if (strcmp(op, ">=") == 0) return "<=";
+  return op;
+}
+
+static bool zone_range_may_match(int64_t lo, int64_t hi, const char* op, int64_t c) {
+  if (strcmp(op, "=") == 0) return lo <= c && c <= hi;
+  if (strcmp(op, "!=") == 0) return !(lo == c && hi == c);
+  if (strcmp(op, "<") == 0) return lo < c;
+  if (strcmp(op, "<=") == 0) return lo <= c;
+  if (strcmp(op, ">") == 0) return hi > c;
+  if (strcmp(op, ">=") == 0) return hi >= c;
+  return true;
+}
+
+static bool zone_may_match(Table* t, const LeafZone* z, const Expr* e) {
+  if (!e) {
+    return true;
+  }
+  switch (e->kind) {
+    case EXPR_BINARY: {
+      if (strcmp(e->op, "AND") == 0) {
+        return zone_may_match(t, z, e->left) && zone_may_match(t, z, e->right);
+      }
+      if (strcmp(e->op, "OR") == 0) {
+        return zone_may_match(t, z, e->left) || zone_may_match(t, z, e->right);
+      }
+      if (!e->left || !e->right) {
+        return true;
+      }
+      const char* op = e->op;
+      int idx = -1;
+      const Expr* lit = NULL;
+      if (e->right->kind == EXPR_LITERAL) {
+        idx = zone_column(t, e->left);
+        lit = e->right;
+      } else if (e->left->kind == EXPR_LITERAL) {
+        idx = zone_column(t, e->right);
+        lit = e->left;
+        op = zone_flip_op(op);
+      }
+      if (idx < 0) {
+        return true;
+      }
+      return zone_range_may_match(z->bounds[2 * idx], z->bounds[2 * idx + 1], op, zone_literal(lit));
+    }
+
+    case EXPR_BETWEEN: {
+      int idx = zone_column(t, e->left);
+      if (idx < 0 || !e->right || !e->right->left || !e->right->right ||
+          e->right->left->kind != EXPR_LITERAL || e->right->right->kind != EXPR_LITERAL) {
+        return true;
+      }
+      int64_t low = zone_literal(e->right->left);
+      int64_t high = zone_literal(e->right->right);
+      return z->bounds[2 * idx + 1] >= low && z->bounds[2 * idx] <= high;
+    }
+
+    case EXPR_IN: {
+      int idx = zone_column(t, e->left);
+      if (idx < 0) {
+        return true;
+      }
+      for (uint32_t i = 0; i < e->n_items; i++) {
+        if (!e->items[i] || e->items[i]->kind != EXPR_LITERAL) {
+          return true;
+        }
+        int64_t v = zone_literal(e->items[i]);
+        if (z->bounds[2 * idx] <= v && v <= z->bounds[2 * idx + 1]) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    default:
+      /* NOT, IS NULL and bare operands are not range-prunable */
+      return true;
+  }
+}
+
+bool zonemap_leaf_may_match(Table* t, uint32_t page_num, const Expr* where) {
+  if (!where) {
+    return true;
+  }
+  const LeafZone* z = zonemap_get(t, page_num);
+  if (!z) {
+    return true;
+  }
+  if (z->num_rows == 0) {
+    return false;
+  }
+  return zone_may_match(t, z, where);
+}
+
+
+/* Zone of `page_num` as it stands: a leaf's, or an internal page's built
+ * since the last leaf change; NULL when there is none */
+static const LeafZone* zone_current(Table* t, uint32_t page_num) {
+  const LeafZone* z = __atomic_load_n(&t->pager->zones[page_num], __ATOMIC_ACQUIRE);
+  if (!z || z->num_columns != t->active_schema.num_columns) {
+    return NULL;
+  }
+  if (z->internal && z->version != t->pager->zone_version) {
+    return NULL;
+  }
+  return z;
+}
+
+void zonemap_note_subtree(Table* t, uint32_t page_num, void* node) {
+  if (page_num >= TABLE_MAX_PAGES || zone_current(t, page_num)) {
+    return;
+  }
+  LeafZone* z = zone_alloc(t->active_schema.num_columns);
+  if (!z) {
+    return;
+  }
+  z->internal = true;
+  z->version = t->pager->zone_version;
+  uint32_t num_keys = *internal_node_num_keys(node);
+  for (uint32_t i = 0; i <= num_keys; i++) {
+    uint32_t child_num = *internal_node_child(node, i);
+    const LeafZone* c = child_num < TABLE_MAX_PAGES ? zone_current(t, child_num) : NULL;
+    if (!c) {
+      free(z);
+      return;
+    }
+    if (c->num_rows == 0) {
+      continue;
+    }
+    for (uint32_t col = 0; col < z->num_columns; col++) {
+      if (z->num_rows == 0 || c->bounds[2 * col] < z->bounds[2 * col]) {
+        z->bounds[2 * col] = c->bounds[2 * col];
+      }
+      if (z->num_rows == 0 || c->bounds[2 * col + 1] > z->bounds[2 * col + 1]) {
+        z->bounds[2 * col + 1] = c->bounds[2 * col + 1];
+      }
+    }
+    z->num_rows += c->num_rows;
+  }
+
+  /* A parallel scan's workers each build zones inside their own subtree */
+  pthread_mutex_lock(&t->pager->lock);
+  zone_drop(t->pager, page_num);
+  __atomic_store_n(&t->pager->zones[page_num], z, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&t->pager->lock);
+}
+
+bool zonemap_subtree_may_match(Table* t, uint32_t page_num, const void* where) {
+  if (!where || page_num >= TABLE_MAX_PAGES) {
+    return true;
+  }
+  const LeafZone* z = zone_current(t, page_num);
+  if (!z) {
+    return true;
+  }
+  return z->num_rows > 0 && zone_may_match(t, z, (const Expr*)where);
+}
@@ -0,0 +1,101 @@
+#ifndef MYDB_AGGREGATE_H
+#define MYDB_AGGREGATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "btree.h"
+
+/* Aggregates accepted per statement (PARSED_MAX_PROJ) */
+#define AGG_MAX_FUNCS 16
+
+/* GROUP BY columns accepted per statement (PARSED_MAX_GROUP_BY) */
+#define AGG_MAX_GROUP_COLS 8
+
+/* Longest output name: "count(" + column name + ")" */
+#define AGG_LABEL_LEN (MAX_COLUMN_NAME_LEN + 8)
+
+typedef enum {
+  AGG_COUNT,
+  AGG_SUM,
+  AGG_MIN,
+  AGG_MAX,
+  AGG_AVG
+} AggFunc;
+
+/* One aggregate of a projection; col_idx is -1 for COUNT(*) */
+typedef struct {
+  AggFunc func;
+  int col_idx;
+} AggSpec;
+
+/* One output column of an aggregate query: a GROUP BY column or an
+ * aggregate, by its index in the plan */
+typedef struct {
+  bool group;
+  uint32_t index;
+} AggOutput;
+
+/*
+ * Layout of the running states of a list of aggregates, packed into one
+ * block of state_size bytes. Each slot holds the number of rows folded in,
+ * then the running sum or MIN/MAX value: 8 bytes for numbers, the column
+ * width for strings.
+ *
+ * With GROUP BY, a group is identified by its key: the raw bytes of its
+ * columns (strings up to the first NUL, zero-padded), key_len in all.
+ */
+typedef struct {
+  AggSpec specs[AGG_MAX_FUNCS];
+  uint32_t n;
+  ColumType types[AGG_MAX_FUNCS];       /* Argument column type */
+  uint32_t col_offsets[AGG_MAX_FUNCS];
+  uint32_t widths[AGG_MAX_FUNCS];       /* Value bytes in the slot */
+  uint32_t state_offsets[AGG_MAX_FUNCS];
+  uint32_t state_size;
+  char labels[AGG_MAX_FUNCS][AGG_LABEL_LEN]; /* e.g. "count(*)", "sum(amount)" */
+
+  int group_cols[AGG_MAX_GROUP_COLS];
+  uint32_t n_group;
+  ColumType group_types[AGG_MAX_GROUP_COLS];
+  uint32_t group_col_offsets[AGG_MAX_GROUP_COLS];
+  uint32_t group_widths[AGG_MAX_GROUP_COLS];
+  uint32_t group_key_offsets[AGG_MAX_GROUP_COLS];
+  uint32_t key_len;
+  char group_labels[AGG_MAX_GROUP_COLS][MAX_COLUMN_NAME_LEN];
+} AggPlan;
+
+typedef enum {
+  AGG_VALUE_NULL,    /* MIN/MAX/SUM/AVG of no rows */
+  AGG_VALUE_INT,
+  AGG_VALUE_DOUBLE,
+  AGG_VALUE_STRING
+} AggValueKind;
+
+/* A final aggregate or group column value; `str` points into the state
+ * or the key */
+typedef struct {
+  AggValueKind kind;
+  int64_t i;
+  double d;
+  const char* str;
+  uint32_t len;
+} AggValue;
+
+void agg_plan_init(AggPlan* p, Table* t, const AggSpec* specs, uint32_t n);
+void agg_plan_group_by(AggPlan* p, Table* t, const int* cols, uint32_t n);
+void agg_init(const AggPlan* p, uint8_t* state);
+/* Fold `row` into aggregate i as if it occurred `times` times */
+void agg_add_rows(const AggPlan* p, uint8_t* state, uint32_t i, const void* row, uint64_t times);
+/* Fold `row` into every aggregate */
+void agg_update(const AggPlan* p, uint8_t* state, const void* row);
+void agg_value(const AggPlan* p, const uint8_t* state, uint32_t i, AggValue* out);
+
+/* Group key of `row` (key_len bytes) */
+void agg_group_key(const AggPlan* p, const void* row, uint8_t* key);
+/* Value of GROUP BY column g within a group key */
+void agg_group_value(const AggPlan* p, const uint8_t* key, uint32_t g, AggValue* out);
+/* Value and name of one output column of a group */
+const char* agg_output_value(const AggPlan* p, AggOutput o, const uint8_t* key,
+                             const uint8_t* state, AggValue* out);
+
+#endif /* MYDB_AGGREGATE_H */
@@ -0,0 +1,71 @@
+#ifndef MYDB_ANALYZE_H
+#define MYDB_ANALYZE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "btree.h"
+#include "../sql_ast.h"
+
+/*
+ * Optimizer statistics collected by ANALYZE. A table's statistics occupy
+ * one page of the database file referenced from its CatalogTableExt
+ * record, like the Bloom filter, so they persist with the tree. They are
+ * a snapshot: rows written afterwards are not counted until the next
+ * ANALYZE, though estimates scale the snapshot to the live row count.
+ */
+
+/* Buckets of an equi-depth histogram */
+#define ANALYZE_HISTOGRAM_BUCKETS 16
+/* Int and timestamp columns that get a histogram; later ones have none */
+#define ANALYZE_MAX_HISTOGRAMS 25
+/* Values sampled per column to place the histogram bounds */
+#define ANALYZE_SAMPLE_ROWS 8192
+/* Smallest hashes kept per column for the distinct estimate */
+#define ANALYZE_DISTINCT_HASHES 1024
+
+/* Each bucket holds about the same number of rows: bounds[i] to
+ * bounds[i + 1]; bounds[0] and bounds[buckets] are the column's min and max */
+typedef struct {
+  uint32_t col;
+  uint32_t buckets;       /* 0 = the table was empty */
+  int64_t bounds[ANALYZE_HISTOGRAM_BUCKETS + 1];
+} ColumnHistogram;
+
+/* Page layout of a table's statistics */
+typedef struct {
+  uint32_t row_count;
+  uint32_t leaf_count;
+  uint32_t height;        /* Levels, 1 = the root is a leaf */
+  uint32_t num_columns;
+  uint32_t num_histograms;
+  uint32_t distinct[MAX_COLUMNS];  /* Estimated distinct values per column */
+  ColumnHistogram histograms[ANALYZE_MAX_HISTOGRAMS];
+} TableStats;
+
+/* Collect statistics for the active table and write them to its page */
+int analyze_table(Table* t);
+/* The active table's statistics, NULL when it was never analyzed */
+const TableStats* analyze_stats(Table* t);
+const ColumnHistogram* analyze_histogram(const TableStats* s, int col);
+
+/* What the planner knows of a table's size. From ANALYZE when present,
+ * scaled to the current row count; otherwise derived from the tree. */
+typedef struct {
+  double rows;
+  double leaves;
+  uint32_t height;
+  const TableStats* stats;  /* NULL when never analyzed */
+  bool pk_bounds;           /* Smallest and largest int primary key, */
+  int64_t pk_min;           /* when there is no histogram of it */
+  int64_t pk_max;
+} TableEstimate;
+
+void table_estimate(Table* t, TableEstimate* out);
+
+/* Fraction of the rows that pass `where` (1 for NULL) */
+double estimate_selectivity(Table* t, const TableEstimate* est, const Expr* where);
+/* Fraction of the rows whose int or timestamp column `col` lies in
+ * [lo, hi] */
+double estimate_range_fraction(const TableEstimate* est, int col, int64_t lo, int64_t hi);
+
+#endif /* MYDB_ANALYZE_H */
@@ -0,0 +1,30 @@
+#ifndef MYDB_BLOOM_H
+#define MYDB_BLOOM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "btree.h"
+
+/*
+ * Optional per-table Bloom filter over primary keys. The filter occupies one
+ * page of the database file; its page number and parameters live in the
+ * table's CatalogTableExt record, so it persists with the tree. Deleted keys
+ * stay in the filter, which only costs false positives.
+ */
+#define BLOOM_NUM_HASHES 5
+#define BLOOM_NUM_BITS (MYDB_PAGE_SIZE * 8)
+
+/* Raw filter operations on a BLOOM_NUM_BITS bit array */
+void bloom_add(void* filter, uint32_t num_hashes, uint32_t key);
+bool bloom_may_contain(const void* filter, uint32_t num_hashes, uint32_t key);
+
+/* Build a filter for the active table from its current keys */
+int bloom_enable(Table* t);
+bool bloom_table_enabled(Table* t);
+
+/* Lookup integration for the active table */
+bool bloom_table_may_contain(Table* t, uint32_t key);
+void bloom_table_note_insert(Table* t, uint32_t key);
+void bloom_table_note_miss(Table* t);
+
+#endif /* MYDB_BLOOM_H */
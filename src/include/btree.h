@@ -3,8 +3,10 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include "pager.h"
 #include "schema.h"
+#include "stats.h"
 
 /* Node types */
 typedef enum { NODE_INTERNAL, NODE_LEAF } NodeType;
@@ -15,6 +17,11 @@ typedef struct Table {
   uint32_t root_page_num;
   TableSchema active_schema;
   uint32_t row_size;
+  DbStats stats;          /* Runtime counters (see stats.h) */
+  size_t sort_budget;     /* Bytes an ORDER BY or GROUP BY may buffer before spilling */
+  uint32_t threads;       /* Pool workers a query may use (1 = serial) */
+  uint32_t catalog_version; /* Bumped by every catalog change */
+  struct PlanCache* plans;  /* Library handles only (see plancache.h) */
 } Table;
 
 /* Cursor for table traversal */
@@ -46,6 +53,11 @@ extern const uint32_t INTERNAL_NODE_KEY_SIZE;
 extern const uint32_t INTERNAL_NODE_CHILD_SIZE;
 extern const uint32_t INTERNAL_NODE_CELL_SIZE;
 extern const uint32_t INTERNAL_NODE_MAX_KEYS;
+extern const uint32_t INTERNAL_NODE_COUNTS_MAGIC;
+extern const uint32_t INTERNAL_NODE_COUNTS_OFFSET;
+
+/* Deepest tree walked by path-based maintenance */
+#define BTREE_MAX_HEIGHT 32
 
 /* Leaf Node Header Layout */
 extern const uint32_t LEAF_NODE_NUM_CELLS_SIZE;
@@ -73,6 +85,15 @@ void internal_node_insert(Table* table, uint32_t parent_page_num, uint32_t child
 void internal_node_split_and_insert(Table* table, uint32_t parent_page_num, uint32_t child_page_num);
 void update_internal_node_key(void* node, uint32_t old_key, uint32_t new_key);
 
+/* Subtree row counts (order statistics) */
+uint32_t* internal_node_child_count(void* node, uint32_t child_num);
+bool internal_node_counts_valid(void* node);
+void internal_node_invalidate_counts(void* node);
+void internal_node_refresh_counts(Table* table, uint32_t page_num);
+uint32_t subtree_row_count(Table* table, uint32_t page_num);
+void btree_refresh_counts(Table* table, uint32_t key);
+uint32_t table_row_count(Table* table);
+
 /* Leaf node functions */
 uint32_t* leaf_node_num_cells(void* node);
 uint32_t* leaf_node_next_leaf(void* node);
@@ -96,10 +117,45 @@ Cursor* leaf_node_find(Table* table, uint32_t page_num, uint32_t key);
 Cursor* internal_node_find(Table* table, uint32_t page_num, uint32_t key);
 void* cursor_value(Cursor* cursor);
 void cursor_advance(Cursor* cursor);
+Cursor* table_seek_nth(Table* table, uint32_t n);
+uint32_t table_rank(Table* table, uint32_t key);
+
+/* Leaves in key order, reached through their parents rather than the leaf
+ * chain, so a leaf can be passed over without being read. `may_match`
+ * (optional) is asked about each page before it is fetched; false passes
+ * over the page and everything under it. Internal nodes get their zone
+ * maps as the walk leaves them (see zonemap.h). */
+typedef bool (*LeafMayMatchFn)(Table* t, uint32_t page_num, const void* ctx);
+typedef struct {
+  Table* table;
+  uint32_t pending;       /* Page to visit before the path (INVALID_PAGE_NUM = none) */
+  uint32_t depth;
+  void* path[BTREE_MAX_HEIGHT];        /* Internal nodes, top down */
+  uint32_t path_page[BTREE_MAX_HEIGHT];
+  uint32_t next_child[BTREE_MAX_HEIGHT];
+  uint32_t lo;            /* Internal nodes pushed while seeking start at `lo` */
+  bool seeking;
+  uint32_t hi;            /* Leaves holding only keys above `hi` end the walk */
+} LeafWalk;
+/* Every leaf under page `page_num` */
+void leaf_walk_init(LeafWalk* w, Table* t, uint32_t page_num);
+/* Leaves that may hold keys `lo` to `hi` */
+void leaf_walk_range(LeafWalk* w, Table* t, uint32_t lo, uint32_t hi);
+/* Next leaf, loaded into *node; INVALID_PAGE_NUM at the end */
+uint32_t leaf_walk_next(LeafWalk* w, LeafMayMatchFn may_match, const void* ctx, void** node);
+
+/* Batched point lookups (sorted, distinct keys) */
+typedef void (*BatchRowHandler)(Table* t, uint32_t key, void* row, void* ctx);
+uint32_t table_find_batch(Table* table, const uint32_t* keys, uint32_t n,
+                          BatchRowHandler found, void* ctx);
 
 /* Insert operations */
 void leaf_node_insert(Cursor* cursor, uint32_t key, char* const* values, uint32_t nvals);
 void leaf_node_split_and_insert(Cursor* cursor, uint32_t key, char* const* values, uint32_t nvals);
+/* Insert rows whose keys are sorted, distinct and absent from the table;
+ * rows[i] holds the nvals value texts of keys[i] */
+void table_insert_sorted(Table* table, const uint32_t* keys, char* const* const* rows,
+                         uint32_t nvals, uint32_t n);
 
 /* Tree structure operations */
 void create_new_root(Table* table, uint32_t right_child_page_num);
@@ -113,6 +169,20 @@ void internal_node_remove_child(Table* table, void* parent, uint32_t child_page_
 void find_siblings(Table* table, uint32_t page_num, uint32_t* left_sibling, uint32_t* right_sibling);
 int find_child_index_in_parent(void* parent, uint32_t child_page_num);
 
+/* Rows a bulk delete removes. `leaf_may_match` (optional) lets a whole
+ * leaf go unchecked; it is still loaded to follow the leaf chain. */
+typedef struct {
+  bool (*leaf_may_match)(Table* t, uint32_t page_num, void* ctx);
+  bool (*row_matches)(Table* t, const void* row, void* ctx);
+  void* ctx;
+} DeleteFilter;
+
+/* Delete every matching row in one pass over the leaf chain: each leaf is
+ * compacted once and its parent key fixed once, and emptied leaves are
+ * unlinked on the way and dropped from their parents together at the end.
+ * Returns the rows deleted. */
+uint32_t table_delete_where(Table* table, const DeleteFilter* f);
+
 /* Debug functions */
 void print_constants(Table* t);
 void print_tree(Table* table, uint32_t page_num, uint32_t indentation_level);
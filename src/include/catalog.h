@@ -28,13 +28,26 @@ typedef struct {
   uint32_t schema_index;
 } CatalogEntry;
 
+/* Per-table extension record. The array sits right after the entry array
+ * in page 0; older files have zeros there, which reads as "no extensions". */
+typedef struct {
+  uint32_t bloom_page;    /* Bloom filter page, 0 = none */
+  uint32_t bloom_hashes;  /* Hash functions per key */
+  uint32_t bloom_keys;    /* Keys added to the filter */
+  uint32_t stats_page;    /* ANALYZE statistics page, 0 = none */
+  uint32_t reserved[12];
+} CatalogTableExt;
+
 /* Catalog operations */
 void catalog_init(Pager* pager);
 CatalogHeader* catalog_header(Pager* pager);
 CatalogEntry* catalog_entries(Pager* pager);
 int catalog_find(Pager* pager, const char* name);
+int catalog_find_by_root(Pager* pager, uint32_t root_page_num);
+CatalogTableExt* catalog_table_ext(Pager* pager, int idx);
 int catalog_add_table(Pager* pager, const TableSchema* schema, uint32_t root_page_num);
 int lookup_table_schema(Pager* pager, const char* name, TableSchema* out_schema);
+int table_activate(Table* table, const char* name);
 
 /* Schema persistence */
 void load_schemas_for_db(const char* dbfile);
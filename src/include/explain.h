@@ -0,0 +1,64 @@
+#ifndef MYDB_EXPLAIN_H
+#define MYDB_EXPLAIN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "btree.h"
+#include "util.h"
+
+/* Steps an explained plan can hold */
+#define EXPLAIN_MAX_NODES 32
+
+/*
+ * One step of an explained plan: an operator, or a step the executor runs
+ * itself (point lookup, positional seek, aggregation). EXPLAIN ANALYZE
+ * fills in the measurements. Rows, time and page fetches are inclusive:
+ * they count everything done while the step was asked for rows, its
+ * inputs included. Memory is the step's own buffers only. The planner's
+ * estimates, where it made them, are shown beside the measurements.
+ */
+typedef struct {
+  char name[32];
+  char detail[160];
+  int parent;             /* Step it feeds, -1 at the top */
+  uint64_t rows;          /* Rows it produced */
+  uint64_t time_ns;
+  uint64_t page_hits;     /* Page fetches served by the cache */
+  uint64_t page_reads;    /* Page fetches that loaded the page */
+  size_t mem_bytes;       /* Peak bytes of its own buffers */
+  double est_pages;       /* Estimated page reads, < 0 = not estimated */
+  double est_rows;        /* Estimated rows produced, < 0 = not estimated */
+} ExplainNode;
+
+typedef struct Explain {
+  bool analyze;           /* The statement runs and is measured */
+  int parent;             /* Step that steps added next feed */
+  uint32_t n;
+  ExplainNode nodes[EXPLAIN_MAX_NODES];
+} Explain;
+
+void explain_init(Explain* ex, bool analyze);
+/* Add a step under ex->parent; NULL when the plan is full */
+ExplainNode* explain_add(Explain* ex, const char* name, const char* fmt, ...);
+int explain_index(const Explain* ex, const ExplainNode* node);
+/* Name of the catalog table `t` reads, "?" for a join's view */
+const char* explain_table_name(Table* t);
+
+/* Measuring a step: mark before it runs, account for it after. Page
+ * fetches are only counted while the pager's count_fetches is set. */
+typedef struct {
+  uint64_t ns;
+  uint64_t page_hits;
+  uint64_t page_reads;
+} ExplainMark;
+
+void explain_mark(const Pager* pager, ExplainMark* m);
+void explain_account(ExplainNode* node, const Pager* pager, const ExplainMark* m, uint64_t rows);
+
+/* One line per step, inputs indented below what they feed */
+void explain_print(const Explain* ex);
+/* Array of the top steps, each with its inputs nested under "inputs" */
+void explain_append_json(const Explain* ex, StrBuf* sb);
+
+#endif /* MYDB_EXPLAIN_H */
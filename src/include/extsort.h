@@ -0,0 +1,35 @@
+#ifndef MYDB_EXTSORT_H
+#define MYDB_EXTSORT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "btree.h"
+#include "sortkey.h"
+
+/* Default bytes a sort may buffer before spilling (Table.sort_budget) */
+#define SORT_DEFAULT_BUDGET (8u * 1024 * 1024)
+
+/*
+ * External merge sort on an ORDER BY column list. Rows are copied, each
+ * behind its normalized sort key, into a buffer bounded by the memory
+ * budget; each time it fills, the buffer is sorted and written out as a run
+ * to a temporary file. Reading back merges all runs
+ * with a loser tree, holding one read buffer per run. A sort that never
+ * fills its buffer does no I/O.
+ */
+typedef struct ExtSort ExtSort;
+
+ExtSort* extsort_new(Table* t, const SortSpec* spec, size_t budget);
+bool extsort_add(ExtSort* s, const void* row);
+bool extsort_finish(ExtSort* s);
+/* Next row in order; valid until the following call. NULL at end. */
+const void* extsort_next(ExtSort* s);
+/* Whether reading a spilled run back failed */
+bool extsort_failed(const ExtSort* s);
+/* Most bytes of rows and keys held in memory at once: buffered rows of
+ * a run, or the merge's read buffers */
+size_t extsort_mem_peak(const ExtSort* s);
+void extsort_free(ExtSort* s);
+
+#endif /* MYDB_EXTSORT_H */
@@ -0,0 +1,41 @@
+#ifndef MYDB_HASHAGG_H
+#define MYDB_HASHAGG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "btree.h"
+#include "aggregate.h"
+
+/* Partitions a pass spills its overflow rows into */
+#define HASHAGG_FANOUT 16
+
+/* Passes deep enough that the hash bits for partitioning run out; from
+ * here on the table grows past the budget instead */
+#define HASHAGG_MAX_LEVEL 8
+
+/*
+ * Hash aggregation for GROUP BY. Groups live in an open-addressing table:
+ * slots of (hash, entry index) probed linearly, over an arena of entries
+ * that each hold a group key followed by its aggregate states. While the
+ * table fits the memory budget every row is folded in place. Once it is
+ * full, rows of groups already in the table still are; rows of any new
+ * group are written to one of HASHAGG_FANOUT temporary files chosen by
+ * hash, so every group ends up whole in exactly one place. After the
+ * in-memory groups are read out, each partition is aggregated the same
+ * way in turn, splitting on further hash bits if it is still too large.
+ */
+typedef struct HashAgg HashAgg;
+
+HashAgg* hashagg_new(Table* t, const AggPlan* plan, size_t budget);
+bool hashagg_add(HashAgg* h, const void* row);
+/* Next group once the input is complete: its key, with its aggregate
+ * states in *state; valid until the following call. NULL at end. */
+const uint8_t* hashagg_next(HashAgg* h, const uint8_t** state);
+/* Whether reading a spilled partition back failed */
+bool hashagg_failed(const HashAgg* h);
+/* Bytes of the table; it only grows, so this is also its peak */
+size_t hashagg_mem_bytes(const HashAgg* h);
+void hashagg_free(HashAgg* h);
+
+#endif /* MYDB_HASHAGG_H */
@@ -0,0 +1,60 @@
+#ifndef MYDB_HASHJOIN_H
+#define MYDB_HASHJOIN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "btree.h"
+
+/* Partitions a pass spills each side into */
+#define HASHJOIN_FANOUT 16
+
+/* Passes deep enough that the hash bits for partitioning run out; from
+ * here on the table grows past the budget instead */
+#define HASHJOIN_MAX_LEVEL 8
+
+/* Where one side's join column sits in its rows */
+typedef struct {
+  uint32_t offset;
+  ColumType type;
+  uint32_t width;     /* Column bytes */
+} JoinKeyCol;
+
+void join_key_col(JoinKeyCol* k, const TableSchema* s, int col);
+/* Key bytes two sides compare on: 8 for numbers, the wider column for strings */
+uint32_t join_key_len(const JoinKeyCol* a, const JoinKeyCol* b);
+/* Numbers as int64, strings up to the first NUL and zero-padded */
+void join_key_encode(const JoinKeyCol* k, uint32_t key_len, const void* row, uint8_t* out);
+
+/*
+ * Hash table for an equi-join. The build side's rows are copied into an
+ * arena, each behind its key, and indexed by slots of (hash, entry)
+ * probed linearly; rows with equal keys are separate entries, so matching
+ * a probe row walks its cluster. When the build side outgrows the memory
+ * budget, the table is emptied into HASHJOIN_FANOUT temporary files by
+ * hash and so is the rest of it; probe rows are then partitioned the same
+ * way, since a row can only match within its own partition. Each pair of
+ * partitions is joined in a later pass, splitting on further hash bits if
+ * its build side is still too large.
+ */
+typedef struct HashJoin HashJoin;
+
+HashJoin* hashjoin_new(Table* t, const JoinKeyCol* build_key, uint32_t build_row_size,
+                       const JoinKeyCol* probe_key, uint32_t probe_row_size, size_t budget);
+bool hashjoin_build(HashJoin* h, const void* row);
+/* Start matching a probe row, once the build side is complete. A row of a
+ * spilled partition is set aside for its pass and matches nothing now. */
+bool hashjoin_probe(HashJoin* h, const void* row);
+/* Next build row matching the current probe row; NULL when done */
+const void* hashjoin_match(HashJoin* h);
+/* After the probe input ends: load the next pair of spilled partitions.
+ * False when none are left or on failure. */
+bool hashjoin_next_pass(HashJoin* h);
+/* Next probe row of the current pass; valid until the following call */
+const void* hashjoin_next_probe(HashJoin* h);
+bool hashjoin_failed(const HashJoin* h);
+/* Bytes of the table; it only grows, so this is also its peak */
+size_t hashjoin_mem_bytes(const HashJoin* h);
+void hashjoin_free(HashJoin* h);
+
+#endif /* MYDB_HASHJOIN_H */
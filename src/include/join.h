@@ -0,0 +1,51 @@
+#ifndef MYDB_JOIN_H
+#define MYDB_JOIN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "btree.h"
+#include "schema.h"
+#include "operator.h"
+
+/* Side 0 is the FROM table, side 1 the JOIN table */
+#define JOIN_SIDES 2
+
+/*
+ * A two-table equi-join. A joined row is side 0's row followed by side 1's
+ * and is described by `schema`, whose columns are named "qualifier.column"
+ * after each table's alias (or name), so every column resolves to one side.
+ */
+typedef struct {
+  bool active;
+  char tables[JOIN_SIDES][MAX_TABLE_NAME_LEN];
+  int key_cols[JOIN_SIDES];   /* ON column of each side, in its own schema */
+  uint32_t left_columns;      /* Side 0's columns in `schema` */
+  TableSchema schema;
+} JoinSpec;
+
+/* `t` seen as the table of joined rows: same pager and settings, the
+ * join's schema and no tree of its own */
+void join_view(const JoinSpec* j, const Table* t, Table* view);
+
+/* Hash join of the rows of two inputs, each over its side's table. The
+ * hash table is built on side `build`; the other side probes it and sets
+ * the output order. Rows are valid until the next call. */
+Operator* op_hash_join(Table* view, const JoinSpec* j, Operator* left, Operator* right, int build);
+
+/* Outer rows an index join looks up together */
+#define INDEX_JOIN_BATCH 1024
+
+/* Index nested-loop join for a side joined on its int primary key: side
+ * `inner_side`, read from `inner`'s tree, is never scanned; rows of `outer`
+ * look up their match by key instead. Keys are gathered a batch of outer
+ * rows at a time, sorted and resolved in one ordered descent, so inner
+ * pages are visited in key order. Output follows the outer order; rows
+ * are valid until the next call. */
+Operator* op_index_join(Table* view, const JoinSpec* j, Operator* outer, Table* inner, int inner_side);
+
+/* Merge join of two tables on their int primary keys: both leaf chains
+ * are already in key order, so two cursors walk them in lockstep. No
+ * hash table, no sort, constant memory; output is in key order. */
+Operator* op_merge_join(Table* view, Table* left, Table* right);
+
+#endif /* MYDB_JOIN_H */
@@ -5,6 +5,8 @@
 
 /* Opaque handle for database connection */
 typedef void* MYDB_Handle;
+/* Opaque prepared statement */
+typedef void* MYDB_Stmt;
 
 /* Open/Close operations */
 MYDB_Handle mydb_open(const char* filename);
@@ -16,5 +18,30 @@ void mydb_close_with_ems(MYDB_Handle h);
 int mydb_execute_json(MYDB_Handle h, const char* sql, char** out_json);
 int mydb_execute_json_with_ems(MYDB_Handle h, const char* sql, char** out_json);
 
+/* Primary-key Bloom filter and runtime counters */
+int mydb_enable_bloom(MYDB_Handle h, const char* table);
+int mydb_stats_json(MYDB_Handle h, char** out_json);
+
+/* Bytes an ORDER BY may buffer before spilling sorted runs to temp files */
+int mydb_set_sort_budget(MYDB_Handle h, unsigned long bytes);
+/* Worker threads a scan may use; defaults to the number of CPUs */
+int mydb_set_threads(MYDB_Handle h, unsigned int threads);
+/* Statements mydb_execute_json keeps prepared, keyed on their SQL with
+ * constants taken out; 0 turns the cache off. Defaults to 64. */
+int mydb_set_plan_cache(MYDB_Handle h, unsigned int entries);
+
+/* Prepared statements: parsed and resolved once by mydb_prepare, then run
+ * by mydb_execute_prepared as often as needed. `?` stands for a literal in
+ * WHERE, HAVING, INSERT ... VALUES and UPDATE ... SET; placeholders are
+ * numbered from 1 in statement order and keep their values until rebound.
+ * Only SELECT, INSERT, UPDATE and DELETE can be prepared. */
+int mydb_prepare(MYDB_Handle h, const char* sql, MYDB_Stmt* out_stmt);
+int mydb_bind_int(MYDB_Stmt stmt, int idx, int value);
+int mydb_bind_int64(MYDB_Stmt stmt, int idx, long long value);
+int mydb_bind_text(MYDB_Stmt stmt, int idx, const char* value);
+/* Same JSON as mydb_execute_json; -6 when a placeholder is unbound */
+int mydb_execute_prepared(MYDB_Stmt stmt, char** out_json);
+void mydb_finalize(MYDB_Stmt stmt);
+
 #endif /* MYDB_H */
 
@@ -0,0 +1,92 @@
+#ifndef MYDB_OPERATOR_H
+#define MYDB_OPERATOR_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "btree.h"
+#include "predicate.h"
+#include "sortkey.h"
+#include "util.h"
+#include "explain.h"
+#include "../sql_ast.h"
+
+/*
+ * Pull-based query operators. A SELECT is a chain of operators; the caller
+ * opens the root, pulls rows with next() until it returns NULL and closes
+ * it. Each operator pulls from its child only as far as it needs to, so a
+ * satisfied LIMIT stops the scan underneath it. Rows are pointers into
+ * cached pages and stay valid until the statement finishes, except rows
+ * from op_sort, which are only valid until its next call.
+ */
+typedef struct Operator Operator;
+
+struct Operator {
+  bool (*open)(Operator* self);         /* false on failure */
+  const void* (*next)(Operator* self);  /* next row, NULL at end or failure */
+  void (*close)(Operator* self);        /* release own state (may be NULL) */
+  Operator* child;
+  Operator* side;                       /* Second input it opens itself (a hash
+                                         * join's build side), or NULL */
+  Table* table;
+  bool failed;                          /* Out of memory or temp space */
+
+  /* EXPLAIN: what the operator is, and where EXPLAIN ANALYZE measures it */
+  const char* name;
+  void (*describe)(Operator* self, char* buf, size_t cap);  /* may be NULL */
+  ExplainNode* prof;
+  size_t mem_peak;                      /* Bytes of buffers, see operator_note_mem */
+  double est_pages;                     /* Planner estimates shown by EXPLAIN, */
+  double est_rows;                      /* < 0 = none */
+};
+
+/* Row-at-a-time filter condition */
+typedef int (*RowFilterFn)(Table* t, const void* row, const void* ctx);
+
+/* Leaves in key order. With `prog`, each leaf is filtered a batch at a time
+ * into a selection vector; with `zone_where`, leaves whose zone map rules
+ * the clause out are skipped. */
+Operator* op_leaf_scan(Table* t, const Predicate* prog, const Expr* zone_where);
+
+/* Rows below which a full scan stays on the calling thread */
+#define PARALLEL_SCAN_MIN_ROWS 4096
+
+/* Like op_leaf_scan, with key ranges of the tree filtered on up to `threads`
+ * pool workers; `fn` (may be NULL) also runs on the workers. Rows come out
+ * in key order when `ordered`, otherwise a range at a time as they finish. */
+Operator* op_parallel_scan(Table* t, const Predicate* prog, const Expr* zone_where,
+                           RowFilterFn fn, const void* ctx, uint32_t threads, bool ordered);
+
+/* Like op_leaf_scan over the int primary keys from `lo` to `hi` only
+ * (inclusive, both of one sign so the keys are contiguous in key order):
+ * one descent to the first leaf, then the chain until a key passes `hi`. */
+Operator* op_range_scan(Table* t, uint32_t lo, uint32_t hi, const Predicate* prog,
+                        const Expr* zone_where);
+
+/* Rows for a sorted, distinct primary-key set (takes ownership of `keys`).
+ * Keys the Bloom filter rules out are never looked up. */
+Operator* op_key_scan(Table* t, uint32_t* keys, uint32_t n);
+
+Operator* op_filter(Operator* child, RowFilterFn fn, const void* ctx);
+Operator* op_sort(Operator* child, const SortSpec* spec);
+/* The first `k` rows of op_sort's order, without sorting the whole input */
+Operator* op_top_k(Operator* child, const SortSpec* spec, uint32_t k);
+Operator* op_limit(Operator* child, uint32_t offset, uint32_t limit);
+
+/* Zeroed operator of `size` bytes over `child` (closes `child` on failure);
+ * for operators defined outside operator.c */
+Operator* operator_alloc(size_t size, Operator* child, Table* t);
+
+/* Record that the operator holds `bytes` of buffers */
+void operator_note_mem(Operator* op, size_t bytes);
+
+/* Add the tree under `root` to `ex` below ex->parent; with ex->analyze,
+ * operator_open and operator_next then measure each operator into its
+ * step, and operator_close records its memory */
+void operator_explain(Operator* root, Explain* ex);
+
+bool operator_open(Operator* op);
+const void* operator_next(Operator* op);
+bool operator_failed(const Operator* op);
+void operator_close(Operator* op);
+
+#endif /* MYDB_OPERATOR_H */
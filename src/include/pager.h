@@ -2,20 +2,33 @@
 #define MYDB_PAGER_H
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
 #include "util.h"
 
-/* Pager structure */
+struct LeafZone;
+
+/* Pager structure. Reads (get_page, zonemap_get) may run on several
+ * threads at once: a cached page is published atomically and cache misses
+ * are loaded under `lock`. Writes are single-threaded. */
 typedef struct {
   int file_descriptor;
   uint32_t file_length;
   uint32_t num_pages;
   void* pages[TABLE_MAX_PAGES];
   char* filename;
+  struct LeafZone* zones[TABLE_MAX_PAGES]; /* Zone maps, see zonemap.h */
+  uint32_t zone_version;                   /* Bumped by every leaf change (zonemap.h) */
+  pthread_mutex_t lock;                    /* Guards cache misses */
+  bool count_fetches;                      /* Count get_page calls (EXPLAIN ANALYZE) */
+  uint64_t page_hits;                      /* Fetches served by the cache */
+  uint64_t page_reads;                     /* Fetches that loaded the page */
 } Pager;
 
 /* Pager operations */
 Pager* pager_open(const char* filename);
 void* get_page(Pager* pager, uint32_t page_num);
+void pager_free(Pager* pager);
 void pager_flush(Pager* pager, uint32_t page_num);
 uint32_t get_unused_page_num(Pager* pager);
 
@@ -0,0 +1,54 @@
+#ifndef MYDB_PLANCACHE_H
+#define MYDB_PLANCACHE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "btree.h"
+#include "sql_executor.h"
+
+/* Statements a handle keeps prepared unless told otherwise */
+#define PLAN_CACHE_DEFAULT_ENTRIES 64
+
+/*
+ * SQL with its constants taken out: every number or string literal that
+ * the parser accepts as a ? placeholder becomes one in `key`, in order,
+ * and its text goes to `literals`. LIMIT and OFFSET counts stay in the
+ * key since they cannot be placeholders. Tokens are joined by single
+ * spaces, so statements that differ only in constants or spacing share
+ * a key, and the key is itself valid SQL.
+ */
+typedef struct {
+  char* key;
+  char** literals;
+  uint32_t n_literals;
+} NormalizedSql;
+
+/* False when `sql` is not a SELECT, UPDATE, DELETE or INSERT ... VALUES,
+ * or already has placeholders of its own; `out` is then left empty */
+bool sql_normalize(const char* sql, NormalizedSql* out);
+void normalized_sql_free(NormalizedSql* n);
+
+/*
+ * Per-handle LRU cache of prepared statements keyed on normalized SQL. A
+ * hit skips parsing and column resolution; the literals are bound to the
+ * cached statement's placeholders instead. Entries prepared before the
+ * handle's catalog_version last changed are dropped on the next lookup.
+ * Hits, misses, evictions and invalidations are counted in the handle's
+ * stats.
+ */
+typedef struct PlanCache PlanCache;
+
+PlanCache* plancache_new(uint32_t capacity);
+void plancache_free(PlanCache* c);
+/* Drops every entry; a capacity of 0 turns the cache off */
+bool plancache_resize(PlanCache* c, uint32_t capacity);
+uint32_t plancache_capacity(const PlanCache* c);
+uint32_t plancache_entries(const PlanCache* c);
+
+/* `sql`'s statement with its literals bound, from the cache or prepared
+ * and cached now; it stays owned by the cache. NULL with *pr set to
+ * PREPARE_SUCCESS when `sql` is not cacheable and should be prepared
+ * as usual; NULL with any other *pr when preparing it failed. */
+Statement* plancache_statement(PlanCache* c, Table* t, const char* sql, PrepareResult* pr);
+
+#endif /* MYDB_PLANCACHE_H */
@@ -0,0 +1,87 @@
+#ifndef MYDB_PREDICATE_H
+#define MYDB_PREDICATE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "btree.h"
+#include "../sql_ast.h"
+
+/*
+ * Compiled WHERE clause. The AST is lowered once, after the statement's
+ * table is known, into a flat instruction array: column names become byte
+ * offsets, operators become enums, literals are parsed up front and AND/OR
+ * become conditional jumps. Evaluation compares values in place on the page
+ * and follows the same rules as eval_expr_to_bool.
+ */
+typedef enum { CMP_EQ, CMP_NE, CMP_LT, CMP_LE, CMP_GT, CMP_GE } CmpOp;
+
+typedef enum {
+  OPND_NONE,      /* Unknown column or missing operand: 0 / "" */
+  OPND_I32_COL,   /* Int column */
+  OPND_I64_COL,   /* Timestamp column */
+  OPND_STR_COL,   /* Fixed-width string column */
+  OPND_NUM_LIT,   /* Literal that parses as an integer */
+  OPND_STR_LIT    /* Any other literal */
+} OperandKind;
+
+typedef struct {
+  OperandKind kind;
+  uint32_t offset;  /* Column byte offset within the row */
+  uint32_t size;    /* String column width / literal length */
+  int64_t num;      /* Numeric literal value */
+  char* str;        /* String literal (owned) */
+} Operand;
+
+typedef enum {
+  PI_CONST,           /* acc = imm */
+  PI_CMP_I32,         /* int column <op> num */
+  PI_CMP_I64,         /* timestamp column <op> num */
+  PI_CMP_STR,         /* string column <op> string literal */
+  PI_CMP,             /* any other comparison */
+  PI_BETWEEN_I32,     /* int column in [lo, hi] */
+  PI_BETWEEN_I64,     /* timestamp column in [lo, hi] */
+  PI_BETWEEN,         /* any other BETWEEN */
+  PI_IN_NUM,          /* numeric operand in sorted set */
+  PI_IN_STR,          /* string operand in sorted set */
+  PI_TRUTHY,          /* bare column used as a condition */
+  PI_NOT,
+  PI_JUMP_IF_FALSE,   /* AND short circuit */
+  PI_JUMP_IF_TRUE     /* OR short circuit */
+} PredOpcode;
+
+typedef struct {
+  PredOpcode code;
+  CmpOp op;
+  bool imm;
+  Operand a;          /* Left operand / tested value */
+  Operand b;          /* Right operand / lower bound */
+  Operand c;          /* Upper bound */
+  int64_t lo, hi;     /* Numeric bounds (PI_CMP_*: lo is the constant) */
+  int64_t* nums;      /* PI_IN_NUM set */
+  char** strs;        /* PI_IN_STR set */
+  uint32_t n_set;
+  uint32_t target;    /* Jump destination */
+} PredInstr;
+
+typedef struct Predicate {
+  PredInstr* code;
+  uint32_t n_code;
+  uint32_t cap;
+  uint32_t root_page_num;  /* Table whose layout the offsets refer to */
+} Predicate;
+
+/* Rows evaluated per predicate_filter_batch call (a multiple of 64) */
+#define PREDICATE_BATCH_MAX 512
+
+/* Compile `where` against the active table (NULL where = always true) */
+Predicate* predicate_compile(Table* t, const Expr* where);
+bool predicate_eval(const Predicate* p, const void* row);
+void predicate_free(Predicate* p);
+
+/* Evaluate `n` (<= PREDICATE_BATCH_MAX) rows spaced `stride` bytes apart,
+ * one instruction at a time across the batch. Writes the ascending
+ * positions of matching rows to `sel` and returns how many matched. */
+uint32_t predicate_filter_batch(const Predicate* p, const void* rows, uint32_t stride,
+                                uint32_t n, uint32_t* sel);
+
+#endif /* MYDB_PREDICATE_H */
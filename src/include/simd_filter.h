@@ -0,0 +1,28 @@
+#ifndef MYDB_SIMD_FILTER_H
+#define MYDB_SIMD_FILTER_H
+
+#include <stdint.h>
+#include "predicate.h"
+
+/*
+ * Filter kernels for `col <op> const` and `col BETWEEN lo AND hi` over a
+ * dense array of gathered int or timestamp values. Bit i of `mask` (64 bits
+ * per word) is set when value i matches; words past the batch are untouched.
+ *
+ * The implementation is picked once at runtime: AVX2 when the CPU has it,
+ * else SSE (SSE2 for 32-bit values, SSE4.2 for 64-bit), else scalar. Non-x86
+ * and Emscripten builds only have the scalar kernels.
+ */
+typedef enum { SIMD_SCALAR, SIMD_SSE, SIMD_AVX2 } SimdLevel;
+
+void simd_filter_cmp_i32(const int32_t* vals, uint32_t n, CmpOp op, int64_t c, uint64_t* mask);
+void simd_filter_cmp_i64(const int64_t* vals, uint32_t n, CmpOp op, int64_t c, uint64_t* mask);
+void simd_filter_between_i32(const int32_t* vals, uint32_t n, int64_t lo, int64_t hi, uint64_t* mask);
+void simd_filter_between_i64(const int64_t* vals, uint32_t n, int64_t lo, int64_t hi, uint64_t* mask);
+
+/* Kernel set in use, and an override for tests (-1 if the CPU lacks it) */
+SimdLevel simd_filter_level(void);
+const char* simd_filter_level_name(SimdLevel level);
+int simd_filter_force(SimdLevel level);
+
+#endif /* MYDB_SIMD_FILTER_H */
@@ -0,0 +1,61 @@
+#ifndef MYDB_SORTKEY_H
+#define MYDB_SORTKEY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "btree.h"
+
+/* ORDER BY columns accepted per statement (PARSED_MAX_ORDER_BY) */
+#define SORT_MAX_KEYS 8
+
+/* Rows below which a radix pass costs more than insertion sort */
+#define SORT_RADIX_MIN 64
+
+/* Rows below which a sort stays on the calling thread */
+#define SORT_PARALLEL_MIN 65536
+
+typedef struct {
+  int col_idx;
+  bool desc;
+} SortKeyCol;
+
+/* ORDER BY column list, resolved against a table schema */
+typedef struct {
+  SortKeyCol cols[SORT_MAX_KEYS];
+  uint32_t n_cols;                /* 0 = no ORDER BY */
+} SortSpec;
+
+/*
+ * Normalized sort keys. Each row's ORDER BY columns are encoded once into a
+ * fixed-length byte string whose memcmp order is the ORDER BY order:
+ * integers big-endian with the sign bit flipped, strings NUL-padded to the
+ * column width, and every byte inverted for DESC columns. A big-endian
+ * sequence number ends the key, so keys are unique and equal rows keep their
+ * input order.
+ */
+typedef struct {
+  SortSpec spec;
+  ColumType types[SORT_MAX_KEYS];
+  uint32_t offsets[SORT_MAX_KEYS]; /* Column offsets within the row */
+  uint32_t widths[SORT_MAX_KEYS];  /* Encoded bytes per column */
+  uint32_t key_len;                /* Total, including the sequence number */
+} SortKeyFormat;
+
+void sortkey_format_init(SortKeyFormat* f, Table* t, const SortSpec* spec);
+void sortkey_encode(const SortKeyFormat* f, const void* row, uint32_t seq, uint8_t* out);
+
+typedef struct {
+  const uint8_t* key;
+  const void* row;
+} SortItem;
+
+/* Sort by key: MSD radix on key bytes, insertion sort for small buckets */
+void sortkey_sort(SortItem* items, uint32_t n, uint32_t key_len);
+
+/* Sample sort on up to `threads` pool workers: items are split into key
+ * ranges by sampled splitters and each range is radix sorted on its own.
+ * Falls back to sortkey_sort below SORT_PARALLEL_MIN rows, with one thread,
+ * or when out of memory. The result is the same as sortkey_sort's. */
+void sortkey_sort_parallel(SortItem* items, uint32_t n, uint32_t key_len, uint32_t threads);
+
+#endif /* MYDB_SORTKEY_H */
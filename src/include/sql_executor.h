@@ -6,13 +6,19 @@
 #include <sys/types.h>
 #include "btree.h"
 #include "schema.h"
+#include "sortkey.h"
+#include "aggregate.h"
+#include "join.h"
+#include "explain.h"
 #include "../sql_ast.h"
 
 /* Statement types */
 typedef enum { 
   STATEMENT_INSERT, 
   STATEMENT_SELECT, 
-  STATEMENT_DELETE 
+  STATEMENT_DELETE,
+  STATEMENT_UPDATE,
+  STATEMENT_ANALYZE     /* target_table, or every table when empty */
 } StatementType;
 
 /* Prepare results */
@@ -29,13 +35,43 @@ typedef enum {
 typedef enum {
   EXECUTE_SUCCESS,
   EXECUTE_DUPLICATE_KEY,
+  EXECUTE_TABLE_NOT_FOUND,
+  EXECUTE_INVALID_VALUE,
+  EXECUTE_FAILED,
 } ExecuteResult;
 
+/* EXPLAIN prefix of a SELECT */
+typedef enum {
+  EXPLAIN_NONE,
+  EXPLAIN_PLAN,         /* EXPLAIN: show the plan without running it */
+  EXPLAIN_ANALYZE       /* EXPLAIN ANALYZE: run it and measure every step */
+} ExplainMode;
+
+/* Where the value bound to a ? placeholder goes */
+typedef enum {
+  PARAM_EXPR,           /* Text of a WHERE or HAVING literal */
+  PARAM_INSERT_VALUE,   /* insert_values[slot] */
+  PARAM_SET_VALUE       /* SET column set_cols[slot], serialized into set_row */
+} ParamTarget;
+
+typedef struct {
+  ParamTarget target;
+  Expr* expr;
+  uint32_t slot;
+  bool bound;
+  bool dirty;           /* Bound since the statement last ran */
+  char value[256];
+} StmtParam;
+
 /* Statement structure */
 typedef struct Statement {
   StatementType type;
   uint32_t num_values;
   char* values[MAX_VALUES];
+  /* INSERT ... VALUES: insert_rows rows of num_values value texts each,
+   * owned by the statement; NULL for the single-row legacy form */
+  char** insert_values;
+  uint32_t insert_rows;
   
   char target_table[MAX_TABLE_NAME_LEN];
   
@@ -45,6 +81,25 @@ typedef struct Statement {
   /* SELECT projection */
   uint32_t proj_count; /* 0 means * */
   int proj_indices[MAX_SELECT_COLS];
+
+  /* Aggregate query: aggregates, GROUP BY or HAVING */
+  bool aggregate;
+  AggSpec aggs[AGG_MAX_FUNCS];          /* Including those only HAVING uses */
+  uint32_t agg_count;
+  AggOutput agg_outputs[AGG_MAX_FUNCS]; /* Result columns, in projection order */
+  uint32_t agg_output_count;
+  int group_by[AGG_MAX_GROUP_COLS];
+  uint32_t group_count;
+  Expr* having_ast;
+
+  /* FROM ... JOIN: column indices above refer to join.schema */
+  JoinSpec join;
+
+  /* UPDATE: the SET columns, with their new values serialized in place in
+   * a row of the target table */
+  uint32_t set_count;
+  int set_cols[MAX_COLUMNS];
+  uint8_t* set_row;
   
   /* WHERE clause (legacy) */
   bool has_where;
@@ -55,6 +110,7 @@ typedef struct Statement {
   
   /* WHERE AST */
   Expr* where_ast;
+  struct Predicate* where_prog; /* where_ast compiled against the target table */
   
   /* LIMIT/OFFSET */
   bool has_limit;
@@ -63,8 +119,15 @@ typedef struct Statement {
   uint32_t offset;
   
   /* ORDER BY */
-  int order_by_index; /* -1 means not specified */
-  bool order_desc;
+  SortSpec order_by; /* n_cols == 0 means not specified */
+
+  /* ? placeholders, number i + 1 at params[i] */
+  uint32_t param_count;
+  StmtParam* params;
+
+  /* EXPLAIN: steps are recorded into `profile` while it runs */
+  ExplainMode explain;
+  Explain* profile;
 } Statement;
 
 /* Input buffer for REPL */
@@ -79,16 +142,37 @@ PrepareResult prepare_statement(InputBuffer* input_buffer, Statement* statement,
 PrepareResult prepare_insert(InputBuffer* input_buffer, Statement* st);
 PrepareResult prepare_select(InputBuffer* in, Statement* st, Table* table);
 
+/* Placeholders: bind the text of number `idx` (from 1); false when out
+ * of range or too long. Bound values stay until rebound. */
+bool statement_bind(Statement* st, uint32_t idx, const char* text);
+/* Move values bound since the last run into the statement; prints why and
+ * returns false when a placeholder is unbound or its value does not fit */
+bool statement_apply_params(Statement* st, Table* table);
+
 /* Execute functions */
 ExecuteResult execute_statement(Statement* statement, Table* table);
+/* Execute without releasing the statement, so it can run again */
+ExecuteResult statement_run(Statement* statement, Table* table);
 ExecuteResult execute_insert(Statement* st, Table* table);
 ExecuteResult execute_delete(Statement* st, Table* table);
+ExecuteResult execute_update(Statement* st, Table* table);
 ExecuteResult execute_select(Statement* st, Table* table);
+void statement_cleanup(Statement* st);
 
 /* Row handler callback for flexible output */
 typedef void (*RowHandler)(Table* t, const void* row, const Statement* st, void* ctx);
 ExecuteResult execute_select_core(Statement* st, Table* table, RowHandler handler, void* ctx);
 
+/* Aggregate result handler, once per group: `key` and `state` are laid
+ * out by `plan` (no key without GROUP BY) */
+typedef void (*AggRowHandler)(const AggPlan* plan, const uint8_t* key, const uint8_t* state,
+                              const Statement* st, void* ctx);
+ExecuteResult execute_aggregate(Statement* st, Table* table, AggRowHandler handler, void* ctx);
+
+/* The plan of an EXPLAIN [ANALYZE] SELECT into `ex`; with ANALYZE the
+ * query runs, its rows discarded, and every step is measured */
+ExecuteResult execute_explain(Statement* st, Table* table, Explain* ex);
+
 /* Expression evaluation */
 int eval_expr_to_bool(Table* t, const void* row, Expr* e);
 
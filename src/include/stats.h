@@ -0,0 +1,70 @@
+#ifndef MYDB_STATS_H
+#define MYDB_STATS_H
+
+#include <stdint.h>
+#include "schema.h"
+#include "util.h"
+
+/* Bloom filter counters for one table */
+typedef struct {
+  uint64_t probes;           /* Point lookups that consulted the filter */
+  uint64_t negatives;        /* Answered "absent" without touching the tree */
+  uint64_t false_positives;  /* Passed the filter but the key was absent */
+} BloomStats;
+
+/* ORDER BY sort counters */
+typedef struct {
+  uint64_t sorts;            /* Full sorts run */
+  uint64_t spilled_sorts;    /* Sorts that exceeded the memory budget */
+  uint64_t runs;             /* Sorted runs written to temp files */
+  uint64_t bytes_spilled;
+} SortStats;
+
+/* GROUP BY hash aggregation counters */
+typedef struct {
+  uint64_t groupings;        /* Hash aggregations run */
+  uint64_t spilled;          /* Aggregations whose groups exceeded the memory budget */
+  uint64_t partitions;       /* Partition files written */
+  uint64_t bytes_spilled;
+} GroupStats;
+
+/* Join counters */
+typedef struct {
+  uint64_t hash_joins;       /* Hash joins run */
+  uint64_t index_joins;      /* Joins that looked rows up by the inner primary key */
+  uint64_t index_lookups;    /* Distinct keys those looked up */
+  uint64_t merge_joins;      /* Joins of two primary keys by merging the leaf chains */
+  uint64_t spilled;          /* Hash joins whose build side exceeded the memory budget */
+  uint64_t partitions;       /* Partition files written, both sides */
+  uint64_t bytes_spilled;
+} JoinStats;
+
+/* Plan cache counters (see plancache.h) */
+typedef struct {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;        /* Least recently used entries dropped for new ones */
+  uint64_t invalidations;    /* Times the catalog changed under cached entries */
+} PlanCacheStats;
+
+/* Runtime counters kept on the handle (not persisted) */
+typedef struct {
+  BloomStats bloom[MAX_TABLES]; /* Indexed by catalog entry */
+  SortStats sort;
+  GroupStats group;
+  JoinStats join;
+  PlanCacheStats plans;
+} DbStats;
+
+/* Measured false-positive rate over probes for absent keys */
+double bloom_false_positive_rate(const BloomStats* bs);
+
+/* Add what `after` counted since `before` to `into`, for work done through
+ * a copy of the handle's Table */
+void stats_add_delta(DbStats* into, const DbStats* before, const DbStats* after);
+
+/* Reporting */
+void stats_print(Table* t);
+void stats_append_json(Table* t, StrBuf* sb);
+
+#endif /* MYDB_STATS_H */
@@ -0,0 +1,38 @@
+#ifndef MYDB_THREADPOOL_H
+#define MYDB_THREADPOOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Upper bound on worker threads in the process */
+#define THREADPOOL_MAX_WORKERS 64
+
+/*
+ * Worker threads shared by every handle in the process. Workers start the
+ * first time a caller asks for them and live until exit; tasks run in
+ * submission order. Builds without thread support (WASM) and a pool that
+ * failed to start run each task inline when it is submitted.
+ */
+typedef void (*TaskFn)(void* arg);
+
+/* Online CPUs, the default parallelism of a handle (Table.threads) */
+uint32_t threadpool_default_threads(void);
+
+/* Start workers until at least `n` are running (capped); returns the count */
+uint32_t threadpool_start(uint32_t n);
+
+/* A fixed set of `n` tasks whose completion can be awaited one at a time */
+typedef struct TaskGroup TaskGroup;
+
+TaskGroup* task_group_new(uint32_t n);
+void task_group_submit(TaskGroup* g, uint32_t i, TaskFn fn, void* arg);
+/* Block until task `i` has finished */
+void task_group_wait_one(TaskGroup* g, uint32_t i);
+/* Block until some finished task not yet returned does, and return it;
+ * UINT32_MAX once every submitted task has been returned */
+uint32_t task_group_wait_any(TaskGroup* g);
+/* Block until every submitted task has finished */
+void task_group_wait(TaskGroup* g);
+void task_group_free(TaskGroup* g);
+
+#endif /* MYDB_THREADPOOL_H */
@@ -18,6 +18,9 @@ typedef struct Statement Statement;
 int parse_int(const char* s, int* out);
 int parse_int64(const char* s, int64_t* out);
 
+/* 64-bit hash of a byte string (hash table keys) */
+uint64_t hash_bytes(const void* data, size_t len);
+
 /* Row printing utilities */
 void print_row_dynamic(Table* t, const void* src);
 void print_row_projected(Table* t, const void* row, const int* idxs, uint32_t n);
@@ -30,21 +33,11 @@ void row_get_string(Table* t, const void* row, int col_idx, char* out, size_t ca
 /* Row matching */
 bool row_matches_where(Table* t, const void* row, const Statement* st);
 
-/* Sorting support */
+/* Row reference collected by scans */
 typedef struct {
   const void* row;
 } RowRef;
 
-typedef struct {
-  Table* table;
-  int col_idx;
-  int desc;
-} SortContext;
-
-extern SortContext g_sort_ctx;
-
-int rowref_comparator(const void* a, const void* b);
-
 /* String buffer for JSON output */
 typedef struct {
   char* buf;
@@ -0,0 +1,51 @@
+#ifndef MYDB_ZONEMAP_H
+#define MYDB_ZONEMAP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "btree.h"
+#include "../sql_ast.h"
+
+/*
+ * Per-leaf zone map: min/max of every int and timestamp column of one leaf.
+ * Zones live beside the page cache (Pager.zones) rather than in the page
+ * itself, so the on-disk format is unchanged. A missing zone is rebuilt
+ * lazily from the leaf the next time a scan asks for it.
+ *
+ * An internal page's zone covers its whole subtree. A leaf walk leaving the
+ * page builds it from its children's zones, and it is only good while no
+ * leaf's bounds have changed since: every such change, and every dropped
+ * leaf zone, bumps Pager.zone_version. Its row count only tells an empty
+ * subtree from one that had rows.
+ */
+typedef struct LeafZone {
+  uint32_t num_columns;
+  uint32_t num_rows;      /* Rows folded into the bounds (0 = empty leaf) */
+  bool internal;          /* Covers an internal page's subtree */
+  uint32_t version;       /* Pager.zone_version when built (internal only) */
+  int64_t bounds[];       /* [2*i] = min, [2*i+1] = max of column i */
+} LeafZone;
+
+/* Zone maintenance (called by the B-tree on leaf mutation) */
+void zonemap_note_insert(Table* t, uint32_t page_num, const void* row);
+void zonemap_note_delete(Table* t, uint32_t page_num, const void* row);
+void zonemap_invalidate(Pager* pager, uint32_t page_num);
+void zonemap_free_all(Pager* pager);
+
+/* Zone lookup (builds the zone from the leaf when missing) */
+const LeafZone* zonemap_get(Table* t, uint32_t page_num);
+
+/* Returns false only when no row of the leaf can satisfy `where` */
+bool zonemap_leaf_may_match(Table* t, uint32_t page_num, const Expr* where);
+
+/* Returns false only when no row under page `page_num`, a leaf or an
+ * internal node, can satisfy `where`; from zones already built, so nothing
+ * is read (true when there is none). A LeafMayMatchFn with `where` as its
+ * context (see leaf_walk_next). */
+bool zonemap_subtree_may_match(Table* t, uint32_t page_num, const void* where);
+
+/* Build the zone of internal page `page_num` from its children's, when each
+ * has one (called by leaf walks leaving the page) */
+void zonemap_note_subtree(Table* t, uint32_t page_num, void* node);
+
+#endif /* MYDB_ZONEMAP_H */
@@ -58,6 +58,15 @@ int main(int argc, char* argv[]) {
       case (EXECUTE_DUPLICATE_KEY):
         printf("Error: Duplicate key.\n");
         break;
+      case (EXECUTE_TABLE_NOT_FOUND):
+        printf("Error: Table not found.\n");
+        break;
+      case (EXECUTE_INVALID_VALUE):
+        printf("Error: Invalid value.\n");
+        break;
+      case (EXECUTE_FAILED):
+        printf("Error: Statement failed.\n");
+        break;
     }
   }
 }
@@ -10,7 +10,8 @@ typedef enum {
     EXPR_UNARY,
     EXPR_IN,
     EXPR_BETWEEN,
-    EXPR_ISNULL
+    EXPR_ISNULL,
+    EXPR_AGG        /* op = function name, text = column or "*" */
 } ExprKind;
 
 
@@ -29,6 +30,8 @@ struct Expr {
     Expr** items;
     uint32_t n_items;
 
+    uint32_t param;     /* Literal from a ? placeholder: its 1-based number, else 0 */
+
 };
 
 
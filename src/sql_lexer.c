@@ -47,6 +47,13 @@ void lexer_next(Lexer* lx){
         return;
     }
 
+    if (c == '?'){
+        lx->cur.type = TOK_PARAM;
+        strcpy(lx->cur.text, "?");
+        lx->pos = i + 1;
+        return;
+    }
+
 
     if (c == '(') {
         lx->cur.type = TOK_LPAREN;
@@ -167,6 +174,8 @@ void lexer_next(Lexer* lx){
             lx->cur.type = TOK_INSERT;
         } else if (strcmp(tmp, "INTO") == 0) {
             lx->cur.type = TOK_INTO;
+        } else if (strcmp(tmp, "VALUES") == 0) {
+            lx->cur.type = TOK_VALUES;
         } else if (strcmp(tmp, "UPDATE") == 0) {
             lx->cur.type = TOK_UPDATE;
         } else if (strcmp(tmp, "SET") == 0) {
@@ -207,6 +216,16 @@ void lexer_next(Lexer* lx){
             lx->cur.type = TOK_ASC;
         } else if (strcmp(tmp, "DESC") == 0) {
             lx->cur.type = TOK_DESC;
+        } else if (strcmp(tmp, "GROUP") == 0) {
+            lx->cur.type = TOK_GROUP;
+        } else if (strcmp(tmp, "HAVING") == 0) {
+            lx->cur.type = TOK_HAVING;
+        } else if (strcmp(tmp, "JOIN") == 0) {
+            lx->cur.type = TOK_JOIN;
+        } else if (strcmp(tmp, "INNER") == 0) {
+            lx->cur.type = TOK_INNER;
+        } else if (strcmp(tmp, "ON") == 0) {
+            lx->cur.type = TOK_ON;
         } else if (strcmp(tmp, "AS") == 0) {
             lx->cur.type = TOK_AS;
         } else if (strcmp(tmp,"DELETE") == 0){
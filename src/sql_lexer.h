@@ -10,6 +10,7 @@ typedef enum{
     TOK_STRING,
     TOK_COMMA,
     TOK_STAR,
+    TOK_PARAM,
     TOK_LPAREN,
     TOK_RPAREN,
     TOK_EQ,
@@ -30,6 +31,7 @@ typedef enum{
     TOK_WHERE,
     TOK_INSERT,
     TOK_INTO,
+    TOK_VALUES,
     TOK_UPDATE,
     TOK_SET,
     TOK_DELETE,
@@ -42,7 +44,12 @@ typedef enum{
     TOK_OFFSET,
     TOK_ASC,
     TOK_DESC,
-    TOK_AS
+    TOK_AS,
+    TOK_GROUP,
+    TOK_HAVING,
+    TOK_JOIN,
+    TOK_INNER,
+    TOK_ON
 } TokenType;
 
 typedef struct{
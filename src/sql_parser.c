@@ -4,14 +4,17 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 
 
 typedef struct{
     Lexer lx;
+    uint32_t n_params;  /* ? placeholders so far */
 } Parser;
 
 
 static void parser_init(Parser* p,const char* s){
+    p->n_params = 0;
     lexer_init(&p->lx,s);
     lexer_next(&p->lx);
 }
@@ -66,6 +69,63 @@ void expr_free(Expr* e){
 
 
 
+static const struct{
+    const char* name;
+    int agg;
+} agg_names[] = {
+    {"count",PARSED_AGG_COUNT},
+    {"sum",PARSED_AGG_SUM},
+    {"min",PARSED_AGG_MIN},
+    {"max",PARSED_AGG_MAX},
+    {"avg",PARSED_AGG_AVG},
+};
+
+int parsed_agg_from_name(const char* name){
+    for(size_t i = 0; i < sizeof(agg_names) / sizeof(agg_names[0]); i++){
+        if(strcasecmp(name,agg_names[i].name) == 0){
+            return agg_names[i].agg;
+        }
+    }
+    return PARSED_AGG_NONE;
+}
+
+/* Argument of an aggregate call after its name: "(col)", or "(*)" for
+ * COUNT, which leaves "*" in `arg` */
+static int parse_agg_arg(Lexer* lx,int agg,char* arg,size_t cap){
+    if(!accept(lx,TOK_LPAREN)){
+        return -1;
+    }
+    if(agg == PARSED_AGG_COUNT && accept(lx,TOK_STAR)){
+        strcpy(arg,"*");
+    } else if(lx->cur.type == TOK_IDENT){
+        strncpy(arg,lx->cur.text,cap - 1);
+        arg[cap - 1] = '\0';
+        lexer_next(lx);
+    } else {
+        return -1;
+    }
+    return accept(lx,TOK_RPAREN) ? 0 : -1;
+}
+
+/* Table name with an optional alias: "name [AS] alias" */
+static int parse_table_ref(Lexer* lx,char* name,char* alias){
+    if(lx->cur.type != TOK_IDENT){
+        return -1;
+    }
+    strncpy(name,lx->cur.text,PARSED_TABLE_NAME_LEN - 1);
+    name[PARSED_TABLE_NAME_LEN - 1] = '\0';
+    lexer_next(lx);
+    int as = accept(lx,TOK_AS);
+    if(lx->cur.type == TOK_IDENT){
+        strncpy(alias,lx->cur.text,PARSED_TABLE_NAME_LEN - 1);
+        alias[PARSED_TABLE_NAME_LEN - 1] = '\0';
+        lexer_next(lx);
+    } else if(as){
+        return -1;
+    }
+    return 0;
+}
+
 static Expr* parse_primary(Parser* p);
 static Expr* parse_unary(Parser* p);
 static Expr* parse_comparison(Parser* p);
@@ -81,6 +141,16 @@ static Expr* parse_primary(Parser* p){
         e->kind= EXPR_COLUMN;
         strncpy(e->text,lx->cur.text,sizeof(e->text)-1);
         lexer_next(lx);
+        /* Aggregate call, as in HAVING */
+        int agg = lx->cur.type == TOK_LPAREN ? parsed_agg_from_name(e->text) : PARSED_AGG_NONE;
+        if(agg != PARSED_AGG_NONE){
+            e->kind = EXPR_AGG;
+            strncpy(e->op,e->text,sizeof(e->op) - 1);
+            if(parse_agg_arg(lx,agg,e->text,sizeof(e->text)) != 0){
+                expr_free(e);
+                return NULL;
+            }
+        }
         return e;
     }
 
@@ -92,9 +162,21 @@ static Expr* parse_primary(Parser* p){
         return e;
     }
 
+    /* A literal whose text is bound before each execution */
+    if(lx->cur.type == TOK_PARAM){
+        Expr* e = expr_new();
+        e->kind = EXPR_LITERAL;
+        e->param = ++p->n_params;
+        lexer_next(lx);
+        return e;
+    }
+
     if(accept(lx,TOK_LPAREN)){
         Expr* inner = parse_expr(p);
-        accept(lx,TOK_RPAREN);
+        if(inner && !accept(lx,TOK_RPAREN)){
+            expr_free(inner);
+            return NULL;
+        }
         return inner;
     }
 
@@ -106,6 +188,9 @@ static Expr* parse_unary(Parser* p){
     Lexer* lx = &p->lx;
     if(accept(lx,TOK_NOT)){
         Expr* operand = parse_unary(p);
+        if(!operand){
+            return NULL;
+        }
         Expr* e = expr_new();
         e->kind = EXPR_UNARY;
         strncpy(e->op,"NOT",sizeof(e->op)-1);
@@ -134,6 +219,10 @@ static Expr* parse_comparison(Parser* p){
         e->left = left;
         lexer_next(lx);
         e->right = parse_unary(p);
+        if(!e->right){
+            expr_free(e);
+            return NULL;
+        }
         return e;
     }
 
@@ -154,14 +243,21 @@ static Expr* parse_comparison(Parser* p){
             }
             return e;
         }
+        /* IS must be followed by [NOT] NULL */
+        expr_free(left);
+        return NULL;
     }
 
 
     if(lx->cur.type == TOK_BETWEEN){
         lexer_next(lx);
         Expr* low = parse_primary(p);
-        accept(lx,TOK_AND);
-        Expr* high = parse_primary(p);
+        Expr* high = low && accept(lx,TOK_AND) ? parse_primary(p) : NULL;
+        if(!high){
+            expr_free(left);
+            expr_free(low);
+            return NULL;
+        }
         Expr* e = expr_new();
         e->kind = EXPR_BETWEEN;
         e->left = left;
@@ -175,38 +271,64 @@ static Expr* parse_comparison(Parser* p){
 
     if(lx->cur.type == TOK_IN){
         lexer_next(lx);
-        if(accept(lx,TOK_LPAREN)){
-            Expr* e = expr_new();
-            e->kind = EXPR_IN;
-            e->left = left;
-            Expr** items = (Expr**) malloc(sizeof(Expr*)*16);
-            uint32_t n = 0;
-            while(1){
-                Expr* it = parse_primary(p);
-                if(!it){
+        if(!accept(lx,TOK_LPAREN)){
+            expr_free(left);
+            return NULL;
+        }
+        Expr* e = expr_new();
+        e->kind = EXPR_IN;
+        e->left = left;
+        Expr** items = NULL;
+        uint32_t n = 0;
+        uint32_t cap = 0;
+        int complete = 1;
+        while(1){
+            Expr* it = parse_primary(p);
+            if(!it){
+                /* Only an empty list may have no items */
+                complete = n == 0;
+                break;
+            }
+            if(n == cap){
+                uint32_t new_cap = cap ? cap * 2 : 16;
+                Expr** grown = (Expr**) realloc(items,sizeof(Expr*)*new_cap);
+                if(!grown){
+                    expr_free(it);
+                    complete = 0;
                     break;
                 }
-                items[n++] = it;
-                if(accept(lx,TOK_COMMA)){
-                    continue;
-                }
-                break;
+                items = grown;
+                cap = new_cap;
             }
-            accept(lx,TOK_RPAREN);
-            e->items = items;
-            e->n_items = n;
-            return e;
+            items[n++] = it;
+            if(accept(lx,TOK_COMMA)){
+                continue;
+            }
+            break;
+        }
+        e->items = items;
+        e->n_items = n;
+        if(!complete || !accept(lx,TOK_RPAREN)){
+            expr_free(e);
+            return NULL;
         }
+        return e;
     }
     return left;
 }
 
+/* A missing operand on either side of AND or OR fails the whole
+ * expression: a node with a NULL operand would pass every row */
 static Expr* parse_and(Parser* p){
     Expr* left = parse_comparison(p);
     Lexer* lx = &p->lx;
-    while(lx->cur.type == TOK_AND){
+    while(left && lx->cur.type == TOK_AND){
         lexer_next(lx);
         Expr* right = parse_comparison(p);
+        if(!right){
+            expr_free(left);
+            return NULL;
+        }
         Expr* e = expr_new();
         e->kind = EXPR_BINARY;
         strncpy(e->op,"AND",sizeof(e->op) - 1);
@@ -221,9 +343,13 @@ static Expr* parse_and(Parser* p){
 static Expr* parse_expr(Parser* p){
     Expr* left = parse_and(p);
     Lexer* lx = &p->lx;
-    while(lx->cur.type == TOK_OR){
+    while(left && lx->cur.type == TOK_OR){
         lexer_next(lx);
         Expr* right = parse_and(p);
+        if(!right){
+            expr_free(left);
+            return NULL;
+        }
         Expr* e = expr_new();
         e->kind = EXPR_BINARY;
         strncpy(e->op,"OR",sizeof(e->op) - 1);
@@ -250,15 +376,31 @@ static int parse_select(Parser* p,ParsedStmt* out){
         lexer_next(lx);
     }else{
         while(lx->cur.type == TOK_IDENT){
+            char name[PARSED_MAX_PROJ_NAME_LEN];
+            strncpy(name, lx->cur.text, PARSED_MAX_PROJ_NAME_LEN - 1);
+            name[PARSED_MAX_PROJ_NAME_LEN - 1] = '\0';
+            lexer_next(lx);
+
+            /* FUNC(col), or COUNT(*) */
+            int agg = PARSED_AGG_NONE;
+            if(lx->cur.type == TOK_LPAREN){
+                agg = parsed_agg_from_name(name);
+                if(agg == PARSED_AGG_NONE || parse_agg_arg(lx,agg,name,sizeof(name)) != 0){
+                    return -1;
+                }
+            }
             if(out->proj_count < PARSED_MAX_PROJ){
-                strncpy(out->proj_list[out->proj_count], lx->cur.text, PARSED_MAX_PROJ_NAME_LEN - 1);
-                out->proj_list[out->proj_count][PARSED_MAX_PROJ_NAME_LEN - 1] = '\0';
+                strcpy(out->proj_list[out->proj_count], name);
+                out->proj_agg[out->proj_count] = agg;
                 out->proj_count++;
             }
-            lexer_next(lx);
             if(!accept(lx,TOK_COMMA)){
                 break;
             }
+            /* Another item must follow the comma */
+            if(lx->cur.type != TOK_IDENT){
+                return -1;
+            }
         }
     }
 
@@ -268,34 +410,80 @@ static int parse_select(Parser* p,ParsedStmt* out){
         return -1;
     }
 
-    if(lx->cur.type != TOK_IDENT){
+    if(parse_table_ref(lx,out->table_name,out->table_alias) != 0){
         return -1;
     }
 
-    strncpy(out->table_name, lx->cur.text, PARSED_TABLE_NAME_LEN - 1);
-    out->table_name[PARSED_TABLE_NAME_LEN - 1] = '\0';
-    lexer_next(lx);
+    /* One equi-join: JOIN t2 ON a.x = b.y */
+    int inner = accept(lx,TOK_INNER);
+    if(accept(lx,TOK_JOIN)){
+        if(parse_table_ref(lx,out->join_table,out->join_alias) != 0 || !accept(lx,TOK_ON)){
+            return -1;
+        }
+        for(int side = 0; side < 2; side++){
+            if(lx->cur.type != TOK_IDENT){
+                return -1;
+            }
+            strncpy(out->join_on[side],lx->cur.text,PARSED_MAX_PROJ_NAME_LEN - 1);
+            out->join_on[side][PARSED_MAX_PROJ_NAME_LEN - 1] = '\0';
+            lexer_next(lx);
+            if(side == 0 && !accept(lx,TOK_EQ)){
+                return -1;
+            }
+        }
+        out->has_join = 1;
+    } else if(inner){
+        return -1;
+    }
 
     if(accept(lx,TOK_WHERE)){
         out->where = parse_expr(p);
+        if(!out->where){
+            return -1;
+        }
     }
 
-    if(accept(lx,TOK_ORDER)){
+    if(accept(lx,TOK_GROUP)){
         if(!accept(lx,TOK_BY)){
             return -1;
         }
-        if(lx->cur.type != TOK_IDENT){
+        do{
+            if(lx->cur.type != TOK_IDENT || out->group_count >= PARSED_MAX_GROUP_BY){
+                return -1;
+            }
+            uint32_t i = out->group_count++;
+            strncpy(out->group_by[i],lx->cur.text,PARSED_MAX_PROJ_NAME_LEN-1);
+            out->group_by[i][PARSED_MAX_PROJ_NAME_LEN-1] = '\0';
+            lexer_next(lx);
+        }while(accept(lx,TOK_COMMA));
+    }
+
+    if(accept(lx,TOK_HAVING)){
+        out->having = parse_expr(p);
+        if(!out->having){
             return -1;
         }
-        strncpy(out->order_by,lx->cur.text,PARSED_MAX_PROJ_NAME_LEN-1);
-        out->order_by[PARSED_MAX_PROJ_NAME_LEN-1] = '\0';
-        lexer_next(lx);
-        out->order_desc = 0;
-        if(accept(lx,TOK_DESC)){
-            out->order_desc = 1;
-        } else {
-            accept(lx,TOK_ASC);
+    }
+
+    if(accept(lx,TOK_ORDER)){
+        if(!accept(lx,TOK_BY)){
+            return -1;
         }
+        do{
+            if(lx->cur.type != TOK_IDENT || out->order_count >= PARSED_MAX_ORDER_BY){
+                return -1;
+            }
+            uint32_t i = out->order_count++;
+            strncpy(out->order_by[i],lx->cur.text,PARSED_MAX_PROJ_NAME_LEN-1);
+            out->order_by[i][PARSED_MAX_PROJ_NAME_LEN-1] = '\0';
+            lexer_next(lx);
+            out->order_desc[i] = 0;
+            if(accept(lx,TOK_DESC)){
+                out->order_desc[i] = 1;
+            } else {
+                accept(lx,TOK_ASC);
+            }
+        }while(accept(lx,TOK_COMMA));
     }
 
 
@@ -321,6 +509,14 @@ static int parse_select(Parser* p,ParsedStmt* out){
         out->has_offset = 0;
     }
 
+    /* Anything left over is a clause this parser does not know, e.g. LIKE */
+    if(lx->cur.type == TOK_ILLEGAL && lx->cur.text[0] == ';'){
+        lexer_next(lx);
+    }
+    if(lx->cur.type != TOK_EOF){
+        return -1;
+    }
+
     return 0;
 }
 
@@ -343,16 +539,147 @@ static int parse_delete(Parser* p, ParsedStmt* out){
         out->table_name[0] = '\0';
     }
 
+    out->where = NULL;
     if(accept(lx,TOK_WHERE)){
         out->where = parse_expr(p);
-    } else {
-        out->where = NULL;
+        if(!out->where){
+            return -1;
+        }
+    }
+    /* Anything left over would widen the delete, e.g. a misspelled WHERE */
+    if(lx->cur.type == TOK_ILLEGAL && lx->cur.text[0] == ';'){
+        lexer_next(lx);
+    }
+    if(lx->cur.type != TOK_EOF){
+        return -1;
     }
 
     out->kind = PARSED_DELETE;
     return 0;
 }
 
+static int parse_update(Parser* p, ParsedStmt* out){
+    Lexer* lx = &p->lx;
+    lexer_next(lx);
+
+    if(lx->cur.type != TOK_IDENT){
+        return -1;
+    }
+    strncpy(out->table_name,lx->cur.text,PARSED_TABLE_NAME_LEN-1);
+    out->table_name[PARSED_TABLE_NAME_LEN-1] = '\0';
+    lexer_next(lx);
+
+    if(!accept(lx,TOK_SET)){
+        return -1;
+    }
+    do{
+        if(lx->cur.type != TOK_IDENT || out->set_count >= PARSED_MAX_SET){
+            return -1;
+        }
+        uint32_t i = out->set_count;
+        strncpy(out->set_cols[i],lx->cur.text,PARSED_MAX_PROJ_NAME_LEN-1);
+        out->set_cols[i][PARSED_MAX_PROJ_NAME_LEN-1] = '\0';
+        lexer_next(lx);
+        if(!accept(lx,TOK_EQ)){
+            return -1;
+        }
+        /* A literal; bare words are strings, as in WHERE */
+        if(lx->cur.type == TOK_PARAM){
+            out->set_param[i] = ++p->n_params;
+        } else if(lx->cur.type != TOK_NUMBER && lx->cur.type != TOK_STRING && lx->cur.type != TOK_IDENT){
+            return -1;
+        }
+        strncpy(out->set_values[i],lx->cur.text,PARSED_MAX_VALUE_LEN-1);
+        out->set_values[i][PARSED_MAX_VALUE_LEN-1] = '\0';
+        lexer_next(lx);
+        out->set_count++;
+    }while(accept(lx,TOK_COMMA));
+
+    if(accept(lx,TOK_WHERE)){
+        out->where = parse_expr(p);
+        if(!out->where){
+            return -1;
+        }
+    }
+    /* Anything left over would widen the update, e.g. a misspelled WHERE */
+    if(lx->cur.type == TOK_ILLEGAL && lx->cur.text[0] == ';'){
+        lexer_next(lx);
+    }
+    if(lx->cur.type != TOK_EOF){
+        return -1;
+    }
+
+    out->kind = PARSED_UPDATE;
+    return 0;
+}
+
+static int parse_insert(Parser* p, ParsedStmt* out){
+    Lexer* lx = &p->lx;
+    lexer_next(lx);
+
+    if(!accept(lx,TOK_INTO) || lx->cur.type != TOK_IDENT){
+        return -1;
+    }
+    strncpy(out->insert_table,lx->cur.text,PARSED_TABLE_NAME_LEN-1);
+    out->insert_table[PARSED_TABLE_NAME_LEN-1] = '\0';
+    lexer_next(lx);
+
+    if(!accept(lx,TOK_VALUES)){
+        return -1;
+    }
+    uint32_t cap = 0;
+    do{
+        if(!accept(lx,TOK_LPAREN)){
+            return -1;
+        }
+        uint32_t row_len = 0;
+        do{
+            /* A literal; bare words are strings, as in WHERE */
+            if(lx->cur.type != TOK_NUMBER && lx->cur.type != TOK_STRING && lx->cur.type != TOK_IDENT &&
+               lx->cur.type != TOK_PARAM){
+                return -1;
+            }
+            if(out->insert_n == cap){
+                uint32_t new_cap = cap ? cap * 2 : 16;
+                char** grown = (char**) realloc(out->insert_value,new_cap * sizeof(char*));
+                if(!grown){
+                    return -1;
+                }
+                out->insert_value = grown;
+                cap = new_cap;
+            }
+            char* v = NULL;
+            if(lx->cur.type == TOK_PARAM){
+                p->n_params++;
+            } else if((v = strdup(lx->cur.text)) == NULL){
+                return -1;
+            }
+            out->insert_value[out->insert_n++] = v;
+            row_len++;
+            lexer_next(lx);
+        }while(accept(lx,TOK_COMMA));
+        if(!accept(lx,TOK_RPAREN)){
+            return -1;
+        }
+        /* Every row has as many values as the first */
+        if(out->insert_row_len == 0){
+            out->insert_row_len = row_len;
+        } else if(row_len != out->insert_row_len){
+            return -1;
+        }
+    }while(accept(lx,TOK_COMMA));
+
+    if(lx->cur.type == TOK_ILLEGAL && lx->cur.text[0] == ';'){
+        lexer_next(lx);
+    }
+    if(lx->cur.type != TOK_EOF){
+        return -1;
+    }
+
+    out->kind = PARSED_INSERT;
+    return 0;
+}
+
 
 void parsed_stmt_free(ParsedStmt* ps){
     if(!ps){
@@ -362,6 +689,10 @@ void parsed_stmt_free(ParsedStmt* ps){
         expr_free(ps->where);
         ps->where = NULL;
     }
+    if(ps->having){
+        expr_free(ps->having);
+        ps->having = NULL;
+    }
     if(ps->insert_value){
         for(uint32_t i = 0 ; i < ps->insert_n ; i++){
             free(ps->insert_value[i]);
@@ -382,16 +713,38 @@ int parse_sql_to_parsed_stmt(const char* sql, ParsedStmt* out) {
     /* Only implement SELECT for now */
     if (p.lx.cur.type == TOK_SELECT) {
         int ret = parse_select(&p, out);
-        if (ret != 0) return -1;
+        if (ret != 0) {
+            parsed_stmt_free(out);
+            return -1;
+        }
         out->kind = PARSED_SELECT;
+        out->param_count = p.n_params;
+        return 0;
+    }
+    if(p.lx.cur.type == TOK_INSERT){
+        if(parse_insert(&p,out) != 0){
+            parsed_stmt_free(out);
+            return -1;
+        }
+        out->param_count = p.n_params;
+        return 0;
+    }
+    if(p.lx.cur.type == TOK_UPDATE){
+        if(parse_update(&p,out) != 0){
+            parsed_stmt_free(out);
+            return -1;
+        }
+        out->param_count = p.n_params;
         return 0;
     }
     if(p.lx.cur.type == TOK_DELETE){
         int ret = parse_delete(&p,out);
         if(ret != 0){
+            parsed_stmt_free(out);
             return -1;
         }
         out->kind = PARSED_DELETE;
+        out->param_count = p.n_params;
         return 0;
     }
 
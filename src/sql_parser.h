@@ -8,6 +8,20 @@
 
 #define PARSED_MAX_PROJ 16
 #define PARSED_MAX_PROJ_NAME_LEN 64
+#define PARSED_MAX_ORDER_BY 8
+#define PARSED_MAX_GROUP_BY 8
+#define PARSED_MAX_SET 16
+#define PARSED_MAX_VALUE_LEN 256
+
+/* Aggregate wrapped around a projection item */
+typedef enum{
+    PARSED_AGG_NONE,
+    PARSED_AGG_COUNT,
+    PARSED_AGG_SUM,
+    PARSED_AGG_MIN,
+    PARSED_AGG_MAX,
+    PARSED_AGG_AVG
+} ParsedAgg;
 
 typedef enum{
     PARSED_SELECT,
@@ -23,26 +37,52 @@ typedef struct{
     ParsedKind kind;
     char table_name[PARSED_TABLE_NAME_LEN];
     char proj_list[PARSED_MAX_PROJ][PARSED_MAX_PROJ_NAME_LEN];
+    int proj_agg[PARSED_MAX_PROJ]; /* ParsedAgg; the name is "*" for COUNT(*) */
     uint32_t proj_count;
     int select_all;
     Expr* where;
 
 
+    /* INSERT INTO <insert_table> VALUES (...), (...): insert_n values,
+     * row after row, insert_row_len per row */
     char insert_table[PARSED_TABLE_NAME_LEN];
     char** insert_value;
     uint32_t insert_n;
+    uint32_t insert_row_len;
 
     uint32_t limit;
     int has_limit;
     uint32_t offset;
     int has_offset;
-    char order_by[PARSED_MAX_PROJ_NAME_LEN];
-    int order_desc;
+    char order_by[PARSED_MAX_ORDER_BY][PARSED_MAX_PROJ_NAME_LEN];
+    int order_desc[PARSED_MAX_ORDER_BY];
+    uint32_t order_count;
+    char group_by[PARSED_MAX_GROUP_BY][PARSED_MAX_PROJ_NAME_LEN];
+    uint32_t group_count;
+    Expr* having;
     char table_alias[PARSED_TABLE_NAME_LEN];
 
+    /* FROM ... [INNER] JOIN <join_table> [alias] ON <join_on[0]> = <join_on[1]> */
+    int has_join;
+    char join_table[PARSED_TABLE_NAME_LEN];
+    char join_alias[PARSED_TABLE_NAME_LEN];
+    char join_on[2][PARSED_MAX_PROJ_NAME_LEN];
+
+    /* UPDATE <table_name> SET <set_cols[i]> = <set_values[i]>, ... [WHERE ...] */
+    char set_cols[PARSED_MAX_SET][PARSED_MAX_PROJ_NAME_LEN];
+    char set_values[PARSED_MAX_SET][PARSED_MAX_VALUE_LEN];
+    uint32_t set_param[PARSED_MAX_SET]; /* ? number of a SET value, 0 for a literal */
+    uint32_t set_count;
+
+    /* ? placeholders, numbered from 1 in statement order. A placeholder in
+     * VALUES leaves a NULL in insert_value; the k-th NULL is number k. */
+    uint32_t param_count;
+
 } ParsedStmt;
 
 int parse_sql_to_parsed_stmt(const char* sql,ParsedStmt* out);
+/* ParsedAgg of an aggregate function name, PARSED_AGG_NONE if it is not one */
+int parsed_agg_from_name(const char* name);
 void parsed_stmt_free(ParsedStmt* ps);
 
 
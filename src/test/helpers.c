@@ -0,0 +1,113 @@
+#include "helpers.h"
+#include "../include/schema.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+
+void test_table_init(Table* t, const char* columns) {
+    memset(t, 0, sizeof(*t));
+    TableSchema* s = &t->active_schema;
+    const char* p = columns;
+    while (*p) {
+        assert(s->num_columns < MAX_COLUMNS);
+        ColumnDef* c = &s->columns[s->num_columns++];
+        char type[16];
+        int used = 0;
+        assert(sscanf(p, " %31[^ ] %15[a-z]%n", c->name, type, &used) == 2);
+        p += used;
+        c->type = parse_column_type(type);
+        c->size = c->type == COL_TYPE_TIMESTAMP ? 8 : 4;
+        if (c->type == COL_TYPE_STRING) {
+            assert(sscanf(p, "(%u)%n", &c->size, &used) == 1);
+            p += used;
+        }
+        while (*p == ',' || *p == ' ') {
+            p++;
+        }
+    }
+    t->row_size = compute_row_size(s);
+}
+
+void test_make_row(const Table* t, uint8_t* row, ...) {
+    const TableSchema* s = &t->active_schema;
+    memset(row, 0, t->row_size);
+    va_list ap;
+    va_start(ap, row);
+    for (uint32_t c = 0; c < s->num_columns; c++) {
+        uint8_t* field = row + schema_col_offset(s, (int)c);
+        if (s->columns[c].type == COL_TYPE_STRING) {
+            const char* v = va_arg(ap, const char*);
+            memcpy(field, v, strlen(v));
+        } else if (s->columns[c].type == COL_TYPE_TIMESTAMP) {
+            int64_t v = va_arg(ap, int64_t);
+            memcpy(field, &v, 8);
+        } else {
+            int32_t v = (int32_t)va_arg(ap, int64_t);
+            memcpy(field, &v, 4);
+        }
+    }
+    va_end(ap);
+}
+
+MYDB_Handle test_open_db(char* path) {
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+    MYDB_Handle h = mydb_open(path);
+    assert(h != NULL);
+    return h;
+}
+
+void test_close_db(MYDB_Handle h, const char* path) {
+    mydb_close(h);
+    unlink(path);
+}
+
+char* test_json(MYDB_Handle h, const char* sql) {
+    char* out = NULL;
+    assert(mydb_execute_json(h, sql, &out) == 0);
+    assert(strstr(out, "\"ok\":true") != NULL);
+    return out;
+}
+
+void test_run(MYDB_Handle h, const char* sql) {
+    free(test_json(h, sql));
+}
+
+void test_expect(MYDB_Handle h, const char* sql, const char* want) {
+    char* out = test_json(h, sql);
+    if (strcmp(out, want) != 0) {
+        fprintf(stderr, "%s\n  got:  %s\n  want: %s\n", sql, out, want);
+        assert(0);
+    }
+    free(out);
+}
+
+void test_expect_part(MYDB_Handle h, const char* sql, const char* part) {
+    char* out = test_json(h, sql);
+    if (strstr(out, part) == NULL) {
+        fprintf(stderr, "%s\n  got:  %s\n  want: ...%s...\n", sql, out, part);
+        assert(0);
+    }
+    free(out);
+}
+
+void test_expect_error(MYDB_Handle h, const char* sql) {
+    char* out = NULL;
+    int rc = mydb_execute_json(h, sql, &out);
+    assert(rc != 0 || strstr(out, "\"ok\":false") != NULL);
+    free(out);
+}
+
+uint64_t test_step_page_hits(const char* json, const char* op) {
+    char key[64];
+    snprintf(key, sizeof(key), "\"op\":\"%s\"", op);
+    const char* step = strstr(json, key);
+    assert(step != NULL);
+    const char* hits = strstr(step, "\"page_hits\":");
+    assert(hits != NULL);
+    return strtoull(hits + strlen("\"page_hits\":"), NULL, 10);
+}
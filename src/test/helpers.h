@@ -0,0 +1,37 @@
+#ifndef MYDB_TEST_HELPERS_H
+#define MYDB_TEST_HELPERS_H
+
+/* Fixtures shared by the unit tests, linked into every test binary */
+
+#include <stdint.h>
+#include "../include/btree.h"
+#include "../include/mydb.h"
+
+/* A table with no pager, for testing modules that only read its schema:
+ * `columns` is "name type, ...", type being int, timestamp or
+ * string(size), e.g. "id int, name string(8)" */
+void test_table_init(Table* t, const char* columns);
+/* Fill `row` with one value per column of `t`, in order: an int64_t for
+ * int and timestamp columns, a const char* for strings */
+void test_make_row(const Table* t, uint8_t* row, ...);
+
+/* A new database in a temp file; `path` is a mkstemp template and holds
+ * the name afterwards */
+MYDB_Handle test_open_db(char* path);
+/* Close it and remove the file */
+void test_close_db(MYDB_Handle h, const char* path);
+
+/* JSON result of `sql`, which must run with "ok":true; caller frees */
+char* test_json(MYDB_Handle h, const char* sql);
+void test_run(MYDB_Handle h, const char* sql);
+/* `sql` must return exactly `want` */
+void test_expect(MYDB_Handle h, const char* sql, const char* want);
+/* `sql` must return something containing `part` */
+void test_expect_part(MYDB_Handle h, const char* sql, const char* part);
+/* `sql` must be rejected: fail to prepare, or return "ok":false */
+void test_expect_error(MYDB_Handle h, const char* sql);
+
+/* Page hits of the first `op` step in an EXPLAIN ANALYZE result */
+uint64_t test_step_page_hits(const char* json, const char* op);
+
+#endif /* MYDB_TEST_HELPERS_H */
@@ -0,0 +1,176 @@
+#include "../include/aggregate.h"
+#include "../sql_parser.h"
+#include "helpers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+static Table table;
+
+void test_aggregate_numeric() {
+    printf("Running test_aggregate_numeric...\n");
+
+    AggSpec specs[] = {
+        { AGG_COUNT, -1 }, { AGG_SUM, 0 }, { AGG_AVG, 0 },
+        { AGG_MIN, 0 }, { AGG_MAX, 0 }, { AGG_MIN, 2 }, { AGG_MAX, 2 },
+    };
+    AggPlan plan;
+    agg_plan_init(&plan, &table, specs, 7);
+    assert(strcmp(plan.labels[0], "count(*)") == 0);
+    assert(strcmp(plan.labels[2], "avg(id)") == 0);
+
+    uint8_t* state = malloc(plan.state_size);
+    agg_init(&plan, state);
+    uint8_t row[64];
+    int32_t ids[] = { 7, -3, 12, 0, -3 };
+    int64_t ts[] = { 5000000000LL, -1, INT64_MAX, INT64_MIN, 0 };
+    for (int i = 0; i < 5; i++) {
+        test_make_row(&table, row, (int64_t)ids[i], "x", ts[i]);
+        agg_update(&plan, state, row);
+    }
+
+    AggValue v;
+    agg_value(&plan, state, 0, &v);
+    assert(v.kind == AGG_VALUE_INT && v.i == 5);
+    agg_value(&plan, state, 1, &v);
+    assert(v.kind == AGG_VALUE_INT && v.i == 13);
+    agg_value(&plan, state, 2, &v);
+    assert(v.kind == AGG_VALUE_DOUBLE && v.d == 2.6);
+    agg_value(&plan, state, 3, &v);
+    assert(v.i == -3);
+    agg_value(&plan, state, 4, &v);
+    assert(v.i == 12);
+    agg_value(&plan, state, 5, &v);
+    assert(v.i == INT64_MIN);
+    agg_value(&plan, state, 6, &v);
+    assert(v.i == INT64_MAX);
+
+    // A row folded in n times counts n times in COUNT and SUM
+    test_make_row(&table, row, (int64_t)10, "x", (int64_t)0);
+    agg_add_rows(&plan, state, 0, row, 1000);
+    agg_add_rows(&plan, state, 1, row, 1000);
+    agg_value(&plan, state, 0, &v);
+    assert(v.i == 1005);
+    agg_value(&plan, state, 1, &v);
+    assert(v.i == 10013);
+
+    free(state);
+    printf("  ✓ test_aggregate_numeric passed\n");
+}
+
+void test_aggregate_string() {
+    printf("Running test_aggregate_string...\n");
+
+    AggSpec specs[] = { { AGG_MIN, 1 }, { AGG_MAX, 1 }, { AGG_COUNT, 1 } };
+    AggPlan plan;
+    agg_plan_init(&plan, &table, specs, 3);
+    assert(strcmp(plan.labels[1], "max(name)") == 0);
+
+    uint8_t* state = malloc(plan.state_size);
+    agg_init(&plan, state);
+    uint8_t row[64];
+    // A prefix sorts first; a name filling the column has no NUL
+    const char* names[] = { "bob", "abcdefgh", "ab", "zz", "b" };
+    for (int i = 0; i < 5; i++) {
+        test_make_row(&table, row, (int64_t)i, names[i], (int64_t)0);
+        agg_update(&plan, state, row);
+    }
+
+    AggValue v;
+    agg_value(&plan, state, 0, &v);
+    assert(v.kind == AGG_VALUE_STRING && v.len == 2 && memcmp(v.str, "ab", 2) == 0);
+    agg_value(&plan, state, 1, &v);
+    assert(v.kind == AGG_VALUE_STRING && v.len == 2 && memcmp(v.str, "zz", 2) == 0);
+    agg_value(&plan, state, 2, &v);
+    assert(v.i == 5);
+
+    agg_init(&plan, state);
+    test_make_row(&table, row, (int64_t)0, "abcdefgh", (int64_t)0);
+    agg_update(&plan, state, row);
+    agg_value(&plan, state, 1, &v);
+    assert(v.len == 8 && memcmp(v.str, "abcdefgh", 8) == 0);
+
+    free(state);
+    printf("  ✓ test_aggregate_string passed\n");
+}
+
+void test_aggregate_empty() {
+    printf("Running test_aggregate_empty...\n");
+
+    // Over no rows COUNT is 0 and everything else is NULL
+    AggSpec specs[] = { { AGG_COUNT, -1 }, { AGG_SUM, 0 }, { AGG_AVG, 0 }, { AGG_MIN, 1 } };
+    AggPlan plan;
+    agg_plan_init(&plan, &table, specs, 4);
+    uint8_t* state = malloc(plan.state_size);
+    agg_init(&plan, state);
+
+    AggValue v;
+    agg_value(&plan, state, 0, &v);
+    assert(v.kind == AGG_VALUE_INT && v.i == 0);
+    for (uint32_t i = 1; i < 4; i++) {
+        agg_value(&plan, state, i, &v);
+        assert(v.kind == AGG_VALUE_NULL);
+    }
+
+    free(state);
+    printf("  ✓ test_aggregate_empty passed\n");
+}
+
+void test_aggregate_select_list() {
+    printf("Running test_aggregate_select_list...\n");
+
+    ParsedStmt ps;
+    assert(parse_sql_to_parsed_stmt("select count(*), sum(id), name from t", &ps) == 0);
+    assert(ps.proj_count == 3 && ps.proj_agg[0] == PARSED_AGG_COUNT && ps.proj_agg[2] == PARSED_AGG_NONE);
+    parsed_stmt_free(&ps);
+
+    // A comma must be followed by another item
+    const char* bad[] = {
+        "select count(*), from t", "select id, from t", "select id,, name from t",
+        "select count(id from t", "select nope(id) from t", "select count() from t",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        assert(parse_sql_to_parsed_stmt(bad[i], &ps) != 0);
+        parsed_stmt_free(&ps);
+    }
+
+    printf("  ✓ test_aggregate_select_list passed\n");
+}
+
+void test_aggregate_sql() {
+    printf("Running test_aggregate_sql...\n");
+
+    char path[] = "/tmp/test_aggregate_XXXXXX";
+    MYDB_Handle h = test_open_db(path);
+    test_run(h, "create table t (id int, v int, ts timestamp)");
+    test_run(h, "use t");
+    test_run(h, "insert into t values (1, 10, 5000000000), (2, -4, -1), (3, 0, 7)");
+
+    // Every aggregate is named func(arg), COUNT(*) included
+    test_expect(h, "select count(*), count(v), sum(v), avg(v), min(ts), max(ts) from t",
+                "{\"ok\":true,\"rows\":[{\"count(*)\":3,\"count(v)\":3,\"sum(v)\":6,"
+                "\"avg(v)\":2,\"min(ts)\":-1,\"max(ts)\":5000000000}]}");
+
+    // SUM/AVG take int columns only; a sum of timestamps could overflow
+    test_expect_error(h, "select sum(ts) from t");
+    test_expect_error(h, "select avg(ts) from t");
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_aggregate_sql passed\n");
+}
+
+int main() {
+    printf("\n=== Running Aggregate Tests ===\n\n");
+
+    test_table_init(&table, "id int, name string(8), ts timestamp");
+    test_aggregate_numeric();
+    test_aggregate_string();
+    test_aggregate_empty();
+    test_aggregate_select_list();
+    test_aggregate_sql();
+
+    printf("\n=== All Aggregate Tests Passed ===\n\n");
+    return 0;
+}
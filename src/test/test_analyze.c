@@ -0,0 +1,196 @@
+#include "../include/analyze.h"
+#include "../include/sql_executor.h"
+#include "helpers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// Rows id = 0..n-1 with v = id % mod and ts = id * 10, in one INSERT;
+// with `names`, also name = 'n' followed by id % 7
+static void fill(MYDB_Handle h, const char* table, int n, int mod, bool names) {
+    char* sql = malloc(64 + (size_t)n * 48);
+    assert(sql);
+    size_t len = (size_t)sprintf(sql, "insert into %s values ", table);
+    for (int i = 0; i < n; i++) {
+        len += (size_t)sprintf(sql + len, "%s(%d, %d, %d", i ? ", " : "", i, i % mod, i * 10);
+        len += (size_t)(names ? sprintf(sql + len, ", 'n%d')", i % 7) : sprintf(sql + len, ")"));
+    }
+    test_run(h, sql);
+    free(sql);
+}
+
+static MYDB_Handle open_db(char* path) {
+    MYDB_Handle h = test_open_db(path);
+    test_run(h, "create table t (id int, v int, ts timestamp)");
+    test_run(h, "create table small (id int, v int, ts timestamp, name string)");
+    test_run(h, "use t");
+    fill(h, "t", 4000, 100, false);
+    test_run(h, "use small");
+    fill(h, "small", 20, 100, true);
+    test_run(h, "use t");
+    return h;
+}
+
+void test_analyze_collects() {
+    printf("Running test_analyze_collects...\n");
+
+    char path[] = "/tmp/test_analyze_XXXXXX";
+    MYDB_Handle h = open_db(path);
+    Table* t = (Table*)h;
+    assert(analyze_stats(t) == NULL);
+
+    uint32_t version = t->catalog_version;
+    test_run(h, "analyze t");
+    assert(t->catalog_version == version + 1);
+    const TableStats* s = analyze_stats(t);
+    assert(s && s->row_count == 4000 && s->num_columns == 3);
+    assert(s->height > 1 && s->leaf_count > 1);
+    // Distinct counts are exact below the sketch size, close above it
+    assert(s->distinct[1] == 100);
+    assert(s->distinct[0] > 3800 && s->distinct[0] <= 4000);
+
+    // Histograms for every int and timestamp column, ends exact
+    assert(s->num_histograms == 3);
+    const ColumnHistogram* ts = analyze_histogram(s, 2);
+    assert(ts && ts->buckets == ANALYZE_HISTOGRAM_BUCKETS);
+    assert(ts->bounds[0] == 0 && ts->bounds[ANALYZE_HISTOGRAM_BUCKETS] == 39990);
+    for (uint32_t i = 0; i < ts->buckets; i++) {
+        assert(ts->bounds[i] <= ts->bounds[i + 1]);
+    }
+
+    // Without a name every table is analyzed; the active table stays
+    test_run(h, "analyze");
+    assert(analyze_stats(t) == s);
+    test_run(h, "use small");
+    s = analyze_stats(t);
+    assert(s && s->row_count == 20 && s->distinct[3] == 7);
+    // Strings get a distinct count but no histogram
+    assert(s->num_histograms == 3 && analyze_histogram(s, 3) == NULL);
+    test_run(h, "use t");
+
+    // An unknown table is an error of the statement, not of its syntax
+    const char* missing[] = { "analyze nosuch", "analyze nosuch;" };
+    for (int i = 0; i < 2; i++) {
+        char* out = NULL;
+        assert(mydb_execute_json(h, missing[i], &out) == 0);
+        assert(strcmp(out, "{\"ok\":false,\"error\":\"table_not_found\"}") == 0);
+        free(out);
+    }
+    test_expect_part(h, "select count(*) from t", "\"count(*)\":4000");
+
+    // The statistics persist with the file
+    mydb_close(h);
+    h = mydb_open(path);
+    t = (Table*)h;
+    test_run(h, "use t");
+    assert(analyze_stats(t) && analyze_stats(t)->row_count == 4000);
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_analyze_collects passed\n");
+}
+
+static void check_estimate(Table* t, const TableEstimate* est, const char* where, double want) {
+    char sql[256];
+    snprintf(sql, sizeof(sql), "select * from t where %s", where);
+    Statement st;
+    InputBuffer in;
+    in.buffer = sql;
+    in.buffer_length = strlen(sql) + 1;
+    in.input_length = (ssize_t)strlen(sql);
+    assert(prepare_statement(&in, &st, t) == PREPARE_SUCCESS);
+    double got = estimate_selectivity(t, est, st.where_ast);
+    assert(got > want - 0.02 && got < want + 0.02);
+    statement_cleanup(&st);
+}
+
+void test_analyze_selectivity() {
+    printf("Running test_analyze_selectivity...\n");
+
+    char path[] = "/tmp/test_analyze_XXXXXX";
+    MYDB_Handle h = open_db(path);
+    Table* t = (Table*)h;
+
+    // Before ANALYZE the key is taken as spread evenly over its range
+    TableEstimate est;
+    table_estimate(t, &est);
+    assert(est.stats == NULL && est.rows == 4000 && est.pk_bounds);
+    check_estimate(t, &est, "id < 1000", 0.25);
+    check_estimate(t, &est, "id = 7", 1.0 / 4000);
+
+    test_run(h, "analyze t");
+    table_estimate(t, &est);
+    assert(est.stats && est.height == est.stats->height);
+    check_estimate(t, &est, "v < 25", 0.25);
+    check_estimate(t, &est, "v = 3", 0.01);
+    check_estimate(t, &est, "ts between 10000 and 19990", 0.25);
+    check_estimate(t, &est, "30000 <= ts", 0.25);
+    check_estimate(t, &est, "v < 50 and ts >= 20000", 0.25);
+    check_estimate(t, &est, "v > 1000 or not (v != 1)", 0.01);
+    check_estimate(t, &est, "v in (1, 2, 3)", 0.03);
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_analyze_selectivity passed\n");
+}
+
+void test_analyze_access_paths() {
+    printf("Running test_analyze_access_paths...\n");
+
+    char path[] = "/tmp/test_analyze_XXXXXX";
+    MYDB_Handle h = open_db(path);
+    test_run(h, "analyze");
+
+    // A narrow key range reads a few leaves; a wide one the whole chain
+    test_expect_part(h, "explain select * from t where id between 100 and 120",
+                "\"op\":\"Range Scan\",\"detail\":\"on t, keys 100 to 120, compiled filter, zone maps\"");
+    test_expect_part(h, "explain select * from t where id > 10 and v = 3", "\"op\":\"Leaf Scan\"");
+    // A short key list is looked up; one touching every leaf is scanned
+    test_expect_part(h, "explain select * from t where id in (1, 2, 3)", "\"op\":\"Key Scan\"");
+    char sql[4096];
+    size_t len = (size_t)sprintf(sql, "explain select * from t where id in (0");
+    for (int i = 1; i < 400; i++) {
+        len += (size_t)sprintf(sql + len, ", %d", i * 10);
+    }
+    sprintf(sql + len, ")");
+    test_expect_part(h, sql, "\"op\":\"Leaf Scan\"");
+    test_expect_part(h, "explain select * from t where id = 5 limit 1", "\"op\":\"Key Scan\"");
+
+    // Results do not depend on the path
+    test_expect(h, "select count(*) from t where id between 100 and 120", "{\"ok\":true,\"rows\":[{\"count(*)\":21}]}");
+    test_expect(h, "select count(*) from t where id >= 3990 and v < 95", "{\"ok\":true,\"rows\":[{\"count(*)\":5}]}");
+    test_expect(h, "select id from t where 3997 < id order by id desc",
+           "{\"ok\":true,\"rows\":[{\"id\":3999},{\"id\":3998}]}");
+    test_expect(h, "select count(*) from t where id > 5 and id < 3", "{\"ok\":true,\"rows\":[{\"count(*)\":0}]}");
+    test_expect(h, "select count(*) from t where id > 4000000000", "{\"ok\":true,\"rows\":[{\"count(*)\":0}]}");
+    test_expect(h, "select id from t where id = 5 limit 0", "{\"ok\":true,\"rows\":[]}");
+
+    // Negative keys order after the others and are found by key too
+    test_run(h, "insert into t values (-5, 1, 1)");
+    test_expect(h, "select id from t where id = -5", "{\"ok\":true,\"rows\":[{\"id\":-5}]}");
+    test_expect(h, "select id from t where id in (-5, 1)", "{\"ok\":true,\"rows\":[{\"id\":1},{\"id\":-5}]}");
+    test_expect(h, "select id from t where id < 1", "{\"ok\":true,\"rows\":[{\"id\":0},{\"id\":-5}]}");
+
+    // Few outer rows look the other side up by key; many scan it
+    test_expect_part(h, "explain select * from small join t on small.v = t.id", "\"op\":\"Index Join\"");
+    test_expect_part(h, "explain select * from t join small on t.v = small.id", "\"op\":\"Hash Join\"");
+    test_expect_part(h, "explain select * from t join small on t.v = small.v",
+                "\"op\":\"Hash Join\",\"detail\":\"build on small, probe with t");
+    test_expect(h, "select count(*) from t join small on t.v = small.id", "{\"ok\":true,\"rows\":[{\"count(*)\":801}]}");
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_analyze_access_paths passed\n");
+}
+
+int main() {
+    printf("\n=== Running ANALYZE Tests ===\n\n");
+
+    test_analyze_collects();
+    test_analyze_selectivity();
+    test_analyze_access_paths();
+
+    printf("\n=== All ANALYZE Tests Passed ===\n\n");
+    return 0;
+}
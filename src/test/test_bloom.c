@@ -0,0 +1,56 @@
+#include "../include/bloom.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+static unsigned char filter[MYDB_PAGE_SIZE];
+
+void test_bloom_no_false_negatives() {
+    printf("Running test_bloom_no_false_negatives...\n");
+
+    memset(filter, 0, sizeof(filter));
+    for (uint32_t k = 0; k < 2000; k++) {
+        bloom_add(filter, BLOOM_NUM_HASHES, k * 7);
+    }
+    for (uint32_t k = 0; k < 2000; k++) {
+        assert(bloom_may_contain(filter, BLOOM_NUM_HASHES, k * 7));
+    }
+
+    printf("  ✓ test_bloom_no_false_negatives passed\n");
+}
+
+void test_bloom_false_positive_rate() {
+    printf("Running test_bloom_false_positive_rate...\n");
+
+    memset(filter, 0, sizeof(filter));
+    assert(!bloom_may_contain(filter, BLOOM_NUM_HASHES, 42));
+
+    // 2000 keys in 32768 bits with 5 hashes: expected rate is about 0.1%
+    for (uint32_t k = 0; k < 2000; k++) {
+        bloom_add(filter, BLOOM_NUM_HASHES, k);
+    }
+    uint32_t hits = 0;
+    for (uint32_t k = 100000; k < 110000; k++) {
+        if (bloom_may_contain(filter, BLOOM_NUM_HASHES, k)) {
+            hits++;
+        }
+    }
+    assert(hits < 100);
+
+    BloomStats bs = {.probes = 10, .negatives = 6, .false_positives = 2};
+    assert(bloom_false_positive_rate(&bs) == 0.25);
+    BloomStats empty = {0};
+    assert(bloom_false_positive_rate(&empty) == 0.0);
+
+    printf("  ✓ test_bloom_false_positive_rate passed\n");
+}
+
+int main() {
+    printf("\n=== Running Bloom Tests ===\n\n");
+
+    test_bloom_no_false_negatives();
+    test_bloom_false_positive_rate();
+
+    printf("\n=== All Bloom Tests Passed ===\n\n");
+    return 0;
+}
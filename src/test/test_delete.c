@@ -0,0 +1,95 @@
+#include "helpers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define ROWS 400
+
+// Rows id 0 .. ROWS - 1, with v = id % 10
+static MYDB_Handle open_db(char* path) {
+    MYDB_Handle h = test_open_db(path);
+    test_run(h, "create table t (id int, v int)");
+    test_run(h, "use t");
+    char* sql = malloc(64 + (size_t)ROWS * 24);
+    assert(sql);
+    size_t len = (size_t)sprintf(sql, "insert into t values ");
+    for (int id = 0; id < ROWS; id++) {
+        len += (size_t)sprintf(sql + len, "%s(%d, %d)", id ? ", " : "", id, id % 10);
+    }
+    test_run(h, sql);
+    free(sql);
+    return h;
+}
+
+static void expect_count(MYDB_Handle h, const char* where, int n) {
+    char sql[128], want[64];
+    snprintf(sql, sizeof(sql), "select count(*) from t %s", where);
+    snprintf(want, sizeof(want), "{\"ok\":true,\"rows\":[{\"count(*)\":%d}]}", n);
+    test_expect(h, sql, want);
+}
+
+void test_delete_where() {
+    printf("Running test_delete_where...\n");
+
+    char path[] = "/tmp/test_delete_XXXXXX";
+    MYDB_Handle h = open_db(path);
+
+    test_run(h, "delete from t where id = 7");
+    expect_count(h, "", ROWS - 1);
+    expect_count(h, "where id = 7", 0);
+    test_run(h, "delete from t where v = 3 and id < 100;");
+    expect_count(h, "", ROWS - 11);
+    test_run(h, "delete t where id between 300 and 399 or id in (0, 1)");
+    expect_count(h, "", ROWS - 113);
+    test_run(h, "delete from t where id > 100000");
+    expect_count(h, "", ROWS - 113);
+
+    // No WHERE takes every row
+    test_run(h, "delete from t");
+    expect_count(h, "", 0);
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_delete_where passed\n");
+}
+
+void test_delete_malformed_where() {
+    printf("Running test_delete_malformed_where...\n");
+
+    char path[] = "/tmp/test_delete_XXXXXX";
+    MYDB_Handle h = open_db(path);
+
+    // Each of these once deleted every row
+    const char* deletes[] = {
+        "delete from t where", "delete from t where (", "delete from t where and",
+        "delete from t wher id = 1", "delete from t where id = 1 or", "delete from t where id = 1 garbage",
+        "delete from t where id = 1 and", "delete from t where (id = 1", "delete from t where id in (1,",
+        "delete from t where not", "delete from t where id between 1", "delete t wher id = 1",
+        "delete from t where id = 1; delete from t",
+    };
+    for (size_t i = 0; i < sizeof(deletes) / sizeof(deletes[0]); i++) {
+        test_expect_error(h, deletes[i]);
+        expect_count(h, "", ROWS);
+
+        // Nor do they prepare
+        MYDB_Stmt st = NULL;
+        assert(mydb_prepare(h, deletes[i], &st) != 0);
+        assert(st == NULL);
+    }
+    expect_count(h, "", ROWS);
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_delete_malformed_where passed\n");
+}
+
+int main() {
+    printf("\n=== Running DELETE Tests ===\n\n");
+
+    test_delete_where();
+    test_delete_malformed_where();
+
+    printf("\n=== All DELETE Tests Passed ===\n\n");
+    return 0;
+}
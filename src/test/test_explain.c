@@ -0,0 +1,232 @@
+#include "../include/explain.h"
+#include "../include/operator.h"
+#include "helpers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+static MYDB_Handle open_db(char* path) {
+    MYDB_Handle h = test_open_db(path);
+    test_run(h, "create table t (id int, v int)");
+    test_run(h, "use t");
+    test_run(h, "insert into t values (1, 10), (2, 20), (3, 30), (4, 40), (5, 50), (6, 60)");
+    test_run(h, "create table u (id int, t_v int)");
+    test_run(h, "use u");
+    test_run(h, "insert into u values (1, 20), (2, 40), (3, 40)");
+    test_run(h, "use t");
+    return h;
+}
+
+void test_explain_tree() {
+    printf("Running test_explain_tree...\n");
+
+    Explain ex;
+    explain_init(&ex, true);
+    ExplainNode* top = explain_add(&ex, "Limit", "limit %d", 2);
+    ex.parent = explain_index(&ex, top);
+    ExplainNode* a = explain_add(&ex, "Scan", "a");
+    ExplainNode* b = explain_add(&ex, "Scan", "b");
+    assert(a->parent == 0 && b->parent == 0 && strcmp(top->detail, "limit 2") == 0);
+    top->rows = 2;
+    a->rows = 3;
+    b->rows = 4;
+
+    StrBuf sb;
+    sb_init(&sb);
+    explain_append_json(&ex, &sb);
+    // Rows in are what the inputs produced; steps without inputs have none
+    assert(strstr(sb.buf, "[{\"op\":\"Limit\",\"detail\":\"limit 2\",\"rows_in\":7,\"rows_out\":2,") == sb.buf);
+    assert(strstr(sb.buf, "{\"op\":\"Scan\",\"detail\":\"a\",\"rows_out\":3,") != NULL);
+    sb_free(&sb);
+
+    // A full plan drops further steps
+    while (ex.n < EXPLAIN_MAX_NODES) {
+        assert(explain_add(&ex, "Step", "") != NULL);
+    }
+    assert(explain_add(&ex, "Step", "") == NULL);
+    assert(explain_index(&ex, NULL) == ex.parent);
+
+    printf("  ✓ test_explain_tree passed\n");
+}
+
+void test_explain_plans() {
+    printf("Running test_explain_plans...\n");
+
+    char path[] = "/tmp/test_explain_XXXXXX";
+    MYDB_Handle h = open_db(path);
+
+    // EXPLAIN shows the access path without running anything
+    char* out = test_json(h, "explain select * from t where id = 3");
+    assert(strcmp(out, "{\"ok\":true,\"analyze\":false,\"plan\":[{\"op\":\"Point Lookup\","
+                       "\"detail\":\"on t, id = 3, Bloom filter first\",\"est_pages\":1,\"est_rows\":1,"
+                       "\"inputs\":[]}]}") == 0);
+    free(out);
+    out = test_json(h, "explain select * from t where v > 15 order by v limit 2");
+    assert(strstr(out, "{\"op\":\"Limit\",\"detail\":\"offset 0, limit 2\",\"inputs\":"
+                       "[{\"op\":\"Top-K\",\"detail\":\"k=2\",\"inputs\":[{\"op\":\"Leaf Scan\"") != NULL);
+    free(out);
+    out = test_json(h, "explain select v, count(*) from t group by v");
+    assert(strstr(out, "\"op\":\"Hash Aggregate\"") != NULL && strstr(out, "\"op\":\"Leaf Scan\"") != NULL);
+    free(out);
+    out = test_json(h, "explain select * from t join u on t.v = u.t_v");
+    assert(strstr(out, "\"op\":\"Hash Join\",\"detail\":\"build on u, probe with t") != NULL);
+    free(out);
+
+    // Only SELECT can be explained
+    char* err = NULL;
+    assert(mydb_execute_json(h, "explain delete from t", &err) == -3);
+    assert(err == NULL);
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_explain_plans passed\n");
+}
+
+void test_explain_analyze() {
+    printf("Running test_explain_analyze...\n");
+
+    char path[] = "/tmp/test_explain_XXXXXX";
+    MYDB_Handle h = open_db(path);
+    Table* t = (Table*)h;
+
+    char* out = test_json(h, "explain analyze select * from t where v > 15 order by v limit 2");
+    assert(strstr(out, "\"analyze\":true") != NULL);
+    // Six rows are scanned, five pass the filter, Top-K keeps two
+    assert(strstr(out, "\"op\":\"Limit\",\"detail\":\"offset 0, limit 2\",\"rows_in\":2,\"rows_out\":2,") != NULL);
+    assert(strstr(out, "\"op\":\"Top-K\",\"detail\":\"k=2\",\"rows_in\":5,\"rows_out\":2,") != NULL);
+    assert(strstr(out, "\"rows_out\":5,") != NULL && strstr(out, "\"page_hits\":0") == NULL);
+    free(out);
+    // Fetches are only counted while EXPLAIN ANALYZE runs
+    assert(!t->pager->count_fetches);
+    uint64_t hits = t->pager->page_hits;
+    test_run(h, "select * from t");
+    assert(t->pager->page_hits == hits);
+
+    out = test_json(h, "explain analyze select * from t join u on t.v = u.t_v");
+    assert(strstr(out, "\"op\":\"Hash Join\"") != NULL && strstr(out, "\"rows_in\":9,\"rows_out\":3,") != NULL);
+    // The hash table is the join's own memory
+    assert(strstr(out, "\"memory_bytes\":0,\"inputs\":[{") == NULL);
+    free(out);
+
+    out = test_json(h, "explain analyze select v, count(*) from t group by v having count(*) > 1");
+    assert(strstr(out, "\"op\":\"Hash Aggregate\"") != NULL && strstr(out, "\"rows_in\":6,\"rows_out\":0,") != NULL);
+    free(out);
+
+    // The query's own output is unchanged
+    out = test_json(h, "select id from t where v > 15 order by v limit 2");
+    assert(strcmp(out, "{\"ok\":true,\"rows\":[{\"id\":2},{\"id\":3}]}") == 0);
+    free(out);
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_explain_analyze passed\n");
+}
+
+// Rows id = 0 .. n - 1 with v = id % 100, in one INSERT
+static MYDB_Handle open_big_db(char* path, int n) {
+    MYDB_Handle h = test_open_db(path);
+    test_run(h, "create table t (id int, v int)");
+    test_run(h, "use t");
+    char* sql = malloc(64 + (size_t)n * 24);
+    assert(sql);
+    size_t len = (size_t)sprintf(sql, "insert into t values ");
+    for (int id = 0; id < n; id++) {
+        len += (size_t)sprintf(sql + len, "%s(%d, %d)", id ? ", " : "", id, id % 100);
+    }
+    test_run(h, sql);
+    free(sql);
+    return h;
+}
+
+void test_explain_limit() {
+    printf("Running test_explain_limit...\n");
+
+    char path[] = "/tmp/test_explain_XXXXXX";
+    MYDB_Handle h = open_big_db(path, 3 * PARALLEL_SCAN_MIN_ROWS);
+    assert(mydb_set_threads(h, 1) == 0);
+
+    char* out = test_json(h, "explain analyze select count(*) from t where v > 50");
+    uint64_t all = test_step_page_hits(out, "Leaf Scan");
+    free(out);
+
+    // The scan stops once LIMIT has its rows
+    out = test_json(h, "explain analyze select id from t where v > 50 limit 5");
+    assert(strstr(out, "\"op\":\"Limit\",\"detail\":\"offset 0, limit 5\",\"rows_in\":5,\"rows_out\":5,") != NULL);
+    assert(strstr(out, "\"op\":\"Leaf Scan\"") != NULL);
+    assert(test_step_page_hits(out, "Leaf Scan") * 10 < all);
+    free(out);
+
+    // OFFSET rows are read and dropped, then LIMIT applies
+    out = test_json(h, "explain analyze select id from t where v > 50 limit 5 offset 100");
+    assert(strstr(out, "\"detail\":\"offset 100, limit 5\",\"rows_in\":105,\"rows_out\":5,") != NULL);
+    assert(test_step_page_hits(out, "Leaf Scan") * 10 < all);
+    free(out);
+    test_expect(h, "select id from t where v > 50 limit 2 offset 50",
+                "{\"ok\":true,\"rows\":[{\"id\":152},{\"id\":153}]}");
+
+    // LIMIT 0 reads no rows, with or without OFFSET
+    const char* empty[] = {
+        "explain analyze select id from t where v > 50 limit 0",
+        "explain analyze select id from t where v > 50 limit 0 offset 10",
+    };
+    for (int i = 0; i < 2; i++) {
+        out = test_json(h, empty[i]);
+        assert(strstr(out, "\"rows_in\":0,\"rows_out\":0,") != NULL);
+        assert(strstr(out, "\"op\":\"Leaf Scan\",\"detail\":\"on t, compiled filter, zone maps\","
+                           "\"est_pages\"") != NULL);
+        free(out);
+    }
+    test_expect(h, "select id from t where v > 50 limit 0 offset 10", "{\"ok\":true,\"rows\":[]}");
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_explain_limit passed\n");
+}
+
+void test_explain_limit_parallel() {
+    printf("Running test_explain_limit_parallel...\n");
+
+    char path[] = "/tmp/test_explain_XXXXXX";
+    // Enough rows for a parallel scan
+    MYDB_Handle h = open_big_db(path, 3 * PARALLEL_SCAN_MIN_ROWS);
+    const char* limited = "explain analyze select * from t where v > 50 limit 5";
+    assert(mydb_set_threads(h, 1) == 0);
+    char* out = test_json(h, limited);
+    uint64_t serial = test_step_page_hits(out, "Leaf Scan");
+    free(out);
+
+    // LIMIT stops a scan on workers no sooner than its last range, so
+    // with more threads the scan stays serial and reads as few pages
+    assert(mydb_set_threads(h, 4) == 0);
+    out = test_json(h, limited);
+    assert(strstr(out, "\"op\":\"Parallel Scan\"") == NULL);
+    assert(test_step_page_hits(out, "Leaf Scan") <= serial);
+    free(out);
+
+    // Without a LIMIT that can stop it, the scan runs on the workers
+    out = test_json(h, "explain analyze select count(*) from t where v > 50");
+    assert(test_step_page_hits(out, "Parallel Scan") > 4 * serial);
+    free(out);
+    out = test_json(h, "explain analyze select * from t where v > 50 order by v limit 5");
+    assert(strstr(out, "\"op\":\"Parallel Scan\"") != NULL);
+    free(out);
+    test_expect(h, "select id from t where v > 50 limit 2", "{\"ok\":true,\"rows\":[{\"id\":51},{\"id\":52}]}");
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_explain_limit_parallel passed\n");
+}
+
+int main() {
+    printf("\n=== Running EXPLAIN Tests ===\n\n");
+
+    test_explain_tree();
+    test_explain_plans();
+    test_explain_analyze();
+    test_explain_limit();
+    test_explain_limit_parallel();
+
+    printf("\n=== All EXPLAIN Tests Passed ===\n\n");
+    return 0;
+}
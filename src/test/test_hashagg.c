@@ -0,0 +1,136 @@
+#include "../include/hashagg.h"
+#include "../include/extsort.h"
+#include "helpers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+static Table table;
+
+/* Groups `n` rows on g (ids 0..n-1, g = id % n_groups - offset) and checks
+ * that every group comes back once with its COUNT and SUM(id) */
+static void group_and_check(uint32_t n, uint32_t n_groups, size_t budget) {
+    AggSpec specs[] = { { AGG_COUNT, -1 }, { AGG_SUM, 0 } };
+    int cols[] = { 1 };
+    AggPlan plan;
+    agg_plan_init(&plan, &table, specs, 2);
+    agg_plan_group_by(&plan, &table, cols, 1);
+    HashAgg* h = hashagg_new(&table, &plan, budget);
+    assert(h != NULL);
+
+    uint8_t row[32];
+    int32_t offset = (int32_t)(n_groups / 2);
+    for (uint32_t i = 0; i < n; i++) {
+        test_make_row(&table, row, (int64_t)i, (int64_t)(i % n_groups) - offset, "x");
+        assert(hashagg_add(h, row));
+    }
+
+    uint8_t* seen = calloc(n_groups ? n_groups : 1, 1);
+    const uint8_t* key;
+    const uint8_t* state;
+    uint32_t groups = 0;
+    while ((key = hashagg_next(h, &state)) != NULL) {
+        AggValue g, count, sum;
+        agg_group_value(&plan, key, 0, &g);
+        uint32_t r = (uint32_t)(g.i + offset);
+        assert(r < n_groups && !seen[r]);
+        seen[r] = 1;
+
+        // Group r holds ids r, r + n_groups, ...
+        uint64_t k = (n - r + n_groups - 1) / n_groups;
+        agg_value(&plan, state, 0, &count);
+        agg_value(&plan, state, 1, &sum);
+        assert(count.i == (int64_t)k);
+        assert(sum.i == (int64_t)(k * r + n_groups * k * (k - 1) / 2));
+        groups++;
+    }
+    assert(groups == (n < n_groups ? n : n_groups));
+    assert(!hashagg_failed(h));
+    hashagg_free(h);
+    free(seen);
+}
+
+void test_hashagg_in_memory() {
+    printf("Running test_hashagg_in_memory...\n");
+
+    table.stats.group = (GroupStats){0};
+    group_and_check(0, 10, SORT_DEFAULT_BUDGET);
+    group_and_check(1000, 7, SORT_DEFAULT_BUDGET);
+    // The table grows well past its initial size
+    group_and_check(20000, 5000, SORT_DEFAULT_BUDGET);
+    assert(table.stats.group.groupings == 3);
+    assert(table.stats.group.spilled == 0);
+
+    printf("  ✓ test_hashagg_in_memory passed\n");
+}
+
+void test_hashagg_spills_partitions() {
+    printf("Running test_hashagg_spills_partitions...\n");
+
+    table.stats.group = (GroupStats){0};
+    group_and_check(20000, 5000, 8192);
+    assert(table.stats.group.spilled == 1);
+    assert(table.stats.group.partitions >= HASHAGG_FANOUT);
+    assert(table.stats.group.bytes_spilled % table.row_size == 0);
+
+    // A budget too small for even the first table: partitions split again
+    table.stats.group = (GroupStats){0};
+    group_and_check(20000, 5000, 1);
+    assert(table.stats.group.partitions > HASHAGG_FANOUT);
+
+    printf("  ✓ test_hashagg_spills_partitions passed\n");
+}
+
+void test_hashagg_string_keys() {
+    printf("Running test_hashagg_string_keys...\n");
+
+    // Bytes after the NUL do not split a group
+    AggSpec specs[] = { { AGG_COUNT, -1 } };
+    int cols[] = { 2 };
+    AggPlan plan;
+    agg_plan_init(&plan, &table, specs, 1);
+    agg_plan_group_by(&plan, &table, cols, 1);
+    assert(plan.key_len == 8);
+    HashAgg* h = hashagg_new(&table, &plan, SORT_DEFAULT_BUDGET);
+
+    uint8_t row[32];
+    test_make_row(&table, row, (int64_t)0, (int64_t)0, "ab");
+    assert(hashagg_add(h, row));
+    test_make_row(&table, row, (int64_t)1, (int64_t)0, "ab");
+    row[schema_col_offset(&table.active_schema, 2) + 5] = 'z';
+    assert(hashagg_add(h, row));
+    test_make_row(&table, row, (int64_t)2, (int64_t)0, "abcdefgh");
+    assert(hashagg_add(h, row));
+
+    const uint8_t* key;
+    const uint8_t* state;
+    uint32_t groups = 0;
+    while ((key = hashagg_next(h, &state)) != NULL) {
+        AggValue name, count;
+        agg_group_value(&plan, key, 0, &name);
+        agg_value(&plan, state, 0, &count);
+        if (name.len == 2) {
+            assert(memcmp(name.str, "ab", 2) == 0 && count.i == 2);
+        } else {
+            assert(name.len == 8 && count.i == 1);
+        }
+        groups++;
+    }
+    assert(groups == 2);
+    hashagg_free(h);
+
+    printf("  ✓ test_hashagg_string_keys passed\n");
+}
+
+int main() {
+    printf("\n=== Running Hash Aggregation Tests ===\n\n");
+
+    test_table_init(&table, "id int, g int, name string(8)");
+    test_hashagg_in_memory();
+    test_hashagg_spills_partitions();
+    test_hashagg_string_keys();
+
+    printf("\n=== All Hash Aggregation Tests Passed ===\n\n");
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include "../include/hashjoin.h"
+#include "../include/extsort.h"
+#include "../include/util.h"
+#include "helpers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+static Table table;
+/* Joins build rows (id i, k = i % n_keys - offset) with probe rows (id j,
+ * k = j % (2 * n_keys) - offset) on k and checks every pair comes back once */
+static void join_and_check(uint32_t n_build, uint32_t n_probe, uint32_t n_keys, size_t budget) {
+    JoinKeyCol key;
+    join_key_col(&key, &table.active_schema, 1);
+    HashJoin* h = hashjoin_new(&table, &key, table.row_size, &key, table.row_size, budget);
+    assert(h != NULL);
+
+    uint8_t row[32];
+    int32_t offset = (int32_t)(n_keys / 2);
+    for (uint32_t i = 0; i < n_build; i++) {
+        test_make_row(&table, row, (int64_t)i, (int64_t)(i % n_keys) - offset, "b");
+        assert(hashjoin_build(h, row));
+    }
+
+    // Probe keys past n_keys match nothing
+    uint8_t* seen = calloc((size_t)n_build * n_probe, 1);
+    uint64_t pairs = 0;
+    bool in_pass = false;
+    for (uint32_t j = 0;;) {
+        const void* probe;
+        if (in_pass) {
+            probe = hashjoin_next_probe(h);
+        } else if (j < n_probe) {
+            test_make_row(&table, row, (int64_t)j, (int64_t)(j % (2 * n_keys)) - offset, "p");
+            probe = row;
+            j++;
+        } else {
+            probe = NULL;
+        }
+        if (!probe) {
+            if (!hashjoin_next_pass(h)) {
+                break;
+            }
+            in_pass = true;
+            continue;
+        }
+        assert(hashjoin_probe(h, probe));
+        const void* match;
+        while ((match = hashjoin_match(h)) != NULL) {
+            int32_t b = row_get_int(&table, match, 0);
+            int32_t p = row_get_int(&table, probe, 0);
+            assert(row_get_int(&table, match, 1) == row_get_int(&table, probe, 1));
+            assert(!seen[(size_t)b * n_probe + (size_t)p]);
+            seen[(size_t)b * n_probe + (size_t)p] = 1;
+            pairs++;
+        }
+    }
+    assert(!hashjoin_failed(h));
+    hashjoin_free(h);
+
+    uint64_t expected = 0;
+    for (uint32_t i = 0; i < n_build; i++) {
+        for (uint32_t j = 0; j < n_probe; j++) {
+            expected += (i % n_keys) == (j % (2 * n_keys));
+        }
+    }
+    assert(pairs == expected);
+    free(seen);
+}
+
+void test_hashjoin_in_memory() {
+    printf("Running test_hashjoin_in_memory...\n");
+
+    table.stats.join = (JoinStats){0};
+    join_and_check(0, 100, 10, SORT_DEFAULT_BUDGET);
+    join_and_check(100, 0, 10, SORT_DEFAULT_BUDGET);
+    // Duplicate keys on both sides, and a table that grows past its first size
+    join_and_check(3000, 1000, 700, SORT_DEFAULT_BUDGET);
+    assert(table.stats.join.hash_joins == 3);
+    assert(table.stats.join.spilled == 0);
+
+    printf("  ✓ test_hashjoin_in_memory passed\n");
+}
+
+void test_hashjoin_spills_partitions() {
+    printf("Running test_hashjoin_spills_partitions...\n");
+
+    table.stats.join = (JoinStats){0};
+    join_and_check(3000, 1000, 700, 8192);
+    assert(table.stats.join.spilled == 1);
+    assert(table.stats.join.partitions >= HASHJOIN_FANOUT);
+    assert(table.stats.join.bytes_spilled % table.row_size == 0);
+
+    // One key for every row: no split helps, so the deepest pass holds it all
+    table.stats.join = (JoinStats){0};
+    join_and_check(500, 20, 1, 1);
+    assert(table.stats.join.spilled == 1);
+
+    printf("  ✓ test_hashjoin_spills_partitions passed\n");
+}
+
+void test_hashjoin_key_encoding() {
+    printf("Running test_hashjoin_key_encoding...\n");
+
+    // Bytes after the NUL do not take part in a string key
+    JoinKeyCol key;
+    join_key_col(&key, &table.active_schema, 2);
+    assert(join_key_len(&key, &key) == 8);
+    uint8_t a[32], b[32], ka[8], kb[8];
+    test_make_row(&table, a, (int64_t)0, (int64_t)0, "ab");
+    test_make_row(&table, b, (int64_t)1, (int64_t)0, "ab");
+    b[schema_col_offset(&table.active_schema, 2) + 5] = 'z';
+    join_key_encode(&key, 8, a, ka);
+    join_key_encode(&key, 8, b, kb);
+    assert(memcmp(ka, kb, 8) == 0);
+
+    // Ints widen with their sign, so they compare with 8-byte timestamps
+    JoinKeyCol ik;
+    join_key_col(&ik, &table.active_schema, 1);
+    assert(join_key_len(&ik, &ik) == 8);
+    test_make_row(&table, a, (int64_t)0, (int64_t)-5, "x");
+    int64_t v;
+    join_key_encode(&ik, 8, a, (uint8_t*)&v);
+    assert(v == -5);
+
+    printf("  ✓ test_hashjoin_key_encoding passed\n");
+}
+
+int main() {
+    printf("\n=== Running Hash Join Tests ===\n\n");
+
+    test_table_init(&table, "id int, k int, name string(8)");
+    test_hashjoin_in_memory();
+    test_hashjoin_spills_partitions();
+    test_hashjoin_key_encoding();
+
+    printf("\n=== All Hash Join Tests Passed ===\n\n");
+    return 0;
+}
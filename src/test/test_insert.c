@@ -0,0 +1,227 @@
+#include "helpers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define ROWS 3000
+
+// One INSERT of the given keys, with v = key * 2
+static void insert_keys(MYDB_Handle h, const int* keys, int n, int expect_ok) {
+    char* sql = malloc(64 + (size_t)n * 48);
+    assert(sql);
+    size_t len = (size_t)sprintf(sql, "insert into t values ");
+    for (int i = 0; i < n; i++) {
+        len += (size_t)sprintf(sql + len, "%s(%d, %d)", i ? ", " : "", keys[i], keys[i] * 2);
+    }
+    if (expect_ok) {
+        test_run(h, sql);
+    } else {
+        test_expect_error(h, sql);
+    }
+    free(sql);
+}
+
+// Every row in key order must be exactly `keys` (sorted, signed)
+static void expect_keys(MYDB_Handle h, const int* keys, int n) {
+    char* want = malloc(64 + (size_t)n * 48);
+    assert(want);
+    size_t len = (size_t)sprintf(want, "{\"ok\":true,\"rows\":[");
+    for (int i = 0; i < n; i++) {
+        len += (size_t)sprintf(want + len, "%s{\"id\":%d,\"v\":%d}", i ? "," : "", keys[i], keys[i] * 2);
+    }
+    sprintf(want + len, "]}");
+    test_expect(h, "select * from t order by id", want);
+    free(want);
+}
+
+static int cmp_int(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+static MYDB_Handle open_db(char* path) {
+    MYDB_Handle h = test_open_db(path);
+    test_run(h, "create table t (id int, v int)");
+    test_run(h, "use t");
+    return h;
+}
+
+void test_insert_batch_order() {
+    printf("Running test_insert_batch_order...\n");
+
+    char path[] = "/tmp/test_insert_XXXXXX";
+    MYDB_Handle h = open_db(path);
+
+    // Even keys in descending order, negatives included: the batch is
+    // sorted and fills many leaves
+    int keys[ROWS + 1];
+    int n = 0;
+    for (int k = 2 * (ROWS / 2) - 200; k >= -200; k -= 2) {
+        keys[n++] = k;
+    }
+    insert_keys(h, keys, n, 1);
+    qsort(keys, n, sizeof(int), cmp_int);
+    expect_keys(h, keys, n);
+
+    // Odd keys land between them, splitting the leaves already there
+    int odd[ROWS / 2];
+    int m = 0;
+    for (int k = -199; k < ROWS - 200; k += 2) {
+        odd[m++] = k;
+    }
+    insert_keys(h, odd, m, 1);
+    for (int i = 0; i < m; i++) {
+        keys[n++] = odd[i];
+    }
+    qsort(keys, n, sizeof(int), cmp_int);
+    expect_keys(h, keys, n);
+    test_expect(h, "select count(*) from t", "{\"ok\":true,\"rows\":[{\"count(*)\":3001}]}");
+    test_expect(h, "select * from t where id = 1001",
+                "{\"ok\":true,\"rows\":[{\"id\":1001,\"v\":2002}]}");
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_insert_batch_order passed\n");
+}
+
+void test_insert_batch_duplicate() {
+    printf("Running test_insert_batch_duplicate...\n");
+
+    char path[] = "/tmp/test_insert_XXXXXX";
+    MYDB_Handle h = open_db(path);
+    int keys[ROWS];
+    for (int i = 0; i < 500; i++) {
+        keys[i] = i * 3;
+    }
+    insert_keys(h, keys, 500, 1);
+
+    // A key already in the table partway through the batch commits
+    // none of the batch
+    int clash[600];
+    for (int i = 0; i < 600; i++) {
+        clash[i] = 100000 + i;
+    }
+    clash[300] = 42;
+    insert_keys(h, clash, 600, 0);
+    expect_keys(h, keys, 500);
+
+    // Nor does a key twice within the batch
+    clash[300] = 100000;
+    insert_keys(h, clash, 600, 0);
+    expect_keys(h, keys, 500);
+    test_expect_error(h, "insert into t values (7, 1), (7, 2)");
+    expect_keys(h, keys, 500);
+
+    // Without the duplicate the same batch goes in whole
+    clash[300] = 99999;
+    insert_keys(h, clash, 600, 1);
+    for (int i = 0; i < 600; i++) {
+        keys[500 + i] = clash[i];
+    }
+    qsort(keys, 1100, sizeof(int), cmp_int);
+    expect_keys(h, keys, 1100);
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_insert_batch_duplicate passed\n");
+}
+
+void test_insert_batch_arity() {
+    printf("Running test_insert_batch_arity...\n");
+
+    char path[] = "/tmp/test_insert_XXXXXX";
+    MYDB_Handle h = open_db(path);
+    test_run(h, "insert into t values (1, 2)");
+
+    // Every row must have as many values as the first; nothing goes in
+    // otherwise
+    const char* bad[] = {
+        "insert into t values (5, 10), (6)",
+        "insert into t values (5), (6, 12)",
+        "insert into t values (5, 10), (6, 12, 7)",
+        "insert into t values (5, 10), (6, 12), (7)",
+        "insert into t values (5, 10), ()",
+        "insert into t values (5, 10),",
+        "insert into t values (5, 10) (6, 12)",
+    };
+    int one[] = { 1 };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        test_expect_error(h, bad[i]);
+        expect_keys(h, one, 1);
+    }
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_insert_batch_arity passed\n");
+}
+
+void test_insert_batch_values() {
+    printf("Running test_insert_batch_values...\n");
+
+    char path[] = "/tmp/test_insert_XXXXXX";
+    MYDB_Handle h = test_open_db(path);
+    test_run(h, "create table t (id int, v int, ts timestamp, name string)");
+    test_run(h, "use t");
+    test_run(h, "insert into t values (1, 2, 3, 'a'), (-4, -2147483648, -9000000000, b)");
+    const char* rows = "{\"ok\":true,\"rows\":[{\"id\":-4,\"v\":-2147483648,\"ts\":-9000000000,\"name\":\"b\"},"
+                       "{\"id\":1,\"v\":2,\"ts\":3,\"name\":\"a\"}]}";
+    test_expect(h, "select * from t order by id", rows);
+
+    // Each value must fit its column and each row must fill every column,
+    // wherever the bad row sits in the batch; nothing goes in otherwise
+    const char* bad[] = {
+        "insert into t values (5, 'abc', 6, 'x')",
+        "insert into t values (5, 1, 6, 'x'), (6, 99999999999, 6, 'x')",
+        "insert into t values (5, 1, 6, 'x'), (6, 2147483648, 6, 'x'), (7, 1, 6, 'x')",
+        "insert into t values ('abc', 1, 6, 'x')",
+        "insert into t values (5, 1, 6, 'x'), (99999999999, 1, 6, 'x')",
+        "insert into t values (5, 1, 'notts', 'x')",
+        "insert into t values (5, 1, 6, 'x'), (6, 1, '', 'x')",
+        "insert into t values (5, 1, 99999999999999999999, 'x')",
+        "insert into t values (5, 1, 6)",
+        "insert into t values (5, 1, 6), (6, 1, 7)",
+        "insert into t values (5, 1, 6, 'x', 7)",
+        "insert into t values (5)",
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        char* out = NULL;
+        assert(mydb_execute_json(h, bad[i], &out) == 0);
+        if (strcmp(out, "{\"ok\":false,\"error\":\"invalid_value\"}") != 0) {
+            fprintf(stderr, "%s\n  got: %s\n", bad[i], out);
+            assert(0);
+        }
+        free(out);
+        test_expect(h, "select * from t order by id", rows);
+    }
+
+    // Bound values are held to the same rules
+    MYDB_Stmt st = NULL;
+    assert(mydb_prepare(h, "insert into t values (?, ?, ?, 'p')", &st) == 0);
+    assert(mydb_bind_int(st, 1, 9) == 0);
+    assert(mydb_bind_text(st, 2, "nine") == 0);
+    assert(mydb_bind_int(st, 3, 9) == 0);
+    char* out = NULL;
+    assert(mydb_execute_prepared(st, &out) == 0);
+    assert(strcmp(out, "{\"ok\":false,\"error\":\"invalid_value\"}") == 0);
+    free(out);
+    test_expect(h, "select * from t order by id", rows);
+    mydb_finalize(st);
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_insert_batch_values passed\n");
+}
+
+int main() {
+    printf("\n=== Running INSERT Tests ===\n\n");
+
+    test_insert_batch_order();
+    test_insert_batch_duplicate();
+    test_insert_batch_arity();
+    test_insert_batch_values();
+
+    printf("\n=== All INSERT Tests Passed ===\n\n");
+    return 0;
+}
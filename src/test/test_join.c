@@ -0,0 +1,184 @@
+#include "helpers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define INNER_ROWS 6000
+
+// Rows "(f(i))" for i in [0, n), as one INSERT into `table`
+static void insert_rows(MYDB_Handle h, const char* table, int n, void (*row)(int i, char* out)) {
+    if (n == 0) {
+        return;
+    }
+    char* sql = malloc(64 + (size_t)n * 48);
+    assert(sql);
+    size_t len = (size_t)sprintf(sql, "insert into %s values ", table);
+    for (int i = 0; i < n; i++) {
+        char values[48];
+        row(i, values);
+        len += (size_t)sprintf(sql + len, "%s(%s)", i ? ", " : "", values);
+    }
+    char use[64];
+    snprintf(use, sizeof(use), "use %s", table);
+    test_run(h, use);
+    test_run(h, sql);
+    free(sql);
+}
+
+// Outer rows: ids from -10, five join values repeating, negatives included
+static void outer_row(int i, char* out) {
+    sprintf(out, "%d, %d", i - 10, (i % 5) * 3 - 4);
+}
+
+// Inner rows keyed -30 .. INNER_ROWS - 31, as the primary key of b and as
+// a plain column (bid) of b2
+static void inner_row(int i, char* out) {
+    sprintf(out, "%d, %d", i - 30, (i - 30) * 3);
+}
+
+static void inner_copy_row(int i, char* out) {
+    sprintf(out, "%d, %d, %d", 100000 + i, i - 30, (i - 30) * 3);
+}
+
+static MYDB_Handle open_db(char* path, int outer_rows, int inner_rows) {
+    MYDB_Handle h = test_open_db(path);
+    test_run(h, "create table a (id int, v int)");
+    test_run(h, "create table b (id int, w int)");
+    test_run(h, "create table b2 (id int, bid int, w int)");
+    insert_rows(h, "a", outer_rows, outer_row);
+    insert_rows(h, "b", inner_rows, inner_row);
+    insert_rows(h, "b2", inner_rows, inner_copy_row);
+    return h;
+}
+
+// `sql` with "%s" standing for the join, once for each form; both must
+// return the same rows
+static void check_same(MYDB_Handle h, const char* sql, const char* join, const char* reference) {
+    char got_sql[512], want_sql[512];
+    snprintf(got_sql, sizeof(got_sql), sql, join);
+    snprintf(want_sql, sizeof(want_sql), sql, reference);
+    char* got = test_json(h, got_sql);
+    char* want = test_json(h, want_sql);
+    if (strcmp(got, want) != 0) {
+        fprintf(stderr, "%s\n  got:  %s\n  want: %s\n", got_sql, got, want);
+        assert(0);
+    }
+    free(got);
+    free(want);
+}
+
+// Every form of the outer side joined with b on its key against the hash
+// join of the same rows through b2.bid
+static void check_index_join(MYDB_Handle h) {
+    const char* join = "a join b x on a.v = x.id";
+    const char* hash = "a join b2 x on a.v = x.bid";
+    check_same(h, "select a.id, a.v, x.w from %s order by a.id", join, hash);
+    check_same(h, "select count(*) from %s", join, hash);
+    check_same(h, "select a.id, x.w from %s where x.w > 0 order by x.w desc, a.id limit 5 offset 2", join, hash);
+    // The key side on the left
+    check_same(h, "select x.w, a.id from %s order by a.id", "b x join a on x.id = a.v", "b2 x join a on x.bid = a.v");
+}
+
+void test_join_index() {
+    printf("Running test_join_index...\n");
+
+    char path[] = "/tmp/test_join_XXXXXX";
+    MYDB_Handle h = open_db(path, 12, INNER_ROWS);
+
+    // Few outer rows look the key side up; without a key on either side
+    // the join hashes
+    test_expect_part(h, "explain select * from a join b on a.v = b.id", "\"op\":\"Index Join\"");
+    test_expect_part(h, "explain select * from b join a on b.id = a.v", "\"op\":\"Index Join\"");
+    test_expect_part(h, "explain select * from a join b2 on a.v = b2.bid", "\"op\":\"Hash Join\"");
+    test_expect(h, "select a.id, b.w from a join b on a.v = b.id where a.id < -7 order by a.id",
+                "{\"ok\":true,\"rows\":[{\"a.id\":-10,\"b.w\":-12},{\"a.id\":-9,\"b.w\":-3},"
+                "{\"a.id\":-8,\"b.w\":6}]}");
+    check_index_join(h);
+
+    // Outer keys past the inner side's end match nothing
+    test_run(h, "use a");
+    test_run(h, "insert into a values (1000, 999999), (1001, -999999)");
+    check_index_join(h);
+    test_close_db(h, path);
+
+    // Either side empty
+    char empty_outer[] = "/tmp/test_join_XXXXXX";
+    h = open_db(empty_outer, 0, INNER_ROWS);
+    test_expect_part(h, "explain select * from a join b on a.v = b.id", "\"op\":\"Index Join\"");
+    test_expect(h, "select * from a join b on a.v = b.id", "{\"ok\":true,\"rows\":[]}");
+    check_index_join(h);
+    test_close_db(h, empty_outer);
+
+    char empty_inner[] = "/tmp/test_join_XXXXXX";
+    h = open_db(empty_inner, 12, 0);
+    test_expect(h, "select * from a join b on a.v = b.id", "{\"ok\":true,\"rows\":[]}");
+    check_index_join(h);
+    test_close_db(h, empty_inner);
+
+    printf("  ✓ test_join_index passed\n");
+}
+
+// Both sides on their primary keys merge; the same join through b2.bid
+// must return the same rows
+static void check_merge_join(MYDB_Handle h) {
+    const char* join = "a join b x on a.id = x.id";
+    const char* hash = "a join b2 x on a.id = x.bid";
+    check_same(h, "select a.id, a.v, x.w from %s order by a.id", join, hash);
+    check_same(h, "select count(*) from %s", join, hash);
+    check_same(h, "select a.id, x.w from %s where a.v = 2 order by x.w desc limit 7 offset 3", join, hash);
+    check_same(h, "select x.w, a.v from %s order by a.id", "b x join a on x.id = a.id", "b2 x join a on x.bid = a.id");
+}
+
+void test_join_merge() {
+    printf("Running test_join_merge...\n");
+
+    // Keys overlap from -10 to 3989, negatives included, across many leaves
+    char path[] = "/tmp/test_join_XXXXXX";
+    MYDB_Handle h = open_db(path, 4000, INNER_ROWS);
+    test_expect_part(h, "explain select * from a join b on a.id = b.id", "\"op\":\"Merge Join\"");
+    test_expect_part(h, "explain select * from b join a on b.id = a.id", "\"op\":\"Merge Join\"");
+    test_expect(h, "select a.id, b.w from a join b on a.id = b.id where a.id < -8 order by a.id",
+                "{\"ok\":true,\"rows\":[{\"a.id\":-10,\"b.w\":-30},{\"a.id\":-9,\"b.w\":-27}]}");
+    test_expect(h, "select count(*) from a join b on a.id = b.id", "{\"ok\":true,\"rows\":[{\"count(*)\":4000}]}");
+    check_merge_join(h);
+
+    // Gaps on either side, and leaves emptied by the deletes
+    test_run(h, "use a");
+    test_run(h, "delete from a where id between 100 and 1500");
+    test_run(h, "delete from a where v = 2");
+    test_run(h, "use b");
+    test_run(h, "delete from b where id between 1000 and 2500");
+    test_run(h, "delete from b where id < -5");
+    test_run(h, "use b2");
+    test_run(h, "delete from b2 where bid between 1000 and 2500");
+    test_run(h, "delete from b2 where bid < -5");
+    check_merge_join(h);
+    test_close_db(h, path);
+
+    // Either side empty
+    char empty_left[] = "/tmp/test_join_XXXXXX";
+    h = open_db(empty_left, 0, INNER_ROWS);
+    test_expect_part(h, "explain select * from a join b on a.id = b.id", "\"op\":\"Merge Join\"");
+    test_expect(h, "select * from a join b on a.id = b.id", "{\"ok\":true,\"rows\":[]}");
+    check_merge_join(h);
+    test_close_db(h, empty_left);
+
+    char empty_right[] = "/tmp/test_join_XXXXXX";
+    h = open_db(empty_right, 4000, 0);
+    test_expect(h, "select * from a join b on a.id = b.id", "{\"ok\":true,\"rows\":[]}");
+    check_merge_join(h);
+    test_close_db(h, empty_right);
+
+    printf("  ✓ test_join_merge passed\n");
+}
+
+int main() {
+    printf("\n=== Running Join Tests ===\n\n");
+
+    test_join_index();
+    test_join_merge();
+
+    printf("\n=== All Join Tests Passed ===\n\n");
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include "../include/plancache.h"
+#include "helpers.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+static void check_normalized(const char* sql, const char* key, uint32_t n_literals) {
+    NormalizedSql n;
+    assert(sql_normalize(sql, &n));
+    assert(strcmp(n.key, key) == 0);
+    assert(n.n_literals == n_literals);
+    normalized_sql_free(&n);
+}
+
+static void check_rejected(const char* sql) {
+    NormalizedSql n;
+    assert(!sql_normalize(sql, &n));
+    assert(n.key == NULL && n.n_literals == 0);
+}
+
+void test_plancache_normalize() {
+    printf("Running test_plancache_normalize...\n");
+
+    check_normalized("select * from t where id = 5", "select * from t where id = ?", 1);
+    // Constants and spacing do not matter; quoted strings are constants too
+    check_normalized("select  name from t where name='bob'   and v in (1, -2)",
+                     "select name from t where name = ? and v in ( ? , ? )", 3);
+    NormalizedSql n;
+    assert(sql_normalize("update t set name = \"a b\", v = -7 where id between 3 and 4", &n));
+    assert(strcmp(n.key, "update t set name = ? , v = ? where id between ? and ?") == 0);
+    assert(n.n_literals == 4);
+    assert(strcmp(n.literals[0], "a b") == 0);
+    assert(strcmp(n.literals[1], "-7") == 0);
+    assert(strcmp(n.literals[3], "4") == 0);
+    normalized_sql_free(&n);
+
+    // LIMIT and OFFSET take no placeholder
+    check_normalized("select * from t where id > 1 limit 10 offset 2",
+                     "select * from t where id > ? limit 10 offset 2", 1);
+    check_normalized("insert into t values (1, 'x'), (2, 'y')",
+                     "insert into t values ( ? , ? ) , ( ? , ? )", 4);
+    check_normalized("delete from t", "delete from t", 0);
+
+    // The legacy INSERT, statements run while preparing and explicit placeholders
+    check_rejected("insert into t 1 x 2");
+    check_rejected("insert into t");
+    check_rejected("create table t (id int)");
+    check_rejected("use t");
+    check_rejected("select * from t where id = ?");
+
+    printf("  ✓ test_plancache_normalize passed\n");
+}
+
+void test_plancache_lru_and_invalidation() {
+    printf("Running test_plancache_lru_and_invalidation...\n");
+
+    char path[] = "/tmp/test_plancache_XXXXXX";
+    MYDB_Handle h = test_open_db(path);
+    Table* t = (Table*)h;
+    assert(t->plans && plancache_capacity(t->plans) == PLAN_CACHE_DEFAULT_ENTRIES);
+    assert(mydb_set_plan_cache(h, 2) == 0);
+
+    test_run(h, "create table t (id int, name string)");
+    test_run(h, "use t");
+    test_run(h, "insert into t values (1, 'a'), (2, 'b')");
+    test_run(h, "insert into t values (3, 'c'), (4, 'd')");
+    assert(t->stats.plans.misses == 1 && t->stats.plans.hits == 1);
+
+    // A hit runs with its own constants
+    test_expect(h, "select name from t where id = 2", "{\"ok\":true,\"rows\":[{\"name\":\"b\"}]}");
+    test_expect(h, "select name from t where id = 4", "{\"ok\":true,\"rows\":[{\"name\":\"d\"}]}");
+    assert(t->stats.plans.hits == 2 && plancache_entries(t->plans) == 2);
+
+    // The INSERT is least recently used, so a third statement replaces it
+    test_expect(h, "select name from t where id > 3", "{\"ok\":true,\"rows\":[{\"name\":\"d\"}]}");
+    assert(t->stats.plans.evictions == 1);
+    test_expect(h, "select name from t where id = 1", "{\"ok\":true,\"rows\":[{\"name\":\"a\"}]}");
+    assert(t->stats.plans.hits == 3);
+    test_run(h, "insert into t values (5, 'e'), (6, 'f')");
+    assert(t->stats.plans.misses == 4 && t->stats.plans.evictions == 2);
+
+    // A catalog change drops every entry
+    test_run(h, "create table u (id int)");
+    test_expect(h, "select name from t where id = 6", "{\"ok\":true,\"rows\":[{\"name\":\"f\"}]}");
+    assert(t->stats.plans.invalidations == 1 && plancache_entries(t->plans) == 1);
+
+    // Turned off, nothing is cached or counted
+    assert(mydb_set_plan_cache(h, 0) == 0);
+    test_expect(h, "select name from t where id = 5", "{\"ok\":true,\"rows\":[{\"name\":\"e\"}]}");
+    assert(plancache_entries(t->plans) == 0 && t->stats.plans.misses == 5);
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_plancache_lru_and_invalidation passed\n");
+}
+
+int main() {
+    printf("\n=== Running Plan Cache Tests ===\n\n");
+
+    test_plancache_normalize();
+    test_plancache_lru_and_invalidation();
+
+    printf("\n=== All Plan Cache Tests Passed ===\n\n");
+    return 0;
+}
@@ -0,0 +1,114 @@
+#include "../include/predicate.h"
+#include "../include/sql_executor.h"
+#include "../sql_parser.h"
+#include "helpers.h"
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+static Table table;
+static uint8_t rows[4][64];
+
+static void setup_table() {
+    test_table_init(&table, "id int, name string(16), ts timestamp");
+    table.root_page_num = 1;
+
+    char* r0[] = {"1", "alice", "100"};
+    char* r1[] = {"2", "bob", "200"};
+    char* r2[] = {"3", "", "300"};
+    char* r3[] = {"-4", "0123456789abcdef", "-5"};
+    serialize_row_dynamic(&table, r0, 3, rows[0]);
+    serialize_row_dynamic(&table, r1, 3, rows[1]);
+    serialize_row_dynamic(&table, r2, 3, rows[2]);
+    serialize_row_dynamic(&table, r3, 3, rows[3]);
+}
+
+/* Returns a bitmask of matching rows, asserting both evaluators agree */
+static unsigned match_mask(const char* where) {
+    char sql[512];
+    snprintf(sql, sizeof(sql), "select * from t where %s", where);
+    ParsedStmt ps;
+    assert(parse_sql_to_parsed_stmt(sql, &ps) == 0);
+    Predicate* p = predicate_compile(&table, ps.where);
+    assert(p != NULL);
+
+    unsigned mask = 0;
+    for (int i = 0; i < 4; i++) {
+        bool compiled = predicate_eval(p, rows[i]);
+        bool interpreted = eval_expr_to_bool(&table, rows[i], ps.where) != 0;
+        assert(compiled == interpreted);
+        mask |= compiled ? (1u << i) : 0;
+    }
+
+    // The batch evaluator must select exactly the same rows, in order
+    uint32_t sel[4];
+    uint32_t m = predicate_filter_batch(p, rows, sizeof(rows[0]), 4, sel);
+    unsigned batch_mask = 0;
+    for (uint32_t k = 0; k < m; k++) {
+        assert(k == 0 || sel[k] > sel[k - 1]);
+        batch_mask |= 1u << sel[k];
+    }
+    assert(batch_mask == mask);
+
+    predicate_free(p);
+    parsed_stmt_free(&ps);
+    return mask;
+}
+
+void test_predicate_comparisons() {
+    printf("Running test_predicate_comparisons...\n");
+
+    assert(match_mask("id = 2") == 0x2);
+    assert(match_mask("2 < id") == 0x4);
+    assert(match_mask("id != 2") == 0xD);
+    assert(match_mask("ts >= 200") == 0x6);
+    assert(match_mask("name = 'bob'") == 0x2);
+    assert(match_mask("name > 'b'") == 0x2);
+    assert(match_mask("name = '0123456789abcdef'") == 0x8);
+    assert(match_mask("name = 0") == 0xF);
+    assert(match_mask("id = 'x'") == 0x0);
+    assert(match_mask("missing = 0") == 0xF);
+
+    printf("  ✓ test_predicate_comparisons passed\n");
+}
+
+void test_predicate_between_in() {
+    printf("Running test_predicate_between_in...\n");
+
+    assert(match_mask("id between 2 and 3") == 0x6);
+    assert(match_mask("ts between -10 and 150") == 0x9);
+    assert(match_mask("name between 'a' and 'b'") == 0x1);
+    assert(match_mask("id in (3, 1, 99)") == 0x5);
+    assert(match_mask("id in ()") == 0x0);
+    assert(match_mask("name in ('bob', 'alice')") == 0x3);
+    assert(match_mask("name in ('zed', 0)") == 0xF);
+    assert(match_mask("id in (ts, 2)") == 0x2);
+
+    printf("  ✓ test_predicate_between_in passed\n");
+}
+
+void test_predicate_logic() {
+    printf("Running test_predicate_logic...\n");
+
+    assert(match_mask("id > 1 and ts < 300") == 0x2);
+    assert(match_mask("id = 1 or name = 'bob'") == 0x3);
+    assert(match_mask("not (id = 1 or id = 2)") == 0xC);
+    assert(match_mask("(id < 0 or id > 2) and not (name = '')") == 0x8);
+    assert(match_mask("name") == 0xB);
+    assert(match_mask("id") == 0xF);
+    assert(match_mask("0") == 0x0);
+
+    printf("  ✓ test_predicate_logic passed\n");
+}
+
+int main() {
+    printf("\n=== Running Predicate Tests ===\n\n");
+
+    setup_table();
+    test_predicate_comparisons();
+    test_predicate_between_in();
+    test_predicate_logic();
+
+    printf("\n=== All Predicate Tests Passed ===\n\n");
+    return 0;
+}
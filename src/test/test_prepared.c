@@ -0,0 +1,207 @@
+#include "helpers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+static MYDB_Handle open_db(char* path) {
+    MYDB_Handle h = test_open_db(path);
+    test_run(h, "create table t (id int, v int, ts timestamp, name string)");
+    test_run(h, "use t");
+    return h;
+}
+
+static MYDB_Stmt prepare(MYDB_Handle h, const char* sql) {
+    MYDB_Stmt st = NULL;
+    assert(mydb_prepare(h, sql, &st) == 0);
+    assert(st != NULL);
+    return st;
+}
+
+// Run `st`, which must return exactly `want`
+static void expect_prepared(MYDB_Stmt st, const char* want) {
+    char* out = NULL;
+    assert(mydb_execute_prepared(st, &out) == 0);
+    if (strcmp(out, want) != 0) {
+        fprintf(stderr, "  got:  %s\n  want: %s\n", out, want);
+        assert(0);
+    }
+    free(out);
+}
+
+void test_prepared_bind_types() {
+    printf("Running test_prepared_bind_types...\n");
+
+    char path[] = "/tmp/test_prepared_XXXXXX";
+    MYDB_Handle h = open_db(path);
+
+    // One placeholder per column, each bound by its own type
+    MYDB_Stmt ins = prepare(h, "insert into t values (?, ?, ?, ?)");
+    for (int i = 1; i <= 3; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "row %d", i);
+        assert(mydb_bind_int(ins, 1, i) == 0);
+        assert(mydb_bind_int(ins, 2, -i) == 0);
+        assert(mydb_bind_int64(ins, 3, 5000000000LL * i) == 0);
+        assert(mydb_bind_text(ins, 4, name) == 0);
+        expect_prepared(ins, "{\"ok\":true}");
+    }
+    mydb_finalize(ins);
+    test_expect(h, "select * from t where id = 2",
+                "{\"ok\":true,\"rows\":[{\"id\":2,\"v\":-2,\"ts\":10000000000,\"name\":\"row 2\"}]}");
+
+    // And in WHERE, against each type of column
+    MYDB_Stmt sel = prepare(h, "select id from t where v = ? or ts = ? or name = ?");
+    assert(mydb_bind_int(sel, 1, -1) == 0);
+    assert(mydb_bind_int64(sel, 2, 15000000000LL) == 0);
+    assert(mydb_bind_text(sel, 3, "row 2") == 0);
+    expect_prepared(sel, "{\"ok\":true,\"rows\":[{\"id\":1},{\"id\":2},{\"id\":3}]}");
+    mydb_finalize(sel);
+
+    // And in SET
+    MYDB_Stmt upd = prepare(h, "update t set ts = ?, name = ? where id = ?");
+    assert(mydb_bind_int64(upd, 1, -7) == 0);
+    assert(mydb_bind_text(upd, 2, "renamed") == 0);
+    assert(mydb_bind_int(upd, 3, 3) == 0);
+    expect_prepared(upd, "{\"ok\":true}");
+    mydb_finalize(upd);
+    test_expect(h, "select ts, name from t where id = 3",
+                "{\"ok\":true,\"rows\":[{\"ts\":-7,\"name\":\"renamed\"}]}");
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_prepared_bind_types passed\n");
+}
+
+void test_prepared_bind_errors() {
+    printf("Running test_prepared_bind_errors...\n");
+
+    char path[] = "/tmp/test_prepared_XXXXXX";
+    MYDB_Handle h = open_db(path);
+    test_run(h, "insert into t values (1, 10, 100, 'a')");
+
+    // Placeholders are numbered 1 .. count
+    MYDB_Stmt upd = prepare(h, "update t set v = ? where id = ?");
+    assert(mydb_bind_int(upd, 0, 5) == -2);
+    assert(mydb_bind_int(upd, -1, 5) == -2);
+    assert(mydb_bind_int(upd, 3, 5) == -3);
+    assert(mydb_bind_text(upd, 1, NULL) == -2);
+    assert(mydb_bind_int(NULL, 1, 5) == -2);
+
+    // Running with a placeholder unbound fails and changes nothing
+    char* out = NULL;
+    assert(mydb_execute_prepared(upd, &out) == -6);
+    assert(out == NULL);
+    assert(mydb_bind_int(upd, 1, 99) == 0);
+    assert(mydb_execute_prepared(upd, &out) == -6);
+    test_expect(h, "select v from t", "{\"ok\":true,\"rows\":[{\"v\":10}]}");
+
+    // So does a value that does not fit its column
+    assert(mydb_bind_text(upd, 1, "not a number") == 0);
+    assert(mydb_bind_int(upd, 2, 1) == 0);
+    assert(mydb_execute_prepared(upd, &out) == -6);
+    test_expect(h, "select v from t", "{\"ok\":true,\"rows\":[{\"v\":10}]}");
+    assert(mydb_bind_int(upd, 1, 99) == 0);
+    expect_prepared(upd, "{\"ok\":true}");
+    test_expect(h, "select v from t", "{\"ok\":true,\"rows\":[{\"v\":99}]}");
+    mydb_finalize(upd);
+
+    // A statement without placeholders takes no bindings
+    MYDB_Stmt sel = prepare(h, "select id from t");
+    assert(mydb_bind_int(sel, 1, 1) == -3);
+    expect_prepared(sel, "{\"ok\":true,\"rows\":[{\"id\":1}]}");
+    mydb_finalize(sel);
+
+    // What cannot be prepared leaves no statement behind
+    MYDB_Stmt st = (MYDB_Stmt)&st;
+    assert(mydb_prepare(h, "select from where", &st) == -3 && st == NULL);
+    assert(mydb_prepare(h, "create table u (id int)", &st) == -4 && st == NULL);
+    assert(mydb_prepare(h, "use t", &st) == -4 && st == NULL);
+    assert(mydb_prepare(NULL, "select id from t", &st) == -2 && st == NULL);
+    assert(mydb_prepare(h, "select id from t", NULL) == -1);
+    assert(mydb_execute_prepared(NULL, &out) == -2);
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_prepared_bind_errors passed\n");
+}
+
+void test_prepared_rebind() {
+    printf("Running test_prepared_rebind...\n");
+
+    char path[] = "/tmp/test_prepared_XXXXXX";
+    MYDB_Handle h = open_db(path);
+    test_run(h, "insert into t values (1, 10, 0, 'a'), (2, 20, 0, 'b'), (3, 30, 0, 'c')");
+
+    // Values stay bound across runs until rebound
+    MYDB_Stmt sel = prepare(h, "select id from t where v > ? order by id desc");
+    assert(mydb_bind_int(sel, 1, 15) == 0);
+    expect_prepared(sel, "{\"ok\":true,\"rows\":[{\"id\":3},{\"id\":2}]}");
+    expect_prepared(sel, "{\"ok\":true,\"rows\":[{\"id\":3},{\"id\":2}]}");
+    assert(mydb_bind_int(sel, 1, 25) == 0);
+    expect_prepared(sel, "{\"ok\":true,\"rows\":[{\"id\":3}]}");
+    assert(mydb_bind_text(sel, 1, "0") == 0);
+    expect_prepared(sel, "{\"ok\":true,\"rows\":[{\"id\":3},{\"id\":2},{\"id\":1}]}");
+
+    // Rows written between runs are seen by the next one
+    MYDB_Stmt ins = prepare(h, "insert into t values (?, ?, 0, 'd')");
+    assert(mydb_bind_int(ins, 1, 4) == 0);
+    assert(mydb_bind_int(ins, 2, 40) == 0);
+    expect_prepared(ins, "{\"ok\":true}");
+    // The same key again is a duplicate; a new one goes in
+    expect_prepared(ins, "{\"ok\":false,\"error\":\"duplicate_key\"}");
+    assert(mydb_bind_int(ins, 1, 5) == 0);
+    expect_prepared(ins, "{\"ok\":true}");
+    mydb_finalize(ins);
+    assert(mydb_bind_int(sel, 1, 35) == 0);
+    expect_prepared(sel, "{\"ok\":true,\"rows\":[{\"id\":5},{\"id\":4}]}");
+    mydb_finalize(sel);
+
+    // A primary key lookup rebinds to another key
+    MYDB_Stmt del = prepare(h, "delete from t where id = ?");
+    for (int id = 1; id <= 5; id += 2) {
+        assert(mydb_bind_int(del, 1, id) == 0);
+        expect_prepared(del, "{\"ok\":true}");
+    }
+    mydb_finalize(del);
+    test_expect(h, "select id from t", "{\"ok\":true,\"rows\":[{\"id\":2},{\"id\":4}]}");
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_prepared_rebind passed\n");
+}
+
+void test_prepared_finalize() {
+    printf("Running test_prepared_finalize...\n");
+
+    char path[] = "/tmp/test_prepared_XXXXXX";
+    MYDB_Handle h = open_db(path);
+
+    // Never executed, bound or not; nothing is written
+    mydb_finalize(prepare(h, "select * from t where id in (?, ?)"));
+    MYDB_Stmt ins = prepare(h, "insert into t values (?, 1, 2, 'x'), (?, 3, 4, 'y')");
+    assert(mydb_bind_int(ins, 1, 8) == 0);
+    mydb_finalize(ins);
+    MYDB_Stmt upd = prepare(h, "update t set name = ? where id = ?");
+    assert(mydb_bind_text(upd, 1, "z") == 0);
+    assert(mydb_bind_int(upd, 2, 8) == 0);
+    mydb_finalize(upd);
+    mydb_finalize(NULL);
+    test_expect(h, "select count(*) from t", "{\"ok\":true,\"rows\":[{\"count(*)\":0}]}");
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_prepared_finalize passed\n");
+}
+
+int main() {
+    printf("\n=== Running Prepared Statement Tests ===\n\n");
+
+    test_prepared_bind_types();
+    test_prepared_bind_errors();
+    test_prepared_rebind();
+    test_prepared_finalize();
+
+    printf("\n=== All Prepared Statement Tests Passed ===\n\n");
+    return 0;
+}
@@ -0,0 +1,286 @@
+#include "../include/btree.h"
+#include "helpers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define ROWS 3000
+
+// Rows id = first, first + step, ... below ROWS, with v = id % 10
+static void insert_ids(MYDB_Handle h, int first, int step) {
+    char* sql = malloc(64 + (size_t)ROWS * 24);
+    assert(sql);
+    size_t len = (size_t)sprintf(sql, "insert into t values ");
+    for (int id = first; id < ROWS; id += step) {
+        len += (size_t)sprintf(sql + len, "%s(%d, %d)", id == first ? "" : ", ", id, id % 10);
+    }
+    test_run(h, sql);
+    free(sql);
+}
+
+// Every leaf splits as rows arrive in ten interleaved batches
+static MYDB_Handle open_db(char* path) {
+    MYDB_Handle h = test_open_db(path);
+    test_run(h, "create table t (id int, v int)");
+    test_run(h, "use t");
+    for (int r = 0; r < 10; r++) {
+        insert_ids(h, (r * 7) % 10, 10);
+    }
+    return h;
+}
+
+// `tail` gives the same rows with and without a filter every row passes,
+// which keeps the query off the position seek
+static void check_same(MYDB_Handle h, const char* tail) {
+    char fast[256], slow[256];
+    snprintf(fast, sizeof(fast), "select id from t %s", tail);
+    snprintf(slow, sizeof(slow), "select id from t where v > -1 %s", tail);
+    char* a = test_json(h, fast);
+    char* b = test_json(h, slow);
+    if (strcmp(a, b) != 0) {
+        fprintf(stderr, "%s\n  seek:    %s\n  general: %s\n", tail, a, b);
+        assert(0);
+    }
+    free(a);
+    free(b);
+}
+
+static void check_positions(MYDB_Handle h) {
+    check_same(h, "limit 5");
+    check_same(h, "limit 5 offset 1234");
+    check_same(h, "order by id limit 3 offset 2990");
+    check_same(h, "order by id desc limit 4 offset 17");
+    check_same(h, "order by id limit 10 offset 5000");
+    check_same(h, "order by id desc limit 0");
+}
+
+void test_select_subtree_counts() {
+    printf("Running test_select_subtree_counts...\n");
+
+    char path[] = "/tmp/test_select_XXXXXX";
+    MYDB_Handle h = open_db(path);
+    Table* t = (Table*)h;
+
+    // The counts give every row's position without walking the leaves
+    assert(table_row_count(t) == ROWS);
+    for (uint32_t n = 0; n < ROWS; n += 97) {
+        Cursor* c = table_seek_nth(t, n);
+        assert(!c->end_of_table && *(uint32_t*)cursor_value(c) == n);
+        free(c);
+        assert(table_rank(t, n) == n);
+    }
+    Cursor* c = table_seek_nth(t, ROWS);
+    assert(c->end_of_table);
+    free(c);
+    assert(table_rank(t, ROWS + 5) == ROWS);
+
+    // And stay right as rows go
+    test_run(h, "delete from t where id < 1000 and v = 3");
+    test_run(h, "delete from t where id between 2000 and 2499");
+    assert(table_row_count(t) == ROWS - 100 - 500);
+    assert(table_rank(t, 2000) == 1900 && table_rank(t, 2500) == 1900);
+    test_expect(h, "select count(*) from t", "{\"ok\":true,\"rows\":[{\"count(*)\":2400}]}");
+    test_expect(h, "select count(*) from t where v = 3", "{\"ok\":true,\"rows\":[{\"count(*)\":150}]}");
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_select_subtree_counts passed\n");
+}
+
+void test_select_offset_seek() {
+    printf("Running test_select_offset_seek...\n");
+
+    char path[] = "/tmp/test_select_XXXXXX";
+    MYDB_Handle h = open_db(path);
+
+    test_expect_part(h, "explain select id from t order by id limit 2 offset 5",
+                     "\"op\":\"Position Seek\",\"detail\":\"on t, ascending, offset 5\"");
+    test_expect_part(h, "explain select id from t where v > -1 order by id limit 2", "\"op\":\"Top-K\"");
+    test_expect(h, "select id from t order by id desc limit 2 offset 1",
+                "{\"ok\":true,\"rows\":[{\"id\":2998},{\"id\":2997}]}");
+    check_positions(h);
+    test_run(h, "delete from t where v < 5");
+    check_positions(h);
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_select_offset_seek passed\n");
+}
+
+void test_select_negative_keys() {
+    printf("Running test_select_negative_keys...\n");
+
+    char path[] = "/tmp/test_select_XXXXXX";
+    MYDB_Handle h = test_open_db(path);
+    test_run(h, "create table t (id int, v int)");
+    test_run(h, "use t");
+    test_run(h, "insert into t values (3, 1), (-1, 1), (7, 1), (-5, 1)");
+
+    // ORDER BY compares ids signed; the tree keeps negatives last
+    test_expect(h, "select id from t order by id",
+                "{\"ok\":true,\"rows\":[{\"id\":-5},{\"id\":-1},{\"id\":3},{\"id\":7}]}");
+    test_expect(h, "select id from t order by id limit 2", "{\"ok\":true,\"rows\":[{\"id\":-5},{\"id\":-1}]}");
+    test_expect(h, "select id from t order by id desc limit 2", "{\"ok\":true,\"rows\":[{\"id\":7},{\"id\":3}]}");
+    test_expect(h, "select id from t order by id limit 2 offset 1",
+                "{\"ok\":true,\"rows\":[{\"id\":-1},{\"id\":3}]}");
+    test_expect(h, "select id from t order by id desc limit 3 offset 2",
+                "{\"ok\":true,\"rows\":[{\"id\":-1},{\"id\":-5}]}");
+    test_expect(h, "select count(*), min(id), max(id) from t",
+                "{\"ok\":true,\"rows\":[{\"count(*)\":4,\"min(id)\":-5,\"max(id)\":7}]}");
+
+    // Many of both signs, across leaves
+    char sql[64];
+    for (int i = 1; i <= 600; i++) {
+        snprintf(sql, sizeof(sql), "insert into t values (%d, 2)", i % 2 ? -10 - i : 10 + i);
+        test_run(h, sql);
+    }
+    for (uint32_t off = 0; off < 610; off += 151) {
+        char tail[96];
+        snprintf(tail, sizeof(tail), "order by id limit 7 offset %u", off);
+        check_same(h, tail);
+        snprintf(tail, sizeof(tail), "order by id desc limit 300 offset %u", off);
+        check_same(h, tail);
+    }
+    check_same(h, "order by id limit 1000 offset 299");
+    check_same(h, "limit 5 offset 302");
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_select_negative_keys passed\n");
+}
+
+// An IN list on the key is looked up key by key; OR-ing a predicate no
+// row passes keeps the same query on the filtered scan
+static void check_in_list(MYDB_Handle h, const char* list, const char* rest) {
+    char lookup[4096], scan[4096];
+    snprintf(lookup, sizeof(lookup), "select id, v from t where id in %s%s", list, rest);
+    snprintf(scan, sizeof(scan), "select id, v from t where (id in %s or v < -1)%s", list, rest);
+    char* a = test_json(h, lookup);
+    char* b = test_json(h, scan);
+    if (strcmp(a, b) != 0) {
+        fprintf(stderr, "%s\n  lookup: %s\n  scan:   %s\n", lookup, a, b);
+        assert(0);
+    }
+    free(a);
+    free(b);
+}
+
+void test_select_in_list() {
+    printf("Running test_select_in_list...\n");
+
+    char path[] = "/tmp/test_select_XXXXXX";
+    MYDB_Handle h = open_db(path);
+    test_run(h, "insert into t values (-7, 3)");
+
+    test_expect_part(h, "explain select * from t where id in (4, 1, 9)", "\"op\":\"Key Scan\"");
+    test_expect(h, "select id from t where id in (9, 1, 4, 1)",
+                "{\"ok\":true,\"rows\":[{\"id\":1},{\"id\":4},{\"id\":9}]}");
+    test_expect(h, "select id from t where id in ()", "{\"ok\":true,\"rows\":[]}");
+
+    // Duplicates, misses, both ends, a negative key, out-of-range numbers
+    // and a string, which compares as 0
+    const char* lists[] = {
+        "(5)", "()", "(17, 5, 17, 5)", "(2999, 0, 3000, 123456)", "(-7, -8, 7)",
+        "(99999999999, -99999999999, 12)", "('abc', 1)",
+    };
+    const char* rests[] = { "", " and v > 4", " order by id desc", " order by v, id limit 2 offset 1" };
+    for (size_t i = 0; i < sizeof(lists) / sizeof(lists[0]); i++) {
+        for (size_t j = 0; j < sizeof(rests) / sizeof(rests[0]); j++) {
+            check_in_list(h, lists[i], rests[j]);
+        }
+    }
+
+    // A long list spanning every leaf
+    char list[2048];
+    size_t len = (size_t)sprintf(list, "(3");
+    for (int i = 1; i < 300; i++) {
+        len += (size_t)sprintf(list + len, ", %d", i * 11);
+    }
+    sprintf(list + len, ")");
+    check_in_list(h, list, "");
+    check_in_list(h, list, " and v = 2");
+
+    // Writes go through the same lookup
+    test_run(h, "delete from t where id in (1, 2, 3, -7, 5000)");
+    test_expect(h, "select count(*) from t where id < 5", "{\"ok\":true,\"rows\":[{\"count(*)\":2}]}");
+    test_run(h, "update t set v = 42 where id in (0, 4, 4)");
+    test_expect(h, "select id from t where v = 42", "{\"ok\":true,\"rows\":[{\"id\":0},{\"id\":4}]}");
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_select_in_list passed\n");
+}
+
+// Rows [offset, offset + limit) of a {"ok":true,"rows":[{...},...]} result
+// whose rows hold no braces
+static char* slice_rows(const char* json, int offset, int limit) {
+    char* out = malloc(strlen(json) + 1);
+    assert(out);
+    size_t len = (size_t)sprintf(out, "{\"ok\":true,\"rows\":[");
+    const char* row = strchr(json, '[');
+    assert(row);
+    for (int i = 0; (row = strchr(row, '{')) != NULL && i < offset + limit; i++) {
+        const char* end = strchr(row, '}');
+        assert(end);
+        if (i >= offset) {
+            len += (size_t)sprintf(out + len, "%s%.*s", i > offset ? "," : "", (int)(end - row + 1), row);
+        }
+        row = end;
+    }
+    sprintf(out + len, "]}");
+    return out;
+}
+
+// Top-K gives the rows a full sort would, then LIMIT/OFFSET
+static void check_top_k(MYDB_Handle h, const char* order, int limit, int offset) {
+    char sorted[256], top[320];
+    snprintf(sorted, sizeof(sorted), "select id, v from t where v > -1 order by %s", order);
+    snprintf(top, sizeof(top), "%s limit %d offset %d", sorted, limit, offset);
+    char* all = test_json(h, sorted);
+    char* want = slice_rows(all, offset, limit);
+    char* got = test_json(h, top);
+    if (strcmp(got, want) != 0) {
+        fprintf(stderr, "%s\n  top-k: %s\n  sort:  %s\n", top, got, want);
+        assert(0);
+    }
+    free(all);
+    free(want);
+    free(got);
+}
+
+void test_select_top_k() {
+    printf("Running test_select_top_k...\n");
+
+    char path[] = "/tmp/test_select_XXXXXX";
+    MYDB_Handle h = open_db(path);
+
+    test_expect_part(h, "explain select id from t where v > -1 order by v limit 5 offset 2",
+                     "\"op\":\"Top-K\",\"detail\":\"k=7\"");
+
+    // v takes ten values, so every K cuts through a run of ties
+    const char* orders[] = { "v", "v desc", "v, id desc", "v desc, id", "id desc" };
+    int limits[][2] = { { 1, 0 }, { 5, 0 }, { 25, 0 }, { 10, 295 }, { 7, 2990 }, { 50, 2980 }, { 5000, 0 }, { 10, 3000 } };
+    for (size_t i = 0; i < sizeof(orders) / sizeof(orders[0]); i++) {
+        for (size_t j = 0; j < sizeof(limits) / sizeof(limits[0]); j++) {
+            check_top_k(h, orders[i], limits[j][0], limits[j][1]);
+        }
+    }
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_select_top_k passed\n");
+}
+
+int main() {
+    printf("\n=== Running SELECT Tests ===\n\n");
+
+    test_select_subtree_counts();
+    test_select_offset_seek();
+    test_select_negative_keys();
+    test_select_in_list();
+    test_select_top_k();
+
+    printf("\n=== All SELECT Tests Passed ===\n\n");
+    return 0;
+}
@@ -0,0 +1,108 @@
+#include "../include/simd_filter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define N 300
+
+static int32_t v32[N];
+static int64_t v64[N];
+
+static int expect_cmp(CmpOp op, int64_t v, int64_t c) {
+    switch (op) {
+        case CMP_EQ: return v == c;
+        case CMP_NE: return v != c;
+        case CMP_LT: return v < c;
+        case CMP_LE: return v <= c;
+        case CMP_GT: return v > c;
+        case CMP_GE: return v >= c;
+    }
+    return 0;
+}
+
+static int bit(const uint64_t* mask, uint32_t i) {
+    return (int)((mask[i >> 6] >> (i & 63)) & 1);
+}
+
+static void fill_values() {
+    srand(32);
+    for (int i = 0; i < N; i++) {
+        v32[i] = (rand() % 21) - 10;
+        v64[i] = ((int64_t)(rand() % 21) - 10) * 4000000000LL;
+    }
+    v32[0] = INT32_MIN;
+    v32[1] = INT32_MAX;
+    v64[0] = INT64_MIN;
+    v64[1] = INT64_MAX;
+}
+
+/* Checks every kernel at the current level against plain C comparisons */
+static void check_level() {
+    const int64_t consts32[] = {-10, -1, 0, 3, 10, INT32_MIN, INT32_MAX, 5000000000LL, -5000000000LL};
+    const int64_t consts64[] = {0, 4000000000LL, -8000000000LL, INT64_MIN, INT64_MAX, 7};
+    uint64_t mask[(N + 63) / 64 + 1];
+
+    for (uint32_t n = 0; n <= N; n += (n < 20 ? 1 : 37)) {
+        for (int op = CMP_EQ; op <= CMP_GE; op++) {
+            for (size_t c = 0; c < sizeof(consts32) / sizeof(consts32[0]); c++) {
+                mask[n / 64] = 0xDEAD;
+                simd_filter_cmp_i32(v32, n, (CmpOp)op, consts32[c], mask);
+                for (uint32_t i = 0; i < n; i++) {
+                    assert(bit(mask, i) == expect_cmp((CmpOp)op, v32[i], consts32[c]));
+                }
+            }
+            for (size_t c = 0; c < sizeof(consts64) / sizeof(consts64[0]); c++) {
+                simd_filter_cmp_i64(v64, n, (CmpOp)op, consts64[c], mask);
+                for (uint32_t i = 0; i < n; i++) {
+                    assert(bit(mask, i) == expect_cmp((CmpOp)op, v64[i], consts64[c]));
+                }
+            }
+        }
+        simd_filter_between_i32(v32, n, -3, 4, mask);
+        for (uint32_t i = 0; i < n; i++) {
+            assert(bit(mask, i) == (v32[i] >= -3 && v32[i] <= 4));
+        }
+        simd_filter_between_i32(v32, n, -5000000000LL, 0, mask);
+        for (uint32_t i = 0; i < n; i++) {
+            assert(bit(mask, i) == (v32[i] <= 0));
+        }
+        simd_filter_between_i64(v64, n, -4000000000LL, INT64_MAX, mask);
+        for (uint32_t i = 0; i < n; i++) {
+            assert(bit(mask, i) == (v64[i] >= -4000000000LL));
+        }
+        simd_filter_between_i64(v64, n, 5, 4, mask);
+        for (uint32_t i = 0; i < n; i++) {
+            assert(bit(mask, i) == 0);
+        }
+    }
+}
+
+void test_simd_filter_levels() {
+    printf("Running test_simd_filter_levels...\n");
+
+    SimdLevel detected = simd_filter_level();
+    printf("  detected: %s\n", simd_filter_level_name(detected));
+
+    fill_values();
+    for (int level = SIMD_SCALAR; level <= SIMD_AVX2; level++) {
+        if (simd_filter_force((SimdLevel)level) != 0) {
+            printf("  (%s not supported, skipped)\n", simd_filter_level_name((SimdLevel)level));
+            continue;
+        }
+        assert(simd_filter_level() == (SimdLevel)level);
+        check_level();
+    }
+    assert(simd_filter_force(detected) == 0);
+
+    printf("  ✓ test_simd_filter_levels passed\n");
+}
+
+int main() {
+    printf("\n=== Running SIMD Filter Tests ===\n\n");
+
+    test_simd_filter_levels();
+
+    printf("\n=== All SIMD Filter Tests Passed ===\n\n");
+    return 0;
+}
@@ -0,0 +1,193 @@
+#include "../include/sortkey.h"
+#include "helpers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define N 3000
+
+static Table table;
+static uint8_t* rows;
+
+static const char* names[] = { "", "a", "ab", "abc", "b", "ba", "z\xc3\xa9", "zz" };
+
+static uint8_t* row_at(uint32_t i) {
+    return rows + (size_t)i * table.row_size;
+}
+
+static void fill_rows() {
+    uint32_t name_off = schema_col_offset(&table.active_schema, 1);
+    uint32_t ts_off = schema_col_offset(&table.active_schema, 2);
+    rows = calloc(N, table.row_size);
+    srand(36);
+    for (uint32_t i = 0; i < N; i++) {
+        int32_t id = (rand() % 11) - 5;
+        int64_t ts = ((int64_t)(rand() % 5) - 2) * 5000000000LL;
+        const char* name = names[rand() % 8];
+        memcpy(row_at(i), &id, 4);
+        memcpy(row_at(i) + name_off, name, strlen(name));
+        memcpy(row_at(i) + ts_off, &ts, 8);
+    }
+    // Extremes sort by value, not by raw bytes
+    int32_t id_min = INT32_MIN, id_max = INT32_MAX;
+    int64_t ts_min = INT64_MIN;
+    memcpy(row_at(0), &id_min, 4);
+    memcpy(row_at(1), &id_max, 4);
+    memcpy(row_at(2) + ts_off, &ts_min, 8);
+}
+
+/* Reference ORDER BY comparison, one column at a time */
+static int compare_rows(const SortSpec* spec, const void* a, const void* b) {
+    for (uint32_t i = 0; i < spec->n_cols; i++) {
+        int col = spec->cols[i].col_idx;
+        int cmp;
+        if (col == 0) {
+            int va = row_get_int(&table, a, col), vb = row_get_int(&table, b, col);
+            cmp = (va > vb) - (va < vb);
+        } else if (col == 2) {
+            int64_t va = row_get_timestamp(&table, a, col), vb = row_get_timestamp(&table, b, col);
+            cmp = (va > vb) - (va < vb);
+        } else {
+            char sa[32], sb[32];
+            row_get_string(&table, a, col, sa, sizeof(sa));
+            row_get_string(&table, b, col, sb, sizeof(sb));
+            cmp = strcmp(sa, sb);
+        }
+        if (cmp != 0) {
+            return spec->cols[i].desc ? -cmp : cmp;
+        }
+    }
+    return 0;
+}
+
+/* Sorts the first `n` rows and checks the result against compare_rows;
+ * rows that compare equal must keep their input order */
+static void sort_and_check(const SortSpec* spec, uint32_t n) {
+    SortKeyFormat fmt;
+    sortkey_format_init(&fmt, &table, spec);
+    uint8_t* keys = malloc((size_t)n * fmt.key_len + 1);
+    SortItem* items = malloc((n ? n : 1) * sizeof(SortItem));
+    for (uint32_t i = 0; i < n; i++) {
+        sortkey_encode(&fmt, row_at(i), i, keys + (size_t)i * fmt.key_len);
+        items[i].key = keys + (size_t)i * fmt.key_len;
+        items[i].row = row_at(i);
+    }
+
+    sortkey_sort(items, n, fmt.key_len);
+
+    for (uint32_t i = 1; i < n; i++) {
+        int cmp = compare_rows(spec, items[i - 1].row, items[i].row);
+        assert(cmp <= 0);
+        if (cmp == 0) {
+            assert(items[i - 1].row < items[i].row);
+        }
+    }
+    free(keys);
+    free(items);
+}
+
+void test_sortkey_single_column() {
+    printf("Running test_sortkey_single_column...\n");
+
+    for (int col = 0; col < 3; col++) {
+        SortSpec asc = { .cols = { { col, false } }, .n_cols = 1 };
+        SortSpec desc = { .cols = { { col, true } }, .n_cols = 1 };
+        sort_and_check(&asc, N);
+        sort_and_check(&desc, N);
+    }
+
+    printf("  ✓ test_sortkey_single_column passed\n");
+}
+
+void test_sortkey_multi_column() {
+    printf("Running test_sortkey_multi_column...\n");
+
+    SortSpec spec = { .cols = { { 1, false }, { 0, true }, { 2, false } }, .n_cols = 3 };
+    sort_and_check(&spec, N);
+    SortSpec spec2 = { .cols = { { 2, true }, { 1, true } }, .n_cols = 2 };
+    sort_and_check(&spec2, N);
+
+    // Below SORT_RADIX_MIN only insertion sort runs
+    sort_and_check(&spec, SORT_RADIX_MIN - 1);
+    sort_and_check(&spec, 1);
+    sort_and_check(&spec, 0);
+
+    printf("  ✓ test_sortkey_multi_column passed\n");
+}
+
+void test_sortkey_string_prefix() {
+    printf("Running test_sortkey_string_prefix...\n");
+
+    // A string sorts before any longer string it is a prefix of, in both directions
+    SortSpec spec = { .cols = { { 1, false } }, .n_cols = 1 };
+    SortKeyFormat fmt;
+    sortkey_format_init(&fmt, &table, &spec);
+    assert(fmt.key_len == 16 + 4);
+
+    uint32_t name_off = schema_col_offset(&table.active_schema, 1);
+    uint8_t a[64] = {0}, b[64] = {0};
+    uint8_t ka[32], kb[32];
+    memcpy(a + name_off, "ab", 2);
+    memcpy(b + name_off, "abc", 3);
+    sortkey_encode(&fmt, a, 0, ka);
+    sortkey_encode(&fmt, b, 0, kb);
+    assert(memcmp(ka, kb, fmt.key_len) < 0);
+
+    spec.cols[0].desc = true;
+    sortkey_format_init(&fmt, &table, &spec);
+    sortkey_encode(&fmt, a, 0, ka);
+    sortkey_encode(&fmt, b, 0, kb);
+    assert(memcmp(ka, kb, fmt.key_len) > 0);
+
+    printf("  ✓ test_sortkey_string_prefix passed\n");
+}
+
+void test_sortkey_parallel() {
+    printf("Running test_sortkey_parallel...\n");
+
+    // Enough rows to take the sample sort path; it must match the serial sort
+    uint32_t n = SORT_PARALLEL_MIN * 3;
+    SortSpec spec = { .cols = { { 2, true }, { 0, false } }, .n_cols = 2 };
+    SortKeyFormat fmt;
+    sortkey_format_init(&fmt, &table, &spec);
+    uint8_t* keys = malloc((size_t)n * fmt.key_len);
+    SortItem* serial = malloc(n * sizeof(SortItem));
+    SortItem* parallel = malloc(n * sizeof(SortItem));
+    for (uint32_t i = 0; i < n; i++) {
+        const uint8_t* row = row_at(i % N);
+        sortkey_encode(&fmt, row, i, keys + (size_t)i * fmt.key_len);
+        serial[i].key = keys + (size_t)i * fmt.key_len;
+        serial[i].row = row;
+    }
+    memcpy(parallel, serial, n * sizeof(SortItem));
+
+    sortkey_sort(serial, n, fmt.key_len);
+    for (uint32_t threads = 1; threads <= 5; threads += 2) {
+        SortItem* copy = malloc(n * sizeof(SortItem));
+        memcpy(copy, parallel, n * sizeof(SortItem));
+        sortkey_sort_parallel(copy, n, fmt.key_len, threads);
+        assert(memcmp(copy, serial, n * sizeof(SortItem)) == 0);
+        free(copy);
+    }
+
+    free(keys);
+    free(serial);
+    free(parallel);
+    printf("  ✓ test_sortkey_parallel passed\n");
+}
+
+int main() {
+    printf("\n=== Running Sort Key Tests ===\n\n");
+
+    test_table_init(&table, "id int, name string(16), ts timestamp");
+    fill_rows();
+    test_sortkey_single_column();
+    test_sortkey_multi_column();
+    test_sortkey_string_prefix();
+    test_sortkey_parallel();
+    free(rows);
+
+    printf("\n=== All Sort Key Tests Passed ===\n\n");
+    return 0;
+}
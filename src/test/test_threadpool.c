@@ -0,0 +1,103 @@
+#include "../include/threadpool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define TASKS 40
+
+typedef struct {
+    uint32_t index;
+    uint64_t sum;
+} Work;
+
+static void sum_task(void* arg) {
+    Work* w = (Work*)arg;
+    w->sum = 0;
+    for (uint64_t i = 0; i <= 20000ull * (w->index + 1); i++) {
+        w->sum += i;
+    }
+}
+
+static uint64_t expected_sum(uint32_t index) {
+    uint64_t n = 20000ull * (index + 1);
+    return n * (n + 1) / 2;
+}
+
+static void submit_all(TaskGroup* g, Work* work) {
+    for (uint32_t i = 0; i < TASKS; i++) {
+        work[i].index = i;
+        work[i].sum = 0;
+        task_group_submit(g, i, sum_task, &work[i]);
+    }
+}
+
+void test_threadpool_wait_in_order() {
+    printf("Running test_threadpool_wait_in_order...\n");
+
+    assert(threadpool_default_threads() >= 1);
+    assert(threadpool_start(4) >= 4);
+    Work work[TASKS];
+    TaskGroup* g = task_group_new(TASKS);
+    assert(g != NULL);
+    submit_all(g, work);
+    for (uint32_t i = 0; i < TASKS; i++) {
+        task_group_wait_one(g, i);
+        assert(work[i].sum == expected_sum(i));
+    }
+    task_group_free(g);
+
+    printf("  ✓ test_threadpool_wait_in_order passed\n");
+}
+
+void test_threadpool_wait_any() {
+    printf("Running test_threadpool_wait_any...\n");
+
+    Work work[TASKS];
+    uint8_t seen[TASKS] = {0};
+    TaskGroup* g = task_group_new(TASKS);
+    submit_all(g, work);
+    for (uint32_t n = 0; n < TASKS; n++) {
+        uint32_t i = task_group_wait_any(g);
+        assert(i < TASKS && !seen[i]);
+        seen[i] = 1;
+        assert(work[i].sum == expected_sum(i));
+    }
+    // Every task has been handed out
+    assert(task_group_wait_any(g) == UINT32_MAX);
+    task_group_free(g);
+
+    printf("  ✓ test_threadpool_wait_any passed\n");
+}
+
+void test_threadpool_wait_all() {
+    printf("Running test_threadpool_wait_all...\n");
+
+    Work work[TASKS];
+    TaskGroup* g = task_group_new(TASKS);
+    submit_all(g, work);
+    task_group_wait(g);
+    for (uint32_t i = 0; i < TASKS; i++) {
+        assert(work[i].sum == expected_sum(i));
+    }
+    task_group_free(g);
+
+    // A group with nothing submitted finishes immediately
+    g = task_group_new(0);
+    task_group_wait(g);
+    assert(task_group_wait_any(g) == UINT32_MAX);
+    task_group_free(g);
+
+    printf("  ✓ test_threadpool_wait_all passed\n");
+}
+
+int main() {
+    printf("\n=== Running Thread Pool Tests ===\n\n");
+
+    test_threadpool_wait_in_order();
+    test_threadpool_wait_any();
+    test_threadpool_wait_all();
+
+    printf("\n=== All Thread Pool Tests Passed ===\n\n");
+    return 0;
+}
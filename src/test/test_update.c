@@ -0,0 +1,150 @@
+#include "helpers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define ROWS 500
+
+// Rows id 0 .. ROWS - 1, with v = id % 10 and name "n<id>"
+static MYDB_Handle open_db(char* path) {
+    MYDB_Handle h = test_open_db(path);
+    test_run(h, "create table t (id int, v int, name string)");
+    test_run(h, "use t");
+    char* sql = malloc(64 + (size_t)ROWS * 32);
+    assert(sql);
+    size_t len = (size_t)sprintf(sql, "insert into t values ");
+    for (int id = 0; id < ROWS; id++) {
+        len += (size_t)sprintf(sql + len, "%s(%d, %d, 'n%d')", id ? ", " : "", id, id % 10, id);
+    }
+    test_run(h, sql);
+    free(sql);
+    return h;
+}
+
+// `sql` must be rejected and leave every row as it was
+static void expect_unchanged(MYDB_Handle h, const char* sql) {
+    char* before = test_json(h, "select * from t");
+    test_expect_error(h, sql);
+    char* after = test_json(h, "select * from t");
+    if (strcmp(before, after) != 0) {
+        fprintf(stderr, "%s changed the table\n", sql);
+        assert(0);
+    }
+    free(before);
+    free(after);
+}
+
+void test_update_in_place() {
+    printf("Running test_update_in_place...\n");
+
+    char path[] = "/tmp/test_update_XXXXXX";
+    MYDB_Handle h = open_db(path);
+
+    test_run(h, "update t set v = 42, name = 'x' where id between 10 and 14 or id = 300");
+    test_expect(h, "select id, name from t where v = 42",
+                "{\"ok\":true,\"rows\":[{\"id\":10,\"name\":\"x\"},{\"id\":11,\"name\":\"x\"},"
+                "{\"id\":12,\"name\":\"x\"},{\"id\":13,\"name\":\"x\"},{\"id\":14,\"name\":\"x\"},"
+                "{\"id\":300,\"name\":\"x\"}]}");
+    test_expect(h, "select count(*) from t where v = 4", "{\"ok\":true,\"rows\":[{\"count(*)\":49}]}");
+
+    // Every row, then none
+    test_run(h, "update t set v = 1;");
+    test_expect(h, "select count(*) from t where v = 1", "{\"ok\":true,\"rows\":[{\"count(*)\":500}]}");
+    test_run(h, "update t set v = 2 where id > 100000");
+    test_expect(h, "select count(*) from t where v = 2", "{\"ok\":true,\"rows\":[{\"count(*)\":0}]}");
+
+    // A bad SET changes nothing
+    expect_unchanged(h, "update t set v = 'abc' where id = 1");
+    expect_unchanged(h, "update t set nope = 1 where id = 1");
+    expect_unchanged(h, "update t set v = 1, v = 2 where id = 1");
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_update_in_place passed\n");
+}
+
+void test_update_moving_keys() {
+    printf("Running test_update_moving_keys...\n");
+
+    char path[] = "/tmp/test_update_XXXXXX";
+    MYDB_Handle h = open_db(path);
+
+    // The row moves to its new key, keeping its other columns
+    test_run(h, "update t set id = 1000, v = 9 where id = 3");
+    test_expect(h, "select * from t where id = 3", "{\"ok\":true,\"rows\":[]}");
+    test_expect(h, "select * from t where id = 1000",
+                "{\"ok\":true,\"rows\":[{\"id\":1000,\"v\":9,\"name\":\"n3\"}]}");
+    test_expect(h, "select id from t order by id desc limit 2",
+                "{\"ok\":true,\"rows\":[{\"id\":1000},{\"id\":499}]}");
+    test_run(h, "update t set id = -1 where id = 1000");
+    test_expect(h, "select id, name from t order by id limit 1",
+                "{\"ok\":true,\"rows\":[{\"id\":-1,\"name\":\"n3\"}]}");
+    test_expect(h, "select count(*) from t", "{\"ok\":true,\"rows\":[{\"count(*)\":500}]}");
+
+    // A row may keep its own key
+    test_run(h, "update t set id = 7 where id = 7");
+    test_expect(h, "select name from t where id = 7", "{\"ok\":true,\"rows\":[{\"name\":\"n7\"}]}");
+
+    // A key another row holds, or two rows moving to one key, fails whole
+    expect_unchanged(h, "update t set id = 5 where id = 4");
+    expect_unchanged(h, "update t set id = 2000 where id < 3");
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_update_moving_keys passed\n");
+}
+
+void test_update_malformed_where() {
+    printf("Running test_update_malformed_where...\n");
+
+    char path[] = "/tmp/test_update_XXXXXX";
+    MYDB_Handle h = open_db(path);
+
+    // A predicate with a missing part must not be read as "every row"
+    const char* wheres[] = {
+        "where", "where id = 1 or", "where id = 1 and", "where and", "where or id = 1",
+        "where id = 1 or or id = 2", "where (", "where (id = 1", "where id =", "where not",
+        "where id between 1", "where id between 1 and", "where id between and 5",
+        "where id in (1,", "where id in (1, 2", "where id in (1,)", "where id in 1",
+        "where id is 5", "wher id = 1", "where id = 1 garbage",
+    };
+    for (size_t i = 0; i < sizeof(wheres) / sizeof(wheres[0]); i++) {
+        char sql[128];
+        snprintf(sql, sizeof(sql), "update t set v = 77 %s", wheres[i]);
+        expect_unchanged(h, sql);
+    }
+    test_expect(h, "select count(*) from t where v = 77", "{\"ok\":true,\"rows\":[{\"count(*)\":0}]}");
+
+    // SELECT rejects the same predicates,
+    test_expect_error(h, "select * from t where id = 1 or");
+    test_expect_error(h, "select * from t where");
+    test_expect_error(h, "select * from t where id in (1,");
+    // and anything after a complete statement, such as an unknown LIKE
+    test_expect_error(h, "select * from t where id = 1 garbage");
+    test_expect_error(h, "select * from t where name like 'n1%'");
+    test_expect_error(h, "select id from t order by id limit 1 offset 2 3");
+    test_expect_error(h, "select id from t; select id from t");
+    test_expect(h, "select id from t where id = 1;", "{\"ok\":true,\"rows\":[{\"id\":1}]}");
+
+    // Their well-formed neighbours still parse
+    test_run(h, "update t set v = 77 where (id = 1 or id = 2) and not (id is null)");
+    test_run(h, "update t set v = 77 where id in () or id between 5 and 6");
+    test_expect(h, "select id from t where v = 77",
+                "{\"ok\":true,\"rows\":[{\"id\":1},{\"id\":2},{\"id\":5},{\"id\":6}]}");
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_update_malformed_where passed\n");
+}
+
+int main() {
+    printf("\n=== Running UPDATE Tests ===\n\n");
+
+    test_update_in_place();
+    test_update_moving_keys();
+    test_update_malformed_where();
+
+    printf("\n=== All UPDATE Tests Passed ===\n\n");
+    return 0;
+}
@@ -41,6 +41,8 @@ void test_parse_int64() {
     
     // Invalid integers
     assert(parse_int64("not_a_number", &value) != 0);
+    assert(parse_int64("99999999999999999999", &value) != 0);
+    assert(parse_int64("-99999999999999999999", &value) != 0);
     
     printf("  ✓ test_parse_int64 passed\n");
 }
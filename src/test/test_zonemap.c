@@ -0,0 +1,226 @@
+#include "../include/zonemap.h"
+#include "../include/operator.h"
+#include "helpers.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// Rows id = first, first + step, ... below last, with v = id % 100 and
+// ts = id * 10, in one INSERT
+static void insert_ids(MYDB_Handle h, int first, int step, int last) {
+    char* sql = malloc(64 + (size_t)(last - first) / (size_t)step * 40 + 40);
+    assert(sql);
+    size_t len = (size_t)sprintf(sql, "insert into t values ");
+    for (int id = first; id < last; id += step) {
+        len += (size_t)sprintf(sql + len, "%s(%d, %d, %d)", id == first ? "" : ", ", id, id % 100, id * 10);
+    }
+    test_run(h, sql);
+    free(sql);
+}
+
+static MYDB_Handle open_db(char* path) {
+    MYDB_Handle h = test_open_db(path);
+    test_run(h, "create table t (id int, v int, ts timestamp)");
+    test_run(h, "use t");
+    assert(mydb_set_threads(h, 1) == 0);
+    return h;
+}
+
+#define MAX_COLS 3
+
+// Fold the rows under `page_num` into `rows` and `bounds`, checking that
+// every zone there has exact bounds: a leaf's always, an internal page's
+// unless it is stale. Returns the leaves under it.
+static uint32_t check_subtree(Table* t, uint32_t page_num, uint32_t* rows, int64_t* bounds) {
+    const TableSchema* s = &t->active_schema;
+    void* node = get_page(t->pager, page_num);
+    uint32_t n = 0;
+    int64_t b[2 * MAX_COLS];
+    uint32_t leaves = 1;
+    if (get_node_type(node) == NODE_INTERNAL) {
+        leaves = 0;
+        for (uint32_t i = 0; i <= *internal_node_num_keys(node); i++) {
+            leaves += check_subtree(t, *internal_node_child(node, i), &n, b);
+        }
+    } else {
+        for (uint32_t i = 0; i < *leaf_node_num_cells(node); i++, n++) {
+            const uint8_t* row = leaf_value_t(t, node, i);
+            for (uint32_t c = 0; c < s->num_columns; c++) {
+                int64_t v;
+                if (s->columns[c].type == COL_TYPE_TIMESTAMP) {
+                    memcpy(&v, row + schema_col_offset(s, (int)c), 8);
+                } else {
+                    int32_t v32;
+                    memcpy(&v32, row + schema_col_offset(s, (int)c), 4);
+                    v = v32;
+                }
+                b[2 * c] = n == 0 || v < b[2 * c] ? v : b[2 * c];
+                b[2 * c + 1] = n == 0 || v > b[2 * c + 1] ? v : b[2 * c + 1];
+            }
+        }
+    }
+
+    const LeafZone* z = t->pager->zones[page_num];
+    assert(!z || z->internal == (get_node_type(node) == NODE_INTERNAL));
+    if (z && (!z->internal || z->version == t->pager->zone_version)) {
+        // Above the leaves the row count only tells empty from not
+        assert(z->internal ? (z->num_rows > 0) == (n > 0) : z->num_rows == n);
+        for (uint32_t c = 0; c < s->num_columns && n > 0; c++) {
+            assert(z->bounds[2 * c] == b[2 * c] && z->bounds[2 * c + 1] == b[2 * c + 1]);
+        }
+    }
+    for (uint32_t c = 0; c < s->num_columns && n > 0; c++) {
+        bounds[2 * c] = *rows == 0 || b[2 * c] < bounds[2 * c] ? b[2 * c] : bounds[2 * c];
+        bounds[2 * c + 1] = *rows == 0 || b[2 * c + 1] > bounds[2 * c + 1] ? b[2 * c + 1] : bounds[2 * c + 1];
+    }
+    *rows += n;
+    return leaves;
+}
+
+static uint32_t check_zones(Table* t) {
+    uint32_t rows = 0;
+    int64_t bounds[2 * MAX_COLS];
+    return check_subtree(t, t->root_page_num, &rows, bounds);
+}
+
+static void expect_count(MYDB_Handle h, const char* where, int n) {
+    char sql[128], want[64];
+    snprintf(sql, sizeof(sql), "select count(*) from t where %s", where);
+    snprintf(want, sizeof(want), "{\"ok\":true,\"rows\":[{\"count(*)\":%d}]}", n);
+    test_expect(h, sql, want);
+}
+
+// Page hits of the scan under EXPLAIN ANALYZE of `sql`
+static uint64_t scan_hits(MYDB_Handle h, const char* sql, const char* op) {
+    char explain[256];
+    snprintf(explain, sizeof(explain), "explain analyze %s", sql);
+    char* out = test_json(h, explain);
+    uint64_t hits = test_step_page_hits(out, op);
+    free(out);
+    return hits;
+}
+
+void test_zonemap_prunes() {
+    printf("Running test_zonemap_prunes...\n");
+
+    char path[] = "/tmp/test_zonemap_XXXXXX";
+    MYDB_Handle h = open_db(path);
+    Table* t = (Table*)h;
+    insert_ids(h, 0, 1, 3 * PARALLEL_SCAN_MIN_ROWS);
+    uint32_t leaves = check_zones(t);
+    assert(leaves > 20);
+
+    // The first scan builds the zones, reading every leaf; leaving an
+    // internal node it builds that node's zone from its children's
+    const char* narrow = "select * from t where ts between 50000 and 50100";
+    uint64_t first = scan_hits(h, narrow, "Leaf Scan");
+    assert(first >= leaves);
+    assert(check_zones(t) == leaves);
+
+    // Later ones rule leaves out from their parents without reading them
+    uint64_t again = scan_hits(h, narrow, "Leaf Scan");
+    assert(again * 10 < leaves);
+    expect_count(h, "ts between 50000 and 50100", 11);
+    assert(scan_hits(h, "select * from t where ts > 122000 or v in (100, -1)", "Leaf Scan") * 10 < leaves);
+    assert(scan_hits(h, "select * from t where ts < 0", "Leaf Scan") * 10 < leaves);
+    // A predicate the zones cannot decide reads every leaf
+    assert(scan_hits(h, "select * from t where v = 7", "Leaf Scan") >= leaves);
+
+    // So does a parallel scan, and a key range
+    assert(mydb_set_threads(h, 4) == 0);
+    assert(scan_hits(h, "select count(*) from t where ts between 50000 and 50100", "Parallel Scan") * 5 < leaves);
+    expect_count(h, "ts between 50000 and 50100", 11);
+    assert(mydb_set_threads(h, 1) == 0);
+    assert(scan_hits(h, "select * from t where id > 100 and ts between 50000 and 50100", "Range Scan") * 10 < leaves);
+    expect_count(h, "id > 100 and ts between 50000 and 50100", 11);
+
+    // And UPDATE, whose pages are counted the same way; v = 50 is inside
+    // every leaf's bounds, so the zones it was pruned by stay current
+    uint64_t hits = t->pager->page_hits;
+    t->pager->count_fetches = true;
+    test_run(h, "update t set v = 50 where ts between 50020 and 50080");
+    t->pager->count_fetches = false;
+    assert((t->pager->page_hits - hits) * 5 < leaves);
+    expect_count(h, "v = 50", 123 + 7);
+    assert(scan_hits(h, narrow, "Leaf Scan") * 10 < leaves);
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_zonemap_prunes passed\n");
+}
+
+void test_zonemap_invalidation() {
+    printf("Running test_zonemap_invalidation...\n");
+
+    char path[] = "/tmp/test_zonemap_XXXXXX";
+    MYDB_Handle h = open_db(path);
+    Table* t = (Table*)h;
+
+    // Root copy: the root leaf's zone goes when it becomes internal
+    insert_ids(h, 0, 2, 100);
+    expect_count(h, "ts > 100", 44);
+    assert(t->pager->zones[t->root_page_num] != NULL);
+    insert_ids(h, 100, 2, 4000);
+    assert(get_node_type(get_page(t->pager, t->root_page_num)) == NODE_INTERNAL);
+    check_zones(t);
+    expect_count(h, "ts > 100", 1994);
+
+    // Splits: odd keys land between the even ones in leaves with zones
+    check_zones(t);
+    insert_ids(h, 1, 2, 4000);
+    check_zones(t);
+    expect_count(h, "ts between 10005 and 10025", 2);
+    expect_count(h, "ts > 39980", 1);
+
+    // UPDATE: a value moved past a zone's bounds is still found
+    test_run(h, "update t set ts = 99999999 where id = 2001");
+    test_run(h, "update t set v = -5 where id between 100 and 130");
+    check_zones(t);
+    expect_count(h, "ts = 99999999", 1);
+    expect_count(h, "v = -5", 31);
+    expect_count(h, "ts = 20010", 0);
+
+    // DELETE of a leaf's bounds, in bulk and key by key
+    test_run(h, "delete from t where ts < 1000 or v = 3");
+    check_zones(t);
+    expect_count(h, "ts < 2000", 100);
+    test_run(h, "delete from t where id in (150, 151, 152)");
+    check_zones(t);
+    expect_count(h, "ts between 1500 and 1520", 0);
+
+    // Merges: emptied leaves leave their parents and neighbours merge
+    test_run(h, "delete from t where id > 1000 and id < 3000");
+    check_zones(t);
+    expect_count(h, "ts between 10020 and 29990", 0);
+    expect_count(h, "ts >= 30000", 990);
+    for (int id = 3000; id < 3600; id++) {
+        char sql[64];
+        snprintf(sql, sizeof(sql), "delete from t where id = %d", id);
+        test_run(h, sql);
+    }
+    check_zones(t);
+    expect_count(h, "ts >= 30000", 396);
+
+    // Down to a few rows, then growing again
+    test_run(h, "delete from t where id > 120");
+    check_zones(t);
+    expect_count(h, "ts > 0", 21);
+    test_run(h, "insert into t values (5000, 1, 7777777)");
+    expect_count(h, "ts = 7777777", 1);
+    check_zones(t);
+
+    test_close_db(h, path);
+
+    printf("  ✓ test_zonemap_invalidation passed\n");
+}
+
+int main() {
+    printf("\n=== Running Zone Map Tests ===\n\n");
+
+    test_zonemap_prunes();
+    test_zonemap_invalidation();
+
+    printf("\n=== All Zone Map Tests Passed ===\n\n");
+    return 0;
+}